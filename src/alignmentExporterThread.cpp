@@ -0,0 +1,529 @@
+
+#include "alignmentExporterThread.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QtDebug>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include "contigList.h"
+#include "database.h"
+#include "trace.h"
+
+#define	WRITE_BUFFER_SIZE		4194304		/* Bytes of SAM output buffered before they are written */
+#define	UNIQUE_MAPPING_QUALITY	60			/* Mapping quality of reads placed once */
+#define	PROGRESS_INTERVAL		1000000		/* Reads between progress messages */
+#define	FLAG_REVERSE			16
+#define	FLAG_UNMAPPED			4
+#define	PAD_CHAR				'*'
+
+/* CIGAR operations */
+enum {CigarMatch = 0, CigarInsertion = 1, CigarDeletion = 2, CigarSoftClip = 4};
+static const char cigarChars[] = "MIDNSHP=X";
+
+/* 4-bit BAM encoding of each base; anything else is N */
+static const char bamBases[] = "=ACMGRSVTWYHKDBN";
+
+
+/*
+ * Appends a little-endian integer of the given number of bytes
+ */
+static void appendInt(QByteArray &bytes, const quint32 n, const int size)
+{
+	int i;
+
+	for (i = 0; i < size; ++i)
+		bytes.append((char) ((n >> (8 * i)) & 0xFF));
+}
+
+
+/*
+ * Returns the 4-bit BAM code of the given base
+ */
+static int getBaseCode(const char base)
+{
+	const char *p;
+
+	p = strchr(bamBases, toupper(base));
+	if (base == '\0' || p == NULL)
+		return 15;
+	return p - bamBases;
+}
+
+
+/**
+ * Constructor
+ */
+AlignmentExporterThread::AlignmentExporterThread()
+	: contigConnectionName(QString(this->metaObject()->className()) + "Contig"),
+	  fragConnectionName(QString(this->metaObject()->className()) + "Frag")
+{
+	format = Bam;
+	numReads = 0;
+	isSuccessful = false;
+	hasWriteError = false;
+	isCanceled = false;
+}
+
+
+/**
+ * Destructor
+ */
+AlignmentExporterThread::~AlignmentExporterThread()
+{
+	cancel();
+	wait();
+}
+
+
+/**
+ * Sets the file written by the next run
+ *
+ * @param name : Name of the output file; a BAM index is written to
+ * 'name.bai'
+ * @param fileFormat : Format of the output file
+ */
+void AlignmentExporterThread::setFile(const QString &name, const Format fileFormat)
+{
+	fileName = name;
+	format = fileFormat;
+}
+
+
+/**
+ * Asks a running export to stop. The partially written file is removed.
+ */
+void AlignmentExporterThread::cancel()
+{
+	isCanceled = true;
+}
+
+
+/**
+ * Implements the run method
+ */
+void AlignmentExporterThread::run()
+{
+	bool ok;
+
+	isCanceled = false;
+	isSuccessful = false;
+	hasWriteError = false;
+	numReads = 0;
+	{
+		TRACE_SPAN("export alignments");
+		QSqlDatabase contigDb =
+			Database::createConnection(
+				contigConnectionName,
+				Database::getContigDBName());
+		QSqlDatabase fragDb =
+			Database::createConnection(
+				fragConnectionName,
+				Database::getFragDBName());
+
+		ok = exportAlignments(contigDb, fragDb);
+
+		contigDb.close();
+		fragDb.close();
+	}
+	QSqlDatabase::removeDatabase(contigConnectionName);
+	QSqlDatabase::removeDatabase(fragConnectionName);
+
+	/* Closing also waits for blocks that are still being compressed */
+	bgzfWriter.close();
+	if (samFile.isOpen())
+		samFile.close();
+	pendingRecords.clear();
+	samBuffer.clear();
+	bamIndex.clear();
+	if (ok)
+	{
+		isSuccessful = true;
+		emit messageChanged(tr("%L1 reads exported to %2").arg(numReads).arg(fileName));
+	}
+	else
+	{
+		QFile::remove(fileName);
+		QFile::remove(fileName + ".bai");
+		if (isCanceled)
+			emit messageChanged(tr("Export canceled"));
+		else
+			emit messageChanged(tr("Error exporting reads to %1").arg(fileName));
+	}
+}
+
+
+/*
+ * Writes the header and then the reads of each contig in position order
+ *
+ * @return Returns true on success and false on failure or cancellation
+ */
+bool AlignmentExporterThread::exportAlignments(QSqlDatabase &contigDb, QSqlDatabase &fragDb)
+{
+	QSqlQuery query(contigDb);
+	QSqlQuery fragQuery(fragDb);
+	QList<int> idList, lengthList, sizeList;
+	QList<QByteArray> nameList;
+	PadIndex padIndex;
+	Record record;
+	QString str;
+	int i, startPos;
+
+	/* Reference sequences, in unpadded lengths */
+	emit messageChanged(tr("Reading contigs..."));
+	if (!DB_EXEC(query, "select id, name, size from contig order by id"))
+	{
+		qCritical() << "Error fetching contigs for export:" << query.lastError().text();
+		return false;
+	}
+	while (query.next())
+	{
+		idList.append(query.value(0).toInt());
+		nameList.append(query.value(1).toByteArray());
+		sizeList.append(query.value(2).toInt());
+	}
+	query.finish();
+	for (i = 0; i < idList.size(); ++i)
+	{
+		if (!ContigList::fetchPadIndex(query, idList.at(i), padIndex))
+			return false;
+		lengthList.append(sizeList.at(i) - padIndex.getNumPads());
+	}
+	query.finish();
+
+	/* Projects imported before reads were indexed by position get the
+	 * index now */
+	emit messageChanged(tr("Indexing reads..."));
+	if (!fragQuery.exec(Database::getFragIndexSql()))
+	{
+		qCritical() << "Error creating fragment index:" << fragQuery.lastError().text();
+		return false;
+	}
+
+	if (format == Bam)
+	{
+		if (!bgzfWriter.open(fileName))
+			return false;
+		bamIndex.clear();
+		bamIndex.setNumReferences(idList.size());
+	}
+	else
+	{
+		samFile.setFileName(fileName);
+		if (!samFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qCritical() << "Cannot write file" << fileName << ":" << samFile.errorString();
+			return false;
+		}
+	}
+	writeHeader(nameList, lengthList);
+	emit messageChanged(tr("Exporting reads..."));
+
+	/* Reads come out of the index in padded start order. A read's
+	 * position is never before the unpadded position of its start, so
+	 * records before that position can be written once a read has been
+	 * converted. */
+	fragQuery.setForwardOnly(true);
+	for (i = 0; i < idList.size() && !isCanceled && !hasWriteError; ++i)
+	{
+		TRACE_SPAN("export contig");
+		if (!ContigList::fetchPadIndex(query, idList.at(i), padIndex))
+			return false;
+		query.finish();
+
+		str = "select name, complement, startPos, seq, qualStart, qualEnd, "
+				" alignStart, alignEnd, numMappings "
+				" from fragment "
+				" where contig_id = " + QString::number(idList.at(i))
+				+ " order by startPos, id";
+		if (!DB_EXEC(fragQuery, str))
+		{
+			qCritical() << "Error fetching reads for export:"
+				<< fragQuery.lastError().text();
+			return false;
+		}
+		while (fragQuery.next() && !isCanceled && !hasWriteError)
+		{
+			record = convertRead(i, nameList.at(i), fragQuery, padIndex,
+					sizeList.at(i), lengthList.at(i));
+			pendingRecords.insert(record.pos, record);
+
+			startPos = fragQuery.value(2).toInt() - 1;
+			writeRecords(i, (startPos <= 0)? 0: padIndex.toUnpadded(startPos));
+			if (++numReads % PROGRESS_INTERVAL == 0)
+			{
+				emit messageChanged(tr("Exporting contig %1 of %2: %L3 reads")
+						.arg(i + 1).arg(idList.size()).arg(numReads));
+			}
+		}
+		fragQuery.finish();
+		writeRecords(i, INT_MAX);
+	}
+	if (isCanceled)
+		return false;
+
+	if (format == Bam)
+	{
+		if (!bgzfWriter.close() || hasWriteError)
+			return false;
+		emit messageChanged(tr("Writing index..."));
+		return bamIndex.write(fileName + ".bai", bgzfWriter);
+	}
+	if (!hasWriteError && !samBuffer.isEmpty())
+	{
+		if (samFile.write(samBuffer) != samBuffer.size())
+			hasWriteError = true;
+		samBuffer.clear();
+	}
+	samFile.close();
+	return !hasWriteError;
+}
+
+
+/*
+ * Writes the SAM header, and for BAM files the reference list
+ */
+void AlignmentExporterThread::writeHeader(
+		const QList<QByteArray> &nameList,
+		const QList<int> &lengthList)
+{
+	QByteArray text, bytes;
+	int i;
+
+	text = "@HD\tVN:1.4\tSO:coordinate\n";
+	for (i = 0; i < nameList.size(); ++i)
+	{
+		text += "@SQ\tSN:" + nameList.at(i)
+			+ "\tLN:" + QByteArray::number(lengthList.at(i)) + "\n";
+	}
+	text += "@PG\tID:basejumper\tPN:basejumper\n";
+	if (format == Sam)
+	{
+		write(text);
+		return;
+	}
+
+	bytes = "BAM\1";
+	appendInt(bytes, text.size(), 4);
+	bytes += text;
+	appendInt(bytes, nameList.size(), 4);
+	for (i = 0; i < nameList.size(); ++i)
+	{
+		appendInt(bytes, nameList.at(i).size() + 1, 4);
+		bytes += nameList.at(i);
+		bytes.append('\0');
+		appendInt(bytes, lengthList.at(i), 4);
+	}
+	write(bytes);
+}
+
+
+/*
+ * Converts the read at the current row of the given query. The aligned
+ * part of the read lies within its quality and alignment clipping and
+ * the contig, and starts and ends with a base aligned to a contig base;
+ * the rest is soft clipped. Columns where only the contig has a pad are
+ * insertions and columns where only the read has a pad are deletions.
+ * Reads with no aligned part are written as unmapped reads placed at
+ * their start.
+ *
+ * @param refId : Index of the contig in the header
+ * @param refName : Name of the contig
+ * @param query : Query positioned at the read
+ * @param padIndex : Pads of the contig
+ * @param contigSize : Padded length of the contig
+ * @param refLength : Unpadded length of the contig
+ */
+AlignmentExporterThread::Record AlignmentExporterThread::convertRead(
+		const int refId,
+		const QByteArray &refName,
+		const QSqlQuery &query,
+		const PadIndex &padIndex,
+		const int contigSize,
+		const int refLength)
+{
+	Record record;
+	QByteArray name, paddedSeq, seq, cigarStr;
+	QVector<quint32> cigar;
+	const char *readSeq;
+	int startPos, first, last, i, col, op, lastOp, length, flag, mapq, numLeft, numRight, refSpan;
+
+	name = query.value(0).toByteArray();
+	startPos = query.value(2).toInt();
+	paddedSeq = query.value(3).toByteArray();
+	readSeq = paddedSeq.constData();
+	flag = (query.value(1).toString() == "C")? FLAG_REVERSE: 0;
+	mapq = (query.value(8).toInt() > 1)? 0: UNIQUE_MAPPING_QUALITY;
+
+	/* Aligned part of the read, 1-based within the padded read */
+	first = qMax(qMax(query.value(4).toInt(), query.value(6).toInt()), 1);
+	last = qMin(query.value(5).toInt(), query.value(7).toInt());
+	first = qMax(first, 2 - startPos);
+	last = qMin(qMin(last, contigSize - startPos + 1), paddedSeq.size());
+	while (first <= last
+			&& (readSeq[first - 1] == PAD_CHAR
+				|| padIndex.isPad(startPos + first - 2)))
+		++first;
+	while (last >= first
+			&& (readSeq[last - 1] == PAD_CHAR
+				|| padIndex.isPad(startPos + last - 2)))
+		--last;
+
+	seq.reserve(paddedSeq.size());
+	numLeft = numRight = 0;
+	refSpan = 0;
+	lastOp = -1;
+	length = 0;
+	for (i = 1; i <= paddedSeq.size(); ++i)
+	{
+		if (readSeq[i - 1] != PAD_CHAR)
+			seq.append(readSeq[i - 1]);
+		if (first > last)
+			continue;
+		if (i < first || i > last)
+		{
+			if (readSeq[i - 1] == PAD_CHAR)
+				continue;
+			if (i < first)
+				++numLeft;
+			else
+				++numRight;
+			continue;
+		}
+
+		col = startPos + i - 2;
+		if (readSeq[i - 1] != PAD_CHAR)
+			op = padIndex.isPad(col)? CigarInsertion: CigarMatch;
+		else if (!padIndex.isPad(col))
+			op = CigarDeletion;
+		else
+			continue;
+		if (op != CigarInsertion)
+			++refSpan;
+
+		if (op == lastOp)
+			++length;
+		else
+		{
+			if (lastOp >= 0)
+				cigar.append((length << 4) | lastOp);
+			lastOp = op;
+			length = 1;
+		}
+	}
+	if (lastOp >= 0)
+		cigar.append((length << 4) | lastOp);
+	if (numLeft > 0)
+		cigar.prepend((numLeft << 4) | CigarSoftClip);
+	if (numRight > 0)
+		cigar.append((numRight << 4) | CigarSoftClip);
+
+	if (first <= last)
+	{
+		record.pos = padIndex.toUnpadded(startPos + first - 2);
+		record.end = record.pos + refSpan;
+	}
+	else
+	{
+		flag = FLAG_UNMAPPED;
+		mapq = 0;
+		cigar.clear();
+		record.pos = qBound(0, padIndex.toUnpadded(qMax(startPos - 1, 0)), qMax(refLength - 1, 0));
+		record.end = record.pos + 1;
+	}
+
+	/* SAM line */
+	if (format == Sam)
+	{
+		foreach (quint32 c, cigar)
+			cigarStr += QByteArray::number(c >> 4) + cigarChars[c & 0xF];
+		if (cigarStr.isEmpty())
+			cigarStr = "*";
+		record.data = name + "\t" + QByteArray::number(flag)
+			+ "\t" + refName + "\t" + QByteArray::number(record.pos + 1)
+			+ "\t" + QByteArray::number(mapq) + "\t" + cigarStr
+			+ "\t*\t0\t0\t" + (seq.isEmpty()? QByteArray("*"): seq) + "\t*\n";
+		return record;
+	}
+
+	/* BAM record; the DB keeps no base qualities, so they are 0xFF */
+	record.data.reserve(36 + name.size() + 4 * cigar.size() + seq.size() * 3 / 2 + 1);
+	appendInt(record.data, 0, 4);
+	appendInt(record.data, refId, 4);
+	appendInt(record.data, record.pos, 4);
+	appendInt(record.data, name.size() + 1, 1);
+	appendInt(record.data, mapq, 1);
+	appendInt(record.data, BamIndex::getBin(record.pos, record.end), 2);
+	appendInt(record.data, cigar.size(), 2);
+	appendInt(record.data, flag, 2);
+	appendInt(record.data, seq.size(), 4);
+	appendInt(record.data, (quint32) -1, 4);
+	appendInt(record.data, (quint32) -1, 4);
+	appendInt(record.data, 0, 4);
+	record.data += name;
+	record.data.append('\0');
+	foreach (quint32 c, cigar)
+		appendInt(record.data, c, 4);
+	for (i = 0; i < seq.size(); i += 2)
+	{
+		record.data.append((char) ((getBaseCode(seq.at(i)) << 4)
+				| ((i + 1 < seq.size())? getBaseCode(seq.at(i + 1)): 0)));
+	}
+	record.data.append(QByteArray(seq.size(), (char) 0xFF));
+	length = record.data.size() - 4;
+	for (i = 0; i < 4; ++i)
+		record.data[i] = (char) ((length >> (8 * i)) & 0xFF);
+	return record;
+}
+
+
+/*
+ * Writes the pending records whose position is not after the given one
+ *
+ * @param refId : Index of the contig in the header
+ * @param maxPos : 0-based unpadded position
+ */
+void AlignmentExporterThread::writeRecords(const int refId, const int maxPos)
+{
+	QMultiMap<int, Record>::iterator i;
+	quint64 beginOffset;
+
+	i = pendingRecords.begin();
+	while (i != pendingRecords.end() && i.key() <= maxPos)
+	{
+		beginOffset = bgzfWriter.tell();
+		write(i.value().data);
+		if (format == Bam)
+		{
+			bamIndex.add(refId, i.value().pos, i.value().end,
+					beginOffset, bgzfWriter.tell());
+		}
+		i = pendingRecords.erase(i);
+	}
+}
+
+
+/*
+ * Appends the given bytes to the output file
+ */
+void AlignmentExporterThread::write(const QByteArray &bytes)
+{
+	if (hasWriteError)
+		return;
+	if (format == Bam)
+	{
+		if (!bgzfWriter.write(bytes))
+			hasWriteError = true;
+		return;
+	}
+	samBuffer += bytes;
+	if (samBuffer.size() >= WRITE_BUFFER_SIZE)
+	{
+		if (samFile.write(samBuffer) != samBuffer.size())
+		{
+			qCritical() << "Error writing file" << fileName << ":" << samFile.errorString();
+			hasWriteError = true;
+		}
+		samBuffer.clear();
+	}
+}
@@ -0,0 +1,77 @@
+#ifndef ALIGNMENTEXPORTERTHREAD_H_
+#define ALIGNMENTEXPORTERTHREAD_H_
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QVector>
+#include <QMultiMap>
+#include <QFile>
+#include <QSqlDatabase>
+#include "bgzfWriter.h"
+#include "bamIndex.h"
+#include "padIndex.h"
+
+/*
+ * Writes all the loaded reads to a coordinate-sorted SAM or BAM file.
+ * Contigs become reference sequences in unpadded coordinates and the
+ * CIGAR of each read is derived from the pads of the read and the
+ * contig and from its quality and alignment clipping. BAM files are
+ * compressed on the thread pool and get a '.bai' index.
+ */
+class AlignmentExporterThread : public QThread
+{
+	Q_OBJECT
+
+public:
+	enum Format {Sam, Bam};
+
+	AlignmentExporterThread();
+	~AlignmentExporterThread();
+	void setFile(const QString &, const Format);
+	void cancel();
+
+	/** Returns the number of reads written by the last run */
+	inline qint64 getNumReads() const { return numReads; };
+
+	/** Returns whether the last run wrote the whole file */
+	inline bool hasSucceeded() const { return isSuccessful; };
+
+    signals:
+    void messageChanged(const QString &);
+
+protected:
+	void run();
+
+private:
+	/* A read converted to a SAM or BAM record */
+	struct Record
+	{
+		int pos;				/* 0-based unpadded position */
+		int end;				/* Position after the last reference base covered */
+		QByteArray data;		/* SAM line or BAM record */
+	};
+
+	QString contigConnectionName;
+	QString fragConnectionName;
+	QString fileName;
+	Format format;
+	QFile samFile;
+	QByteArray samBuffer;		/* SAM output waiting to be written */
+	BgzfWriter bgzfWriter;
+	BamIndex bamIndex;
+	QMultiMap<int, Record> pendingRecords;	/* Records waiting to be written in position order */
+	qint64 numReads;
+	bool isSuccessful;
+	bool hasWriteError;
+	volatile bool isCanceled;
+
+	bool exportAlignments(QSqlDatabase &, QSqlDatabase &);
+	void writeHeader(const QList<QByteArray> &, const QList<int> &);
+	Record convertRead(const int, const QByteArray &, const QSqlQuery &,
+			const PadIndex &, const int, const int);
+	void writeRecords(const int, const int);
+	void write(const QByteArray &);
+};
+
+#endif /* ALIGNMENTEXPORTERTHREAD_H_ */
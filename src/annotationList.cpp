@@ -5,6 +5,10 @@
 #include <QtGui>
 #include "contig.h"
 #include "gene.h"
+#include "database.h"
+#include "indexedTrack.h"
+#include "contigPlacementIndex.h"
+#include "limits.h"
 
 #define LINE_HEIGHT 		10
 #define	POINT_SIZE_MIN		1.00
@@ -19,6 +23,25 @@
 #define	UTR3P_TRACK			6
 
 
+/*
+ * Returns true if the first annotation starts before the second one
+ */
+static bool annotationLessThan(const Annotation *a1, const Annotation *a2)
+{
+	return (a1->startPos < a2->startPos);
+}
+
+
+/*
+ * Returns true if the given position is before the start of the given
+ * annotation
+ */
+static bool posLessThanAnnotation(const int pos, const Annotation *a)
+{
+	return (pos < a->startPos);
+}
+
+
 /**
  * Constructor
  */
@@ -29,25 +52,38 @@ AnnotationList::AnnotationList()
 	this->type = Custom;
 	this->order = 0;
 	this->alias = "";
+	this->fetchedStart = 0;
+	this->fetchedEnd = -1;
 }
 
 
 /**
  * Constructor with initial value parameters
+ *
+ * If an indexed file is given, nothing is loaded here; the features
+ * are read from the file by fetchRegion() as the view moves.
  */
 AnnotationList::AnnotationList(
 		const int id,
 		Contig *contig,
 		const Type type,
 		const int order,
-		const QString &alias)
+		const QString &alias,
+		const QString &indexedFile)
 {
 	this->id = id;
 	this->contig = contig;
 	this->type = type;
 	this->order = order;
 	this->alias = alias;
-	getAnnotation();
+	this->indexedFile = indexedFile;
+	this->fetchedStart = 0;
+	this->fetchedEnd = -1;
+	if (!isIndexed())
+	{
+		getAnnotation();
+		buildIndex();
+	}
 }
 
 
@@ -55,11 +91,152 @@ AnnotationList::AnnotationList(
  * Destructor
  */
 AnnotationList::~AnnotationList()
+{
+	clearList();
+	contig = NULL;
+}
+
+
+/**
+ * Makes sure that the features overlapping the given contig range are
+ * in the list. Only used for indexed tracks; the list holds the
+ * features of the range and of one range-width on either side of it,
+ * so memory stays bounded however large the track is.
+ *
+ * @param start : Start position of the range within the contig
+ * @param end : End position of the range within the contig
+ */
+void AnnotationList::fetchRegion(const int start, const int end)
+{
+	IndexedTrack *track;
+	const ContigPlacementIndex *placementIndex;
+	ContigPlacementIndex::Placement placement;
+	int width, regionStart, regionEnd, chromStart, chromEnd, startPos, endPos;
+
+	if (!isIndexed() || (start >= fetchedStart && end <= fetchedEnd))
+		return;
+
+	placementIndex = ContigPlacementIndex::getShared();
+	track = IndexedTrack::getTrack(indexedFile);
+	if (placementIndex == NULL
+			|| track == NULL
+			|| !placementIndex->findContig(contig->id, placement))
+	{
+		/* Nothing to show for this contig; do not try again */
+		fetchedStart = INT_MIN;
+		fetchedEnd = INT_MAX;
+		return;
+	}
+
+	width = end - start + 1;
+	regionStart = qMin(start, qMax(0, start - width));
+	regionEnd = qMax(end, qMin(contig->size - 1, end + width));
+
+	/* Contig positions are padded; genome positions are not */
+	ContigPlacementIndex::toGenomeRange(
+			placement,
+			contig->padIndex.toUnpadded(regionStart),
+			contig->padIndex.toUnpadded(regionEnd),
+			chromStart,
+			chromEnd);
+
+	clearList();
+	if (!track->fetch(placement.chrom, chromStart, chromEnd + 1, list))
+	{
+		QMessageBox::critical(
+				QApplication::activeWindow(),
+				tr("Basejumper"),
+				tr("Error reading annotation file %1.").arg(indexedFile));
+		fetchedStart = INT_MIN;
+		fetchedEnd = INT_MAX;
+		return;
+	}
+
+	/* Convert the features to contig coordinates */
+	foreach (Annotation *a, list)
+	{
+		ContigPlacementIndex::toContigRange(
+				placement,
+				a->startPos,
+				a->endPos,
+				startPos,
+				endPos);
+		contig->padIndex.toPaddedRange(startPos, endPos);
+		a->startPos = startPos;
+		a->endPos = endPos;
+	}
+	buildIndex();
+	fetchedStart = regionStart;
+	fetchedEnd = regionEnd;
+}
+
+
+/**
+ * Finds the annotations that overlap the given range
+ *
+ * @param start : Start position of the range within the contig
+ * @param end : End position of the range within the contig
+ * @param result : Cleared and filled with the overlapping annotations,
+ * sorted by start position
+ */
+void AnnotationList::getOverlapping(
+		const int start,
+		const int end,
+		QList<Annotation *> &result) const
+{
+	int i, first;
+
+	result.clear();
+
+	/* Only annotations that start at or before 'end' can overlap; walk
+	 * back from the last of them while some annotation further back
+	 * may still reach 'start' */
+	i = qUpperBound(list.constBegin(), list.constEnd(), end, posLessThanAnnotation)
+		- list.constBegin() - 1;
+	for (; i >= 0 && maxEndList.at(i) >= start; --i)
+	{
+		if (list.at(i)->endPos >= start)
+			result.append(list.at(i));
+	}
+
+	/* Restore start order */
+	first = 0;
+	for (i = result.size() - 1; first < i; ++first, --i)
+		result.swap(first, i);
+}
+
+
+/*
+ * Deletes the annotations in the list
+ */
+void AnnotationList::clearList()
 {
 	foreach (Annotation *a, list)
 		delete a;
 	list.clear();
-	contig = NULL;
+	maxEndList.clear();
+}
+
+
+/*
+ * Sorts the list by start position and computes the running maximum of
+ * the end positions, so that getOverlapping() only has to look at the
+ * annotations near the requested range
+ */
+void AnnotationList::buildIndex()
+{
+	int i, size, maxEnd;
+
+	qStableSort(list.begin(), list.end(), annotationLessThan);
+	size = list.size();
+	maxEndList.resize(size);
+	for (i = 0; i < size; ++i)
+	{
+		maxEnd = list.at(i)->endPos;
+		if (i > 0 && maxEndList.at(i - 1) > maxEnd)
+			maxEnd = maxEndList.at(i - 1);
+		maxEndList[i] = maxEnd;
+	}
 }
 
 
@@ -74,6 +251,8 @@ void AnnotationList::getAnnotation()
 		QSqlQuery query;
 		QString str, name;
 		int annotId, startPos, endPos, yPos, strand;
+		QHash<int, Gene *> geneHash;
+		Gene *gene;
 
 		/* Fetch genes */
 		str = "select annotation.id, "
@@ -85,7 +264,7 @@ void AnnotationList::getAnnotation()
 				" from annotation, gene "
 				" where annotation.id = gene.id "
 				" and annotation.contigId = " + QString::number(contig->id) + "";
-		if (!query.exec(str))
+		if (!DB_EXEC(query, str))
 		{
 			QMessageBox::critical(
 					QApplication::activeWindow(),
@@ -102,14 +281,49 @@ void AnnotationList::getAnnotation()
 			name = query.value(3).toString();
 			yPos = query.value(4).toInt();
 			strand = query.value(5).toInt();
-			list.append(new Gene::Gene(annotId, name, startPos, endPos, yPos, (enum Gene::Strand) strand));
+			gene = new Gene::Gene(annotId, name, startPos, endPos, yPos, (enum Gene::Strand) strand);
+			geneHash.insert(annotId, gene);
+			list.append(gene);
+		}
+
+		/* Fetch the substructures of all the genes at once */
+		str = "select geneStructure.geneId, "
+				" geneStructure.id, "
+				" geneStructure.name, "
+				" geneStructure.start, "
+				" geneStructure.end, "
+				" geneStructure.type "
+				" from annotation, geneStructure "
+				" where annotation.id = geneStructure.geneId "
+				" and annotation.contigId = " + QString::number(contig->id) +
+				" order by geneStructure.geneId, geneStructure.start";
+		if (!DB_EXEC(query, str))
+		{
+			QMessageBox::critical(
+					QApplication::activeWindow(),
+					tr("Basejumper"),
+					tr("Error fetching data from 'geneStructure' table.\nReason: "
+							+ query.lastError().text().toAscii()));
+			return;
+		}
+		while (query.next())
+		{
+			gene = geneHash.value(query.value(0).toInt(), NULL);
+			if (gene == NULL)
+				continue;
+			gene->addSubstructure(new GeneStructure(
+					query.value(1).toInt(),
+					query.value(2).toString(),
+					(enum GeneStructure::SubstructureType) query.value(5).toInt(),
+					query.value(3).toInt(),
+					query.value(4).toInt()));
 		}
 
 		/* Fetch max gene rows from 'contig' table */
 		str = "select maxGeneRows "
 				" from contig "
 				" where id = " + QString::number(contig->id);
-		if (!query.exec(str))
+		if (!DB_EXEC(query, str))
 		{
 			QMessageBox::critical(
 					QApplication::activeWindow(),
@@ -132,7 +346,7 @@ void AnnotationList::getAnnotation()
 				" from annotation "
 				" where contigId = " + QString::number(contig->id) + ""
 				" and annotationTypeId = " + QString::number(id) + "";
-		if (!query.exec(str))
+		if (!DB_EXEC(query, str))
 		{
 			QMessageBox::critical(
 					QApplication::activeWindow(),
@@ -16,7 +16,13 @@ public:
 
 	AnnotationList();
 	AnnotationList(const int, const int, const Type, const int, const QString &);
-	AnnotationList(const int, Contig *, const Type, const int, const QString &);
+	AnnotationList(
+			const int,
+			Contig *,
+			const Type,
+			const int,
+			const QString &,
+			const QString &indexedFile = QString());
 	~AnnotationList();
 
 	inline int getId() const { return this->id; };
@@ -26,7 +32,7 @@ public:
 	inline void setType(const AnnotationList::Type type) { this->type = type; };
 
 	inline QList<Annotation *>& getList() { return this->list; }
-	inline void setList(const QList<Annotation *> &list) { this->list = list; };
+	inline void setList(const QList<Annotation *> &list) { this->list = list; buildIndex(); };
 
 	inline int getOrder() const { return this->order; };
 	inline void setOrder(const int order) { this->order = order; };
@@ -34,6 +40,11 @@ public:
 	inline QString getAlias() const { return alias; }
 	inline void setAlias(const QString &alias) { this->alias = alias; };
 
+	/** Returns whether the features are read from an indexed file */
+	inline bool isIndexed() const { return !indexedFile.isEmpty(); };
+
+	void fetchRegion(const int, const int);
+	void getOverlapping(const int, const int, QList<Annotation *> &) const;
 
 private:
 	int id;
@@ -42,8 +53,14 @@ private:
 	int order;
 	QString alias;
 	Contig *contig;
+	QString indexedFile;		/* Path of the indexed file, if any */
+	int fetchedStart;			/* Start of the region held in 'list' */
+	int fetchedEnd;				/* End of the region held in 'list' */
+	QVector<int> maxEndList;	/* Largest end position of list[0..i]; 'list' is sorted by start */
 
 	void getAnnotation();
+	void clearList();
+	void buildIndex();
 };
 
 #endif /* ANNOTATIONLIST_H_ */
@@ -122,7 +122,7 @@ void AnnotationNavWidget::goToFirstAnnotation()
 			" and annotationTypeId = " + QString::number(track) +
 			" order by startPos asc "
 			" limit 1";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this->parentWidget(),
@@ -161,7 +161,7 @@ void AnnotationNavWidget::goToPrevAnnotation()
 			" and startPos < " + QString::number(Contig::startPos) +
 			" order by startPos desc "
 			" limit 1";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this->parentWidget(),
@@ -200,7 +200,7 @@ void AnnotationNavWidget::goToNextAnnotation()
 			" and startPos > " + QString::number(Contig::startPos+1) +
 			" order by startPos asc "
 			" limit 1";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this->parentWidget(),
@@ -238,7 +238,7 @@ void AnnotationNavWidget::goToLastAnnotation()
 			" and annotationTypeId = " + QString::number(track) +
 			" order by startPos desc "
 			" limit 1";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this->parentWidget(),
@@ -340,7 +340,7 @@ void AnnotationNavWidget::setItems()
 	str = "select id, alias "
 			" from annotationType "
 			" order by annotOrder asc ";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 			this->parentWidget(),
@@ -0,0 +1,210 @@
+#include "bamIndex.h"
+#include <QFile>
+#include <QtDebug>
+#include "bgzfWriter.h"
+
+#define	LINEAR_INDEX_SHIFT	14		/* Windows of the linear index are 16 kb */
+
+
+/*
+ * Appends a little-endian 32-bit integer
+ */
+static void appendInt32(QByteArray &bytes, const quint32 n)
+{
+	bytes.append((char) (n & 0xFF));
+	bytes.append((char) ((n >> 8) & 0xFF));
+	bytes.append((char) ((n >> 16) & 0xFF));
+	bytes.append((char) ((n >> 24) & 0xFF));
+}
+
+
+/*
+ * Appends a little-endian 64-bit integer
+ */
+static void appendInt64(QByteArray &bytes, const quint64 n)
+{
+	appendInt32(bytes, (quint32) (n & 0xFFFFFFFF));
+	appendInt32(bytes, (quint32) (n >> 32));
+}
+
+
+/**
+ * Constructor
+ */
+BamIndex::BamIndex()
+{
+
+}
+
+
+/**
+ * Destructor
+ */
+BamIndex::~BamIndex()
+{
+
+}
+
+
+/**
+ * Removes all the records from the index
+ */
+void BamIndex::clear()
+{
+	references.clear();
+}
+
+
+/**
+ * Sets the number of reference sequences in the BAM header
+ *
+ * @param n : Number of references
+ */
+void BamIndex::setNumReferences(const int n)
+{
+	references.resize(n);
+}
+
+
+/**
+ * Adds a record. Records must be added in the order they are written.
+ *
+ * @param refId : Index of the reference sequence
+ * @param begin : 0-based position of the first reference base covered
+ * @param end : 0-based position after the last reference base covered
+ * @param beginOffset : Logical offset of the record in the BGZF file
+ * @param endOffset : Logical offset after the record
+ */
+void BamIndex::add(
+		const int refId,
+		const int begin,
+		const int end,
+		const quint64 beginOffset,
+		const quint64 endOffset)
+{
+	Reference *ref;
+	QVector<Chunk> *chunks;
+	int i, first, last;
+
+	if (refId < 0 || refId >= references.size())
+		return;
+	ref = &references[refId];
+
+	/* Consecutive records of the same bin share a chunk */
+	chunks = &ref->binHash[(quint32) getBin(begin, end)];
+	if (!chunks->isEmpty() && chunks->last().second == beginOffset)
+		chunks->last().second = endOffset;
+	else
+		chunks->append(Chunk(beginOffset, endOffset));
+
+	/* Linear index; 0 marks a window with no record yet */
+	first = begin >> LINEAR_INDEX_SHIFT;
+	last = ((end > begin)? end - 1: begin) >> LINEAR_INDEX_SHIFT;
+	if (ref->linearIndex.size() <= last)
+		ref->linearIndex.resize(last + 1);
+	for (i = first; i <= last; ++i)
+	{
+		if (ref->linearIndex.at(i) == 0)
+			ref->linearIndex[i] = beginOffset;
+	}
+}
+
+
+/**
+ * Writes the index to the given file
+ *
+ * @param path : Path of the index, usually the BAM file name followed
+ * by '.bai'
+ * @param writer : Closed writer of the BAM file, which resolves the
+ * logical offsets
+ * @return Returns true on success and false on failure
+ */
+bool BamIndex::write(const QString &path, const BgzfWriter &writer) const
+{
+	QFile file(path);
+	QByteArray bytes;
+	QMap<quint32, QVector<Chunk> >::const_iterator i;
+	quint64 offset;
+	int j;
+	bool ok;
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qCritical() << "Cannot write file " << path << ". Reason: "
+			<< file.errorString();
+		return false;
+	}
+
+	ok = true;
+	bytes.append("BAI\1", 4);
+	appendInt32(bytes, references.size());
+	foreach (const Reference &ref, references)
+	{
+		appendInt32(bytes, ref.binHash.size());
+		for (i = ref.binHash.constBegin(); i != ref.binHash.constEnd(); ++i)
+		{
+			appendInt32(bytes, i.key());
+			appendInt32(bytes, i.value().size());
+			foreach (const Chunk &chunk, i.value())
+			{
+				appendInt64(bytes, writer.getVirtualOffset(chunk.first));
+				appendInt64(bytes, writer.getVirtualOffset(chunk.second));
+			}
+		}
+
+		/* Windows without records start where the previous one does */
+		appendInt32(bytes, ref.linearIndex.size());
+		offset = 0;
+		for (j = 0; j < ref.linearIndex.size(); ++j)
+		{
+			if (ref.linearIndex.at(j) != 0)
+				offset = writer.getVirtualOffset(ref.linearIndex.at(j));
+			appendInt64(bytes, offset);
+		}
+
+		if (bytes.size() >= 1048576)
+		{
+			ok = (file.write(bytes) == bytes.size());
+			bytes.clear();
+			if (!ok)
+				break;
+		}
+	}
+	if (ok)
+		ok = (file.write(bytes) == bytes.size());
+	if (!ok)
+	{
+		qCritical() << "Error writing file " << path << ". Reason: "
+			<< file.errorString();
+		file.close();
+		file.remove();
+		return false;
+	}
+	file.close();
+	return true;
+}
+
+
+/**
+ * Returns the bin of the binning index that holds the given interval
+ *
+ * @param begin : 0-based first position
+ * @param end : 0-based position after the last one
+ */
+int BamIndex::getBin(const int begin, const int end)
+{
+	int last;
+
+	last = (end > begin)? end - 1: begin;
+	if (begin >> 14 == last >> 14)
+		return ((1 << 15) - 1) / 7 + (begin >> 14);
+	if (begin >> 17 == last >> 17)
+		return ((1 << 12) - 1) / 7 + (begin >> 17);
+	if (begin >> 20 == last >> 20)
+		return ((1 << 9) - 1) / 7 + (begin >> 20);
+	if (begin >> 23 == last >> 23)
+		return ((1 << 6) - 1) / 7 + (begin >> 23);
+	if (begin >> 26 == last >> 26)
+		return ((1 << 3) - 1) / 7 + (begin >> 26);
+	return 0;
+}
@@ -0,0 +1,40 @@
+#ifndef BAMINDEX_H_
+#define BAMINDEX_H_
+
+#include <QString>
+#include <QVector>
+#include <QMap>
+#include <QPair>
+
+class BgzfWriter;
+
+/*
+ * Builds the BAI index of a coordinate-sorted BAM file as its records
+ * are written. Offsets are the logical offsets of BgzfWriter and are
+ * resolved to virtual offsets when the index is written.
+ */
+class BamIndex
+{
+public:
+	BamIndex();
+	~BamIndex();
+	void clear();
+	void setNumReferences(const int);
+	void add(const int, const int, const int, const quint64, const quint64);
+	bool write(const QString &, const BgzfWriter &) const;
+	static int getBin(const int, const int);
+
+private:
+	typedef QPair<quint64, quint64> Chunk;	/* Begin and end offsets */
+
+	/* Index of one reference sequence */
+	struct Reference
+	{
+		QMap<quint32, QVector<Chunk> > binHash;	/* Chunks of each bin */
+		QVector<quint64> linearIndex;	/* First offset of each 16 kb window */
+	};
+
+	QVector<Reference> references;
+};
+
+#endif /* BAMINDEX_H_ */
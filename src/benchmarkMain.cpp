@@ -0,0 +1,499 @@
+#include <QApplication>
+#include <QDir>
+#include <QProcess>
+#include <QStringList>
+#include <QTextStream>
+#include <QTime>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QtDebug>
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+#include "database.h"
+#include "contig.h"
+#include "contigList.h"
+#include "fragmentList.h"
+#include "dataGenerator.h"
+
+#define	SNP_THRESHOLD		30		/* Default SNP threshold of the viewer */
+#define	DISPLAY_BIN_SIZE	10		/* Bases per pixel column for the sampling query */
+
+/* Data set of --check-limits; each value is just past a limit of the
+ * old 16-bit fields */
+#define	LIMITS_NUM_CONTIGS	65600	/* Contig IDs past 65,535 */
+#define	LIMITS_READ_LENGTH	70000	/* Read size past 65,535 */
+#define	LIMITS_STACK_DEPTH	33000	/* Read rows past 32,767 */
+#define	LIMITS_CONTIG_LENGTH	100
+#define	LIMITS_READ_LENGTH_SHORT	50
+
+/*
+ * Scaling benchmark. For each scale, generates a synthetic data set
+ * whose contig count is the base count times the scale, imports it with
+ * 'basejumper-import' and runs the queries the viewer makes when a
+ * contig is opened. Prints one tab-separated line per measurement:
+ *
+ *     scale  kind  name  seconds  amount  unit
+ *
+ * 'kind' is 'import' for the stages reported by the importer, 'query'
+ * for the queries and 'rss' for the peak resident set size in KB.
+ * Peak RSS is the maximum so far, so scales should be given in
+ * ascending order.
+ *
+ * With '--check-limits', a single data set is imported that goes past
+ * the limits of the formerly 16-bit read fields: more than 65,535
+ * contigs, a read longer than 65,535 bases and more than 32,767 read
+ * rows. The widened values are checked after a round trip through the
+ * DB, one 'check' line each, and the exit code is 1 if any check fails.
+ */
+
+
+/*
+ * Prints the usage message
+ */
+static void printUsage()
+{
+	QTextStream err(stderr);
+
+	err << "Usage: basejumper-benchmark --out <dir> [options]\n"
+		<< "Options:\n"
+		<< "  --out <dir>            Directory for the generated data and projects\n"
+		<< "  --importer <file>      Path of 'basejumper-import'\n"
+		<< "  --scales <list>        Comma-separated scales (default 1,10,100)\n"
+		<< "  --contigs <n>          Contigs at scale 1\n"
+		<< "  --length <n>           Contig length\n"
+		<< "  --read-length <n>      Read length\n"
+		<< "  --depth <n>            Read depth\n"
+		<< "  --chromosomes <n>      Number of chromosomes\n"
+		<< "  --snp-rate <x>         Fraction of bases that are SNPs\n"
+		<< "  --pad-rate <x>         Fraction of bases followed by a pad\n"
+		<< "  --multimap-rate <x>    Fraction of reads that map to several contigs\n"
+		<< "  --seed <n>             Random seed\n"
+		<< "  --check-limits         Import a data set past the 16-bit limits and check it\n";
+}
+
+
+/*
+ * Prints one line of the results table
+ */
+static void printRow(
+		const int scale,
+		const QString &kind,
+		const QString &name,
+		const QString &seconds,
+		const QString &amount,
+		const QString &unit)
+{
+	QTextStream out(stdout);
+
+	out << scale << "\t" << kind << "\t" << name << "\t" << seconds << "\t"
+		<< amount << "\t" << unit << "\n";
+	out.flush();
+}
+
+
+/*
+ * Prints one query timing
+ */
+static void printQuery(
+		const int scale,
+		const QString &name,
+		const int msecs,
+		const qint64 amount,
+		const QString &unit)
+{
+	printRow(scale, "query", name, QString::number(msecs / 1000.0, 'f', 3),
+			QString::number(amount), unit);
+}
+
+
+/*
+ * Returns the peak resident set size in KB of this process or, if
+ * 'children' is true, of its largest finished child process. Returns -1
+ * where this is not available.
+ */
+static qint64 getPeakRss(const bool children)
+{
+#ifdef Q_OS_UNIX
+	struct rusage usage;
+
+	if (getrusage(children? RUSAGE_CHILDREN: RUSAGE_SELF, &usage) == 0)
+		return usage.ru_maxrss;
+#else
+	Q_UNUSED(children);
+#endif
+	return -1;
+}
+
+
+/*
+ * Runs the importer on the generated data and prints the stages it
+ * reports
+ */
+static bool runImport(
+		const int scale,
+		const QString &importer,
+		const QString &inputDir,
+		const QString &projectDir,
+		const QString &aceFile,
+		const QStringList &options)
+{
+	QProcess process;
+	QStringList args, fields;
+	QString line;
+	QTime timer;
+
+	args << "--project" << projectDir << "--ref" << inputDir << options << aceFile;
+	process.setProcessChannelMode(QProcess::ForwardedErrorChannel);
+	timer.start();
+	process.start(importer, args);
+	if (!process.waitForStarted())
+	{
+		qCritical() << "Cannot start " << importer;
+		return false;
+	}
+	process.waitForFinished(-1);
+	printRow(scale, "import", "wall", QString::number(timer.elapsed() / 1000.0, 'f', 3),
+			"0", "-");
+
+	/* Skip the header and reuse the importer's own columns */
+	process.readLine();
+	while (process.canReadLine())
+	{
+		line = QString(process.readLine()).trimmed();
+		fields = line.split("\t");
+		if (fields.size() >= 4)
+			printRow(scale, "import", fields.at(0), fields.at(1), fields.at(2), fields.at(3));
+	}
+	if (process.exitStatus() != QProcess::NormalExit || process.exitCode() != 0)
+	{
+		qCritical() << "Import failed at scale " << scale;
+		return false;
+	}
+	return true;
+}
+
+
+/*
+ * Runs the queries that the viewer makes when contigs are opened: the
+ * contig record with its sequence, its reads, its SNP profile and the
+ * display sample of its reads
+ */
+static bool runQueries(const int scale)
+{
+	QString connectionName = "benchmark";
+	QList<int> idList;
+	QList<Contig *> contigList;
+	QList<Fragment *> sampleList;
+	FragmentList *fragList;
+	Contig *contig;
+	QTime timer;
+	qint64 numReads, numSampled;
+	int id, fetchTime, snpTime, sampleTime;
+
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getContigDBName());
+		QSqlQuery query(db);
+
+		if (!query.exec("select id from contig order by id"))
+		{
+			qCritical() << "Error fetching contig IDs. Reason: "
+				<< query.lastError().text();
+			db.close();
+			return false;
+		}
+		while (query.next())
+			idList.append(query.value(0).toInt());
+
+		timer.start();
+		foreach (id, idList)
+		{
+			contig = ContigList::fetchContig(query, id, true);
+			if (contig != NULL)
+				contigList.append(contig);
+		}
+		printQuery(scale, "contig_fetch", timer.elapsed(), contigList.size(), "contigs");
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+
+	fetchTime = 0;
+	snpTime = 0;
+	sampleTime = 0;
+	numReads = 0;
+	numSampled = 0;
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getFragDBName());
+		QSqlQuery query(db);
+
+		foreach (contig, contigList)
+		{
+			fragList = new FragmentList(contig);
+			timer.start();
+			if (!fragList->getFrags(query))
+			{
+				qCritical() << "Error fetching reads. Reason: "
+					<< query.lastError().text();
+				delete fragList;
+				break;
+			}
+			fetchTime += timer.elapsed();
+			numReads += fragList->getList().size();
+
+			timer.start();
+			contig->getSnps(SNP_THRESHOLD);
+			snpTime += timer.elapsed();
+
+			timer.start();
+			sampleList.clear();
+			fragList->sample(DISPLAY_BIN_SIZE, sampleList);
+			sampleTime += timer.elapsed();
+			numSampled += sampleList.size();
+			delete fragList;
+		}
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+
+	printQuery(scale, "fragment_fetch", fetchTime, numReads, "reads");
+	printQuery(scale, "snp_fetch", snpTime, contigList.size(), "contigs");
+	printQuery(scale, "display_sample", sampleTime, numSampled, "reads");
+	qDeleteAll(contigList);
+	return true;
+}
+
+
+/*
+ * Prints the result of one limit check
+ */
+static bool printCheck(const QString &name, const qint64 value, const bool ok)
+{
+	printRow(1, "check", name, "-", QString::number(value), ok? "ok": "FAILED");
+	return ok;
+}
+
+
+/*
+ * Checks that the values past the old 16-bit limits have been stored
+ * and read back intact
+ */
+static bool checkLimits(const DataGenerator &generator)
+{
+	QString connectionName = "benchmark";
+	FragmentList *fragList;
+	Contig *contig;
+	qint64 numContigs, maxContigId, totalSize, maxReadSize, maxFragRows;
+	qint64 maxSize, maxYPos, longReadSize;
+	bool ok;
+
+	ok = true;
+	contig = NULL;
+	numContigs = 0;
+	totalSize = 0;
+	maxReadSize = 0;
+	maxFragRows = 0;
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getContigDBName());
+		QSqlQuery query(db);
+
+		if (DB_EXEC(query, "select count(*), sum(size) from contig") && query.next())
+		{
+			numContigs = query.value(0).toLongLong();
+			totalSize = query.value(1).toLongLong();
+		}
+		if (DB_EXEC(query, "select maxReadSize, maxFragRows from contig where id = 1")
+				&& query.next())
+		{
+			maxReadSize = query.value(0).toLongLong();
+			maxFragRows = query.value(1).toLongLong();
+		}
+		contig = ContigList::fetchContig(query, 1, false);
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+
+	ok &= printCheck("contigs", numContigs,
+			numContigs == generator.getNumContigs() && numContigs > 65535);
+	ok &= printCheck("total_size", totalSize, totalSize > 0);
+	if (contig == NULL)
+		return printCheck("first_contig", 0, false);
+	ok &= printCheck("max_read_size", maxReadSize,
+			maxReadSize == generator.getLongReadLength());
+	ok &= printCheck("max_rows", maxFragRows, maxFragRows > generator.getStackDepth());
+
+	maxContigId = 0;
+	maxSize = 0;
+	maxYPos = -1;
+	longReadSize = 0;
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getFragDBName());
+		QSqlQuery query(db);
+
+		if (DB_EXEC(query, "select max(contig_id) from fragment") && query.next())
+			maxContigId = query.value(0).toLongLong();
+
+		/* Read back through the same code as the viewer */
+		fragList = new FragmentList(contig);
+		if (fragList->getFrags(query))
+		{
+			foreach (Fragment *frag, fragList->getList())
+			{
+				maxSize = qMax(maxSize, (qint64) frag->size);
+				maxYPos = qMax(maxYPos, (qint64) frag->yPos);
+				if (frag->size == generator.getLongReadLength())
+					longReadSize = frag->seq.size();
+			}
+		}
+		delete fragList;
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+	delete contig;
+
+	ok &= printCheck("max_contig_id", maxContigId, maxContigId == numContigs);
+	ok &= printCheck("read_size", maxSize, maxSize == generator.getLongReadLength());
+	ok &= printCheck("read_seq_size", longReadSize, longReadSize == maxSize);
+	ok &= printCheck("max_row", maxYPos, maxYPos >= generator.getStackDepth());
+	return ok;
+}
+
+
+int main(int argc, char *argv[])
+{
+	/* No windows are created, so no display is needed */
+	QApplication app(argc, argv, false);
+	QStringList args, scaleList, importOptions;
+	QString outDir, importer, arg, value, inputDir, projectDir;
+	DataGenerator generator;
+	QList<int> scales;
+	QTime timer;
+	bool ok, isCheckingLimits;
+	int i, scale, numContigs;
+
+	importer = QDir(app.applicationDirPath()).filePath("basejumper-import");
+	scaleList << "1" << "10" << "100";
+	numContigs = generator.getNumContigs();
+	isCheckingLimits = false;
+
+	args = app.arguments();
+	for (i = 1; i < args.size(); ++i)
+	{
+		arg = args.at(i);
+		if (arg == "--check-limits")
+		{
+			isCheckingLimits = true;
+			continue;
+		}
+		if (!arg.startsWith("--") || i + 1 >= args.size())
+		{
+			printUsage();
+			return 2;
+		}
+		value = args.at(++i);
+		ok = true;
+		if (arg == "--out")
+			outDir = value;
+		else if (arg == "--importer")
+			importer = value;
+		else if (arg == "--scales")
+			scaleList = value.split(",", QString::SkipEmptyParts);
+		else if (arg == "--contigs")
+			numContigs = value.toInt(&ok);
+		else if (arg == "--length")
+			generator.setContigLength(value.toInt(&ok));
+		else if (arg == "--read-length")
+			generator.setReadLength(value.toInt(&ok));
+		else if (arg == "--depth")
+			generator.setDepth(value.toInt(&ok));
+		else if (arg == "--chromosomes")
+			generator.setNumChromosomes(value.toInt(&ok));
+		else if (arg == "--snp-rate")
+			generator.setSnpRate(value.toDouble(&ok));
+		else if (arg == "--pad-rate")
+			generator.setPadRate(value.toDouble(&ok));
+		else if (arg == "--multimap-rate")
+			generator.setMultiMapRate(value.toDouble(&ok));
+		else if (arg == "--seed")
+			generator.setSeed(value.toUInt(&ok));
+		else
+			ok = false;
+		if (!ok)
+		{
+			printUsage();
+			return 2;
+		}
+	}
+	foreach (value, scaleList)
+	{
+		scale = value.toInt(&ok);
+		if (!ok || scale <= 0)
+		{
+			printUsage();
+			return 2;
+		}
+		scales.append(scale);
+	}
+	if (outDir.isEmpty() || numContigs <= 0)
+	{
+		printUsage();
+		return 2;
+	}
+
+	/* The limits data set replaces the scaled ones; the row limit of
+	 * the importer is lifted so that every stacked read gets a row */
+	if (isCheckingLimits)
+	{
+		scales.clear();
+		scales.append(1);
+		numContigs = LIMITS_NUM_CONTIGS;
+		generator.setContigLength(LIMITS_CONTIG_LENGTH);
+		generator.setReadLength(LIMITS_READ_LENGTH_SHORT);
+		generator.setDepth(1);
+		generator.setLongReadLength(LIMITS_READ_LENGTH);
+		generator.setStackDepth(LIMITS_STACK_DEPTH);
+		importOptions << "--max-rows" << "0";
+	}
+
+	QTextStream(stdout) << "scale\tkind\tname\tseconds\tamount\tunit\n";
+	foreach (scale, scales)
+	{
+		inputDir = QDir(outDir).filePath("scale" + QString::number(scale) + "/input");
+		projectDir = QDir(outDir).filePath("scale" + QString::number(scale) + "/project");
+
+		generator.setNumContigs(numContigs * scale);
+		timer.start();
+		if (!generator.write(inputDir))
+			return 1;
+		printRow(scale, "generate", "files", QString::number(timer.elapsed() / 1000.0, 'f', 3),
+				QString::number(generator.getNumContigs()), "contigs");
+
+		if (!runImport(scale, importer, inputDir, projectDir,
+				QDir(inputDir).filePath(generator.getAceFileName()),
+				importOptions))
+			return 1;
+		printRow(scale, "rss", "import_peak", "-",
+				QString::number(getPeakRss(true)), "KB");
+
+		Database::setDirectory(projectDir);
+		if (isCheckingLimits)
+			return checkLimits(generator)? 0: 1;
+		if (!runQueries(scale))
+			return 1;
+		printRow(scale, "rss", "query_peak", "-",
+				QString::number(getPeakRss(false)), "KB");
+	}
+	return 0;
+}
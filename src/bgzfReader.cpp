@@ -0,0 +1,367 @@
+
+#include "bgzfReader.h"
+#include <QtDebug>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <string.h>
+#include <zlib.h>
+
+#define	BGZF_HEADER_SIZE	12
+#define	BGZF_FOOTER_SIZE	8
+#define	BGZF_MAX_BLOCK_SIZE	65536
+#define	PENDING_BLOCKS_PER_THREAD	4	/* Blocks read ahead for each thread */
+
+
+/**
+ * Constructor
+ */
+BgzfReader::BgzfReader()
+{
+	blockOffset = 0;
+	blockAddress = 0;
+	nextBlockAddress = 0;
+	readAheadAddress = 0;
+	maxPendingBlocks = 0;
+	error = false;
+}
+
+
+/**
+ * Destructor
+ */
+BgzfReader::~BgzfReader()
+{
+	close();
+}
+
+
+/**
+ * Opens the given BGZF (blocked gzip) file
+ *
+ * @param path : Path of the file
+ * @return Returns true on success and false on failure
+ */
+bool BgzfReader::open(const QString &path)
+{
+	close();
+	file.setFileName(path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qCritical() << "Cannot read file " << path << ". Reason: "
+			<< file.errorString();
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Closes the file
+ */
+void BgzfReader::close()
+{
+	clearPendingBlocks();
+	if (file.isOpen())
+		file.close();
+	block.clear();
+	blockOffset = 0;
+	blockAddress = 0;
+	nextBlockAddress = 0;
+	error = false;
+}
+
+
+/**
+ * Moves to the given virtual offset. The upper 48 bits of the offset
+ * are the file offset of a block and the lower 16 bits are the offset
+ * within the uncompressed block.
+ *
+ * @param virtualOffset : Virtual offset
+ * @return Returns true on success and false on failure
+ */
+bool BgzfReader::seek(const quint64 virtualOffset)
+{
+	qint64 address;
+	int offset;
+
+	address = (qint64) (virtualOffset >> 16);
+	offset = (int) (virtualOffset & 0xFFFF);
+	if (!file.seek(address))
+		return false;
+	nextBlockAddress = address;
+	block.clear();
+	blockOffset = 0;
+	if (!readBlock() && offset > 0)
+		return false;
+	if (offset > block.size())
+		return false;
+	blockOffset = offset;
+	return true;
+}
+
+
+/**
+ * Reads the next line, without the line terminator
+ *
+ * @param line : Set to the line that was read
+ * @return Returns false if there are no more lines
+ */
+bool BgzfReader::readLine(QByteArray &line)
+{
+	const char *data, *newLine;
+	int length;
+
+	line.clear();
+	forever
+	{
+		if (blockOffset >= block.size() && !readBlock())
+			return !line.isEmpty();
+
+		data = block.constData() + blockOffset;
+		length = block.size() - blockOffset;
+		newLine = (const char *) memchr(data, '\n', length);
+		if (newLine == NULL)
+		{
+			line.append(data, length);
+			blockOffset = block.size();
+			continue;
+		}
+		line.append(data, newLine - data);
+		blockOffset += (newLine - data) + 1;
+		if (line.endsWith('\r'))
+			line.chop(1);
+		return true;
+	}
+}
+
+
+/**
+ * Reads up to the given number of bytes into the given buffer
+ *
+ * @return Returns the number of bytes read
+ */
+qint64 BgzfReader::read(char *data, const qint64 maxSize)
+{
+	qint64 numRead;
+	int length;
+
+	numRead = 0;
+	while (numRead < maxSize)
+	{
+		if (blockOffset >= block.size() && !readBlock())
+			break;
+		length = (int) qMin((qint64) (block.size() - blockOffset), maxSize - numRead);
+		memcpy(data + numRead, block.constData() + blockOffset, length);
+		blockOffset += length;
+		numRead += length;
+	}
+	return numRead;
+}
+
+
+/**
+ * Returns whether all the data has been read
+ */
+bool BgzfReader::atEnd()
+{
+	while (blockOffset >= block.size())
+	{
+		if (!readBlock())
+			return true;
+	}
+	return false;
+}
+
+
+/**
+ * Sets whether the blocks ahead of the current one are uncompressed in
+ * parallel on the global thread pool. This suits files that are read
+ * from start to end.
+ *
+ * @param parallel : Whether blocks are read ahead
+ */
+void BgzfReader::setParallel(const bool parallel)
+{
+	clearPendingBlocks();
+	maxPendingBlocks = parallel?
+		PENDING_BLOCKS_PER_THREAD * qMax(1, QThreadPool::globalInstance()->maxThreadCount()):
+		0;
+}
+
+
+/*
+ * Reads and uncompresses the block at nextBlockAddress. Returns false
+ * at the end of the file or on error.
+ */
+bool BgzfReader::readBlock()
+{
+	QFuture<QByteArray> future;
+	qint64 size;
+
+	block.clear();
+	blockOffset = 0;
+	if (maxPendingBlocks == 0)
+	{
+		if (!readRawBlock(nextBlockAddress, compressedBlock, size))
+			return false;
+		block = inflateBlock(compressedBlock);
+		blockAddress = nextBlockAddress;
+		nextBlockAddress += size;
+	}
+	else
+	{
+		/* Read the compressed blocks ahead and queue them for
+		 * uncompression, restarting after a seek */
+		if (!pendingAddresses.isEmpty()
+				&& pendingAddresses.head() != nextBlockAddress)
+			clearPendingBlocks();
+		if (pendingAddresses.isEmpty())
+			readAheadAddress = nextBlockAddress;
+		while (!error && pendingBlocks.size() < maxPendingBlocks
+				&& readRawBlock(readAheadAddress, compressedBlock, size))
+		{
+			pendingBlocks.enqueue(QtConcurrent::run(inflateBlock, compressedBlock));
+			pendingAddresses.enqueue(readAheadAddress);
+			readAheadAddress += size;
+		}
+		if (pendingBlocks.isEmpty())
+			return false;
+		future = pendingBlocks.dequeue();
+		blockAddress = pendingAddresses.dequeue();
+		nextBlockAddress = pendingAddresses.isEmpty()?
+			readAheadAddress: pendingAddresses.head();
+		block = future.result();
+	}
+
+	if (block.isNull())
+	{
+		qCritical() << "Error uncompressing BGZF block in " << file.fileName();
+		error = true;
+		return false;
+	}
+	return true;
+}
+
+
+/*
+ * Reads the compressed block at the given file offset, including its
+ * header and footer. Returns false at the end of the file or on error;
+ * a block that is cut short or malformed sets the error flag.
+ */
+bool BgzfReader::readRawBlock(const qint64 address, QByteArray &raw, qint64 &size)
+{
+	uchar header[BGZF_HEADER_SIZE];
+	int extraLength, blockSize, i, subfieldLength;
+	qint64 numRead;
+	const char *extra;
+
+	if (file.pos() != address && !file.seek(address))
+	{
+		error = true;
+		return false;
+	}
+	numRead = file.read((char *) header, BGZF_HEADER_SIZE);
+	if (numRead != BGZF_HEADER_SIZE)
+	{
+		if (numRead != 0)
+		{
+			qCritical() << "Unexpected end of BGZF file " << file.fileName();
+			error = true;
+		}
+		return false;
+	}
+
+	/* gzip member with the FEXTRA flag */
+	if (header[0] != 31 || header[1] != 139 || header[2] != 8
+			|| (header[3] & 4) == 0)
+	{
+		qCritical() << "Not a BGZF file: " << file.fileName();
+		error = true;
+		return false;
+	}
+
+	/* Find the 'BC' subfield, which holds the size of the block */
+	extraLength = header[10] | (header[11] << 8);
+	raw = QByteArray((const char *) header, BGZF_HEADER_SIZE) + file.read(extraLength);
+	if (raw.size() != BGZF_HEADER_SIZE + extraLength)
+	{
+		qCritical() << "Unexpected end of BGZF file " << file.fileName();
+		error = true;
+		return false;
+	}
+	extra = raw.constData() + BGZF_HEADER_SIZE;
+	blockSize = -1;
+	for (i = 0; i + 4 <= extraLength; i += 4 + subfieldLength)
+	{
+		subfieldLength = (uchar) extra[i + 2] | ((uchar) extra[i + 3] << 8);
+		if (extra[i] == 'B' && extra[i + 1] == 'C' && subfieldLength == 2)
+			blockSize = ((uchar) extra[i + 4] | ((uchar) extra[i + 5] << 8)) + 1;
+	}
+	if (blockSize < BGZF_HEADER_SIZE + extraLength + BGZF_FOOTER_SIZE)
+	{
+		qCritical() << "Invalid BGZF block in " << file.fileName();
+		error = true;
+		return false;
+	}
+
+	raw += file.read(blockSize - raw.size());
+	if (raw.size() != blockSize)
+	{
+		qCritical() << "Unexpected end of BGZF file " << file.fileName();
+		error = true;
+		return false;
+	}
+	size = blockSize;
+	return true;
+}
+
+
+/*
+ * Uncompresses the given block. Runs on the thread pool when blocks are
+ * read in parallel.
+ *
+ * @return The uncompressed data, or a null array on error
+ */
+QByteArray BgzfReader::inflateBlock(const QByteArray raw)
+{
+	QByteArray data;
+	z_stream stream;
+	const uchar *footer;
+	quint32 uncompressedSize;
+	int extraLength, result;
+
+	extraLength = (uchar) raw.at(10) | ((uchar) raw.at(11) << 8);
+	footer = (const uchar *) raw.constData() + raw.size() - BGZF_FOOTER_SIZE;
+	uncompressedSize = footer[4] | (footer[5] << 8) | (footer[6] << 16)
+		| ((quint32) footer[7] << 24);
+	if (uncompressedSize > BGZF_MAX_BLOCK_SIZE)
+		return QByteArray();
+	data = QByteArray("");
+	if (uncompressedSize == 0)
+		return data;
+
+	/* Inflate the raw deflate data */
+	data.resize(uncompressedSize);
+	memset(&stream, 0, sizeof(stream));
+	if (inflateInit2(&stream, -15) != Z_OK)
+		return QByteArray();
+	stream.next_in = (Bytef *) raw.constData() + BGZF_HEADER_SIZE + extraLength;
+	stream.avail_in = raw.size() - BGZF_HEADER_SIZE - extraLength - BGZF_FOOTER_SIZE;
+	stream.next_out = (Bytef *) data.data();
+	stream.avail_out = uncompressedSize;
+	result = inflate(&stream, Z_FINISH);
+	inflateEnd(&stream);
+	if (result != Z_STREAM_END)
+		return QByteArray();
+	return data;
+}
+
+
+/*
+ * Drops the blocks that have been read ahead
+ */
+void BgzfReader::clearPendingBlocks()
+{
+	pendingBlocks.clear();
+	pendingAddresses.clear();
+}
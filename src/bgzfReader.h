@@ -0,0 +1,60 @@
+#ifndef BGZFREADER_H_
+#define BGZFREADER_H_
+
+#include <QFile>
+#include <QByteArray>
+#include <QQueue>
+#include <QFuture>
+
+class BgzfReader
+{
+public:
+	BgzfReader();
+	~BgzfReader();
+	bool open(const QString &);
+	void close();
+	bool seek(const quint64);
+	bool readLine(QByteArray &);
+	qint64 read(char *, const qint64);
+	bool atEnd();
+	void setParallel(const bool);
+
+	/** Returns the virtual offset of the next byte to be read */
+	inline quint64 tell() const
+	{
+		if (blockOffset >= block.size())
+			return ((quint64) nextBlockAddress) << 16;
+		return (((quint64) blockAddress) << 16) | ((quint64) blockOffset);
+	};
+
+	/** Returns the file offset of the block being read, which tells
+	 * how much of the compressed file has been consumed */
+	inline qint64 getBlockAddress() const { return blockAddress; };
+
+	/** Returns whether reading stopped on a truncated or corrupt block
+	 * rather than at the end of the file */
+	inline bool hasError() const { return error; };
+
+	/** Returns whether the file is open */
+	inline bool isOpen() const { return file.isOpen(); };
+
+private:
+	QFile file;
+	QByteArray compressedBlock;	/* Buffer for the compressed block */
+	QByteArray block;			/* Uncompressed data of the current block */
+	int blockOffset;			/* Offset of the next byte within the block */
+	qint64 blockAddress;		/* File offset of the current block */
+	qint64 nextBlockAddress;	/* File offset of the next block */
+	QQueue<QFuture<QByteArray> > pendingBlocks;	/* Blocks being uncompressed, in file order */
+	QQueue<qint64> pendingAddresses;	/* File offset of each pending block */
+	qint64 readAheadAddress;	/* File offset of the next block to be read ahead */
+	int maxPendingBlocks;		/* 0 if blocks are not read ahead */
+	bool error;					/* Whether a truncated or corrupt block was found */
+
+	bool readBlock();
+	bool readRawBlock(const qint64, QByteArray &, qint64 &);
+	void clearPendingBlocks();
+	static QByteArray inflateBlock(const QByteArray);
+};
+
+#endif /* BGZFREADER_H_ */
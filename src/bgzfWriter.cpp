@@ -0,0 +1,245 @@
+#include "bgzfWriter.h"
+#include <QtDebug>
+#include <QThreadPool>
+#include <QtConcurrentRun>
+#include <string.h>
+#include <zlib.h>
+
+#define	BGZF_HEADER_SIZE		18
+#define	BGZF_FOOTER_SIZE		8
+#define	BGZF_MAX_BLOCK_SIZE		65536
+#define	BGZF_BLOCK_DATA_SIZE	0xff00	/* Leaves room for incompressible data */
+#define	COMPRESSION_LEVEL		6
+#define	PENDING_BLOCKS_PER_THREAD	4	/* Blocks queued for each compression thread */
+
+
+/**
+ * Constructor
+ */
+BgzfWriter::BgzfWriter()
+{
+	blockNumber = 0;
+	address = 0;
+	maxPendingBlocks = PENDING_BLOCKS_PER_THREAD
+		* qMax(1, QThreadPool::globalInstance()->maxThreadCount());
+	isError = false;
+}
+
+
+/**
+ * Destructor
+ */
+BgzfWriter::~BgzfWriter()
+{
+	close();
+}
+
+
+/**
+ * Creates the given BGZF file
+ *
+ * @param path : Path of the file
+ * @return Returns true on success and false on failure
+ */
+bool BgzfWriter::open(const QString &path)
+{
+	close();
+	file.setFileName(path);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qCritical() << "Cannot write file " << path << ". Reason: "
+			<< file.errorString();
+		return false;
+	}
+	block.clear();
+	block.reserve(BGZF_BLOCK_DATA_SIZE);
+	blockNumber = 0;
+	address = 0;
+	blockAddresses.clear();
+	isError = false;
+	return true;
+}
+
+
+/**
+ * Appends the given bytes
+ *
+ * @param data : Bytes to be written
+ * @param size : Number of bytes
+ * @return Returns false if an earlier block could not be written
+ */
+bool BgzfWriter::write(const char *data, const int size)
+{
+	int length, written;
+
+	written = 0;
+	while (written < size)
+	{
+		length = qMin(size - written, BGZF_BLOCK_DATA_SIZE - block.size());
+		block.append(data + written, length);
+		written += length;
+		if (block.size() >= BGZF_BLOCK_DATA_SIZE)
+			submitBlock();
+	}
+	return !isError;
+}
+
+
+/**
+ * Writes the remaining data and the end-of-file marker and closes the
+ * file
+ *
+ * @return Returns true if all the data was written
+ */
+bool BgzfWriter::close()
+{
+	if (!file.isOpen())
+		return !isError;
+
+	if (!block.isEmpty())
+		submitBlock();
+	while (!pendingBlocks.isEmpty())
+		writePendingBlock();
+
+	/* The end-of-file marker is an empty block; logical offsets at the
+	 * end of the data resolve to it */
+	writeBlock(compressBlock(QByteArray()));
+	file.close();
+	return !isError;
+}
+
+
+/**
+ * Returns the virtual offset of the given logical offset. The upper 48
+ * bits of a virtual offset are the file offset of a block and the lower
+ * 16 bits are the offset within the uncompressed block. Valid once the
+ * file has been closed.
+ *
+ * @param offset : Logical offset returned by tell()
+ */
+quint64 BgzfWriter::getVirtualOffset(const quint64 offset) const
+{
+	qint64 n;
+
+	n = (qint64) (offset >> 16);
+	if (n >= blockAddresses.size())
+		return ((quint64) address) << 16;
+	return (((quint64) blockAddresses.at(n)) << 16) | (offset & 0xFFFF);
+}
+
+
+/*
+ * Queues the current block for compression, writing the oldest queued
+ * block first if the queue is full
+ */
+void BgzfWriter::submitBlock()
+{
+	while (pendingBlocks.size() >= maxPendingBlocks)
+		writePendingBlock();
+	pendingBlocks.enqueue(QtConcurrent::run(compressBlock, block));
+	block.clear();
+	block.reserve(BGZF_BLOCK_DATA_SIZE);
+	++blockNumber;
+}
+
+
+/*
+ * Waits for the oldest queued block to be compressed and writes it
+ */
+void BgzfWriter::writePendingBlock()
+{
+	QFuture<QByteArray> future;
+
+	future = pendingBlocks.dequeue();
+	future.waitForFinished();
+	writeBlock(future.result());
+}
+
+
+/*
+ * Writes the given compressed block and records its file offset
+ */
+void BgzfWriter::writeBlock(const QByteArray &compressed)
+{
+	blockAddresses.append(address);
+	if (isError)
+		return;
+	if (compressed.isEmpty() || file.write(compressed) != compressed.size())
+	{
+		qCritical() << "Error writing BGZF block to " << file.fileName()
+			<< ". Reason: " << file.errorString();
+		isError = true;
+		return;
+	}
+	address += compressed.size();
+}
+
+
+/*
+ * Compresses the given data into a BGZF block. Runs on the thread pool.
+ *
+ * @return The block, or an empty array on error
+ */
+QByteArray BgzfWriter::compressBlock(const QByteArray data)
+{
+	QByteArray compressed;
+	z_stream stream;
+	uchar *p;
+	int blockSize, level;
+	uLong crc;
+
+	/* Incompressible data is stored at level 0, which always fits */
+	blockSize = -1;
+	for (level = COMPRESSION_LEVEL; level >= 0; level -= COMPRESSION_LEVEL)
+	{
+		compressed.resize(BGZF_MAX_BLOCK_SIZE);
+		memset(&stream, 0, sizeof(stream));
+		if (deflateInit2(&stream, level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+			return QByteArray();
+		stream.next_in = (Bytef *) data.constData();
+		stream.avail_in = data.size();
+		stream.next_out = (Bytef *) compressed.data() + BGZF_HEADER_SIZE;
+		stream.avail_out = BGZF_MAX_BLOCK_SIZE - BGZF_HEADER_SIZE - BGZF_FOOTER_SIZE;
+		if (deflate(&stream, Z_FINISH) == Z_STREAM_END)
+		{
+			blockSize = BGZF_HEADER_SIZE + stream.total_out + BGZF_FOOTER_SIZE;
+			deflateEnd(&stream);
+			break;
+		}
+		deflateEnd(&stream);
+		if (level == 0)
+			return QByteArray();
+	}
+	compressed.resize(blockSize);
+
+	/* gzip header with the 'BC' extra subfield holding the block size */
+	p = (uchar *) compressed.data();
+	p[0] = 31;
+	p[1] = 139;
+	p[2] = 8;
+	p[3] = 4;
+	p[4] = p[5] = p[6] = p[7] = 0;
+	p[8] = 0;
+	p[9] = 255;
+	p[10] = 6;
+	p[11] = 0;
+	p[12] = 'B';
+	p[13] = 'C';
+	p[14] = 2;
+	p[15] = 0;
+	p[16] = (blockSize - 1) & 0xFF;
+	p[17] = ((blockSize - 1) >> 8) & 0xFF;
+
+	/* Footer with the CRC and the uncompressed size */
+	crc = crc32(crc32(0L, Z_NULL, 0), (const Bytef *) data.constData(), data.size());
+	p += blockSize - BGZF_FOOTER_SIZE;
+	p[0] = crc & 0xFF;
+	p[1] = (crc >> 8) & 0xFF;
+	p[2] = (crc >> 16) & 0xFF;
+	p[3] = (crc >> 24) & 0xFF;
+	p[4] = data.size() & 0xFF;
+	p[5] = (data.size() >> 8) & 0xFF;
+	p[6] = (data.size() >> 16) & 0xFF;
+	p[7] = (data.size() >> 24) & 0xFF;
+	return compressed;
+}
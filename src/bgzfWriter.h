@@ -0,0 +1,60 @@
+#ifndef BGZFWRITER_H_
+#define BGZFWRITER_H_
+
+#include <QFile>
+#include <QByteArray>
+#include <QQueue>
+#include <QVector>
+#include <QFuture>
+
+/*
+ * Writes a BGZF (blocked gzip) file. Full blocks are compressed on the
+ * global thread pool and written in order as they complete.
+ *
+ * Because blocks are compressed asynchronously, tell() returns a
+ * logical offset made of the block number and the offset within the
+ * block. Once the file is closed, getVirtualOffset() turns it into the
+ * virtual offset used by BAM indexes.
+ */
+class BgzfWriter
+{
+public:
+	BgzfWriter();
+	~BgzfWriter();
+	bool open(const QString &);
+	bool write(const char *, const int);
+	bool close();
+	quint64 getVirtualOffset(const quint64) const;
+
+	/** Appends the given bytes */
+	inline bool write(const QByteArray &bytes)
+	{
+		return write(bytes.constData(), bytes.size());
+	};
+
+	/** Returns the logical offset of the next byte to be written */
+	inline quint64 tell() const
+	{
+		return (((quint64) blockNumber) << 16) | ((quint64) block.size());
+	};
+
+	/** Returns whether a block could not be compressed or written */
+	inline bool hasError() const { return isError; };
+
+private:
+	QFile file;
+	QByteArray block;					/* Uncompressed data of the current block */
+	qint64 blockNumber;					/* Number of the current block */
+	qint64 address;						/* File offset of the next block to be written */
+	QQueue<QFuture<QByteArray> > pendingBlocks;	/* Blocks being compressed, in file order */
+	QVector<qint64> blockAddresses;		/* File offset of each written block */
+	int maxPendingBlocks;
+	bool isError;
+
+	void submitBlock();
+	void writeBlock(const QByteArray &);
+	void writePendingBlock();
+	static QByteArray compressBlock(const QByteArray);
+};
+
+#endif /* BGZFWRITER_H_ */
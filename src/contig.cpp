@@ -4,13 +4,16 @@
 #include <QSqlError>
 #include <QtDebug>
 #include <QVariant>
+#include <QtAlgorithms>
+#include "limits.h"
 #include "search.h"
 #include "gene.h"
 #include "database.h"
 
 int Contig::numContigs = 0;
+int Contig::numAvailableContigs = 0;
 int Contig::currentId = 0;
-int Contig::totalSize = 0;
+qint64 Contig::totalSize = Q_INT64_C(0);
 int Contig::startPos = 0;
 int Contig::endPos = 0;
 int Contig::midPos = 0;
@@ -32,10 +35,12 @@ Contig::Contig()
 	fileId = 0;
 	coverage = 0.0;
 	maxFragRows = 0;
+	maxReadSize = 0;
 	maxGeneRows = 0;
 	zoomLevels = 0;
 	fragList = new FragmentList(this);
 	file = NULL;
+	isSnpProfileLoaded = false;
 }
 
 
@@ -84,6 +89,7 @@ void Contig::reset()
 	readEndIndex = 0;
 	order = 0;
 	maxFragRows = 0;
+	maxReadSize = 0;
 	maxGeneRows = 0;
 	zoomLevels = 0;
 	file = NULL;
@@ -106,7 +112,7 @@ int Contig::getSize(const int id)
 		str = "select size "
 				" from contig "
 				" where id = " + QString::number(id);
-		if (!query.exec(str))
+		if (!DB_EXEC(query, str))
 		{
 			qDebug() << "Error fetching contig from DB.\nReason: "
 				<< query.lastError().text();
@@ -141,7 +147,7 @@ int Contig::getSeq(const int id, QString &seq)
 		queryStr = "select seq "
 				" from contigSeq "
 				" where contigId = " + QString::number(id);
-		if (!query.exec(queryStr))
+		if (!DB_EXEC(query, queryStr))
 		{
 			qDebug() << "Error fetching contig from DB in** "
 				<< "Contig"
@@ -182,7 +188,7 @@ void Contig::getSeq()
 		queryStr = "select seq "
 				" from contigSeq "
 				" where contigId = " + QString::number(id);
-		if (!query.exec(queryStr))
+		if (!DB_EXEC(query, queryStr))
 		{
 			qCritical() << "Error fetching contig from DB in "
 				<< this->metaObject()->className()
@@ -233,15 +239,15 @@ void Contig::getAnnotation()
 				connectionName,
 				Database::getAnnotationDBName());
 		QSqlQuery query(db);
-		QString str, alias;
+		QString str, alias, indexedFile;
 		int id, order, type;
 		AnnotationList *annotList;
 
 		resetAnnotationLists();
 
-		str = "select id, type, annotOrder, alias "
+		str = "select id, type, annotOrder, alias, indexedFile "
 				" from annotationType ";
-		if (!query.exec(str))
+		if (!DB_EXEC(query, str))
 		{
 			QMessageBox::critical(
 					QApplication::activeWindow(),
@@ -257,7 +263,14 @@ void Contig::getAnnotation()
 			type = query.value(1).toInt();
 			order = query.value(2).toInt();
 			alias = query.value(3).toString();
-			annotList = new AnnotationList(id, this, (enum AnnotationList::Type) type, order, alias);
+			indexedFile = query.value(4).toString();
+			annotList = new AnnotationList(
+					id,
+					this,
+					(enum AnnotationList::Type) type,
+					order,
+					alias,
+					indexedFile);
 			annotationLists.append(annotList);
 		}
 		db.close();
@@ -268,8 +281,70 @@ void Contig::getAnnotation()
 
 /**
  * 	Fetches SNP positions
+ *
+ * 	The SNP positions and variation percentages of the contig are loaded
+ * 	from the DB only once. Later calls (e.g. when the threshold changes)
+ * 	only filter the in-memory profile into the SNP bitmap.
+ *
+ * 	@param threshold : Minimum variation percent of the SNPs to be shown
  */
 void Contig::getSnps(const int threshold)
+{
+	int i;
+
+	if (!isSnpProfileLoaded && !getSnpProfile())
+		return;
+
+	/* Clear the bitmap before setting new bits */
+	snpBitmap.fill(false, size + 1);
+	snpThresholdPosList.clear();
+	for (i = 0; i < snpPosList.size(); ++i)
+	{
+		if (snpVariationList.at(i) >= threshold
+				&& snpPosList.at(i) >= 0
+				&& snpPosList.at(i) <= size)
+		{
+			snpBitmap.setBit(snpPosList.at(i));
+			snpThresholdPosList.append(snpPosList.at(i));
+		}
+	}
+	snpThresholdPosList.squeeze();
+
+	/* Reads supporting SNPs are always part of the display sample */
+	fragList->invalidateDisplayList();
+}
+
+
+/**
+ * Returns the range of indexes in snpThresholdPosList of the SNPs that lie
+ * within the given positions, so that a window can be enumerated in time
+ * proportional to the number of SNPs in it
+ *
+ * @param start : Start position (inclusive)
+ * @param end : End position (inclusive)
+ * @param first : Set to the index of the first SNP in the range
+ * @param last : Set to one past the index of the last SNP in the range
+ */
+void Contig::getSnpIndexRange(
+		const int start,
+		const int end,
+		int &first,
+		int &last) const
+{
+	first = qLowerBound(snpThresholdPosList.constBegin(),
+			snpThresholdPosList.constEnd(), start)
+		- snpThresholdPosList.constBegin();
+	last = qUpperBound(snpThresholdPosList.constBegin(),
+			snpThresholdPosList.constEnd(), end)
+		- snpThresholdPosList.constBegin();
+}
+
+
+/*
+ * Fetches the positions and variation percentages of all the SNPs of
+ * this contig, sorted by position
+ */
+bool Contig::getSnpProfile()
 {
 	QString connectionName = QString(this->metaObject()->className());
 	{
@@ -280,11 +355,11 @@ void Contig::getSnps(const int threshold)
 		QSqlQuery query(db);
 		QString str;
 
-		str = " select pos "
+		str = " select pos, variationPercent "
 				" from snp_pos "
 				" where contig_id = " + QString::number(id) +
-				" and variationPercent >= " + QString::number(threshold);
-		if (!query.exec(str))
+				" order by pos asc ";
+		if (!DB_EXEC(query, str))
 		{
 			QMessageBox::critical(
 				QApplication::activeWindow(),
@@ -292,21 +367,184 @@ void Contig::getSnps(const int threshold)
 				tr("Error fetching SNP positions from DB.\nReason: "
 						+ query.lastError().text().toAscii()));
 			db.close();
-			return;
+			return false;
 		}
-		snpPosHash.clear(); // clear the hash before inserting new data
+		snpPosList.clear();
+		snpVariationList.clear();
 		while (query.next())
-			snpPosHash.insert(query.value(0).toInt(), 1);
+		{
+			snpPosList.append(query.value(0).toInt());
+			snpVariationList.append((quint8) query.value(1).toInt());
+		}
+		snpPosList.squeeze();
+		snpVariationList.squeeze();
+		isSnpProfileLoaded = true;
 		db.close();
 	}
 	QSqlDatabase::removeDatabase(connectionName);
+	return true;
 }
 
 
+/**
+ * Empties the SNP bitmap as well as the in-memory SNP profile
+ */
+void Contig::resetSnpProfile()
+{
+	resetSnps();
+	snpPosList.clear();
+	snpVariationList.clear();
+	isSnpProfileLoaded = false;
+}
 
 
+/**
+ * Returns the position of the first SNP whose variation percent is at
+ * least the given threshold
+ *
+ * @param threshold : Minimum variation percent
+ *
+ * @return Position of the SNP, or -1 if there is no such SNP
+ */
+int Contig::getFirstSnp(const int threshold)
+{
+	return getNextSnp(INT_MIN, threshold);
+}
 
 
+/**
+ * Returns the position of the last SNP whose variation percent is at
+ * least the given threshold
+ *
+ * @param threshold : Minimum variation percent
+ *
+ * @return Position of the SNP, or -1 if there is no such SNP
+ */
+int Contig::getLastSnp(const int threshold)
+{
+	return getPrevSnp(INT_MAX, threshold);
+}
 
 
+/**
+ * Returns the position of the closest SNP after the given position
+ * whose variation percent is at least the given threshold
+ *
+ * @param pos : Position after which to look
+ * @param threshold : Minimum variation percent
+ *
+ * @return Position of the SNP, or -1 if there is no such SNP
+ */
+int Contig::getNextSnp(const int pos, const int threshold)
+{
+	int i;
+
+	if (!isSnpProfileLoaded && !getSnpProfile())
+		return -1;
 
+	i = qUpperBound(snpPosList.constBegin(), snpPosList.constEnd(), pos)
+		- snpPosList.constBegin();
+	for (; i < snpPosList.size(); ++i)
+	{
+		if (snpVariationList.at(i) >= threshold)
+			return snpPosList.at(i);
+	}
+	return -1;
+}
+
+
+/**
+ * Returns the position of the closest SNP before the given position
+ * whose variation percent is at least the given threshold
+ *
+ * @param pos : Position before which to look
+ * @param threshold : Minimum variation percent
+ *
+ * @return Position of the SNP, or -1 if there is no such SNP
+ */
+int Contig::getPrevSnp(const int pos, const int threshold)
+{
+	int i;
+
+	if (!isSnpProfileLoaded && !getSnpProfile())
+		return -1;
+
+	i = qLowerBound(snpPosList.constBegin(), snpPosList.constEnd(), pos)
+		- snpPosList.constBegin();
+	for (--i; i >= 0; --i)
+	{
+		if (snpVariationList.at(i) >= threshold)
+			return snpPosList.at(i);
+	}
+	return -1;
+}
+
+
+/**
+ * Returns an approximate number of bytes used by the sequence, fragments,
+ * SNPs and annotations held by this contig, and the share of the
+ * fragments, the sequence and the annotations. The fragments are only
+ * walked once.
+ *
+ * @param fragBytes : Receives the bytes used by fragments
+ * @param seqBytes : Receives the bytes used by the sequence
+ * @param annotBytes : Receives the bytes used by annotations
+ * @return Bytes used by all the data of this contig
+ */
+qint64 Contig::getMemoryUsage(qint64 &fragBytes, qint64 &seqBytes, qint64 &annotBytes)
+{
+	qint64 bytes;
+
+	fragBytes = getFragMemoryUsage();
+	seqBytes = getSeqMemoryUsage();
+	annotBytes = getAnnotationMemoryUsage();
+	bytes = sizeof(Contig) + name.capacity();
+	bytes += seqBytes + fragBytes + annotBytes;
+	bytes += snpBitmap.size() / 8 + snpThresholdPosList.capacity() * sizeof(int);
+	bytes += snpPosList.capacity() * sizeof(int) + snpVariationList.capacity();
+	bytes += coverageProfile.getMemoryUsage();
+	bytes += overflowProfile.getMemoryUsage();
+	bytes += padIndex.getMemoryUsage();
+	return bytes;
+}
+
+
+/**
+ * Returns an approximate number of bytes used by the fragments held by
+ * this contig
+ */
+qint64 Contig::getFragMemoryUsage()
+{
+	qint64 bytes = 0;
+	Fragment *frag;
+
+	foreach (frag, fragList->getList())
+		bytes += sizeof(Fragment) + frag->seq.capacity() + frag->name.capacity();
+	return bytes;
+}
+
+
+/**
+ * Returns an approximate number of bytes used by the annotations held by
+ * this contig
+ */
+qint64 Contig::getAnnotationMemoryUsage()
+{
+	qint64 bytes = 0;
+	AnnotationList *annotList;
+	Annotation *annot;
+
+	foreach (annotList, annotationLists)
+	{
+		foreach (annot, annotList->getList())
+		{
+			if (annotList->getType() == AnnotationList::Gene)
+				bytes += sizeof(Gene)
+					+ ((Gene *) annot)->getSubstructures()->size() * sizeof(GeneStructure);
+			else
+				bytes += sizeof(Annotation);
+			bytes += annot->name.size() * sizeof(QChar);
+		}
+	}
+	return bytes;
+}
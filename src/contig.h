@@ -5,9 +5,13 @@
 #include <QObject>
 #include <QMap>
 #include <QHash>
+#include <QVector>
+#include <QBitArray>
 #include "annotationList.h"
 #include "fragmentList.h"
 #include "file.h"
+#include "coverageProfile.h"
+#include "padIndex.h"
 
 
 class Contig : public QObject
@@ -19,10 +23,22 @@ public:
 	~Contig();
 	void getAnnotation();
 	void getSnps(const int);
+	void resetSnpProfile();
+	int getFirstSnp(const int);
+	int getLastSnp(const int);
+	int getNextSnp(const int, const int);
+	int getPrevSnp(const int, const int);
+	void getSnpIndexRange(const int, const int, int &, int &) const;
 	void resetFrags();
 	void resetAnnotationLists();
 	static int getSize(const int);
 	static int getSeq(const int, QString &);
+	qint64 getMemoryUsage(qint64 &, qint64 &, qint64 &);
+	qint64 getFragMemoryUsage();
+	qint64 getAnnotationMemoryUsage();
+
+	/** Returns an approximate number of bytes used by the sequence */
+	inline qint64 getSeqMemoryUsage() const { return seq.capacity(); };
 
 	inline void setName(const QByteArray &name) { this->name = name; };
 	inline QByteArray & getName() { return name; };
@@ -39,11 +55,17 @@ public:
 	inline static int getNumContigs() { return numContigs; };
 	inline static void setNumContigs(const int n) { numContigs = n; };
 
+	/** Returns the number of contigs that can be browsed. During an
+	 * import these are the contigs whose reads have been committed, which
+	 * may be fewer than the parsed contigs. */
+	inline static int getNumAvailableContigs() { return numAvailableContigs; };
+	inline static void setNumAvailableContigs(const int n) { numAvailableContigs = n; };
+
 	inline static int getCurrentId() { return currentId; };
 	inline static void setCurrentId(const int id) { currentId = id; };
 
-	inline static void setTotalSize(const int size) { totalSize = size; };
-	inline static int getTotalSize() { return totalSize; };
+	inline static void setTotalSize(const qint64 size) { totalSize = size; };
+	inline static qint64 getTotalSize() { return totalSize; };
 
 	inline static void setStartPos(const int pos) { startPos = pos; };
 	inline static int getStartPos() { return startPos; };
@@ -64,11 +86,19 @@ public:
     int numberReads;				/* Number of reads that belong to this contig */
     int readStartIndex;				/* Starting index of reads that belong to this contig */
     int readEndIndex;				/* Ending index of reads that belong to this contig */
-    QHash<int, quint8> snpPosHash;	/* Holds SNP positions of the contig */
+    QBitArray snpBitmap;			/* Bit is set for each SNP position above the threshold */
+    QVector<int> snpThresholdPosList;	/* Sorted positions of the SNPs above the threshold */
+    QVector<int> snpPosList;		/* Sorted positions of all the SNPs of the contig */
+    QVector<quint8> snpVariationList;	/* Variation percent of each SNP in snpPosList */
+    bool isSnpProfileLoaded;		/* Whether snpPosList has been loaded */
     int order;						/* Holds the order of the contig */
     int fileId;						/* Holds the ID of the file that this contig belongs to */
     qreal coverage;					/* Average coverage of the contig */
+    CoverageProfile coverageProfile;	/* Read depth at each position */
+    CoverageProfile overflowProfile;	/* Number of reads left out of the row layout at each position */
+    PadIndex padIndex;				/* Translates between padded and unpadded positions */
     int maxFragRows;				/* Max number of fragment rows */
+    int maxReadSize;				/* Size of the longest read */
     int maxGeneRows;				/* Max number of gene rows */
     int zoomLevels;					/* Number of zoom levels */
     FragmentList *fragList;			/* Fragments belonging to this contig */
@@ -76,8 +106,9 @@ public:
     File *file;						/* File this contig belongs to */
 
     static int numContigs;			/* Number of loaded contigs */
+    static int numAvailableContigs;	/* Number of contigs whose data has been committed */
     static int currentId;			/* Id of the currently displayed contig */
-    static int totalSize;			/* Total size of all the loaded contigs */
+    static qint64 totalSize;		/* Total size of all the loaded contigs */
     static int startPos;			/* Holds the start position of the sequence */
     static int endPos;				/* Holds the end position of the sequence */
     static int midPos;				/* Holds the mid position of the sequence */
@@ -89,8 +120,16 @@ public:
 
 	/** Resets/empties the sequence */
 	inline void resetSeq() { seq = ""; };
-	/** Resets Snp hash */
-	inline void resetSnps() { snpPosHash.clear(); };
+	/** Resets Snp bitmap (the in-memory SNP profile is kept) */
+	inline void resetSnps() { snpBitmap.clear(); snpThresholdPosList.clear(); };
+	/** Returns whether the given position is a SNP above the threshold */
+	inline bool isSnp(const int pos) const
+	{
+		return (pos >= 0 && pos < snpBitmap.size() && snpBitmap.testBit(pos));
+	};
+
+private:
+	bool getSnpProfile();
 
 };
 
@@ -0,0 +1,247 @@
+
+#include "contigAnalyzer.h"
+#include <QtAlgorithms>
+#include <queue>
+#include <vector>
+#include <functional>
+#include <ctype.h>
+
+#define	FRAG_DESC_GAP	20
+#define	MAX_ROWS		500
+
+using namespace std;
+
+int ContigAnalyzer::maxRows = MAX_ROWS;
+
+
+/*
+ * Returns true if the first fragment starts before the second one
+ */
+static bool fragStartLessThan(const Fragment *frag1, const Fragment *frag2)
+{
+	return (frag1->startPos < frag2->startPos);
+}
+
+
+/**
+ * Constructor
+ */
+ContigAnalyzer::ContigAnalyzer()
+{
+	contig = NULL;
+	totalReadBases = 0;
+}
+
+
+/**
+ * Destructor
+ */
+ContigAnalyzer::~ContigAnalyzer()
+{
+
+}
+
+
+/**
+ * Starts the analysis of the given contig. The contig sequence must
+ * already have been read.
+ *
+ * @param c : Contig whose reads will be added next
+ */
+void ContigAnalyzer::begin(Contig *c)
+{
+	contig = c;
+	totalReadBases = 0;
+	coverage.fill(0, contig->size + 1);
+	mismatchCount.fill(0, contig->size);
+}
+
+
+/**
+ * Adds the given read to the pileup of the current contig. Each base
+ * of the read is visited exactly once.
+ *
+ * @param frag : Read belonging to the current contig
+ */
+void ContigAnalyzer::addRead(const Fragment *frag)
+{
+	int first, last, k, index, readSize;
+	const char *contigSeq, *readSeq;
+
+	if (contig == NULL)
+		return;
+
+	totalReadBases += frag->size;
+	if (frag->size > contig->maxReadSize)
+		contig->maxReadSize = frag->size;
+
+	/* Clip the read to the contig (positions are 1-based) */
+	first = (frag->startPos < 1)? 1: frag->startPos;
+	last = (frag->endPos > contig->size)? contig->size: frag->endPos;
+	if (first > last)
+		return;
+
+	/* Coverage difference array */
+	coverage[first - 1]++;
+	coverage[last]--;
+
+	/* Count the bases that differ from the contig */
+	contigSeq = contig->seq.constData();
+	readSeq = frag->seq.constData();
+	readSize = frag->seq.size();
+	index = first - frag->startPos;
+	for (k = first - 1; k < last && index < readSize; ++k, ++index)
+	{
+		if (k < contig->seq.size()
+				&& tolower(contigSeq[k]) != tolower(readSeq[index]))
+			mismatchCount[k]++;
+	}
+}
+
+
+/**
+ * Sets the maximum number of rows the reads of a contig are packed
+ * into. Reads that do not fit are not given a row; they are counted
+ * in the overflow profile of the contig instead.
+ *
+ * @param rows : Maximum number of rows, or 0 for no limit
+ */
+void ContigAnalyzer::setMaxRows(const int rows)
+{
+	maxRows = (rows < 0)? 0: rows;
+}
+
+
+/**
+ * Returns the maximum number of rows the reads of a contig are packed
+ * into, or 0 if there is no limit
+ */
+int ContigAnalyzer::getMaxRows()
+{
+	return maxRows;
+}
+
+
+/**
+ * Finishes the analysis of the current contig. Sets the y-position of
+ * each read, and the SNP profile, coverage profile, overflow profile,
+ * pad index, average coverage and number of read rows of the contig.
+ *
+ * @param fragList : Reads belonging to the current contig
+ */
+void ContigAnalyzer::finish(QList<Fragment *> &fragList)
+{
+	int i, depth, numOverflowReads;
+
+	if (contig == NULL)
+		return;
+
+	/* Turn the difference array into per-base coverage and collect
+	 * the positions where at least one read differs */
+	contig->snpPosList.clear();
+	contig->snpVariationList.clear();
+	depth = 0;
+	for (i = 0; i < contig->size; ++i)
+	{
+		depth += coverage.at(i);
+		coverage[i] = depth;
+		if (mismatchCount.at(i) > 0 && depth > 0)
+		{
+			contig->snpPosList.append(i);
+			contig->snpVariationList.append(
+					(quint8) ((mismatchCount.at(i) * 100) / depth));
+		}
+	}
+	coverage.resize(contig->size);
+	contig->coverageProfile.setDepths(coverage);
+	contig->padIndex.build(contig->seq);
+	contig->isSnpProfileLoaded = true;
+
+	if (contig->size > 0)
+		contig->coverage = ((qreal) totalReadBases) / contig->size;
+
+	/* Reuse the difference array for the reads that get no row */
+	coverage.fill(0, contig->size + 1);
+	contig->maxFragRows = assignRows(fragList, numOverflowReads);
+	contig->overflowProfile.clear();
+	if (numOverflowReads > 0)
+	{
+		depth = 0;
+		for (i = 0; i < contig->size; ++i)
+		{
+			depth += coverage.at(i);
+			coverage[i] = depth;
+		}
+		coverage.resize(contig->size);
+		contig->overflowProfile.setDepths(coverage);
+	}
+
+	coverage.clear();
+	mismatchCount.clear();
+	contig = NULL;
+}
+
+
+/*
+ * Packs the given reads into rows so that reads in the same row are
+ * at least FRAG_DESC_GAP bases apart. Each read goes to the lowest
+ * free row. Once maxRows rows are in use, a read for which no row is
+ * free gets the y-position -1 and is added to the 'coverage' difference
+ * array, so layout cost is bounded by the row limit rather than by the
+ * depth of the contig.
+ *
+ * @param fragList : Reads to be packed
+ * @param numOverflowReads : Set to the number of reads that got no row
+ * @return Returns the number of rows used
+ */
+int ContigAnalyzer::assignRows(QList<Fragment *> &fragList, int &numOverflowReads)
+{
+	QList<Fragment *> sortedList;
+	Fragment *frag;
+	int row, numRows, first, last;
+	priority_queue<pair<int, int>, vector<pair<int, int> >,
+		greater<pair<int, int> > > busyRows;	/* <end position, row> */
+	priority_queue<int, vector<int>, greater<int> > freeRows;
+
+	sortedList = fragList;
+	qStableSort(sortedList.begin(), sortedList.end(), fragStartLessThan);
+
+	numRows = 0;
+	numOverflowReads = 0;
+	foreach (frag, sortedList)
+	{
+		/* Release the rows whose last read ends far enough before
+		 * this read */
+		while (!busyRows.empty()
+				&& busyRows.top().first + FRAG_DESC_GAP < frag->startPos)
+		{
+			freeRows.push(busyRows.top().second);
+			busyRows.pop();
+		}
+
+		if (!freeRows.empty())
+		{
+			row = freeRows.top();
+			freeRows.pop();
+		}
+		else if (maxRows == 0 || numRows < maxRows)
+			row = numRows++;
+		else
+		{
+			/* Count the read in the overflow of the bases it covers */
+			frag->yPos = -1;
+			++numOverflowReads;
+			first = (frag->startPos < 1)? 1: frag->startPos;
+			last = (frag->endPos > contig->size)? contig->size: frag->endPos;
+			if (first <= last)
+			{
+				coverage[first - 1]++;
+				coverage[last]--;
+			}
+			continue;
+		}
+		frag->yPos = row;
+		busyRows.push(make_pair(frag->endPos, row));
+	}
+	return numRows;
+}
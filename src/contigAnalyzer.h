@@ -0,0 +1,30 @@
+#ifndef CONTIGANALYZER_H_
+#define CONTIGANALYZER_H_
+
+#include <QList>
+#include <QVector>
+#include "contig.h"
+#include "fragment.h"
+
+class ContigAnalyzer
+{
+public:
+	ContigAnalyzer();
+	~ContigAnalyzer();
+	void begin(Contig *);
+	void addRead(const Fragment *);
+	void finish(QList<Fragment *> &);
+	static void setMaxRows(const int);
+	static int getMaxRows();
+
+private:
+	Contig *contig;				/* Contig being analyzed */
+	QVector<int> coverage;		/* Coverage (later overflow) difference array */
+	QVector<int> mismatchCount;	/* Number of reads that differ from the contig at each base */
+	qint64 totalReadBases;		/* Sum of the sizes of the reads added so far */
+	static int maxRows;			/* Maximum number of read rows per contig */
+
+	int assignRows(QList<Fragment *> &, int &);
+};
+
+#endif /* CONTIGANALYZER_H_ */
@@ -2,8 +2,12 @@
 #include "contigList.h"
 #include <QSqlQuery>
 #include <QSqlError>
+#include <string.h>
 #include "database.h"
 
+#define	BYTE_TO_MBYTE			1048576
+#define	DEFAULT_MEMORY_BUDGET	512		/* In megabytes */
+
 int ContigList::snpThreshold = 30;
 
 /**
@@ -14,6 +18,14 @@ ContigList::ContigList()
 {
 	currentContig = NULL;
 	loadSequenceFlag = false;
+	memset(&memoryUsage, 0, sizeof(memoryUsage));
+	memoryBudget = (qint64) DEFAULT_MEMORY_BUDGET * BYTE_TO_MBYTE;
+	numCacheHits = 0;
+	numPrefetchHits = 0;
+	numCacheMisses = 0;
+	numEvictions = 0;
+	connect(&prefetcher, SIGNAL(contigFetched(int)),
+			this, SLOT(addPrefetchedContig(int)));
 }
 
 
@@ -23,6 +35,7 @@ ContigList::ContigList()
  */
 ContigList::~ContigList()
 {
+	prefetcher.clear();
 	foreach (Contig *c, idContigMap.values())
 		delete c;
 	idContigMap.clear();
@@ -37,9 +50,14 @@ ContigList::~ContigList()
  */
 void ContigList::reset()
 {
+	prefetcher.clear();
 	foreach (Contig *c, idContigMap.values())
 		delete c;
 	idContigMap.clear();
+	lruList.clear();
+	lruHash.clear();
+	memoryUsageHash.clear();
+	memset(&memoryUsage, 0, sizeof(memoryUsage));
 	orderIdMap.clear();
 	idOrderMap.clear();
 	loadSequenceFlag = false;
@@ -63,6 +81,8 @@ Contig * ContigList::getContigUsingOrder(const int order)
  */
 Contig * ContigList::getContigUsingId(const int id)
 {
+	Contig *fetchedContig;
+
 	if (id <= 0) return currentContig;
 
 	/* Reset the sequence data member of the old contig */
@@ -73,6 +93,31 @@ Contig * ContigList::getContigUsingId(const int id)
 	if (idContigMap.contains(id))
 	{
 		currentContig = idContigMap.value(id);
+
+		/* Reload fragments if they were evicted from the cache. If the
+		 * prefetcher has fetched them or is fetching them, they are
+		 * taken from it instead of being read again. */
+		if (!lruHash.contains(id))
+		{
+			fetchedContig = prefetcher.takeContig(id);
+			if (fetchedContig != NULL)
+			{
+				takeFetchedFrags(currentContig, fetchedContig);
+				++numPrefetchHits;
+			}
+			else
+			{
+				currentContig->getFrags();
+				++numCacheMisses;
+			}
+		}
+		else
+			++numCacheHits;
+
+		/* The threshold may have changed since this contig was last shown;
+		 * filtering the in-memory SNP profile is cheap */
+		currentContig->getSnps(snpThreshold);
+
 		if (loadSequenceFlag == true)
 			currentContig->getSeq();
 		else
@@ -82,18 +127,255 @@ Contig * ContigList::getContigUsingId(const int id)
 		if (currentContig->annotationLists.size() == 0)
 			currentContig->getAnnotation();
 	}
-	/* If contig is not found in the map, fetch it from
-	 * the database and store it in the map */
+	/* If contig is not found in the map, take it from the prefetcher
+	 * or fetch it from the database, and store it in the map */
 	else
 	{
-		currentContig = getContig(id, loadSequenceFlag);
+		currentContig = prefetcher.takeContig(id);
+		if (currentContig != NULL)
+		{
+			currentContig->getSnps(snpThreshold);
+			currentContig->getAnnotation();
+			if (loadSequenceFlag == true)
+				currentContig->getSeq();
+			++numPrefetchHits;
+		}
+		else
+		{
+			currentContig = getContig(id, loadSequenceFlag);
+			++numCacheMisses;
+		}
+		if (currentContig == NULL)
+			return NULL;
 		idContigMap.insert(currentContig->id, currentContig);
 	}
 
+	updateCache(currentContig);
+	prefetchNeighbours(currentContig);
+
 	return currentContig;
 }
 
 
+/*
+ * Marks the given contig as the most recently used one, updates its
+ * memory usage, and evicts least recently used contigs if the cache
+ * has grown over budget.
+ */
+void ContigList::updateCache(Contig *contig)
+{
+	removeFromLru(contig->id);
+	lruHash.insert(contig->id, lruList.insert(lruList.end(), contig->id));
+	updateMemoryUsage(contig);
+	evictContigs();
+}
+
+
+/*
+ * Releases the fragments, SNPs and annotations of least recently used
+ * contigs until the cache is within its memory budget. The contig objects
+ * themselves are small and are kept, so that pointers to them stay valid.
+ * The current contig is never evicted.
+ */
+void ContigList::evictContigs()
+{
+	QLinkedList<int>::iterator i;
+	int id;
+	Contig *c;
+
+	i = lruList.begin();
+	while (memoryUsage.totalBytes > memoryBudget && i != lruList.end())
+	{
+		id = *i;
+		if (currentContig != NULL && id == currentContig->id)
+		{
+			++i;
+			continue;
+		}
+		c = idContigMap.value(id);
+		c->resetFrags();
+		c->resetSnpProfile();
+		c->resetAnnotationLists();
+		c->resetSeq();
+		removeMemoryUsage(id);
+		lruHash.remove(id);
+		i = lruList.erase(i);
+		++numEvictions;
+	}
+}
+
+
+/**
+ * Returns the approximate number of bytes used by the loaded contigs.
+ * The totals are kept up to date as contigs are loaded and evicted, so
+ * this does not walk the fragments.
+ *
+ * @param fragBytes : Receives the bytes used by fragments
+ * @param seqBytes : Receives the bytes used by contig sequences
+ * @param annotBytes : Receives the bytes used by annotations
+ * @param totalBytes : Receives the bytes used by all contig data
+ */
+void ContigList::getCacheMemoryUsage(
+		qint64 &fragBytes,
+		qint64 &seqBytes,
+		qint64 &annotBytes,
+		qint64 &totalBytes)
+{
+	fragBytes = memoryUsage.fragBytes;
+	seqBytes = memoryUsage.seqBytes;
+	annotBytes = memoryUsage.annotBytes;
+	totalBytes = memoryUsage.totalBytes;
+}
+
+
+/*
+ * Asks the prefetcher to load the contigs before and after the given
+ * contig in the current contig order, unless they are already loaded.
+ */
+void ContigList::prefetchNeighbours(const Contig *contig)
+{
+	int neighbourId;
+
+	neighbourId = orderIdMap.value(contig->order - 1);
+	if (neighbourId > 0 && !lruHash.contains(neighbourId))
+		prefetcher.addContig(neighbourId);
+
+	neighbourId = orderIdMap.value(contig->order + 1);
+	if (neighbourId > 0 && !lruHash.contains(neighbourId))
+		prefetcher.addContig(neighbourId);
+}
+
+
+/*
+ * Moves a contig that has been fetched in the background into the cache.
+ * Annotation and SNPs are loaded here because they use the GUI thread's
+ * DB connections.
+ */
+void ContigList::addPrefetchedContig(int id)
+{
+	Contig *contig, *c;
+
+	contig = prefetcher.takeContig(id);
+	if (contig == NULL)
+		return;
+
+	/* If the contig object already exists (its data having been evicted),
+	 * move the fetched fragments into it so existing pointers stay valid */
+	if (idContigMap.contains(id))
+	{
+		c = idContigMap.value(id);
+		if (lruHash.contains(id))
+		{
+			delete contig;
+			return;
+		}
+		takeFetchedFrags(c, contig);
+		contig = c;
+	}
+	else
+		idContigMap.insert(id, contig);
+
+	contig->getSnps(snpThreshold);
+	if (contig->annotationLists.size() == 0)
+		contig->getAnnotation();
+
+	/* Keep the current contig as the most recently used one */
+	removeFromLru(id);
+	if (!lruList.isEmpty() && currentContig != NULL
+			&& lruList.last() == currentContig->id)
+		lruHash.insert(id, lruList.insert(--lruList.end(), id));
+	else
+		lruHash.insert(id, lruList.insert(lruList.end(), id));
+	updateMemoryUsage(contig);
+
+	evictContigs();
+}
+
+
+/*
+ * Removes the given contig from the LRU list if it is there
+ */
+void ContigList::removeFromLru(const int id)
+{
+	if (lruHash.contains(id))
+		lruList.erase(lruHash.take(id));
+}
+
+
+/*
+ * Measures the memory used by the data of the given contig and updates
+ * the totals of the cache with it
+ */
+void ContigList::updateMemoryUsage(Contig *contig)
+{
+	MemoryUsage usage;
+
+	removeMemoryUsage(contig->id);
+	usage.totalBytes = contig->getMemoryUsage(
+			usage.fragBytes, usage.seqBytes, usage.annotBytes);
+	memoryUsageHash.insert(contig->id, usage);
+	memoryUsage.fragBytes += usage.fragBytes;
+	memoryUsage.seqBytes += usage.seqBytes;
+	memoryUsage.annotBytes += usage.annotBytes;
+	memoryUsage.totalBytes += usage.totalBytes;
+}
+
+
+/*
+ * Removes the memory used by the data of the given contig from the
+ * totals of the cache
+ */
+void ContigList::removeMemoryUsage(const int id)
+{
+	MemoryUsage usage;
+
+	if (!memoryUsageHash.contains(id))
+		return;
+	usage = memoryUsageHash.take(id);
+	memoryUsage.fragBytes -= usage.fragBytes;
+	memoryUsage.seqBytes -= usage.seqBytes;
+	memoryUsage.annotBytes -= usage.annotBytes;
+	memoryUsage.totalBytes -= usage.totalBytes;
+}
+
+
+/*
+ * Moves the fragments of a contig fetched by the prefetcher into the
+ * existing contig object with the same ID, so that pointers to that
+ * object stay valid, and deletes the fetched object
+ */
+void ContigList::takeFetchedFrags(Contig *contig, Contig *fetchedContig)
+{
+	contig->resetFrags();
+	contig->getFragList() = fetchedContig->getFragList();
+	fetchedContig->getFragList().clear();
+	delete fetchedContig;
+}
+
+
+/**
+ * Returns the memory budget of the cache in megabytes
+ */
+int ContigList::getMemoryBudget() const
+{
+	return (int) (memoryBudget / BYTE_TO_MBYTE);
+}
+
+
+/**
+ * Sets the memory budget of the cache and evicts contigs if needed
+ *
+ * @param megabytes : Memory budget in megabytes
+ */
+void ContigList::setMemoryBudget(const int megabytes)
+{
+	if (megabytes <= 0)
+		return;
+	memoryBudget = (qint64) megabytes * BYTE_TO_MBYTE;
+	evictContigs();
+}
+
+
 /*
  * Fetches contig from the database
  */
@@ -107,36 +389,9 @@ Contig * ContigList::getContig(const int id, bool fetchSeq)
 				connectionName,
 				Database::getContigDBName());
 		QSqlQuery query(db);
-		QString str;
-		File *file;
 
-		if (fetchSeq == false)
-		{
-			str = "select contig.id, contig.name, contig.size, "
-					" contig.numberReads, contig.readStartIndex, "
-					" contig.readEndIndex, contig.seq, contig.contigOrder, "
-					" contig.coverage, contig.maxGeneRows, "
-					" contig.zoomLevels, contig.maxFragRows, contig.fileId, "
-					" file.file_name, file.filepath "
-					" from contig, file "
-					" where contig.fileId = file.id "
-					" and contig.id = " + QString::number(id);
-		}
-		else
-		{
-			str = "select contig.id, contig.name, contig.size, contig.numberReads, "
-					" contig.readStartIndex, contig.readEndIndex, "
-					" contigSeq.seq, contig.contigOrder, contig.coverage, "
-					" contig.maxGeneRows, contig.zoomLevels, "
-					" contig.maxFragRows, contig.fileId, "
-					" file.file_name, file.filepath "
-					" from contig, contigSeq, file "
-					" where contig.id = contigSeq.contigId "
-					" and contig.fileId = file.id "
-					" and contig.id = " + QString::number(id);
-		}
-
-		if (!query.exec(str))
+		contig = fetchContig(query, id, fetchSeq);
+		if (contig == NULL && query.lastError().isValid())
 		{
 			QMessageBox::critical(
 					QApplication::activeWindow(),
@@ -147,27 +402,8 @@ Contig * ContigList::getContig(const int id, bool fetchSeq)
 			return NULL;
 		}
 
-		if (query.next())
+		if (contig != NULL)
 		{
-			contig = new Contig;
-			contig->id = query.value(0).toInt();
-			contig->name = query.value(1).toByteArray();
-			contig->size = query.value(2).toInt();
-			contig->numberReads = query.value(3).toInt();
-			contig->readStartIndex = query.value(4).toInt();
-			contig->readEndIndex = query.value(5).toInt();
-			contig->seq = query.value(6).toByteArray();;
-			contig->order = query.value(7).toInt();
-			contig->coverage = query.value(8).toDouble();
-			contig->maxGeneRows = query.value(9).toInt();
-			contig->zoomLevels = query.value(10).toInt();
-			contig->maxFragRows = query.value(11).toInt();
-			contig->fileId = query.value(12).toInt();
-			file = new File(
-					contig->fileId,
-					query.value(13).toString(),
-					query.value(14).toString());
-			contig->file = file;
 			contig->getFrags();
 			contig->getSnps(snpThreshold);
 			contig->getAnnotation();
@@ -180,6 +416,124 @@ Contig * ContigList::getContig(const int id, bool fetchSeq)
 }
 
 
+/**
+ * Fetches the row and the coverage profiles of the contig with the given
+ * ID using the given query object. Fragments, SNPs and annotation are
+ * not fetched.
+ *
+ * This does not show any dialogs, so it can also be used from threads
+ * other than the GUI thread.
+ *
+ * @param query : Query object belonging to a connection to the contig DB
+ * @param id : ID of the contig
+ * @param fetchSeq : Whether the contig sequence should be fetched
+ *
+ * @return Pointer to a new contig, or NULL if the contig was not found
+ * or the query failed
+ */
+Contig * ContigList::fetchContig(QSqlQuery &query, const int id, const bool fetchSeq)
+{
+	QString str;
+	Contig *contig = NULL;
+
+	if (fetchSeq == false)
+	{
+		str = "select contig.id, contig.name, contig.size, "
+				" contig.numberReads, contig.readStartIndex, "
+				" contig.readEndIndex, contig.seq, contig.contigOrder, "
+				" contig.coverage, contig.maxGeneRows, "
+				" contig.zoomLevels, contig.maxFragRows, contig.fileId, "
+				" file.file_name, file.filepath "
+				" from contig, file "
+				" where contig.fileId = file.id "
+				" and contig.id = " + QString::number(id);
+	}
+	else
+	{
+		str = "select contig.id, contig.name, contig.size, contig.numberReads, "
+				" contig.readStartIndex, contig.readEndIndex, "
+				" contigSeq.seq, contig.contigOrder, contig.coverage, "
+				" contig.maxGeneRows, contig.zoomLevels, "
+				" contig.maxFragRows, contig.fileId, "
+				" file.file_name, file.filepath "
+				" from contig, contigSeq, file "
+				" where contig.id = contigSeq.contigId "
+				" and contig.fileId = file.id "
+				" and contig.id = " + QString::number(id);
+	}
+
+	if (!DB_EXEC(query, str))
+		return NULL;
+
+	if (query.next())
+	{
+		contig = new Contig;
+		contig->id = query.value(0).toInt();
+		contig->name = query.value(1).toByteArray();
+		contig->size = query.value(2).toInt();
+		contig->numberReads = query.value(3).toInt();
+		contig->readStartIndex = query.value(4).toInt();
+		contig->readEndIndex = query.value(5).toInt();
+		contig->seq = query.value(6).toByteArray();;
+		contig->order = query.value(7).toInt();
+		contig->coverage = query.value(8).toDouble();
+		contig->maxGeneRows = query.value(9).toInt();
+		contig->zoomLevels = query.value(10).toInt();
+		contig->maxFragRows = query.value(11).toInt();
+		contig->fileId = query.value(12).toInt();
+		contig->file = new File(
+				contig->fileId,
+				query.value(13).toString(),
+				query.value(14).toString());
+
+		/* Coverage and overflow profiles */
+		str = "select runs, overflowRuns from contigCoverage "
+				" where contigId = " + QString::number(id);
+		if (!DB_EXEC(query, str))
+		{
+			delete contig;
+			return NULL;
+		}
+		if (query.next())
+		{
+			contig->coverageProfile.fromByteArray(query.value(0).toByteArray());
+			if (!query.value(1).isNull())
+				contig->overflowProfile.fromByteArray(query.value(1).toByteArray());
+		}
+
+		if (!fetchPadIndex(query, id, contig->padIndex))
+		{
+			delete contig;
+			return NULL;
+		}
+	}
+	return contig;
+}
+
+
+/**
+ * Fetches the pad index of the contig with the given ID using the given
+ * query object. The index is left empty, which maps each position to
+ * itself, if none was stored for the contig.
+ *
+ * @param query : Query object belonging to a connection to the contig DB
+ * @param id : ID of the contig
+ * @param padIndex : Set to the pad index of the contig
+ *
+ * @return Returns false if the query failed
+ */
+bool ContigList::fetchPadIndex(QSqlQuery &query, const int id, PadIndex &padIndex)
+{
+	padIndex.clear();
+	if (!DB_EXEC(query, "select pads from contigPads "
+			" where contigId = " + QString::number(id)))
+		return false;
+	if (query.next())
+		padIndex.fromByteArray(query.value(0).toByteArray());
+	return true;
+}
+
+
 /**
  * Sets loadSequenceFlag data member
  *
@@ -217,9 +571,11 @@ void ContigList::mapOrderAndId()
 		QString str;
 		int id, order;
 
+		/* Only contigs whose reads have been saved can be browsed */
 		str = "select id, contigOrder "
-				" from contig ";
-		if (!query.exec(str))
+				" from contig "
+				" where id <= " + QString::number(Contig::getNumAvailableContigs());
+		if (!DB_EXEC(query, str))
 		{
 			QMessageBox::critical(
 					QApplication::activeWindow(),
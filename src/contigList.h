@@ -4,7 +4,10 @@
 
 #include <QObject>
 #include <QList>
+#include <QLinkedList>
+#include <QSqlQuery>
 #include "contig.h"
+#include "contigPrefetcherThread.h"
 
 class ContigList : public QObject
 {
@@ -18,20 +21,66 @@ public:
 	Contig *getContigUsingOrder(const int);
 	Contig *getContigUsingId(const int);
 	inline int getSnpThreshold() { return snpThreshold; };
+	int getMemoryBudget() const;
+	void getCacheMemoryUsage(qint64 &, qint64 &, qint64 &, qint64 &);
+
+	/** Returns the number of requests served from loaded contigs */
+	inline qint64 getNumCacheHits() const { return numCacheHits; };
+
+	/** Returns the number of requests served by the prefetcher */
+	inline qint64 getNumPrefetchHits() const { return numPrefetchHits; };
+
+	/** Returns the number of requests that had to read the DB */
+	inline qint64 getNumCacheMisses() const { return numCacheMisses; };
+
+	/** Returns the number of contigs whose data has been evicted */
+	inline qint64 getNumEvictions() const { return numEvictions; };
+	static Contig *fetchContig(QSqlQuery &, const int, const bool);
+	static bool fetchPadIndex(QSqlQuery &, const int, PadIndex &);
 
 	public slots:
 	void setLoadSequenceFlag(bool);
 	void reset();
 	void mapOrderAndId();
 	void setSnpThreshold(const int);
+	void setMemoryBudget(const int);
 
 private:
+	/* Approximate bytes used by the data of loaded contigs */
+	struct MemoryUsage
+	{
+		qint64 fragBytes;		/* Bytes used by fragments */
+		qint64 seqBytes;		/* Bytes used by contig sequences */
+		qint64 annotBytes;		/* Bytes used by annotations */
+		qint64 totalBytes;		/* Bytes used by all contig data */
+	};
+
 	Contig *currentContig;
 	QMap<int, Contig *> idContigMap;	/* Maps contig ID to contig */
 	QMap<int, int> orderIdMap;			/* Maps contig order to ID */
 	QMap<int, int> idOrderMap;			/* Maps contig ID to order */
 	bool loadSequenceFlag;				/* Flag that indicates whether contig sequence should be loaded */
+	QLinkedList<int> lruList;			/* IDs of contigs whose data is loaded, least recently used first */
+	QHash<int, QLinkedList<int>::iterator> lruHash;	/* Maps contig ID to its entry in lruList */
+	QHash<int, MemoryUsage> memoryUsageHash;	/* Maps contig ID to the bytes used by its data */
+	MemoryUsage memoryUsage;			/* Bytes used by all the loaded contigs */
+	qint64 memoryBudget;				/* Bytes that loaded contigs may use before being evicted */
+	ContigPrefetcherThread prefetcher;	/* Fetches neighbouring contigs in the background */
+	qint64 numCacheHits;
+	qint64 numPrefetchHits;
+	qint64 numCacheMisses;
+	qint64 numEvictions;
 
 	Contig * getContig(const int, bool);
+	void updateCache(Contig *);
+	void evictContigs();
+	void prefetchNeighbours(const Contig *);
+	void removeFromLru(const int);
+	void updateMemoryUsage(Contig *);
+	void removeMemoryUsage(const int);
+	void takeFetchedFrags(Contig *, Contig *);
+
+	private slots:
+	void addPrefetchedContig(int);
 };
 #endif /* CONTIGLIST_H_ */
@@ -0,0 +1,367 @@
+
+#include "contigPlacementIndex.h"
+#include <QtAlgorithms>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QtDebug>
+#include "database.h"
+
+ContigPlacementIndex *ContigPlacementIndex::shared = NULL;
+
+
+/*
+ * Returns true if the first placement starts before the second one
+ */
+static bool placementLessThan(
+		const ContigPlacementIndex::Placement &p1,
+		const ContigPlacementIndex::Placement &p2)
+{
+	return (p1.chromStart < p2.chromStart);
+}
+
+
+/*
+ * Returns true if the given position is before the start of the
+ * given placement
+ */
+static bool posLessThanPlacement(
+		const int pos,
+		const ContigPlacementIndex::Placement &p)
+{
+	return (pos < p.chromStart);
+}
+
+
+/**
+ * Constructor
+ */
+ContigPlacementIndex::ContigPlacementIndex()
+{
+
+}
+
+
+/**
+ * Destructor
+ */
+ContigPlacementIndex::~ContigPlacementIndex()
+{
+
+}
+
+
+/**
+ * Removes all placements
+ */
+void ContigPlacementIndex::clear()
+{
+	chromHash.clear();
+	contigHash.clear();
+}
+
+
+/**
+ * Adds a contig placement. build() must be called after the last
+ * placement has been added.
+ *
+ * @param chrom : Chromosome name; names are compared case-insensitively
+ * @param contigId : ID of the contig
+ * @param chromStart : Start position of the contig on the chromosome
+ * @param chromEnd : End position of the contig on the chromosome
+ * @param isReversed : Whether the contig lies on the reverse strand
+ */
+void ContigPlacementIndex::addPlacement(
+		const QByteArray &chrom,
+		const int contigId,
+		const int chromStart,
+		const int chromEnd,
+		const bool isReversed)
+{
+	Placement p;
+
+	p.contigId = contigId;
+	p.chromStart = chromStart;
+	p.chromEnd = chromEnd;
+	p.isReversed = isReversed;
+	p.chrom = chrom;
+	chromHash[chrom.toLower()].placements.append(p);
+	contigHash.insert(contigId, p);
+}
+
+
+/**
+ * Sorts the placements of each chromosome and computes the running
+ * maximum of their end positions
+ */
+void ContigPlacementIndex::build()
+{
+	QHash<QByteArray, Chromosome>::iterator it;
+	int i, size, maxEnd;
+
+	for (it = chromHash.begin(); it != chromHash.end(); ++it)
+	{
+		Chromosome &chrom = it.value();
+		qStableSort(chrom.placements.begin(), chrom.placements.end(), placementLessThan);
+		size = chrom.placements.size();
+		chrom.maxEndList.resize(size);
+		for (i = 0; i < size; ++i)
+		{
+			maxEnd = chrom.placements.at(i).chromEnd;
+			if (i > 0 && chrom.maxEndList.at(i - 1) > maxEnd)
+				maxEnd = chrom.maxEndList.at(i - 1);
+			chrom.maxEndList[i] = maxEnd;
+		}
+	}
+}
+
+
+/**
+ * Finds the contigs whose placement contains the given chromosome
+ * range
+ *
+ * @param chrom : Chromosome name (case-insensitive)
+ * @param start : Start position on the chromosome
+ * @param end : End position on the chromosome
+ * @param result : Cleared and filled with the matching placements,
+ * sorted by start position
+ */
+void ContigPlacementIndex::findContaining(
+		const QByteArray &chrom,
+		const int start,
+		const int end,
+		QVector<Placement> &result) const
+{
+	QHash<QByteArray, Chromosome>::const_iterator it;
+	int i, first;
+
+	result.clear();
+	it = chromHash.constFind(chrom.toLower());
+	if (it == chromHash.constEnd())
+		return;
+
+	const Chromosome &c = it.value();
+
+	/* Only placements that start at or before 'start' can contain the
+	 * range; walk back from the last of them while some placement
+	 * further back may still reach 'end' */
+	i = qUpperBound(c.placements.constBegin(), c.placements.constEnd(),
+			start, posLessThanPlacement) - c.placements.constBegin() - 1;
+	for (; i >= 0 && c.maxEndList.at(i) >= end; --i)
+	{
+		if (c.placements.at(i).chromEnd >= end)
+			result.append(c.placements.at(i));
+	}
+
+	/* Restore start order */
+	first = 0;
+	for (i = result.size() - 1; first < i; ++first, --i)
+		qSwap(result[first], result[i]);
+}
+
+
+/**
+ * Finds the placement of the given contig
+ *
+ * @param contigId : ID of the contig
+ * @param placement : Set to the placement of the contig
+ * @return Returns false if the contig is not placed on any chromosome
+ */
+bool ContigPlacementIndex::findContig(
+		const int contigId,
+		Placement &placement) const
+{
+	QHash<int, Placement>::const_iterator it;
+
+	it = contigHash.constFind(contigId);
+	if (it == contigHash.constEnd())
+		return false;
+	placement = it.value();
+	return true;
+}
+
+
+/**
+ * Converts a chromosome position to a contig position. If several
+ * contigs contain the position, the one placed first is used.
+ *
+ * @param chrom : Chromosome name (case-insensitive)
+ * @param chromPos : Position on the chromosome
+ * @param contigId : Set to the ID of the contig
+ * @param contigPos : Set to the position within the contig
+ * @return Returns false if no contig contains the position
+ */
+bool ContigPlacementIndex::toContig(
+		const QByteArray &chrom,
+		const int chromPos,
+		int &contigId,
+		int &contigPos) const
+{
+	QVector<Placement> placements;
+	int end;
+
+	findContaining(chrom, chromPos, chromPos, placements);
+	if (placements.isEmpty())
+		return false;
+	contigId = placements.at(0).contigId;
+	toContigRange(placements.at(0), chromPos, chromPos, contigPos, end);
+	return true;
+}
+
+
+/**
+ * Converts a contig range to the chromosome range it covers
+ *
+ * @param contigId : ID of the contig
+ * @param start : Start position within the contig
+ * @param end : End position within the contig
+ * @param chrom : Set to the chromosome name
+ * @param chromStart : Set to the start position on the chromosome
+ * @param chromEnd : Set to the end position on the chromosome
+ * @return Returns false if the contig is not placed on any chromosome
+ */
+bool ContigPlacementIndex::toGenome(
+		const int contigId,
+		const int start,
+		const int end,
+		QByteArray &chrom,
+		int &chromStart,
+		int &chromEnd) const
+{
+	Placement p;
+
+	if (!findContig(contigId, p))
+		return false;
+	chrom = p.chrom;
+	toGenomeRange(p, start, end, chromStart, chromEnd);
+	return true;
+}
+
+
+/**
+ * Converts a chromosome range to a range within the given placement's
+ * contig. The range is mirrored for contigs on the reverse strand, so
+ * that the returned start is never greater than the returned end.
+ */
+void ContigPlacementIndex::toContigRange(
+		const Placement &p,
+		const int chromStart,
+		const int chromEnd,
+		int &start,
+		int &end)
+{
+	if (p.isReversed)
+	{
+		start = p.chromEnd - chromEnd;
+		end = p.chromEnd - chromStart;
+	}
+	else
+	{
+		start = chromStart - p.chromStart;
+		end = chromEnd - p.chromStart;
+	}
+}
+
+
+/**
+ * Converts a range within the given placement's contig to a
+ * chromosome range; the inverse of toContigRange()
+ */
+void ContigPlacementIndex::toGenomeRange(
+		const Placement &p,
+		const int start,
+		const int end,
+		int &chromStart,
+		int &chromEnd)
+{
+	if (p.isReversed)
+	{
+		chromStart = p.chromEnd - end;
+		chromEnd = p.chromEnd - start;
+	}
+	else
+	{
+		chromStart = p.chromStart + start;
+		chromEnd = p.chromStart + end;
+	}
+}
+
+
+/**
+ * Replaces the placements with those in the 'chrom_contig' table
+ *
+ * @return Returns true on success and false on failure
+ */
+bool ContigPlacementIndex::load()
+{
+	QString connectionName = "ContigPlacementIndex_load";
+	bool isSuccess = true;
+
+	clear();
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getContigDBName());
+		QSqlQuery query(db);
+		QString str;
+
+		str = "select chromosome.name, "
+				" chrom_contig.contigId, "
+				" chrom_contig.chromStart, "
+				" chrom_contig.chromEnd, "
+				" chrom_contig.strand "
+				" from chrom_contig, chromosome "
+				" where chrom_contig.chromId = chromosome.id ";
+		if (!DB_EXEC(query, str))
+		{
+			qCritical() << "Error fetching from 'chrom_contig' and "
+				"'chromosome' tables. Reason: " << query.lastError().text();
+			isSuccess = false;
+		}
+		while (isSuccess && query.next())
+		{
+			addPlacement(
+					query.value(0).toByteArray(),
+					query.value(1).toInt(),
+					query.value(2).toInt(),
+					query.value(3).toInt(),
+					query.value(4).toString() == "-");
+		}
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+	build();
+	return isSuccess;
+}
+
+
+/**
+ * Returns the placement index shared by the parser, the search and the
+ * annotation tracks, loading it from the DB the first time
+ *
+ * @return Returns NULL if the placements could not be loaded
+ */
+const ContigPlacementIndex * ContigPlacementIndex::getShared()
+{
+	if (shared == NULL)
+	{
+		shared = new ContigPlacementIndex;
+		if (!shared->load())
+		{
+			delete shared;
+			shared = NULL;
+		}
+	}
+	return shared;
+}
+
+
+/**
+ * Discards the shared index, so that it is reloaded the next time it
+ * is requested. Must be called whenever 'chrom_contig' changes.
+ */
+void ContigPlacementIndex::resetShared()
+{
+	delete shared;
+	shared = NULL;
+}
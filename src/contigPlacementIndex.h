@@ -0,0 +1,68 @@
+#ifndef CONTIGPLACEMENTINDEX_H_
+#define CONTIGPLACEMENTINDEX_H_
+
+#include <QByteArray>
+#include <QHash>
+#include <QVector>
+
+class ContigPlacementIndex
+{
+public:
+	/** Placement of a contig on a chromosome */
+	struct Placement
+	{
+		int contigId;
+		int chromStart;
+		int chromEnd;
+		bool isReversed;	/* Whether the contig lies on the reverse strand */
+		QByteArray chrom;
+	};
+
+	ContigPlacementIndex();
+	~ContigPlacementIndex();
+	void clear();
+	void addPlacement(
+			const QByteArray &,
+			const int,
+			const int,
+			const int,
+			const bool isReversed = false);
+	void build();
+	bool load();
+	void findContaining(
+			const QByteArray &,
+			const int,
+			const int,
+			QVector<Placement> &) const;
+	bool findContig(const int, Placement &) const;
+	bool toContig(const QByteArray &, const int, int &, int &) const;
+	bool toGenome(
+			const int,
+			const int,
+			const int,
+			QByteArray &,
+			int &,
+			int &) const;
+	static void toContigRange(const Placement &, const int, const int, int &, int &);
+	static void toGenomeRange(const Placement &, const int, const int, int &, int &);
+	static const ContigPlacementIndex *getShared();
+	static void resetShared();
+
+	/** Returns whether any placement has been added */
+	inline bool isEmpty() const { return contigHash.isEmpty(); };
+
+private:
+	/* Placements of one chromosome, sorted by start position */
+	struct Chromosome
+	{
+		QVector<Placement> placements;
+		QVector<int> maxEndList;	/* Largest end among placements[0..i] */
+	};
+
+	QHash<QByteArray, Chromosome> chromHash;	/* Keyed by lower-case name */
+	QHash<int, Placement> contigHash;			/* Maps contig ID => placement */
+
+	static ContigPlacementIndex *shared;
+};
+
+#endif /* CONTIGPLACEMENTINDEX_H_ */
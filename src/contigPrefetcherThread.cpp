@@ -0,0 +1,173 @@
+
+#include "contigPrefetcherThread.h"
+#include <QCoreApplication>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include "contigList.h"
+#include "database.h"
+
+
+/**
+ * Constructor
+ * @return
+ */
+ContigPrefetcherThread::ContigPrefetcherThread()
+{
+	fetchingId = 0;
+	isIdle = true;
+}
+
+
+/**
+ * Destructor
+ * @return
+ */
+ContigPrefetcherThread::~ContigPrefetcherThread()
+{
+	clear();
+}
+
+
+/**
+ * Adds the given contig ID to the queue of contigs to be fetched
+ *
+ * @param id : ID of the contig to be fetched
+ */
+void ContigPrefetcherThread::addContig(const int id)
+{
+	QMutexLocker locker(&mutex);
+	if (id == fetchingId
+			|| fetchedHash.contains(id)
+			|| idQueue.contains(id))
+		return;
+	idQueue.enqueue(id);
+
+	/* If run() has decided to return, let it finish before restarting */
+	if (isIdle)
+		wait();
+	if (!isRunning())
+	{
+		isIdle = false;
+		start(QThread::LowPriority);
+	}
+}
+
+
+/**
+ * Returns the fetched contig with the given ID and removes it from this
+ * thread's ownership. If the contig is currently being fetched, this
+ * waits until it is done.
+ *
+ * @param id : ID of the contig
+ *
+ * @return Pointer to the contig, or NULL if the contig has not been fetched
+ */
+Contig * ContigPrefetcherThread::takeContig(const int id)
+{
+	QMutexLocker locker(&mutex);
+	idQueue.removeAll(id);
+	while (fetchingId == id)
+		contigFetchedCondition.wait(&mutex);
+	return fetchedHash.take(id);
+}
+
+
+/**
+ * Discards pending requests and deletes contigs that have been fetched
+ * but not taken yet
+ */
+void ContigPrefetcherThread::clear()
+{
+	mutex.lock();
+	idQueue.clear();
+	mutex.unlock();
+
+	wait();
+
+	mutex.lock();
+	foreach (Contig *c, fetchedHash.values())
+		delete c;
+	fetchedHash.clear();
+	mutex.unlock();
+}
+
+
+/**
+ * Implements the run method
+ */
+void ContigPrefetcherThread::run()
+{
+	QString contigConnectionName = QString(this->metaObject()->className()) + "_contig";
+	QString fragConnectionName = QString(this->metaObject()->className()) + "_frag";
+	{
+		Contig *contig;
+		int id;
+		QSqlDatabase contigDB =
+			Database::createConnection(
+				contigConnectionName,
+				Database::getContigDBName());
+		QSqlDatabase fragDB =
+			Database::createConnection(
+				fragConnectionName,
+				Database::getFragDBName());
+		QSqlQuery contigQuery(contigDB);
+		QSqlQuery fragQuery(fragDB);
+
+		forever
+		{
+			mutex.lock();
+			if (idQueue.isEmpty())
+			{
+				isIdle = true;
+				mutex.unlock();
+				break;
+			}
+			id = idQueue.dequeue();
+			fetchingId = id;
+			mutex.unlock();
+
+			contig = ContigList::fetchContig(contigQuery, id, false);
+			if (contig == NULL)
+			{
+				if (contigQuery.lastError().isValid())
+					qCritical() << "Error fetching contig from DB in "
+						<< this->metaObject()->className()
+						<< ". Reason: "
+						<< contigQuery.lastError().text();
+			}
+			else if (!contig->fragList->getFrags(fragQuery))
+			{
+				qCritical() << "Error fetching fragments from DB in "
+					<< this->metaObject()->className()
+					<< ". Reason: "
+					<< fragQuery.lastError().text();
+				delete contig;
+				contig = NULL;
+			}
+			else
+			{
+				/* Objects created here belong to this thread; hand them
+				 * over to the GUI thread, which is where they will be used */
+				contig->moveToThread(QCoreApplication::instance()->thread());
+				contig->fragList->moveToThread(QCoreApplication::instance()->thread());
+				contig->file->moveToThread(QCoreApplication::instance()->thread());
+			}
+
+			mutex.lock();
+			fetchingId = 0;
+			if (contig != NULL)
+				fetchedHash.insert(id, contig);
+			contigFetchedCondition.wakeAll();
+			mutex.unlock();
+
+			if (contig != NULL)
+				emit contigFetched(id);
+		}
+
+		contigDB.close();
+		fragDB.close();
+	}
+	QSqlDatabase::removeDatabase(contigConnectionName);
+	QSqlDatabase::removeDatabase(fragConnectionName);
+}
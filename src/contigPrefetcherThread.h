@@ -0,0 +1,38 @@
+
+#ifndef CONTIGPREFETCHERTHREAD_H_
+#define CONTIGPREFETCHERTHREAD_H_
+
+#include <QThread>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QHash>
+#include "contig.h"
+
+class ContigPrefetcherThread : public QThread
+{
+	Q_OBJECT
+
+public:
+	ContigPrefetcherThread();
+	~ContigPrefetcherThread();
+	void addContig(const int);
+	Contig *takeContig(const int);
+	void clear();
+
+    signals:
+    void contigFetched(int);
+
+protected:
+	void run();
+
+private:
+	QMutex mutex;
+	QWaitCondition contigFetchedCondition;
+	QQueue<int> idQueue;				/* IDs of contigs to be fetched */
+	QHash<int, Contig *> fetchedHash;	/* Maps contig ID to fetched contig */
+	int fetchingId;						/* ID of the contig being fetched */
+	bool isIdle;						/* Whether run() is about to return */
+};
+
+#endif /* CONTIGPREFETCHERTHREAD_H_ */
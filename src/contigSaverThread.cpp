@@ -4,6 +4,10 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include "database.h"
+#include "trace.h"
+#include "perfMetrics.h"
+
+#define	CONTIGS_PER_COMMIT	20
 
 
 /**
@@ -33,21 +37,33 @@ void ContigSaverThread::run()
 {
 	//qDebug() << "ContigSaverThread begin***";
 	QString connectionName = QString(this->metaObject()->className());
+	QString snpConnectionName = connectionName + "_snp";
 	{
 		Contig *contig;
+		QList<QPair<int, int> > uncommittedList;
+		QVariantList contigIdList, posList, percentList;
+		int i, numSnps;
+		bool hasError = false;
+		TRACE_SPAN("save contigs");
 		QSqlDatabase db =
 			Database::createConnection(
 				connectionName,
 				Database::getContigDBName());
+		QSqlDatabase snpDb =
+			Database::createConnection(
+				snpConnectionName,
+				Database::getSnpDBName());
 
 		QSqlQuery sqlQuery(db);
 		sqlQuery.prepare("insert into contig "
 				" (id, name, size, numberReads, readStartIndex, readEndIndex, "
-				" seq, contigOrder, coverage, zoomLevels, maxFragRows, fileId) "
+				" seq, contigOrder, coverage, zoomLevels, maxFragRows, fileId, "
+				" maxReadSize) "
 				" values "
 				" (:id, :name, :size, :numberReads, :readStartIndex, "
 				" :readEndIndex, :seq, :contigOrder, "
-				" :coverage, :zoomLevels, :maxFragRows, :fileId)");
+				" :coverage, :zoomLevels, :maxFragRows, :fileId, "
+				" :maxReadSize)");
 		QSqlQuery sqlQuery2(db);
 		sqlQuery2.prepare("insert into contigSeq "
 				" (contigId, seq) "
@@ -58,16 +74,48 @@ void ContigSaverThread::run()
 			" (id, file_name, filepath) "
 			" values "
 			" (:id, :fileName, :filePath)");
+		QSqlQuery sqlQuery5(db);
+		sqlQuery5.prepare("insert into contigCoverage "
+			" (contigId, runs, overflowRuns) "
+			" values "
+			" (:contigId, :runs, :overflowRuns)");
+		QSqlQuery sqlQuery6(db);
+		sqlQuery6.prepare("insert into contigPads "
+			" (contigId, pads) "
+			" values "
+			" (:contigId, :pads)");
+		QSqlQuery sqlQuery4(snpDb);
+		sqlQuery4.prepare("insert into snp_pos "
+			" (contig_id, pos, variationPercent) "
+			" values "
+			" (:contigId, :pos, :variationPercent)");
 
-		if (!db.transaction())
+		if (!db.transaction() || !snpDb.transaction())
 		{
 			qDebug() << "unable to open xaction in contigSaverThread";
-			return;
+			hasError = true;
 		}
 
-		forever
+		while (!hasError)
 		{
-			contigMutex.lock();
+			/* Commit what has been saved so far if enough contigs have
+			 * accumulated or if we are about to wait for the parser, so
+			 * that the contigs become visible to the viewer */
+			{
+				TRACE_SPAN("lock contigMutex");
+				contigMutex.lock();
+			}
+			if (uncommittedList.size() >= CONTIGS_PER_COMMIT
+					|| (contigQueue.isEmpty() && !uncommittedList.isEmpty()))
+			{
+				contigMutex.unlock();
+				if (!commitContigs(db, snpDb, uncommittedList, true))
+				{
+					hasError = true;
+					break;
+				}
+				contigMutex.lock();
+			}
 			if (contigQueue.isEmpty())
 			{
 				if (!moreContigs)
@@ -77,7 +125,10 @@ void ContigSaverThread::run()
 				}
 				else
 				{
-					contigQueueNotEmpty.wait(&contigMutex);
+					{
+						TRACE_SPAN("wait contigQueueNotEmpty");
+						contigQueueNotEmpty.wait(&contigMutex);
+					}
 					if (contigQueue.isEmpty() && !moreContigs)
 					{
 						contigMutex.unlock();
@@ -85,10 +136,14 @@ void ContigSaverThread::run()
 					}
 				}
 			}
+			TRACE_COUNTER("contigQueue", contigQueue.size());
 			contig = contigQueue.dequeue();
 			contigQueueNotFull.wakeAll();
 			contigMutex.unlock();
 
+			/* Ends with the iteration */
+			TRACE_SPAN("insert contig");
+
 			/* 'file' table */
 			sqlQuery3.bindValue(":id", contig->file->getId());
 			sqlQuery3.bindValue(":fileName", contig->file->getName());
@@ -100,6 +155,7 @@ void ContigSaverThread::run()
 					<< ". Reason: "
 					<< sqlQuery3.lastError().text();
 				db.rollback();
+				hasError = true;
 				break;
 			}
 
@@ -116,6 +172,7 @@ void ContigSaverThread::run()
 			sqlQuery.bindValue(":zoomLevels", contig->zoomLevels);
 			sqlQuery.bindValue(":maxFragRows", contig->maxFragRows);
 			sqlQuery.bindValue(":fileId", contig->fileId);
+			sqlQuery.bindValue(":maxReadSize", contig->maxReadSize);
 			if (!sqlQuery.exec())
 			{
 				qCritical() << "Error inserting contig into DB in "
@@ -123,6 +180,7 @@ void ContigSaverThread::run()
 					<< ". Reason: "
 					<< sqlQuery.lastError().text();
 				db.rollback();
+				hasError = true;
 				break;
 			}
 
@@ -136,17 +194,140 @@ void ContigSaverThread::run()
 					<< ". Reason: "
 					<< sqlQuery2.lastError().text();
 				db.rollback();
+				hasError = true;
 				break;
 			}
+
+			/* 'contigCoverage' table */
+			sqlQuery5.bindValue(":contigId", contig->id);
+			sqlQuery5.bindValue(":runs", contig->coverageProfile.toByteArray());
+			if (contig->overflowProfile.isEmpty())
+				sqlQuery5.bindValue(":overflowRuns", QVariant(QVariant::ByteArray));
+			else
+				sqlQuery5.bindValue(":overflowRuns", contig->overflowProfile.toByteArray());
+			if (!sqlQuery5.exec())
+			{
+				qCritical() << "Error inserting contigCoverage into DB in "
+					<< this->metaObject()->className()
+					<< ". Reason: "
+					<< sqlQuery5.lastError().text();
+				db.rollback();
+				hasError = true;
+				break;
+			}
+
+			/* 'contigPads' table */
+			sqlQuery6.bindValue(":contigId", contig->id);
+			sqlQuery6.bindValue(":pads", contig->padIndex.toByteArray());
+			if (!sqlQuery6.exec())
+			{
+				qCritical() << "Error inserting contigPads into DB in "
+					<< this->metaObject()->className()
+					<< ". Reason: "
+					<< sqlQuery6.lastError().text();
+				db.rollback();
+				hasError = true;
+				break;
+			}
+
+			/* 'snp_pos' table; the SNP profile was computed by the
+			 * parser while the reads of this contig were read */
+			numSnps = contig->snpPosList.size();
+			if (numSnps > 0)
+			{
+				for (i = 0; i < numSnps; ++i)
+				{
+					contigIdList.append(contig->id);
+					posList.append(contig->snpPosList.at(i));
+					percentList.append((int) contig->snpVariationList.at(i));
+				}
+				sqlQuery4.bindValue(":contigId", contigIdList);
+				sqlQuery4.bindValue(":pos", posList);
+				sqlQuery4.bindValue(":variationPercent", percentList);
+				if (!sqlQuery4.execBatch())
+				{
+					qCritical() << "Error inserting SNPs into DB in "
+						<< this->metaObject()->className()
+						<< ". Reason: "
+						<< sqlQuery4.lastError().text();
+					db.rollback();
+					hasError = true;
+					break;
+				}
+				contigIdList.clear();
+				posList.clear();
+				percentList.clear();
+			}
+
+			uncommittedList.append(qMakePair(contig->id, contig->size));
+			PerfMetrics::add(PerfMetrics::ContigsSaved, 1);
 			delete contig;
 		}
-		if (!db.commit())
-			qCritical() << "Error committing transaction in "
-				<< this->metaObject()->className()
-				<< ". Reason: "
-				<< db.lastError().text();
+		if (!hasError)
+			commitContigs(db, snpDb, uncommittedList, false);
+		else
+			snpDb.rollback();
 	}
 	QSqlDatabase::removeDatabase(connectionName);
+	QSqlDatabase::removeDatabase(snpConnectionName);
 	//qDebug() << "ContigSaverThread end***";
 }
 
+
+/*
+ * Commits the current transactions and emits a signal for each contig
+ * that was part of them. SNPs are committed first so that they are
+ * available as soon as the contig is.
+ *
+ * @param db : Contig database connection
+ * @param snpDb : SNP database connection
+ * @param list : List of <contig ID, contig size> pairs that are part of
+ * the current transaction; it is cleared after the commit
+ * @param beginNext : Whether a new transaction should be started after
+ * the commit
+ *
+ * @return Returns true on success and false on failure
+ */
+bool ContigSaverThread::commitContigs(
+		QSqlDatabase &db,
+		QSqlDatabase &snpDb,
+		QList<QPair<int, int> > &list,
+		const bool beginNext)
+{
+	QPair<int, int> pair;
+
+	TRACE_SPAN("commit contigs");
+
+	if (!snpDb.commit())
+	{
+		qCritical() << "Error committing SNP transaction in "
+			<< this->metaObject()->className()
+			<< ". Reason: "
+			<< snpDb.lastError().text();
+		db.rollback();
+		return false;
+	}
+
+	if (!db.commit())
+	{
+		qCritical() << "Error committing transaction in "
+			<< this->metaObject()->className()
+			<< ". Reason: "
+			<< db.lastError().text();
+		return false;
+	}
+
+	foreach (pair, list)
+		emit contigSaved(pair.first, pair.second);
+	list.clear();
+
+	if (beginNext && (!db.transaction() || !snpDb.transaction()))
+	{
+		qCritical() << "Error beginning transaction in "
+			<< this->metaObject()->className()
+			<< ". Reason: "
+			<< db.lastError().text();
+		return false;
+	}
+	return true;
+}
@@ -3,6 +3,7 @@
 #define CONTIGSAVERTHREAD_H_
 
 #include <QThread>
+#include <QSqlDatabase>
 #include "contig.h"
 
 extern QMutex contigMutex;
@@ -25,10 +26,14 @@ public:
 //		if (!isRunning()) start();
 //	}
 
+    signals:
+    void contigSaved(int, int);
+
 protected:
 	void run();
 
-//private:
+private:
+	bool commitContigs(QSqlDatabase &, QSqlDatabase &, QList<QPair<int, int> > &, const bool);
 	//QQueue<Contig *> contigQueue;
 };
 
@@ -0,0 +1,369 @@
+
+#include "coverageProfile.h"
+#include <QDataStream>
+#include <QtAlgorithms>
+
+#define	RUNS_PER_BLOCK	256		/* Runs summarized by each min/max block */
+
+
+/**
+ * Constructor
+ */
+CoverageProfile::CoverageProfile()
+{
+
+}
+
+
+/**
+ * Destructor
+ */
+CoverageProfile::~CoverageProfile()
+{
+
+}
+
+
+/**
+ * Sets the profile from the given per-base depths. Consecutive bases
+ * with the same depth are stored as one run.
+ *
+ * @param depths : Read depth at each position of the contig
+ */
+void CoverageProfile::setDepths(const QVector<int> &depths)
+{
+	int i, size;
+
+	clear();
+	size = depths.size();
+	for (i = 0; i < size; ++i)
+	{
+		if (i == 0 || depths.at(i) != runDepths.last())
+		{
+			runEnds.append(i + 1);
+			runDepths.append(depths.at(i));
+		}
+		else
+			runEnds.last() = i + 1;
+	}
+	runEnds.squeeze();
+	runDepths.squeeze();
+	buildIndex();
+}
+
+
+/**
+ * Returns the runs of the profile in a form that can be stored in
+ * the DB
+ */
+QByteArray CoverageProfile::toByteArray() const
+{
+	QByteArray bytes;
+	QDataStream out(&bytes, QIODevice::WriteOnly);
+	out << runEnds << runDepths;
+	return bytes;
+}
+
+
+/**
+ * Sets the profile from runs that were stored using toByteArray()
+ *
+ * @param bytes : Stored runs
+ * @return Returns true on success and false if the data is not valid
+ */
+bool CoverageProfile::fromByteArray(const QByteArray &bytes)
+{
+	QDataStream in(bytes);
+
+	clear();
+	in >> runEnds >> runDepths;
+	if (in.status() != QDataStream::Ok || runEnds.size() != runDepths.size())
+	{
+		clear();
+		return false;
+	}
+	buildIndex();
+	return true;
+}
+
+
+/**
+ * Empties the profile
+ */
+void CoverageProfile::clear()
+{
+	runEnds.clear();
+	runDepths.clear();
+	runSums.clear();
+	prefixMins.clear();
+	prefixMaxs.clear();
+	suffixMins.clear();
+	suffixMaxs.clear();
+	blockMinTable.clear();
+	blockMaxTable.clear();
+	blockLogs.clear();
+}
+
+
+/**
+ * Returns the depth at the given position
+ *
+ * @param pos : 0-based position in the contig
+ */
+int CoverageProfile::getDepth(const int pos) const
+{
+	if (pos < 0 || pos >= getSize())
+		return 0;
+	return runDepths.at(findRun(pos));
+}
+
+
+/**
+ * Returns the mean depth over the given range of positions
+ *
+ * @param start : Start position (0-based, inclusive)
+ * @param end : End position (0-based, inclusive)
+ */
+qreal CoverageProfile::getMeanDepth(const int start, const int end) const
+{
+	int s = start, e = end;
+
+	if (!clip(s, e))
+		return 0.0;
+	return ((qreal) (getSum(e + 1) - getSum(s))) / (e - s + 1);
+}
+
+
+/**
+ * Returns the minimum depth over the given range of positions
+ *
+ * @param start : Start position (0-based, inclusive)
+ * @param end : End position (0-based, inclusive)
+ */
+int CoverageProfile::getMinDepth(const int start, const int end) const
+{
+	int minDepth, maxDepth;
+
+	getDepthRange(start, end, minDepth, maxDepth);
+	return minDepth;
+}
+
+
+/**
+ * Returns the maximum depth over the given range of positions
+ *
+ * @param start : Start position (0-based, inclusive)
+ * @param end : End position (0-based, inclusive)
+ */
+int CoverageProfile::getMaxDepth(const int start, const int end) const
+{
+	int minDepth, maxDepth;
+
+	getDepthRange(start, end, minDepth, maxDepth);
+	return maxDepth;
+}
+
+
+/**
+ * Returns the approximate number of bytes used by the profile
+ */
+qint64 CoverageProfile::getMemoryUsage() const
+{
+	qint64 bytes;
+	int k;
+
+	bytes = (runEnds.capacity() + runDepths.capacity()
+			+ prefixMins.capacity() + prefixMaxs.capacity()
+			+ suffixMins.capacity() + suffixMaxs.capacity()
+			+ blockLogs.capacity()) * sizeof(int)
+		+ runSums.capacity() * sizeof(qint64);
+	for (k = 0; k < blockMinTable.size(); ++k)
+		bytes += (blockMinTable.at(k).capacity() + blockMaxTable.at(k).capacity()) * sizeof(int);
+	return bytes;
+}
+
+
+/*
+ * Builds the prefix sums of the depths, the running minimum and maximum
+ * depth within each block of RUNS_PER_BLOCK runs in both directions, and
+ * a sparse table over the minimum and maximum depth of the blocks. The
+ * sparse table has log2(B) levels of B entries for B blocks, so with
+ * R runs the whole index takes O(R) space and time to build.
+ */
+void CoverageProfile::buildIndex()
+{
+	int i, k, b, numRuns, numBlocks, runStart, blockStart, blockEnd, width;
+	qint64 sum;
+
+	numRuns = runEnds.size();
+	runSums.resize(numRuns);
+	sum = 0;
+	runStart = 0;
+	for (i = 0; i < numRuns; ++i)
+	{
+		sum += (qint64) runDepths.at(i) * (runEnds.at(i) - runStart);
+		runSums[i] = sum;
+		runStart = runEnds.at(i);
+	}
+
+	prefixMins.resize(numRuns);
+	prefixMaxs.resize(numRuns);
+	suffixMins.resize(numRuns);
+	suffixMaxs.resize(numRuns);
+	numBlocks = (numRuns + RUNS_PER_BLOCK - 1) / RUNS_PER_BLOCK;
+	blockMinTable.clear();
+	blockMaxTable.clear();
+	if (numBlocks == 0)
+	{
+		blockLogs.clear();
+		return;
+	}
+	blockMinTable.append(QVector<int>(numBlocks));
+	blockMaxTable.append(QVector<int>(numBlocks));
+	for (b = 0; b < numBlocks; ++b)
+	{
+		blockStart = b * RUNS_PER_BLOCK;
+		blockEnd = qMin(blockStart + RUNS_PER_BLOCK, numRuns) - 1;
+		for (i = blockStart; i <= blockEnd; ++i)
+		{
+			prefixMins[i] = (i == blockStart)? runDepths.at(i): qMin(prefixMins.at(i - 1), runDepths.at(i));
+			prefixMaxs[i] = (i == blockStart)? runDepths.at(i): qMax(prefixMaxs.at(i - 1), runDepths.at(i));
+		}
+		for (i = blockEnd; i >= blockStart; --i)
+		{
+			suffixMins[i] = (i == blockEnd)? runDepths.at(i): qMin(suffixMins.at(i + 1), runDepths.at(i));
+			suffixMaxs[i] = (i == blockEnd)? runDepths.at(i): qMax(suffixMaxs.at(i + 1), runDepths.at(i));
+		}
+		blockMinTable[0][b] = prefixMins.at(blockEnd);
+		blockMaxTable[0][b] = prefixMaxs.at(blockEnd);
+	}
+
+	/* blockLogs[n] is floor(log2(n)), the level whose entries cover the
+	 * most of n blocks without going past them */
+	blockLogs.resize(numBlocks + 1);
+	blockLogs[0] = 0;
+	for (b = 1; b <= numBlocks; ++b)
+		blockLogs[b] = (b == 1)? 0: blockLogs.at(b / 2) + 1;
+
+	/* Level k covers 2^k blocks and is made of two halves of level k - 1 */
+	for (k = 1, width = 2; width <= numBlocks; ++k, width *= 2)
+	{
+		blockMinTable.append(QVector<int>(numBlocks - width + 1));
+		blockMaxTable.append(QVector<int>(numBlocks - width + 1));
+		for (b = 0; b + width <= numBlocks; ++b)
+		{
+			blockMinTable[k][b] = qMin(blockMinTable.at(k - 1).at(b),
+					blockMinTable.at(k - 1).at(b + width / 2));
+			blockMaxTable[k][b] = qMax(blockMaxTable.at(k - 1).at(b),
+					blockMaxTable.at(k - 1).at(b + width / 2));
+		}
+	}
+}
+
+
+/*
+ * Finds the minimum and maximum depth over the given range of positions.
+ * Both are 0 if the range is empty.
+ *
+ * Finding the runs at the ends of the range takes O(log R) for R runs.
+ * When the runs are in different blocks, the rest takes constant time:
+ * the partial blocks at both ends come from the running minima and
+ * maxima, and the whole blocks in between from two overlapping entries
+ * of the sparse table. When both runs are in the same block, its runs
+ * between them are scanned, which visits at most RUNS_PER_BLOCK runs.
+ */
+void CoverageProfile::getDepthRange(const int start, const int end,
+		int &minDepth, int &maxDepth) const
+{
+	int s = start, e = end, run1, run2, block1, block2, i, blockMin, blockMax;
+
+	minDepth = 0;
+	maxDepth = 0;
+	if (!clip(s, e))
+		return;
+	run1 = findRun(s);
+	run2 = findRun(e);
+	block1 = run1 / RUNS_PER_BLOCK;
+	block2 = run2 / RUNS_PER_BLOCK;
+
+	if (block1 == block2)
+	{
+		minDepth = runDepths.at(run1);
+		maxDepth = minDepth;
+		for (i = run1 + 1; i <= run2; ++i)
+		{
+			minDepth = qMin(minDepth, runDepths.at(i));
+			maxDepth = qMax(maxDepth, runDepths.at(i));
+		}
+		return;
+	}
+
+	minDepth = qMin(suffixMins.at(run1), prefixMins.at(run2));
+	maxDepth = qMax(suffixMaxs.at(run1), prefixMaxs.at(run2));
+	if (block2 - block1 > 1)
+	{
+		getBlockRange(block1 + 1, block2 - 1, blockMin, blockMax);
+		minDepth = qMin(minDepth, blockMin);
+		maxDepth = qMax(maxDepth, blockMax);
+	}
+}
+
+
+/*
+ * Finds the minimum and maximum depth of the given blocks (inclusive)
+ * from the two entries of the sparse table that together cover them
+ */
+void CoverageProfile::getBlockRange(const int firstBlock, const int lastBlock,
+		int &minDepth, int &maxDepth) const
+{
+	int k, width;
+
+	k = blockLogs.at(lastBlock - firstBlock + 1);
+	width = 1 << k;
+	minDepth = qMin(blockMinTable.at(k).at(firstBlock),
+			blockMinTable.at(k).at(lastBlock - width + 1));
+	maxDepth = qMax(blockMaxTable.at(k).at(firstBlock),
+			blockMaxTable.at(k).at(lastBlock - width + 1));
+}
+
+
+/*
+ * Returns the index of the run that contains the given position
+ */
+int CoverageProfile::findRun(const int pos) const
+{
+	return qUpperBound(runEnds.constBegin(), runEnds.constEnd(), pos)
+		- runEnds.constBegin();
+}
+
+
+/*
+ * Returns the sum of the depths of the positions before the given one
+ */
+qint64 CoverageProfile::getSum(const int pos) const
+{
+	int run, runStart;
+
+	if (pos <= 0)
+		return 0;
+	if (pos >= getSize())
+		return runSums.last();
+	run = findRun(pos);
+	runStart = (run > 0)? runEnds.at(run - 1): 0;
+	return ((run > 0)? runSums.at(run - 1): 0)
+		+ (qint64) runDepths.at(run) * (pos - runStart);
+}
+
+
+/*
+ * Clips the given range to the profile; returns false if nothing
+ * is left
+ */
+bool CoverageProfile::clip(int &start, int &end) const
+{
+	if (start < 0)
+		start = 0;
+	if (end >= getSize())
+		end = getSize() - 1;
+	return (start <= end);
+}
@@ -0,0 +1,56 @@
+#ifndef COVERAGEPROFILE_H_
+#define COVERAGEPROFILE_H_
+
+#include <QVector>
+#include <QByteArray>
+
+/*
+ * Read depth along a contig, stored as runs of equal depth. The mean
+ * depth over a range is found from prefix sums and the minimum and
+ * maximum depth from a sparse table over blocks of runs. With R runs,
+ * each query takes O(log R) to find the runs at the ends of the range,
+ * plus at most a fixed number of runs scanned when both ends fall in
+ * the same block; the index takes O(R) space.
+ */
+class CoverageProfile
+{
+public:
+	CoverageProfile();
+	~CoverageProfile();
+	void setDepths(const QVector<int> &);
+	QByteArray toByteArray() const;
+	bool fromByteArray(const QByteArray &);
+	void clear();
+	int getDepth(const int) const;
+	qreal getMeanDepth(const int, const int) const;
+	int getMinDepth(const int, const int) const;
+	int getMaxDepth(const int, const int) const;
+	qint64 getMemoryUsage() const;
+
+	/** Returns whether the profile has been loaded */
+	inline bool isEmpty() const { return runEnds.isEmpty(); };
+
+	/** Returns the number of positions covered by the profile */
+	inline int getSize() const { return (runEnds.isEmpty()? 0: runEnds.last()); };
+
+private:
+	QVector<int> runEnds;			/* One past the last position of each run */
+	QVector<int> runDepths;			/* Depth of each run */
+	QVector<qint64> runSums;		/* Sum of depths up to the end of each run */
+	QVector<int> prefixMins;		/* Minimum depth from the start of its block to each run */
+	QVector<int> prefixMaxs;		/* Maximum depth from the start of its block to each run */
+	QVector<int> suffixMins;		/* Minimum depth from each run to the end of its block */
+	QVector<int> suffixMaxs;		/* Maximum depth from each run to the end of its block */
+	QVector<QVector<int> > blockMinTable;	/* [k][b]: minimum depth of blocks b to b + 2^k - 1 */
+	QVector<QVector<int> > blockMaxTable;	/* [k][b]: maximum depth of blocks b to b + 2^k - 1 */
+	QVector<int> blockLogs;			/* floor(log2(n)) for each number of blocks n */
+
+	void buildIndex();
+	void getDepthRange(const int, const int, int &, int &) const;
+	void getBlockRange(const int, const int, int &, int &) const;
+	int findRun(const int) const;
+	qint64 getSum(const int) const;
+	bool clip(int &, int &) const;
+};
+
+#endif /* COVERAGEPROFILE_H_ */
@@ -0,0 +1,381 @@
+
+#include "dataGenerator.h"
+#include <QDir>
+#include <QFile>
+#include <QList>
+#include <QtAlgorithms>
+#include <QtDebug>
+#include <string.h>
+
+#define	LINE_LENGTH		60		/* Bases per sequence line */
+#define	QUAL_PER_LINE	50		/* Quality values per BQ line */
+#define	BASE_QUALITY	"30"
+#define	CONTIG_GAP		1000	/* Bases between neighbouring contigs on a chromosome */
+#define	GENE_SPACING	5000	/* Bases between the starts of neighbouring genes */
+#define	GENE_LENGTH		2000
+#define	SNP_BED_FILE	"snps.bed"
+#define	GENE_BED_FILE	"genes.bed"
+
+static const char bases[] = "ACGT";
+
+
+/**
+ * Constructor
+ */
+DataGenerator::DataGenerator()
+{
+	numContigs = 5;
+	contigLength = 50000;
+	readLength = 100;
+	depth = 10;
+	snpRate = 0.001;
+	padRate = 0.002;
+	multiMapRate = 0.01;
+	numChromosomes = 1;
+	longReadLength = 0;
+	stackDepth = 0;
+	seed = 1;
+	state = seed;
+}
+
+
+/**
+ * Destructor
+ */
+DataGenerator::~DataGenerator()
+{
+
+}
+
+
+/**
+ * Writes an ACE file, a matching 'order.txt' file and SNP and gene BED
+ * tracks into the given directory. The same settings and seed always
+ * produce the same files.
+ *
+ * @param dir : Output directory; it is created if it does not exist
+ * @return Returns true on success and false on failure
+ */
+bool DataGenerator::write(const QString &dir)
+{
+	if (!QDir().mkpath(dir))
+	{
+		qCritical() << "Cannot create directory " << dir;
+		return false;
+	}
+	state = (seed == 0)? 1: seed;
+	return writeAce(dir)
+		&& writeOrderFile(dir)
+		&& writeGeneFile(dir);
+}
+
+
+/*
+ * Returns the next number of the xorshift generator
+ */
+quint32 DataGenerator::nextRandom()
+{
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+
+/*
+ * Returns a random integer from 0 to n - 1
+ */
+int DataGenerator::nextInt(const int n)
+{
+	return (n <= 1)? 0: (int) (nextRandom() % (quint32) n);
+}
+
+
+/*
+ * Returns a random number from 0 (inclusive) to 1 (exclusive)
+ */
+qreal DataGenerator::nextReal()
+{
+	return nextRandom() / 4294967296.0;
+}
+
+
+/*
+ * Writes the given sequence in lines of LINE_LENGTH bases, followed by
+ * an empty line
+ */
+void DataGenerator::writeSequence(QTextStream &out, const QByteArray &seq)
+{
+	int i;
+
+	for (i = 0; i < seq.size(); i += LINE_LENGTH)
+		out << seq.mid(i, LINE_LENGTH) << "\n";
+	out << "\n";
+}
+
+
+/*
+ * Makes a random padded contig sequence with the given unpadded length.
+ * 'alt' is set to the alternate base at each SNP and to 0 elsewhere, and
+ * 'snpPosList' to the unpadded 0-based positions of the SNPs.
+ */
+void DataGenerator::makeContig(
+		const int length,
+		QByteArray &seq,
+		QByteArray &alt,
+		QList<int> &snpPosList)
+{
+	int i;
+	char base;
+
+	seq.clear();
+	alt.clear();
+	snpPosList.clear();
+	seq.reserve(length + (int) (length * padRate) + 1);
+	for (i = 0; i < length; ++i)
+	{
+		base = bases[nextInt(4)];
+		seq.append(base);
+		if (nextReal() < snpRate)
+		{
+			alt.append(bases[(strchr(bases, base) - bases + 1 + nextInt(3)) % 4]);
+			snpPosList.append(i);
+		}
+		else
+			alt.append('\0');
+		if (nextReal() < padRate)
+		{
+			seq.append('*');
+			alt.append('\0');
+		}
+	}
+}
+
+
+/*
+ * Returns the unpadded length of the given contig (0-based index). The
+ * first contig is lengthened to hold the extra long read.
+ */
+int DataGenerator::getContigLength(const int contigIndex) const
+{
+	if (contigIndex == 0)
+		return qMax(contigLength, longReadLength);
+	return contigLength;
+}
+
+
+/*
+ * Returns the name of the chromosome that the given contig (0-based
+ * index) is placed on
+ */
+QString DataGenerator::getChromName(const int contigIndex) const
+{
+	return "chr" + QString::number((contigIndex % numChromosomes) + 1);
+}
+
+
+/*
+ * Returns the 1-based start position of the given contig (0-based
+ * index) on its chromosome
+ */
+int DataGenerator::getChromStart(const int contigIndex) const
+{
+	int start;
+
+	start = 1 + (contigIndex / numChromosomes) * (contigLength + CONTIG_GAP);
+
+	/* Contigs after the first one on its chromosome make room for it */
+	if (contigIndex >= numChromosomes && contigIndex % numChromosomes == 0)
+		start += getContigLength(0) - contigLength;
+	return start;
+}
+
+
+/*
+ * Writes the ACE file and, since the SNP positions are only known while
+ * the contigs are made, the SNP track
+ */
+bool DataGenerator::writeAce(const QString &dir)
+{
+	QFile file(QDir(dir).filePath(getAceFileName()));
+	QFile snpFile(QDir(dir).filePath(SNP_BED_FILE));
+	QByteArray seq, alt, readSeq;
+	QList<QByteArray> nameList, prevNameList;
+	QList<int> startList, spanList, snpPosList;
+	QByteArray name;
+	int i, j, k, numReads, numContigReads, readSpan, readNum, snpNum, chromStart;
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text)
+			|| !snpFile.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qCritical() << "Cannot write files in " << dir;
+		return false;
+	}
+	QTextStream out(&file);
+	QTextStream snpOut(&snpFile);
+
+	numReads = (int) ((qint64) depth * contigLength / qMax(readLength, 1));
+	out << "AS " << numContigs << " "
+		<< ((qint64) numContigs * numReads + stackDepth + ((longReadLength > 0)? 1: 0))
+		<< "\n\n";
+	snpOut << "track name=\"SNPs\" description=\"Synthetic SNPs\"\n";
+
+	readNum = 0;
+	snpNum = 0;
+	for (i = 0; i < numContigs; ++i)
+	{
+		makeContig(getContigLength(i), seq, alt, snpPosList);
+		readSpan = qMin(readLength, seq.size());
+
+		/* Read placements, sorted by start position. The extra reads of
+		 * the first contig all start at its first base, which makes the
+		 * row layout as deep as the number of stacked reads. */
+		startList.clear();
+		spanList.clear();
+		if (i == 0)
+		{
+			if (longReadLength > 0)
+			{
+				startList.append(1);
+				spanList.append(longReadLength);
+			}
+			for (j = 0; j < stackDepth; ++j)
+			{
+				startList.append(1);
+				spanList.append(readSpan);
+			}
+		}
+		for (j = 0; j < numReads; ++j)
+			spanList.append(readSpan);
+		for (j = 0; j < numReads; ++j)
+			startList.append(1 + nextInt(seq.size() - readSpan + 1));
+		qSort(startList);
+		numContigReads = startList.size();
+
+		/* Contig sequence and base qualities (one per unpadded base) */
+		out << "CO Contig" << (i + 1) << " " << seq.size() << " "
+			<< numContigReads << " 1 U\n";
+		writeSequence(out, seq);
+		out << "BQ\n";
+		for (j = 0; j < getContigLength(i); j += QUAL_PER_LINE)
+		{
+			for (k = j; k < j + QUAL_PER_LINE && k < getContigLength(i); ++k)
+				out << " " << BASE_QUALITY;
+			out << "\n";
+		}
+		out << "\n";
+
+		/* SNP track, in chromosome coordinates */
+		chromStart = getChromStart(i);
+		foreach (k, snpPosList)
+		{
+			snpOut << getChromName(i) << "\t" << (chromStart + k - 1) << "\t"
+				<< (chromStart + k) << "\tsnp" << ++snpNum << "\n";
+		}
+
+		/* Some reads reuse the name of a read of the previous contig, so
+		 * that they are counted as mapping to several contigs */
+		nameList.clear();
+		for (j = 0; j < numContigReads; ++j)
+		{
+			if (!prevNameList.isEmpty() && nextReal() < multiMapRate)
+				name = prevNameList.at(nextInt(prevNameList.size()));
+			else
+				name = "read" + QByteArray::number(++readNum);
+			nameList.append(name);
+			out << "AF " << name << " " << (nextInt(2)? "C": "U") << " "
+				<< startList.at(j) << "\n";
+		}
+		if (numContigReads > 0)
+			out << "BS 1 " << seq.size() << " " << nameList.at(0) << "\n";
+		out << "\n";
+
+		/* Read sequences; a read carries the alternate base of a SNP
+		 * half of the time */
+		for (j = 0; j < numContigReads; ++j)
+		{
+			readSeq = seq.mid(startList.at(j) - 1, spanList.at(j));
+			for (k = 0; k < readSeq.size(); ++k)
+			{
+				if (alt.at(startList.at(j) - 1 + k) != '\0' && nextInt(2))
+					readSeq[k] = alt.at(startList.at(j) - 1 + k);
+			}
+			out << "RD " << nameList.at(j) << " " << readSeq.size() << " 0 0\n";
+			writeSequence(out, readSeq);
+			out << "QA 1 " << readSeq.size() << " 1 " << readSeq.size() << "\n";
+			out << "DS CHROMAT_FILE: " << nameList.at(j)
+				<< " PHD_FILE: " << nameList.at(j) << ".phd.1 TIME: synthetic\n\n";
+		}
+		prevNameList = nameList;
+
+		if (out.status() != QTextStream::Ok)
+		{
+			qCritical() << "Error writing " << file.fileName();
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/*
+ * Writes 'order.txt', which places the contigs on the chromosomes and
+ * lists the annotation tracks
+ */
+bool DataGenerator::writeOrderFile(const QString &dir)
+{
+	QFile file(QDir(dir).filePath("order.txt"));
+	int i;
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qCritical() << "Cannot write file " << file.fileName();
+		return false;
+	}
+	QTextStream out(&file);
+
+	out << "[annotation files]\n"
+		<< GENE_BED_FILE << "\tgene\tGenes\n"
+		<< SNP_BED_FILE << "\tsnp\tSNPs\n"
+		<< "[/annotation files]\n\n"
+		<< "[sequence files]\n";
+	for (i = 0; i < numContigs; ++i)
+	{
+		out << getChromName(i) << "\t" << getChromStart(i) << "\t"
+			<< (getChromStart(i) + getContigLength(i) - 1) << "\tContig" << (i + 1)
+			<< "\n";
+	}
+	out << "[/sequence files]\n";
+	return (out.status() == QTextStream::Ok);
+}
+
+
+/*
+ * Writes the gene track, with a gene every GENE_SPACING bases
+ */
+bool DataGenerator::writeGeneFile(const QString &dir)
+{
+	QFile file(QDir(dir).filePath(GENE_BED_FILE));
+	int i, pos, geneNum, chromStart;
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+	{
+		qCritical() << "Cannot write file " << file.fileName();
+		return false;
+	}
+	QTextStream out(&file);
+
+	out << "track name=\"Genes\" description=\"Synthetic genes\"\n";
+	geneNum = 0;
+	for (i = 0; i < numContigs; ++i)
+	{
+		chromStart = getChromStart(i);
+		for (pos = 0; pos + GENE_LENGTH <= contigLength; pos += GENE_SPACING)
+		{
+			out << getChromName(i) << "\t" << (chromStart + pos - 1) << "\t"
+				<< (chromStart + pos + GENE_LENGTH - 1) << "\tgene" << ++geneNum
+				<< "\t0\t" << (nextInt(2)? "+": "-") << "\n";
+		}
+	}
+	return (out.status() == QTextStream::Ok);
+}
@@ -0,0 +1,61 @@
+#ifndef DATAGENERATOR_H_
+#define DATAGENERATOR_H_
+
+#include <QByteArray>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+class DataGenerator
+{
+public:
+	DataGenerator();
+	~DataGenerator();
+	bool write(const QString &);
+
+	inline void setNumContigs(const int n) { numContigs = n; };
+	inline void setContigLength(const int n) { contigLength = n; };
+	inline void setReadLength(const int n) { readLength = n; };
+	inline void setDepth(const int n) { depth = n; };
+	inline void setSnpRate(const qreal r) { snpRate = r; };
+	inline void setPadRate(const qreal r) { padRate = r; };
+	inline void setMultiMapRate(const qreal r) { multiMapRate = r; };
+	inline void setNumChromosomes(const int n) { numChromosomes = n; };
+	inline void setSeed(const quint32 s) { seed = s; };
+	inline void setLongReadLength(const int n) { longReadLength = n; };
+	inline void setStackDepth(const int n) { stackDepth = n; };
+
+	inline int getNumContigs() const { return numContigs; };
+	inline int getLongReadLength() const { return longReadLength; };
+	inline int getStackDepth() const { return stackDepth; };
+	inline QString getAceFileName() const { return "synthetic.ace"; };
+
+private:
+	int numContigs;			/* Number of contigs */
+	int contigLength;		/* Unpadded length of each contig */
+	int readLength;			/* Unpadded length of each read */
+	int depth;				/* Average read depth */
+	qreal snpRate;			/* Fraction of the contig bases that are SNPs */
+	qreal padRate;			/* Fraction of the contig bases followed by a pad */
+	qreal multiMapRate;		/* Fraction of the reads that reuse an earlier read name */
+	int numChromosomes;		/* Number of chromosomes the contigs are placed on */
+	int longReadLength;		/* Length of an extra read on the first contig, 0 for none */
+	int stackDepth;			/* Number of extra reads stacked at the start of the first contig */
+	quint32 seed;			/* Seed of the random number generator */
+	quint32 state;			/* State of the random number generator */
+
+	quint32 nextRandom();
+	int nextInt(const int);
+	qreal nextReal();
+	void writeSequence(QTextStream &, const QByteArray &);
+	void makeContig(const int, QByteArray &, QByteArray &, QList<int> &);
+	int getContigLength(const int) const;
+	QString getChromName(const int) const;
+	int getChromStart(const int) const;
+	bool writeAce(const QString &);
+	bool writeOrderFile(const QString &);
+	bool writeGeneFile(const QString &);
+};
+
+#endif /* DATAGENERATOR_H_ */
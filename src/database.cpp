@@ -3,6 +3,11 @@
 #include <QSqlQuery>
 #include <QSqlError>
 #include <QtGui>
+#include "contigPlacementIndex.h"
+#include "perfMetrics.h"
+#include "slowQueryLog.h"
+#include "trace.h"
+#include <QElapsedTimer>
 //#include <QSqlDatabase>
 
 QString Database::contigDBConnection = "contigDBConnection";
@@ -13,6 +18,7 @@ QString Database::contigDBName = "contigDB";
 QString Database::fragDBName = "fragDB";
 QString Database::snpDBName = "snpDB";
 QString Database::annotationDBName = "annotationDB";
+QString Database::directory = "";
 
 
 /**
@@ -72,7 +78,9 @@ QSqlDatabase Database::createConnection(
 	if (!query.exec("PRAGMA encoding='UTF-8';"))
 		qCritical() << "Error issuing 'pragma encoding' command in Database. Reason: "
 			<< query.lastError().text();
-	if (!query.exec("PRAGMA journal_mode='TRUNCATE';"))
+	/* Write-ahead logging lets the viewer read contigs that the saver
+	 * threads have already committed while the import is still running */
+	if (!query.exec("PRAGMA journal_mode=WAL;"))
 		qCritical() << "Error issuing 'pragma journal_mode' command in Database. Reason: "
 			<< query.lastError().text();
 //	if (!query.exec("PRAGMA cache_size=10000;"))
@@ -86,6 +94,76 @@ QSqlDatabase Database::createConnection(
 }
 
 
+/**
+ * Keeps the DBs in the given project directory instead of the current
+ * directory. Must be called before any connection is created.
+ *
+ * @param dir : Project directory
+ */
+void Database::setDirectory(const QString &dir)
+{
+	directory = QDir(dir).absolutePath();
+	contigDBName = QDir(directory).filePath("contigDB");
+	fragDBName = QDir(directory).filePath("fragDB");
+	snpDBName = QDir(directory).filePath("snpDB");
+	annotationDBName = QDir(directory).filePath("annotationDB");
+}
+
+
+/**
+ * Executes the given statement and times it. Statements that take
+ * longer than the slow query threshold are logged together with their
+ * query plan and call site. Use it through the DB_EXEC macro, which
+ * fills in the call site.
+ *
+ * @param query : Query object that executes the statement
+ * @param sql : Statement
+ * @param file : Source file that issues the statement
+ * @param line : Line that issues the statement
+ *
+ * @return Returns the result of QSqlQuery::exec()
+ */
+bool Database::exec(
+		QSqlQuery &query,
+		const QString &sql,
+		const char *file,
+		const int line)
+{
+	QElapsedTimer timer;
+	qint64 nsecs;
+	bool ok;
+
+	{
+		TRACE_SPAN("SQL exec");
+		timer.start();
+		ok = query.exec(sql);
+		nsecs = timer.nsecsElapsed();
+	}
+	PerfMetrics::recordQuery(nsecs);
+	if (ok && SlowQueryLog::getThreshold() > 0
+			&& nsecs >= (qint64) SlowQueryLog::getThreshold() * 1000000)
+	{
+		SlowQueryLog::record(
+				query,
+				QFileInfo(file).fileName() + ":" + QString::number(line),
+				nsecs);
+	}
+	return ok;
+}
+
+
+/**
+ * Returns the statement that indexes the fragment table by contig and
+ * start position. The index is created after an import has saved all
+ * the fragments, and on demand for projects imported without it.
+ */
+QString Database::getFragIndexSql()
+{
+	return "CREATE INDEX IF NOT EXISTS fragment_contigId_startPos "
+			" ON fragment (contig_id, startPos)";
+}
+
+
 /**
  * Closes connection
  */
@@ -108,6 +186,8 @@ void Database::deleteContig()
 		QSqlQuery query(db);
 		query.exec("begin");
 		query.exec("delete from contigSeq");
+		query.exec("delete from contigCoverage");
+		query.exec("delete from contigPads");
 		query.exec("delete from chrom_contig");
 		query.exec("delete from cytoband");
 		query.exec("delete from chromosome");
@@ -117,6 +197,7 @@ void Database::deleteContig()
 		query.exec("vacuum");
 	}
 	QSqlDatabase::removeDatabase(contigDBConnection);
+	ContigPlacementIndex::resetShared();
 }
 
 
@@ -232,13 +313,19 @@ void Database::createTables()
 				" maxFragRows INTEGER NOT NULL, "
 				" fileId INTEGER NOT NULL "
 				" REFERENCES file (id) "
-				" ON DELETE RESTRICT ON UPDATE CASCADE)";
+				" ON DELETE RESTRICT ON UPDATE CASCADE, "
+				" maxReadSize INTEGER NOT NULL DEFAULT 0)";
 		if (!contigDBQuery.exec(str))
 		{
 			qCritical() << "Error creating contig table in the DB.";
 			qCritical() << contigDBQuery.lastError().text();
 		}
 
+		/* Tables created before region export was supported lack the
+		 * 'maxReadSize' column; this fails harmlessly if it exists */
+		contigDBQuery.exec("ALTER TABLE contig "
+				" ADD COLUMN maxReadSize INTEGER NOT NULL DEFAULT 0");
+
 		/* Create contigSeq table */
 		str = "CREATE TABLE IF NOT EXISTS contigSeq "
 				" (id INTEGER NOT NULL PRIMARY KEY, "
@@ -252,6 +339,39 @@ void Database::createTables()
 			qCritical() << contigDBQuery.lastError().text();
 		}
 
+		/* Create contigCoverage table; 'runs' holds the run-length
+		 * encoded read depth of the contig and 'overflowRuns' the
+		 * number of reads that did not fit in the row layout */
+		str = "CREATE TABLE IF NOT EXISTS contigCoverage "
+				" (contigId INTEGER NOT NULL PRIMARY KEY "
+				" REFERENCES contig (id) "
+				" ON DELETE RESTRICT ON UPDATE CASCADE, "
+				" runs BLOB NOT NULL, "
+				" overflowRuns BLOB DEFAULT NULL )";
+		if (!contigDBQuery.exec(str))
+		{
+			qCritical() << "Error creating contigCoverage table in the DB.";
+			qCritical() << contigDBQuery.lastError().text();
+		}
+
+		/* Tables created before the row layout was capped lack the
+		 * 'overflowRuns' column; this fails harmlessly if it exists */
+		contigDBQuery.exec("ALTER TABLE contigCoverage "
+				" ADD COLUMN overflowRuns BLOB DEFAULT NULL");
+
+		/* Create contigPads table; 'pads' holds the pad ('*') bitmap
+		 * of the contig sequence */
+		str = "CREATE TABLE IF NOT EXISTS contigPads "
+				" (contigId INTEGER NOT NULL PRIMARY KEY "
+				" REFERENCES contig (id) "
+				" ON DELETE RESTRICT ON UPDATE CASCADE, "
+				" pads BLOB NOT NULL )";
+		if (!contigDBQuery.exec(str))
+		{
+			qCritical() << "Error creating contigPads table in the DB.";
+			qCritical() << contigDBQuery.lastError().text();
+		}
+
 		/* Create Fragment table */
 		QSqlQuery fragDBQuery(fragDB);
 		str = "CREATE TABLE IF NOT EXISTS fragment "
@@ -335,6 +455,15 @@ void Database::createTables()
 			qCritical() << annotationDBQuery.lastError().text();
 		}
 
+		/* Substructures are read gene by gene */
+		str = "CREATE INDEX IF NOT EXISTS geneStructure_geneId "
+				" ON geneStructure (geneId, start)";
+		if (!annotationDBQuery.exec(str))
+		{
+			qCritical() << "Error creating geneStructure_geneId index in the DB.";
+			qCritical() << annotationDBQuery.lastError().text();
+		}
+
 		/* Create Chromosome table */
 		str = "CREATE TABLE IF NOT EXISTS chromosome "
 				" (id INTEGER NOT NULL PRIMARY KEY, "
@@ -353,19 +482,26 @@ void Database::createTables()
 				" contigId INTEGER NOT NULL REFERENCES contig (id) "
 				" ON DELETE RESTRICT ON UPDATE CASCADE, "
 				" chromStart INTEGER NOT NULL, "
-				" chromEnd INTEGER NOT NULL) ";
+				" chromEnd INTEGER NOT NULL, "
+				" strand CHAR(1) NOT NULL DEFAULT '+') ";
 		if (!contigDBQuery.exec(str))
 		{
 			qCritical() << "Error creating chrom_contig table in the DB.";
 			qCritical() << contigDBQuery.lastError().text();
 		}
 
+		/* Tables created before contig orientation was supported lack
+		 * the 'strand' column; this fails harmlessly if it exists */
+		contigDBQuery.exec("ALTER TABLE chrom_contig "
+				" ADD COLUMN strand CHAR(1) NOT NULL DEFAULT '+'");
+
 		/* Create 'annotationType' table */
 		str = "CREATE TABLE IF NOT EXISTS annotationType "
 				" (id INTEGER NOT NULL PRIMARY KEY, "
 				" type INTEGER NOT NULL, "
 				" annotOrder INTEGER NOT NULL, "
 				" alias VARCHAR (50) NOT NULL, "
+				" indexedFile VARCHAR (200) DEFAULT NULL, "
 				" fileId INTEGER NOT NULL REFERENCES file (id) "
 				" ON DELETE RESTRICT ON UPDATE CASCADE) ";
 		if (!annotationDBQuery.exec(str))
@@ -374,6 +510,11 @@ void Database::createTables()
 			qCritical() << annotationDBQuery.lastError().text();
 		}
 
+		/* Tables created before indexed tracks were supported lack the
+		 * 'indexedFile' column; this fails harmlessly if it exists */
+		annotationDBQuery.exec("ALTER TABLE annotationType "
+				" ADD COLUMN indexedFile VARCHAR (200) DEFAULT NULL");
+
 		/* Create 'bookmark' table */
 		str = "CREATE TABLE IF NOT EXISTS bookmark "
 				" (id INTEGER NOT NULL PRIMARY KEY, "
@@ -4,6 +4,13 @@
 
 #include <QObject>
 #include <QSqlDatabase>
+#include <QSqlQuery>
+
+/*
+ * Executes an SQL statement through Database::exec(), recording the
+ * file and line it is issued from
+ */
+#define	DB_EXEC(query, sql)	Database::exec(query, sql, __FILE__, __LINE__)
 
 class Database : public QObject
 {
@@ -25,6 +32,13 @@ public:
     bool endTransaction();
     static bool endTransaction(QSqlDatabase);
     static QSqlDatabase createConnection(const QString &, const QString &);
+    static void setDirectory(const QString &);
+    static bool exec(QSqlQuery &, const QString &, const char *, const int);
+    static QString getFragIndexSql();
+
+    /** Returns whether the DBs belong to a project directory, which
+     * is kept when the application exits */
+    inline static bool hasDirectory() { return !directory.isEmpty(); };
 
     inline static QString &getContigDBName() { return contigDBName; };
     inline static QString &getFragDBName() { return fragDBName; };
@@ -47,6 +61,7 @@ private:
 	static QString fragDBName;
 	static QString snpDBName;
 	static QString annotationDBName;
+	static QString directory;
 
 	void deleteContig();
 	void deleteFrag();
@@ -0,0 +1,108 @@
+#include <QCoreApplication>
+#include <QDir>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+#include <QThreadPool>
+#include "database.h"
+#include "alignmentExporterThread.h"
+#include "trace.h"
+
+/*
+ * Command-line exporter. Writes the reads of a project directory, as
+ * created by 'basejumper-import', to a coordinate-sorted SAM file or to
+ * a BAM file with a '.bai' index.
+ */
+
+
+/*
+ * Prints the usage message
+ */
+static void printUsage()
+{
+	QTextStream err(stderr);
+
+	err << "Usage: basejumper-export --project <dir> [options] <output .bam or .sam>\n"
+		<< "Options:\n"
+		<< "  --project <dir>     Project directory\n"
+		<< "  --threads <n>       Threads compressing BAM blocks (default: one per core)\n"
+		<< "  --trace <file>      Record a trace viewable in chrome://tracing\n";
+}
+
+
+int main(int argc, char *argv[])
+{
+	QCoreApplication app(argc, argv);
+	QStringList args;
+	QString projectDir, outFile, arg;
+	AlignmentExporterThread *exporter;
+	bool ok;
+	int i, n;
+
+	args = app.arguments();
+	for (i = 1; i < args.size(); ++i)
+	{
+		arg = args.at(i);
+		if (arg.startsWith("--") && i + 1 >= args.size())
+		{
+			printUsage();
+			return 2;
+		}
+		if (arg == "--project")
+			projectDir = args.at(++i);
+		else if (arg == "--threads")
+		{
+			n = args.at(++i).toInt(&ok);
+			if (!ok || n <= 0)
+			{
+				printUsage();
+				return 2;
+			}
+			QThreadPool::globalInstance()->setMaxThreadCount(n);
+		}
+		else if (arg == "--trace")
+		{
+			if (!Trace::start(args.at(++i)))
+				return 1;
+		}
+		else if (arg.startsWith("--") || !outFile.isEmpty())
+		{
+			printUsage();
+			return 2;
+		}
+		else
+			outFile = arg;
+	}
+	if (projectDir.isEmpty() || outFile.isEmpty())
+	{
+		printUsage();
+		return 2;
+	}
+
+	Database::setDirectory(projectDir);
+	if (!QFile::exists(Database::getContigDBName())
+			|| !QFile::exists(Database::getFragDBName()))
+	{
+		QTextStream(stderr) << "No project found in " << projectDir << "\n";
+		return 1;
+	}
+
+	/* Nothing listens to the exporter's messages; errors go to stderr */
+	exporter = new AlignmentExporterThread;
+	exporter->setFile(
+			outFile,
+			outFile.endsWith(".sam", Qt::CaseInsensitive)?
+					AlignmentExporterThread::Sam: AlignmentExporterThread::Bam);
+	exporter->start();
+	exporter->wait();
+
+	n = exporter->hasSucceeded()? 0: 1;
+	if (n == 0)
+	{
+		QTextStream(stderr) << exporter->getNumReads() << " reads written to "
+			<< outFile << "\n";
+	}
+	Trace::stop();
+	delete exporter;
+	return n;
+}
@@ -0,0 +1,162 @@
+
+#include "fastaReader.h"
+#include <QList>
+#include <QtDebug>
+
+
+/**
+ * Constructor
+ */
+FastaReader::FastaReader()
+{
+
+}
+
+
+/**
+ * Destructor
+ */
+FastaReader::~FastaReader()
+{
+	close();
+}
+
+
+/**
+ * Opens the given FASTA file and locates its sequences
+ *
+ * @param path : Path of the file
+ * @return Returns true on success and false on failure
+ */
+bool FastaReader::open(const QString &path)
+{
+	close();
+	file.setFileName(path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qCritical() << "Cannot read file " << path << ". Reason: "
+			<< file.errorString();
+		return false;
+	}
+	if (QFile::exists(path + ".fai") && readIndex(path + ".fai"))
+		return true;
+	return buildIndex();
+}
+
+
+/**
+ * Closes the file
+ */
+void FastaReader::close()
+{
+	if (file.isOpen())
+		file.close();
+	indexHash.clear();
+}
+
+
+/**
+ * Reads the sequence with the given name
+ *
+ * @param name : Name of the sequence, i.e. the first word of its header
+ * @param seq : Set to the bases of the sequence
+ * @return Returns false if there is no such sequence or it cannot be read
+ */
+bool FastaReader::readSequence(const QByteArray &name, QByteArray &seq)
+{
+	Entry entry;
+	QByteArray line;
+
+	seq.clear();
+	if (!indexHash.contains(name))
+		return false;
+	entry = indexHash.value(name);
+	if (!file.seek(entry.offset))
+		return false;
+
+	seq.reserve(entry.length);
+	while (seq.size() < entry.length && !file.atEnd())
+	{
+		line = file.readLine().trimmed();
+		if (line.startsWith('>'))
+			break;
+		seq += line;
+	}
+	if (seq.size() != entry.length)
+	{
+		qCritical() << "Cannot read sequence " << name << " from " << file.fileName();
+		return false;
+	}
+	return true;
+}
+
+
+/*
+ * Reads the locations of the sequences from the given '.fai' file. Each
+ * line holds the name, length, offset, bases per line and bytes per line
+ * of one sequence.
+ */
+bool FastaReader::readIndex(const QString &path)
+{
+	QFile indexFile(path);
+	QList<QByteArray> fields;
+	Entry entry;
+	bool ok1, ok2;
+
+	if (!indexFile.open(QIODevice::ReadOnly | QIODevice::Text))
+		return false;
+	while (!indexFile.atEnd())
+	{
+		fields = indexFile.readLine().trimmed().split('\t');
+		if (fields.size() < 3)
+			continue;
+		entry.length = fields.at(1).toLongLong(&ok1);
+		entry.offset = fields.at(2).toLongLong(&ok2);
+		if (!ok1 || !ok2)
+		{
+			indexHash.clear();
+			return false;
+		}
+		indexHash.insert(fields.at(0), entry);
+	}
+	return true;
+}
+
+
+/*
+ * Locates the sequences by scanning the whole file
+ */
+bool FastaReader::buildIndex()
+{
+	QByteArray line, name;
+	Entry entry;
+
+	entry.length = 0;
+	entry.offset = 0;
+	while (!file.atEnd())
+	{
+		line = file.readLine();
+		if (line.startsWith('>'))
+		{
+			if (!name.isEmpty())
+				indexHash.insert(name, entry);
+			name = line.mid(1).trimmed();
+			if (name.indexOf(' ') >= 0)
+				name.truncate(name.indexOf(' '));
+			if (name.indexOf('\t') >= 0)
+				name.truncate(name.indexOf('\t'));
+			entry.length = 0;
+			entry.offset = file.pos();
+		}
+		else
+			entry.length += line.trimmed().size();
+	}
+	if (!name.isEmpty())
+		indexHash.insert(name, entry);
+	if (indexHash.isEmpty())
+	{
+		qCritical() << "No sequences found in " << file.fileName();
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,40 @@
+#ifndef FASTAREADER_H_
+#define FASTAREADER_H_
+
+#include <QFile>
+#include <QByteArray>
+#include <QHash>
+
+/*
+ * Reads single sequences from a FASTA file by name. The sequences are
+ * located with the samtools index ('.fai') next to the file if there is
+ * one; otherwise the file is scanned once when it is opened.
+ */
+class FastaReader
+{
+public:
+	FastaReader();
+	~FastaReader();
+	bool open(const QString &);
+	void close();
+	bool readSequence(const QByteArray &, QByteArray &);
+
+	/** Returns whether the file contains a sequence with the given name */
+	inline bool contains(const QByteArray &name) const { return indexHash.contains(name); };
+
+private:
+	/* Location of one sequence in the file */
+	struct Entry
+	{
+		qint64 length;		/* Number of bases */
+		qint64 offset;		/* File offset of the first base */
+	};
+
+	QFile file;
+	QHash<QByteArray, Entry> indexHash;	/* Maps sequence name => location */
+
+	bool readIndex(const QString &);
+	bool buildIndex();
+};
+
+#endif /* FASTAREADER_H_ */
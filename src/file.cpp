@@ -54,7 +54,7 @@ QString File::getName(const int id)
 		s = "select file_name "
 				" from file "
 				" where id = " + QString::number(id);
-		if (!q.exec(s))
+		if (!DB_EXEC(q, s))
 		{
 			qCritical() << "Error fetching file name in "
 					<< QObject::staticMetaObject.className()
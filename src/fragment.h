@@ -19,8 +19,8 @@ public:
 	inline void setSequence(const QByteArray &s) { this->seq = s; };
 	inline QByteArray getSequence() const {return this->seq; };
 
-	inline void setSize(const quint16 s) { this->size = s; };
-	inline quint16 getSize() const { return this->size; };
+	inline void setSize(const int s) { this->size = s; };
+	inline int getSize() const { return this->size; };
 
 	inline void setStartPos(const int pos) { this->startPos = pos; };
 	inline int getStartPos() const {return this->startPos; };
@@ -40,13 +40,13 @@ public:
 	inline void setComplement(const QChar c) { this->complement = c; };
 	inline QChar getComplement() const { return this->complement; };
 
-	inline void setContigNumber(const quint16 n) { this->contigNumber = n; };
-	inline quint16 getContigNumber() const { return this->contigNumber; };
+	inline void setContigNumber(const int n) { this->contigNumber = n; };
+	inline int getContigNumber() const { return this->contigNumber; };
 
 	int id;
     QByteArray name;
     QByteArray seq;
-    quint16 size;
+    int size;
     int startPos;
     int endPos;
     int alignStart;
@@ -54,9 +54,9 @@ public:
     int qualStart;
     int qualEnd;
     QChar complement;
-    quint16 contigNumber;
-    qint16 yPos;
-    quint16 numMappings;
+    int contigNumber;
+    int yPos;
+    int numMappings;
 };
 
 #endif /* FRAGMENT_H_ */
@@ -4,9 +4,57 @@
 #include <QSqlError>
 #include <QtGui>
 #include <cmath>
+#include <ctype.h>
 #include "contig.h"
 #include "database.h"
 
+#define	MAX_READS_PER_BIN	50
+
+int FragmentList::maxReadsPerBin = MAX_READS_PER_BIN;
+quint32 FragmentList::sampleSeed = 0;
+int FragmentList::sampleGeneration = 0;
+
+
+/* Sampling key of a read that may be left out of the display sample */
+struct SampleKey
+{
+	int bin;			/* Bin of the start position of the read */
+	quint32 rank;		/* Pseudo-random rank of the read within its bin */
+	int index;			/* Index of the read in the list */
+};
+
+
+/*
+ * Returns true if the first key comes before the second one; within a
+ * bin, reads with lower ranks are kept first
+ */
+static bool sampleKeyLessThan(const SampleKey &k1, const SampleKey &k2)
+{
+	if (k1.bin != k2.bin)
+		return (k1.bin < k2.bin);
+	if (k1.rank != k2.rank)
+		return (k1.rank < k2.rank);
+	return (k1.index < k2.index);
+}
+
+
+/*
+ * Mixes the bits of the given read ID and seed, so that the rank of a
+ * read depends only on its ID and the seed
+ */
+static quint32 sampleRank(const int id, const quint32 seed)
+{
+	quint32 h;
+
+	h = ((quint32) id) ^ (seed * 0x9E3779B9u);
+	h ^= h >> 16;
+	h *= 0x85EBCA6Bu;
+	h ^= h >> 13;
+	h *= 0xC2B2AE35u;
+	h ^= h >> 16;
+	return h;
+}
+
 
 /**
  * Constructor
@@ -14,6 +62,8 @@
 FragmentList::FragmentList(Contig *contig)
 {
 	this->contig = contig;
+	displayBinSize = 0;
+	displayGeneration = 0;
 }
 
 
@@ -39,27 +89,8 @@ void FragmentList::getFrags()
 				connectionName,
 				Database::getFragDBName());
 		QSqlQuery query(db);
-		QString str;
-		Fragment *frag;
-
-		str = "select id, "
-				" size, "
-				" startPos, "
-				" endPos, "
-				" alignStart, "
-				" alignEnd, "
-				" qualStart, "
-				" qualEnd, "
-				" complement, "
-				" seq, "
-				" name, "
-				" yPos, "
-				" numMappings "
-				" from fragment "
-				" where contig_id = " + QString::number(contig->id);
-	//			" and startPos < " + QString::number(contig->endPos) + ""
-	//			" and endPos > " + QString::number(contig->startPos);
-		if (!query.exec(str))
+
+		if (!getFrags(query))
 		{
 			QMessageBox::critical(
 					QApplication::activeWindow(),
@@ -69,25 +100,6 @@ void FragmentList::getFrags()
 			db.close();
 			return;
 		}
-		while (query.next())
-		{
-			frag = new Fragment();
-			frag->id = query.value(0).toInt();
-			frag->size = query.value(1).toInt();
-			frag->startPos = query.value(2).toInt();
-			frag->endPos = query.value(3).toInt();
-			frag->alignStart = query.value(4).toInt();
-			frag->alignEnd = query.value(5).toInt();
-			frag->qualStart = query.value(6).toInt();
-			frag->qualEnd = query.value(7).toInt();
-			frag->complement = query.value(8).toChar().toAscii();
-			frag->seq = query.value(9).toByteArray();
-			frag->name = query.value(10).toByteArray();
-			frag->yPos = query.value(11).toInt();
-			frag->numMappings = query.value(12).toInt();
-			frag->contigNumber = contig->id;
-			list.append(frag);
-		}
 
 		db.close();
 	}
@@ -95,6 +107,223 @@ void FragmentList::getFrags()
 }
 
 
+/**
+ * Fetches fragments from the database using the given query object.
+ * Reads that were left out of the row layout (negative y-position)
+ * are not fetched.
+ *
+ * This does not show any dialogs, so it can also be used from threads
+ * other than the GUI thread, as long as the query belongs to a
+ * connection that was created in that thread.
+ *
+ * @param query : Query object to be used for fetching the fragments
+ *
+ * @return Returns true on success and false on failure
+ */
+bool FragmentList::getFrags(QSqlQuery &query)
+{
+	QString str;
+	Fragment *frag;
+
+	str = "select id, "
+			" size, "
+			" startPos, "
+			" endPos, "
+			" alignStart, "
+			" alignEnd, "
+			" qualStart, "
+			" qualEnd, "
+			" complement, "
+			" seq, "
+			" name, "
+			" yPos, "
+			" numMappings "
+			" from fragment "
+			" where contig_id = " + QString::number(contig->id) +
+			" and yPos >= 0 ";
+//			" and startPos < " + QString::number(contig->endPos) + ""
+//			" and endPos > " + QString::number(contig->startPos);
+	if (!DB_EXEC(query, str))
+		return false;
+
+	while (query.next())
+	{
+		frag = new Fragment();
+		frag->id = query.value(0).toInt();
+		frag->size = query.value(1).toInt();
+		frag->startPos = query.value(2).toInt();
+		frag->endPos = query.value(3).toInt();
+		frag->alignStart = query.value(4).toInt();
+		frag->alignEnd = query.value(5).toInt();
+		frag->qualStart = query.value(6).toInt();
+		frag->qualEnd = query.value(7).toInt();
+		frag->complement = query.value(8).toChar().toAscii();
+		frag->seq = query.value(9).toByteArray();
+		frag->name = query.value(10).toByteArray();
+		frag->yPos = query.value(11).toInt();
+		frag->numMappings = query.value(12).toInt();
+		frag->contigNumber = contig->id;
+		list.append(frag);
+	}
+	displayBinSize = 0;
+	return true;
+}
+
+
+/**
+ * Returns the reads to be painted when each bin of the given number of
+ * bases is drawn in about one pixel column. The sample is cached until
+ * the bin size, the sampling settings or the list change, so this must
+ * only be called from the GUI thread; other threads should use sample().
+ *
+ * @param binSize : Number of bases per bin
+ * @return Reads to be painted; all the reads if sampling is turned off
+ */
+const QList<Fragment *> & FragmentList::getDisplayList(const int binSize)
+{
+	if (maxReadsPerBin == 0)
+		return list;
+	if (displayBinSize != binSize || displayGeneration != sampleGeneration)
+	{
+		sample(binSize, displayList);
+		displayBinSize = binSize;
+		displayGeneration = sampleGeneration;
+	}
+	return displayList;
+}
+
+
+/**
+ * Downsamples the reads for display. Reads are grouped into bins of the
+ * given number of bases by their start position, and at most
+ * maxReadsPerBin reads of each bin are kept. Which reads are kept only
+ * depends on their IDs and the seed, so the same sample is drawn every
+ * time. Reads that differ from the contig at a SNP above the threshold
+ * are always kept.
+ *
+ * The list itself is not changed, so hovering, navigation and export
+ * still see all the reads.
+ *
+ * @param binSize : Number of bases per bin
+ * @param result : Cleared and filled with the kept reads, in list order
+ */
+void FragmentList::sample(const int binSize, QList<Fragment *> &result) const
+{
+	QVector<SampleKey> keys;
+	QVector<bool> isKept;
+	SampleKey key;
+	Fragment *frag;
+	int i, j, first, last, pos, numInBin, prevBin, size;
+	bool isSnpRead;
+
+	result.clear();
+	size = list.size();
+	if (maxReadsPerBin == 0 || binSize <= 0 || size <= maxReadsPerBin)
+	{
+		result = list;
+		return;
+	}
+
+	isKept.fill(false, size);
+	keys.reserve(size);
+	for (i = 0; i < size; ++i)
+	{
+		frag = list.at(i);
+
+		/* Keep reads that support a SNP */
+		isSnpRead = false;
+		contig->getSnpIndexRange(
+				frag->startPos - 1,
+				frag->startPos + frag->seq.size() - 2,
+				first,
+				last);
+		for (j = first; j < last && !isSnpRead; ++j)
+		{
+			pos = contig->snpThresholdPosList.at(j);
+			if (pos - frag->startPos + 1 >= 0
+					&& pos - frag->startPos + 1 < frag->seq.size()
+					&& pos < contig->seq.size()
+					&& tolower(frag->seq.at(pos - frag->startPos + 1))
+						!= tolower(contig->seq.at(pos)))
+				isSnpRead = true;
+		}
+		if (isSnpRead)
+		{
+			isKept[i] = true;
+			continue;
+		}
+
+		key.bin = (frag->startPos > 0)? (frag->startPos / binSize): 0;
+		key.rank = sampleRank(frag->id, sampleSeed);
+		key.index = i;
+		keys.append(key);
+	}
+
+	/* Keep the lowest-ranked reads of each bin */
+	qSort(keys.begin(), keys.end(), sampleKeyLessThan);
+	prevBin = -1;
+	numInBin = 0;
+	foreach (key, keys)
+	{
+		if (key.bin != prevBin)
+		{
+			prevBin = key.bin;
+			numInBin = 0;
+		}
+		if (numInBin++ < maxReadsPerBin)
+			isKept[key.index] = true;
+	}
+
+	for (i = 0; i < size; ++i)
+	{
+		if (isKept.at(i))
+			result.append(list.at(i));
+	}
+}
+
+
+/**
+ * Sets the maximum number of reads shown per bin
+ *
+ * @param n : Maximum number of reads, or 0 to show all the reads
+ */
+void FragmentList::setMaxReadsPerBin(const int n)
+{
+	maxReadsPerBin = (n < 0)? 0: n;
+	++sampleGeneration;
+}
+
+
+/**
+ * Returns the maximum number of reads shown per bin, or 0 if all the
+ * reads are shown
+ */
+int FragmentList::getMaxReadsPerBin()
+{
+	return maxReadsPerBin;
+}
+
+
+/**
+ * Sets the seed of the read sampling; the same seed always selects
+ * the same reads
+ */
+void FragmentList::setSampleSeed(const quint32 seed)
+{
+	sampleSeed = seed;
+	++sampleGeneration;
+}
+
+
+/**
+ * Returns the seed of the read sampling
+ */
+quint32 FragmentList::getSampleSeed()
+{
+	return sampleSeed;
+}
+
+
 /**
  * Clears the list
  */
@@ -103,6 +332,8 @@ void FragmentList::resetList()
 	foreach (Fragment *frag, list)
 		delete frag;
 	list.clear();
+	displayList.clear();
+	displayBinSize = 0;
 	//qDebug() << "resetList for contig " << contig->id;
 }
 
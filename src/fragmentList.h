@@ -5,6 +5,7 @@
 #include "fragment.h"
 #include <QObject>
 #include <QtGui>
+#include <QSqlQuery>
 
 class Contig;
 
@@ -17,15 +18,32 @@ public:
 	~FragmentList();
 	void resetList();
 	void getFrags();
+	bool getFrags(QSqlQuery &);
+	const QList<Fragment *> & getDisplayList(const int);
+	void sample(const int, QList<Fragment *> &) const;
+	static void setMaxReadsPerBin(const int);
+	static int getMaxReadsPerBin();
+	static void setSampleSeed(const quint32);
+	static quint32 getSampleSeed();
 
 	inline int size() const { return list.size(); };
 	inline Fragment * at(const int i) const { return list.at(i); };
-	inline void append(Fragment *f) { list.append(f); };
+	inline void append(Fragment *f) { list.append(f); displayBinSize = 0; };
 	inline QList<Fragment *> & getList() { return list; };
 
+	/** Discards the cached display sample, e.g. when the SNPs change */
+	inline void invalidateDisplayList() { displayBinSize = 0; };
+
 private:
 	Contig *contig;
 	QList<Fragment *> list;
+	QList<Fragment *> displayList;	/* Cached display sample of 'list' */
+	int displayBinSize;				/* Bin size of displayList, or 0 if not valid */
+	int displayGeneration;			/* Value of sampleGeneration when displayList was made */
+
+	static int maxReadsPerBin;		/* Maximum number of reads shown per bin, or 0 for all */
+	static quint32 sampleSeed;		/* Seed of the read sampling */
+	static int sampleGeneration;	/* Incremented whenever the sampling settings change */
 };
 
 #endif /* FRAGMENTLIST_H_ */
@@ -5,16 +5,19 @@
 #include <QSqlError>
 #include "math.h"
 #include "database.h"
+#include "trace.h"
+#include "perfMetrics.h"
 
 #define	FRAG_DESC_GAP	20
 #define	PARTITION_SIZE	500
+#define	FRAGS_PER_COMMIT	50000
 
 extern QQueue<Fragment *> fragQueue;
 extern QMutex fragMutex;
 extern QWaitCondition fragQueueNotFull;
 extern QWaitCondition fragQueueNotEmpty;
 
-extern QList<quint16> partitionList;
+extern QList<int> partitionList;
 extern int contigPartitions;
 extern QMutex partitionListMutex;
 extern const int maxPartitionSize;
@@ -59,7 +62,10 @@ void FragmentSaverThread::run()
 	{
 		Fragment *frag = NULL;
 		int oldContigId = 0, newContigId = 0, partitionNum = 0;
+		int completedContigId = 0, committedContigId = 0, uncommittedFrags = 0;
+		bool hasError = false;
 		QHash<int, int> partition_fragCountHash;
+		TRACE_SPAN("save reads");
 		QSqlDatabase db =
 			Database::createConnection(
 				connectionName,
@@ -76,19 +82,69 @@ void FragmentSaverThread::run()
 
 		forever
 		{
-			fragMutex.lock();
+			{
+				TRACE_SPAN("lock fragMutex");
+				fragMutex.lock();
+			}
 			if (fragQueue.isEmpty())
-				fragQueueNotEmpty.wait(&fragMutex);
+			{
+				/* Commit the fragments of completed contigs before waiting
+				 * for the parser so that they become visible to the viewer */
+				if (completedContigId > committedContigId)
+				{
+					fragMutex.unlock();
+					if (!commitFrags(db, completedContigId, uncommittedFrags, true))
+					{
+						hasError = true;
+						break;
+					}
+					committedContigId = completedContigId;
+					uncommittedFrags = 0;
+					fragMutex.lock();
+				}
+				if (fragQueue.isEmpty())
+				{
+					TRACE_SPAN("wait fragQueueNotEmpty");
+					fragQueueNotEmpty.wait(&fragMutex);
+				}
+			}
+			TRACE_COUNTER("fragQueue", fragQueue.size());
 			while (!fragQueue.isEmpty())
 				fragQueuePrivate.enqueue(fragQueue.dequeue());
 			fragQueueNotFull.wakeAll();
 			fragMutex.unlock();
 
+			/* Ends with the iteration */
+			TRACE_SPAN("insert reads");
+
 			while (!fragQueuePrivate.isEmpty())
 			{
 				frag = fragQueuePrivate.dequeue();
 				if (frag == NULL)
+				{
+					completedContigId = newContigId;
 					break;
+				}
+
+				/* Fragments arrive in contig order, so all contigs before
+				 * the current one are complete. Commit in chunks at contig
+				 * boundaries. */
+				if (frag->contigNumber != newContigId)
+				{
+					newContigId = frag->contigNumber;
+					completedContigId = newContigId - 1;
+					if (uncommittedFrags >= FRAGS_PER_COMMIT)
+					{
+						if (!commitFrags(db, completedContigId, uncommittedFrags, true))
+						{
+							delete frag;
+							hasError = true;
+							break;
+						}
+						committedContigId = completedContigId;
+						uncommittedFrags = 0;
+					}
+				}
 
 //				/* Clear the hash for fragments of new contig */
 //				newContigId = frag->id;
@@ -120,24 +176,91 @@ void FragmentSaverThread::run()
 						<< ". Reason: "
 						<< query.lastError().text();
 					db.rollback();
-					return;
+					hasError = true;
+					break;
 				}
+				++uncommittedFrags;
 			}
 
-			if (frag == NULL)
+			if (frag == NULL || hasError)
 				break;
 
 		} /* end forever loop */
 
-		if (!db.commit())
-			qCritical() << "Error ending transaction: "
-				<< db.lastError().text();
+		if (!hasError && commitFrags(db, completedContigId, uncommittedFrags, false))
+			indexFrags(db);
 
 	} /* end block */
 	QSqlDatabase::removeDatabase(connectionName);
 }
 
 
+/*
+ * Commits the current transaction and signals that the fragments of
+ * all contigs up to the given contig have been saved. The reads of the
+ * transaction are counted here, once per commit, rather than one by one
+ * under the lock of the metrics.
+ *
+ * @param db : Database connection
+ * @param contigId : ID of the last contig whose fragments are complete
+ * @param numFrags : Number of fragments inserted in the transaction
+ * @param beginNext : Whether a new transaction should be started after
+ * the commit
+ *
+ * @return Returns true on success and false on failure
+ */
+bool FragmentSaverThread::commitFrags(
+		QSqlDatabase &db,
+		const int contigId,
+		const int numFrags,
+		const bool beginNext)
+{
+	TRACE_SPAN("commit reads");
+
+	if (!db.commit())
+	{
+		qCritical() << "Error ending transaction: "
+			<< db.lastError().text();
+		return false;
+	}
+	if (numFrags > 0)
+		PerfMetrics::add(PerfMetrics::ReadsSaved, numFrags);
+
+	if (contigId > 0)
+		emit fragsSaved(contigId);
+
+	if (beginNext && !db.transaction())
+	{
+		qCritical() << "Error beginning transaction: "
+			<< db.lastError().text();
+		return false;
+	}
+	return true;
+}
+
+
+/*
+ * Indexes the saved fragments by position. The index is built once all
+ * the fragments have been inserted because keeping it up to date during
+ * the bulk insert would slow the import down.
+ *
+ * @param db : Database connection
+ */
+void FragmentSaverThread::indexFrags(QSqlDatabase &db)
+{
+	TRACE_SPAN("index reads");
+	QSqlQuery query(db);
+
+	if (!query.exec(Database::getFragIndexSql()))
+	{
+		qCritical() << "Error creating fragment index in "
+			<< this->metaObject()->className()
+			<< ". Reason: "
+			<< query.lastError().text();
+	}
+}
+
+
 void FragmentSaverThread::assignYPos(Fragment *frag)
 {
 //	firstPartition = frag->startPos / maxPartitionSize;
@@ -3,6 +3,7 @@
 #define FRAGMENTSAVERTHREAD_H_
 
 #include <QThread>
+#include <QSqlDatabase>
 #include "contig.h"
 #include "fragment.h"
 
@@ -14,6 +15,9 @@ public:
 	FragmentSaverThread();
 	~FragmentSaverThread();
 
+    signals:
+    void fragsSaved(int);
+
 protected:
 	void run();
 
@@ -24,5 +28,7 @@ private:
 
 	void assignFragYPos(Contig *, const int, int &);
 	void assignYPos(Fragment *);
+	bool commitFrags(QSqlDatabase &, const int, const int, const bool);
+	void indexFrags(QSqlDatabase &);
 };
 #endif /* FRAGMENTSAVERTHREAD_H_ */
@@ -1,7 +1,5 @@
 
 #include "gene.h"
-#include <QSqlQuery>
-#include <QSqlError>
 #include <QtCore>
 
 /**
@@ -14,7 +12,7 @@ Gene::Gene()
 
 
 /**
- * Constructor
+ * Constructor. Substructures are added with addSubstructure().
  */
 Gene::Gene(int id,
 		const QString &name,
@@ -26,35 +24,6 @@ Gene::Gene(int id,
 {
 	this->yPos = yPos;
 	this->direction = direction;
-
-
-	int structureId, structureStart, structureEnd;
-	GeneStructure::SubstructureType structureType;
-	QString structureName, str;
-	QSqlQuery query;
-
-	str = "select id, name, start, end, type "
-			" from geneStructure "
-			" where geneId = " + QString::number(this->id);
-	if (!query.exec(str))
-	{
-		qDebug() << "Error fetching geneStructure from DB.\nReason: " << query.lastError().text();
-		return;
-	}
-	while (query.next())
-	{
-		structureId = query.value(0).toInt();
-		structureName = query.value(1).toInt();
-		structureStart = query.value(2).toInt();
-		structureEnd = query.value(3).toInt();
-		structureType = (enum GeneStructure::SubstructureType) query.value(4).toInt();
-		substructures.append(new GeneStructure(
-				structureId,
-				structureName,
-				structureType,
-				structureStart,
-				structureEnd));
-	}
 }
 
 
@@ -7,6 +7,7 @@
 #include "contig.h"
 #include <QMessageBox>
 #include "annotationList.h"
+#include "database.h"
 
 /**
  * Constructor
@@ -110,7 +111,7 @@ void GeneOverlapExporter::exportGenes()
 				" and annotation.endPos >= fragment.startPos ";
 	}
 
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		qCritical() << "Error fetching from 'annotation' and 'fragment' tables. "
 			<< query.lastError().text();
@@ -85,7 +85,8 @@ void GlobalViewPainterThread::run()
 				connectionName,
 				Database::getContigDBName());
 		QSqlQuery query3(db);
-		if (!query3.exec("attach database 'fragDB' as 'fragDB'"))
+		if (!DB_EXEC(query3, "attach database '" + Database::getFragDBName()
+				+ "' as 'fragDB'"))
 		{
 			qCritical() << "Error attaching DB in "
 				<< this->metaObject()->className()
@@ -99,8 +100,9 @@ void GlobalViewPainterThread::run()
 		QSqlQuery query(db);
 		QString str = "select id, size, contigOrder "
 				" from contig "
+				" where id <= " + QString::number(Contig::getNumAvailableContigs()) +
 				" order by contigOrder asc";
-		if (!query.exec(str))
+		if (!DB_EXEC(query, str))
 		{
 			qCritical() << "Error fetching contigs from DB. Reason: "
 				<< query.lastError().text();
@@ -179,8 +181,9 @@ void GlobalViewPainterThread::run()
 			/* Fetch fragments from DB */
 			str2 = "select startPos, endPos, yPos "
 					" from fragment "
-					" where contig_id = " + QString::number(contigId);
-			if (!query2.exec(str2))
+					" where contig_id = " + QString::number(contigId) +
+					" and yPos >= 0 ";
+			if (!DB_EXEC(query2, str2))
 			{
 				qCritical() << "Error fetching fragments from DB. Reason: "
 					<< query2.lastError().text();
@@ -101,7 +101,7 @@ QSize GlobalView::sizeHint() const
  */
 void GlobalView::paintEvent(QPaintEvent */*event*/)
 {
-	if (Contig::getNumContigs() == 0)
+	if (Contig::getNumAvailableContigs() == 0)
 	{
 		QPainter painter(this);
 		painter.fillRect(0, 0, width(), height(), Qt::transparent);
@@ -135,7 +135,7 @@ void GlobalView::clean()
 void GlobalView::mouseMoveEvent(QMouseEvent *event)
 {
 	/* If no contigs are loaded, then exit */
-    if (Contig::getNumContigs() == 0)
+    if (Contig::getNumAvailableContigs() == 0)
     	return;
 
     foreach (ContigStruct *contigStruct, contigStructList)
@@ -162,7 +162,7 @@ void GlobalView::mouseMoveEvent(QMouseEvent *event)
 void GlobalView::mousePressEvent(QMouseEvent *event)
 {
 	/* If no contigs are loaded, then exit */
-    if (Contig::getNumContigs() == 0)
+    if (Contig::getNumAvailableContigs() == 0)
     	return;
 
 	int id = getContigId(event->pos());
@@ -185,7 +185,7 @@ void GlobalView::mousePressEvent(QMouseEvent *event)
 int GlobalView::getContigId(const QPoint &p)
 {
 	ContigStruct *contigStruct;
-	for (int i = 0; i < Contig::getNumContigs(); ++i)
+	for (int i = 0; i < contigStructList.size(); ++i)
 	{
 		contigStruct = contigStructList.at(i);
 		if (p.x() >= contigStruct->xStart
@@ -206,7 +206,7 @@ int GlobalView::getContigId(const QPoint &p)
 int GlobalView::getNucleotidePos(const int contigId, const QPoint &p)
 {
 	ContigStruct *contigStruct;
-	for (int i = 0; i < Contig::getNumContigs(); ++i)
+	for (int i = 0; i < contigStructList.size(); ++i)
 	{
 		contigStruct = contigStructList.at(i);
 		if (contigId == contigStruct->id)
@@ -265,7 +265,7 @@ void GlobalView::updateView(const Contig *contig)
 	qreal ratio, stretchFactor;
 	ContigStruct *contigStruct;
 
-	if (contig == NULL || Contig::getNumContigs() == 0)
+	if (contig == NULL || Contig::getNumAvailableContigs() == 0)
 	{
 		update();
 		return;
@@ -346,7 +346,7 @@ void GlobalView::setContig(Contig *c)
 void GlobalView::resizeEvent(QResizeEvent */*event*/)
 {
 	/* If there are no contigs, return */
-	if (Contig::getNumContigs() == 0)
+	if (Contig::getNumAvailableContigs() == 0)
 		return;
 
 	createContigPixmap();
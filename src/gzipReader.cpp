@@ -0,0 +1,442 @@
+
+#include "gzipReader.h"
+#include <QFile>
+#include <QThread>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QtDebug>
+#include <string.h>
+#include <zlib.h>
+
+#define	INPUT_SIZE		262144		/* Compressed bytes read at a time */
+#define	CHUNK_SIZE		262144		/* Uncompressed bytes handed over at a time */
+#define	MAX_CHUNKS		16			/* Uncompressed chunks waiting to be read */
+
+
+/*
+ * Uncompresses a gzip file, which may consist of several gzip members,
+ * into a bounded queue of chunks
+ */
+class GzipInflaterThread : public QThread
+{
+public:
+	GzipInflaterThread(const QString &);
+	~GzipInflaterThread();
+	bool takeChunk(QByteArray &);
+	void stop();
+	qint64 getCompressedPos();
+	bool hasError();
+
+protected:
+	void run();
+
+private:
+	QString fileName;
+	QQueue<QByteArray> chunks;		/* Uncompressed data in file order */
+	QMutex mutex;
+	QWaitCondition chunksNotEmpty;
+	QWaitCondition chunksNotFull;
+	bool isDone;					/* Whether no more chunks will be queued */
+	bool isStopped;					/* Whether the reader has gone away */
+	bool error;						/* Whether the file could not be read or is truncated or corrupt */
+	qint64 compressedPos;			/* Compressed bytes uncompressed so far */
+
+	bool putChunk(const QByteArray &);
+};
+
+
+/**
+ * Constructor
+ *
+ * @param fileName : Path of the gzip file
+ */
+GzipInflaterThread::GzipInflaterThread(const QString &fileName)
+{
+	this->fileName = fileName;
+	isDone = false;
+	isStopped = false;
+	error = false;
+	compressedPos = 0;
+}
+
+
+/**
+ * Destructor
+ */
+GzipInflaterThread::~GzipInflaterThread()
+{
+	stop();
+}
+
+
+/**
+ * Takes the next uncompressed chunk, waiting for it if necessary
+ *
+ * @param chunk : Set to the chunk
+ * @return Returns false at the end of the file
+ */
+bool GzipInflaterThread::takeChunk(QByteArray &chunk)
+{
+	QMutexLocker locker(&mutex);
+
+	while (chunks.isEmpty() && !isDone)
+		chunksNotEmpty.wait(&mutex);
+	if (chunks.isEmpty())
+		return false;
+	chunk = chunks.dequeue();
+	chunksNotFull.wakeAll();
+	return true;
+}
+
+
+/**
+ * Stops uncompressing and waits for the thread to finish
+ */
+void GzipInflaterThread::stop()
+{
+	mutex.lock();
+	isStopped = true;
+	chunksNotFull.wakeAll();
+	mutex.unlock();
+	wait();
+}
+
+
+/**
+ * Returns the number of compressed bytes that have been uncompressed
+ */
+qint64 GzipInflaterThread::getCompressedPos()
+{
+	QMutexLocker locker(&mutex);
+
+	return compressedPos;
+}
+
+
+/**
+ * Returns whether uncompressing stopped because the file could not be
+ * read or is truncated or corrupt, rather than at the end of the file
+ */
+bool GzipInflaterThread::hasError()
+{
+	QMutexLocker locker(&mutex);
+
+	return error;
+}
+
+
+/**
+ * Implements the run method
+ */
+void GzipInflaterThread::run()
+{
+	QFile file(fileName);
+	QByteArray input, output;
+	z_stream stream;
+	qint64 numRead;
+	int result;
+	bool isMemberOpen;
+
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qCritical() << "Cannot read file " << fileName << ". Reason: "
+			<< file.errorString();
+		QMutexLocker locker(&mutex);
+		error = true;
+		isDone = true;
+		chunksNotEmpty.wakeAll();
+		return;
+	}
+
+	/* Accept a gzip header; concatenated members are read one by one */
+	memset(&stream, 0, sizeof(stream));
+	inflateInit2(&stream, 15 + 16);
+	input.resize(INPUT_SIZE);
+	isMemberOpen = false;
+	forever
+	{
+		if (stream.avail_in == 0)
+		{
+			numRead = file.read(input.data(), INPUT_SIZE);
+			if (numRead <= 0)
+			{
+				if (isMemberOpen)
+				{
+					qCritical() << "Unexpected end of gzip file " << fileName;
+					mutex.lock();
+					error = true;
+					mutex.unlock();
+				}
+				break;
+			}
+			stream.next_in = (Bytef *) input.data();
+			stream.avail_in = (uInt) numRead;
+		}
+
+		output.resize(CHUNK_SIZE);
+		stream.next_out = (Bytef *) output.data();
+		stream.avail_out = CHUNK_SIZE;
+		result = inflate(&stream, Z_NO_FLUSH);
+		if (result == Z_STREAM_END)
+		{
+			inflateReset(&stream);
+			isMemberOpen = false;
+		}
+		else if (result == Z_OK || result == Z_BUF_ERROR)
+			isMemberOpen = true;
+		else
+		{
+			qCritical() << "Error uncompressing " << fileName << ": "
+				<< (stream.msg? stream.msg: "");
+			mutex.lock();
+			error = true;
+			mutex.unlock();
+			break;
+		}
+		output.resize(CHUNK_SIZE - stream.avail_out);
+
+		mutex.lock();
+		compressedPos = file.pos() - stream.avail_in;
+		mutex.unlock();
+		if (!output.isEmpty() && !putChunk(output))
+			break;
+	}
+	inflateEnd(&stream);
+	file.close();
+
+	QMutexLocker locker(&mutex);
+	isDone = true;
+	chunksNotEmpty.wakeAll();
+}
+
+
+/*
+ * Queues the given chunk, waiting while the queue is full. Returns false
+ * if the reader has stopped.
+ */
+bool GzipInflaterThread::putChunk(const QByteArray &chunk)
+{
+	QMutexLocker locker(&mutex);
+
+	while (chunks.size() >= MAX_CHUNKS && !isStopped)
+		chunksNotFull.wait(&mutex);
+	if (isStopped)
+		return false;
+	chunks.enqueue(chunk);
+	chunksNotEmpty.wakeAll();
+	return true;
+}
+
+
+/**
+ * Constructor
+ *
+ * @param fileName : Path of the gzip or bgzip file
+ */
+GzipReader::GzipReader(const QString &fileName)
+{
+	this->fileName = fileName;
+	isBgzf = false;
+	inflater = NULL;
+	chunkOffset = 0;
+}
+
+
+/**
+ * Destructor
+ */
+GzipReader::~GzipReader()
+{
+	close();
+}
+
+
+/**
+ * Opens the file for reading and starts uncompressing it
+ *
+ * @param mode : Must be a read-only mode
+ * @return Returns true on success and false on failure
+ */
+bool GzipReader::open(OpenMode mode)
+{
+	QFile file(fileName);
+	QByteArray header;
+
+	if (mode & QIODevice::WriteOnly)
+	{
+		setErrorString("Compressed files can only be read");
+		return false;
+	}
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		setErrorString(file.errorString());
+		return false;
+	}
+
+	/* bgzip writes a 'BC' extra subfield right after the gzip header */
+	header = file.read(14);
+	file.close();
+	isBgzf = (header.size() == 14 && (header.at(3) & 4) != 0
+			&& header.at(12) == 'B' && header.at(13) == 'C');
+
+	if (isBgzf)
+	{
+		if (!bgzf.open(fileName))
+		{
+			setErrorString("Cannot read file");
+			return false;
+		}
+		bgzf.setParallel(true);
+	}
+	else
+	{
+		inflater = new GzipInflaterThread(fileName);
+		inflater->start();
+	}
+	chunk.clear();
+	chunkOffset = 0;
+	return QIODevice::open(mode);
+}
+
+
+/**
+ * Stops uncompressing and closes the file
+ */
+void GzipReader::close()
+{
+	if (inflater != NULL)
+	{
+		inflater->stop();
+		delete inflater;
+		inflater = NULL;
+	}
+	bgzf.close();
+	chunk.clear();
+	chunkOffset = 0;
+	if (isOpen())
+		QIODevice::close();
+}
+
+
+/**
+ * Returns true because the uncompressed data can only be read in order
+ */
+bool GzipReader::isSequential() const
+{
+	return true;
+}
+
+
+/**
+ * Returns whether all the data has been read. Waits until more data has
+ * been uncompressed or the end of the file is reached.
+ */
+bool GzipReader::atEnd() const
+{
+	if (!isOpen())
+		return true;
+	if (QIODevice::bytesAvailable() > 0)
+		return false;
+	return !const_cast<GzipReader *>(this)->hasMoreData();
+}
+
+
+/**
+ * Returns the number of compressed bytes that have been read, which is
+ * what parsing progress is measured in
+ */
+qint64 GzipReader::getCompressedPos() const
+{
+	if (isBgzf)
+		return bgzf.getBlockAddress();
+	if (inflater != NULL)
+		return inflater->getCompressedPos();
+	return 0;
+}
+
+
+/**
+ * Returns whether reading stopped because the file is truncated or
+ * corrupt rather than at its end. Readers should check this once they
+ * reach what looks like the end of the file.
+ */
+bool GzipReader::hasError() const
+{
+	if (isBgzf)
+		return bgzf.hasError();
+	if (inflater != NULL)
+		return inflater->hasError();
+	return false;
+}
+
+
+/**
+ * Returns whether the given file is gzip-compressed, which includes
+ * bgzip files
+ *
+ * @param fileName : Path of the file
+ */
+bool GzipReader::isCompressed(const QString &fileName)
+{
+	QFile file(fileName);
+	QByteArray magic;
+
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+	magic = file.read(2);
+	return (magic.size() == 2 && (uchar) magic.at(0) == 31
+			&& (uchar) magic.at(1) == 139);
+}
+
+
+/*
+ * Reads uncompressed data, waiting for it if necessary. Returns 0 only
+ * at the end of the file.
+ */
+qint64 GzipReader::readData(char *data, qint64 maxSize)
+{
+	qint64 numRead;
+	int length;
+
+	if (isBgzf)
+		return bgzf.read(data, maxSize);
+
+	numRead = 0;
+	while (numRead < maxSize && hasMoreData())
+	{
+		length = (int) qMin((qint64) (chunk.size() - chunkOffset), maxSize - numRead);
+		memcpy(data + numRead, chunk.constData() + chunkOffset, length);
+		chunkOffset += length;
+		numRead += length;
+	}
+	return numRead;
+}
+
+
+/*
+ * Writing is not supported
+ */
+qint64 GzipReader::writeData(const char *, qint64)
+{
+	return -1;
+}
+
+
+/*
+ * Makes sure that there is uncompressed data left to read. Returns
+ * false at the end of the file.
+ */
+bool GzipReader::hasMoreData()
+{
+	if (isBgzf)
+		return !bgzf.atEnd();
+
+	while (chunkOffset >= chunk.size())
+	{
+		if (inflater == NULL || !inflater->takeChunk(chunk))
+			return false;
+		chunkOffset = 0;
+	}
+	return true;
+}
@@ -0,0 +1,45 @@
+#ifndef GZIPREADER_H_
+#define GZIPREADER_H_
+
+#include <QIODevice>
+#include <QByteArray>
+#include "bgzfReader.h"
+
+class GzipInflaterThread;
+
+/*
+ * Read-only device that uncompresses a gzip or bgzip file as it is read,
+ * so that the file can be parsed without writing it out uncompressed.
+ * Bgzip blocks are uncompressed in parallel on the global thread pool;
+ * other gzip files are uncompressed on a thread of their own. Either
+ * way at most a few megabytes are uncompressed ahead of the reader.
+ */
+class GzipReader : public QIODevice
+{
+public:
+	GzipReader(const QString &);
+	~GzipReader();
+	bool open(OpenMode);
+	void close();
+	bool isSequential() const;
+	bool atEnd() const;
+	qint64 getCompressedPos() const;
+	bool hasError() const;
+	static bool isCompressed(const QString &);
+
+protected:
+	qint64 readData(char *, qint64);
+	qint64 writeData(const char *, qint64);
+
+private:
+	QString fileName;
+	bool isBgzf;				/* Whether the file is made of BGZF blocks */
+	BgzfReader bgzf;			/* Reads bgzip files */
+	GzipInflaterThread *inflater;	/* Uncompresses other gzip files */
+	QByteArray chunk;			/* Uncompressed data taken from the inflater */
+	int chunkOffset;			/* Offset of the next byte within the chunk */
+
+	bool hasMoreData();
+};
+
+#endif /* GZIPREADER_H_ */
@@ -0,0 +1,218 @@
+
+#include "headlessImporter.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QTextStream>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QtDebug>
+#include "database.h"
+
+#define	BYTE_TO_MBYTE	1048576
+
+
+/**
+ * Constructor
+ */
+HeadlessImporter::HeadlessImporter()
+{
+	parser = new Parser;
+	parser->setParent(this);
+	aceSize = 0;
+	exitCode = 0;
+	stageTimes.fill(-1, 3);
+
+	connect(parser, SIGNAL(stageFinished(int)),
+			this, SLOT(stageFinished(int)));
+	connect(parser, SIGNAL(parsingFinished()),
+			this, SLOT(contigImportFinished()));
+}
+
+
+/**
+ * Destructor
+ */
+HeadlessImporter::~HeadlessImporter()
+{
+
+}
+
+
+/**
+ * Starts the import. The contigs are imported by the parser threads;
+ * the annotation is imported once they are done. finished() is emitted
+ * at the end, after which getExitCode() tells whether the import
+ * succeeded.
+ */
+void HeadlessImporter::start()
+{
+	QTextStream out(stdout);
+
+	out << "stage\tseconds\tamount\tunit\tper_second\n";
+	out.flush();
+
+	aceSize = 0;
+	foreach (QString file, aceFiles)
+		aceSize += QFileInfo(file).size();
+	stageTimes.fill(-1, 3);
+	timer.start();
+
+	if (aceFiles.isEmpty() || !parser->readAce(aceFiles, aceFiles.size()))
+		contigImportFinished();
+}
+
+
+/*
+ * Records the time at which a stage of the contig import finished
+ */
+void HeadlessImporter::stageFinished(int stage)
+{
+	if (stage >= 0 && stage < stageTimes.size())
+		stageTimes[stage] = timer.elapsed();
+}
+
+
+/*
+ * Prints the throughput of the contig import stages, then imports the
+ * annotation
+ */
+void HeadlessImporter::contigImportFinished()
+{
+	QString connectionName = QString(this->metaObject()->className());
+	qint64 numContigs = 0, numBases = 0, numReads = 0;
+
+	if (!aceFiles.isEmpty())
+	{
+		{
+			QSqlDatabase db =
+				Database::createConnection(
+					connectionName,
+					Database::getContigDBName());
+			QSqlQuery query(db);
+
+			if (query.exec("select count(*), sum(size) from contig") && query.next())
+			{
+				numContigs = query.value(0).toLongLong();
+				numBases = query.value(1).toLongLong();
+			}
+			else
+				qCritical() << "Error counting contigs. Reason: "
+					<< query.lastError().text();
+			if (query.exec("attach database '" + Database::getFragDBName()
+						+ "' as 'fragDB'")
+					&& query.exec("select count(*) from fragDB.fragment")
+					&& query.next())
+				numReads = query.value(0).toLongLong();
+			else
+				qCritical() << "Error counting reads. Reason: "
+					<< query.lastError().text();
+			db.close();
+		}
+		QSqlDatabase::removeDatabase(connectionName);
+
+		printStage("ace_parse", stageTimes.at(Parser::AceParsing),
+				(qreal) aceSize / BYTE_TO_MBYTE, "MB");
+		printStage("contig_save", stageTimes.at(Parser::ContigSaving),
+				(qreal) numContigs, "contigs");
+		printStage("contig_bases", stageTimes.at(Parser::ContigSaving),
+				(qreal) numBases, "bases");
+		printStage("fragment_save", stageTimes.at(Parser::FragmentSaving),
+				(qreal) numReads, "reads");
+
+		if (numContigs == 0 || parser->hasParseError())
+		{
+			finish(1);
+			return;
+		}
+	}
+
+	if (!importAnnotation())
+	{
+		finish(1);
+		return;
+	}
+	printStage("total", timer.elapsed(), (qreal) aceSize / BYTE_TO_MBYTE, "MB");
+	finish(0);
+}
+
+
+/*
+ * Imports 'order.txt' and the BED files in the reference directory and
+ * the cytoband file, if they were given
+ */
+bool HeadlessImporter::importAnnotation()
+{
+	QTime stageTimer;
+	QDir dir;
+	QStringList filesList, nameFilters;
+	QString path;
+	qint64 size;
+
+	if (!refDir.isEmpty())
+	{
+		dir.setPath(refDir);
+		nameFilters << "*.bed" << "order.txt";
+		filesList = dir.entryList(nameFilters);
+		if (!filesList.contains("order.txt", Qt::CaseInsensitive))
+		{
+			qCritical() << "Reference directory" << refDir
+				<< "does not contain file 'order.txt'.";
+			return false;
+		}
+
+		size = 0;
+		foreach (QString file, filesList)
+			size += QFileInfo(dir, file).size();
+		path = dir.absolutePath();
+		stageTimer.start();
+		if (!parser->readBedFiles(filesList, filesList.size(), path))
+			return false;
+		printStage("annotation", stageTimer.elapsed(), (qreal) size / BYTE_TO_MBYTE, "MB");
+	}
+
+	if (!cytobandFile.isEmpty())
+	{
+		stageTimer.start();
+		if (!parser->readCytoband(cytobandFile))
+			return false;
+		printStage("cytoband", stageTimer.elapsed(),
+				(qreal) QFileInfo(cytobandFile).size() / BYTE_TO_MBYTE, "MB");
+	}
+	return true;
+}
+
+
+/*
+ * Ends the import with the given exit code
+ */
+void HeadlessImporter::finish(const int code)
+{
+	exitCode = code;
+	emit finished();
+}
+
+
+/*
+ * Prints one line of the throughput table. Stages that did not report
+ * a time are skipped.
+ */
+void HeadlessImporter::printStage(
+		const QString &stage,
+		const int msecs,
+		const qreal amount,
+		const QString &unit)
+{
+	QTextStream out(stdout);
+	qreal seconds;
+
+	if (msecs < 0)
+		return;
+	seconds = msecs / 1000.0;
+	out << stage << "\t"
+		<< QString::number(seconds, 'f', 3) << "\t"
+		<< QString::number(amount, 'f', (unit == "MB")? 1: 0) << "\t"
+		<< unit << "\t"
+		<< QString::number((seconds > 0)? amount / seconds: 0.0, 'f', 1) << "\n";
+	out.flush();
+}
@@ -0,0 +1,49 @@
+#ifndef HEADLESSIMPORTER_H_
+#define HEADLESSIMPORTER_H_
+
+#include <QObject>
+#include <QStringList>
+#include <QTime>
+#include <QVector>
+#include "parser.h"
+
+class HeadlessImporter : public QObject
+{
+	Q_OBJECT
+
+public:
+	HeadlessImporter();
+	~HeadlessImporter();
+	inline void setAceFiles(const QStringList &files) { aceFiles = files; };
+	inline void setRefDir(const QString &dir) { refDir = dir; };
+	inline void setCytobandFile(const QString &file) { cytobandFile = file; };
+
+	/** Returns 0 if the import succeeded and 1 otherwise */
+	inline int getExitCode() const { return exitCode; };
+
+	public slots:
+	void start();
+
+	signals:
+	void finished();
+
+private:
+	Parser *parser;
+	QStringList aceFiles;		/* ACE files to be imported */
+	QString refDir;				/* Directory with 'order.txt' and BED files */
+	QString cytobandFile;		/* Cytoband file */
+	QTime timer;				/* Started when the contig import starts */
+	QVector<int> stageTimes;	/* Milliseconds taken by each Parser::Stage */
+	qint64 aceSize;				/* Total size of the ACE files in bytes */
+	int exitCode;
+
+	bool importAnnotation();
+	void finish(const int);
+	void printStage(const QString &, const int, const qreal, const QString &);
+
+	private slots:
+	void stageFinished(int);
+	void contigImportFinished();
+};
+
+#endif /* HEADLESSIMPORTER_H_ */
@@ -0,0 +1,136 @@
+#include <QApplication>
+#include <QDir>
+#include <QStringList>
+#include <QTimer>
+#include <QTextStream>
+#include <limits.h>
+#include "database.h"
+#include "parserThread.h"
+#include "contigAnalyzer.h"
+#include "headlessImporter.h"
+#include "trace.h"
+
+#define	QUEUED_READ_BYTES	1024		/* Approximate memory held by a queued read */
+
+/*
+ * Command-line importer. Builds a project directory from ACE files, or
+ * from coordinate-sorted SAM/BAM files and a FASTA reference, and,
+ * optionally, a reference directory and a cytoband file, without the
+ * GUI. The desktop application opens the project with
+ * 'basejumper --project <dir>'.
+ */
+
+
+/*
+ * Prints the usage message
+ */
+static void printUsage()
+{
+	QTextStream err(stderr);
+
+	err << "Usage: basejumper-import --project <dir> [options] <ACE files, optionally gzipped>\n"
+		<< "       basejumper-import --project <dir> [options] <SAM/BAM files> <FASTA file>\n"
+		<< "Options:\n"
+		<< "  --project <dir>     Directory in which the project DBs are created\n"
+		<< "  --ref <dir>         Directory containing 'order.txt' and BED files\n"
+		<< "  --cytoband <file>   Cytoband file\n"
+		<< "  --queue-memory <MB> Memory for parsed reads waiting to be saved to the DB.\n"
+		<< "                      The reads of the contig being parsed are not counted,\n"
+		<< "                      so a contig with many reads can use more than this.\n"
+		<< "  --max-rows <n>      Maximum number of read rows per contig (0 for no limit)\n"
+		<< "  --trace <file>      Record a trace viewable in chrome://tracing\n";
+}
+
+
+int main(int argc, char *argv[])
+{
+	/* No windows are created, so no display is needed */
+	QApplication app(argc, argv, false);
+	QStringList args, aceFiles;
+	QString projectDir, refDir, cytobandFile, arg;
+	HeadlessImporter *importer;
+	Database *db;
+	bool ok;
+	int i, n;
+
+	args = app.arguments();
+	for (i = 1; i < args.size(); ++i)
+	{
+		arg = args.at(i);
+		if (arg.startsWith("--") && i + 1 >= args.size())
+		{
+			printUsage();
+			return 2;
+		}
+		if (arg == "--project")
+			projectDir = args.at(++i);
+		else if (arg == "--ref")
+			refDir = args.at(++i);
+		else if (arg == "--cytoband")
+			cytobandFile = args.at(++i);
+		else if (arg == "--queue-memory")
+		{
+			n = args.at(++i).toInt(&ok);
+			if (!ok || n <= 0)
+			{
+				printUsage();
+				return 2;
+			}
+			ParserThread::setMaxQueuedReads(
+					(int) qMin((qint64) n * 1048576 / QUEUED_READ_BYTES, (qint64) INT_MAX));
+		}
+		else if (arg == "--max-rows")
+		{
+			n = args.at(++i).toInt(&ok);
+			if (!ok || n < 0)
+			{
+				printUsage();
+				return 2;
+			}
+			ContigAnalyzer::setMaxRows(n);
+		}
+		else if (arg == "--trace")
+		{
+			if (!Trace::start(args.at(++i)))
+				return 1;
+		}
+		else if (arg.startsWith("--"))
+		{
+			printUsage();
+			return 2;
+		}
+		else
+			aceFiles.append(arg);
+	}
+	if (projectDir.isEmpty() || (aceFiles.isEmpty() && refDir.isEmpty()))
+	{
+		printUsage();
+		return 2;
+	}
+	if (!QDir().mkpath(projectDir))
+	{
+		QTextStream(stderr) << "Cannot create directory " << projectDir << "\n";
+		return 1;
+	}
+
+	/* A new contig import replaces the contents of the project */
+	Database::setDirectory(projectDir);
+	db = new Database;
+	db->createConnection();
+	if (!aceFiles.isEmpty())
+		db->closeConnection();
+
+	importer = new HeadlessImporter;
+	importer->setAceFiles(aceFiles);
+	importer->setRefDir(refDir);
+	importer->setCytobandFile(cytobandFile);
+	QObject::connect(importer, SIGNAL(finished()), &app, SLOT(quit()));
+	QTimer::singleShot(0, importer, SLOT(start()));
+
+	app.exec();
+	n = importer->getExitCode();
+	Trace::stop();
+	delete importer;
+	delete db;
+	return n;
+}
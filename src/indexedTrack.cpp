@@ -0,0 +1,332 @@
+
+#include "indexedTrack.h"
+#include <QFileInfo>
+#include <QDataStream>
+#include <QtAlgorithms>
+#include <QtDebug>
+#include <stdlib.h>
+#include <string.h>
+
+#define	TABIX_MIN_SHIFT		14
+#define	TABIX_ZERO_BASED	0x10000
+#define	MAX_FIELDS			16
+#define	READ_BUFFER_SIZE	65536
+
+QHash<QString, IndexedTrack *> IndexedTrack::trackHash;
+
+
+/*
+ * Returns true if the first chunk begins before the second one
+ */
+static bool chunkLessThan(
+		const QPair<quint64, quint64> &c1,
+		const QPair<quint64, quint64> &c2)
+{
+	return (c1.first < c2.first);
+}
+
+
+/**
+ * Constructor
+ */
+IndexedTrack::IndexedTrack()
+{
+	columnSeq = 0;
+	columnBegin = 1;
+	columnEnd = 2;
+	metaChar = '#';
+	isZeroBased = true;
+}
+
+
+/**
+ * Destructor
+ */
+IndexedTrack::~IndexedTrack()
+{
+	reader.close();
+}
+
+
+/**
+ * Returns the track for the given bgzip-compressed file, opening it
+ * and its tabix index (<file>.tbi) the first time it is requested
+ *
+ * @param path : Path of the compressed file
+ * @return Pointer to the track, or NULL if the file or its index
+ * could not be read
+ */
+IndexedTrack * IndexedTrack::getTrack(const QString &path)
+{
+	IndexedTrack *track;
+
+	if (trackHash.contains(path))
+		return trackHash.value(path);
+
+	track = new IndexedTrack;
+	if (!track->open(path))
+	{
+		delete track;
+		track = NULL;
+	}
+	trackHash.insert(path, track);
+	return track;
+}
+
+
+/**
+ * Closes all the open tracks
+ */
+void IndexedTrack::closeAll()
+{
+	foreach (IndexedTrack *track, trackHash)
+		delete track;
+	trackHash.clear();
+}
+
+
+/**
+ * Fetches the features that overlap the given range of the given
+ * sequence
+ *
+ * @param seqName : Name of the sequence (chromosome)
+ * @param begin : Start of the range (0-based, inclusive)
+ * @param end : End of the range (0-based, exclusive)
+ * @param list : The features are appended to this list, in chromosome
+ * coordinates
+ *
+ * @return Returns true on success and false on failure
+ */
+bool IndexedTrack::fetch(
+		const QByteArray &seqName,
+		const int begin,
+		const int end,
+		QList<Annotation *> &list)
+{
+	QList<Chunk> chunks;
+	Chunk chunk;
+	QByteArray line;
+	int fieldStart[MAX_FIELDS], fieldEnd[MAX_FIELDS];
+	int numFields, nameColumn, pos, size, featureBegin, featureEnd;
+	const char *data, *next;
+
+	if (!refIdHash.contains(seqName) || end <= 0 || begin >= end)
+		return true;
+	getChunks(refIdHash.value(seqName), qMax(begin, 0), end, chunks);
+
+	nameColumn = qMax(columnSeq, qMax(columnBegin, columnEnd)) + 1;
+	foreach (chunk, chunks)
+	{
+		if (!reader.seek(chunk.first))
+			return false;
+		while (reader.tell() < chunk.second && reader.readLine(line))
+		{
+			if (line.isEmpty()
+					|| line.at(0) == metaChar
+					|| line.startsWith("track")
+					|| line.startsWith("browser"))
+				continue;
+
+			/* Split the line at tabs */
+			data = line.constData();
+			size = line.size();
+			numFields = 0;
+			pos = 0;
+			while (numFields < MAX_FIELDS && pos <= size)
+			{
+				fieldStart[numFields] = pos;
+				next = (const char *) memchr(data + pos, '\t', size - pos);
+				pos = (next == NULL)? size: (next - data);
+				fieldEnd[numFields++] = pos++;
+			}
+			if (numFields <= columnSeq || numFields <= columnBegin
+					|| (columnEnd >= 0 && numFields <= columnEnd))
+				continue;
+			if (fieldEnd[columnSeq] - fieldStart[columnSeq] != seqName.size()
+					|| memcmp(data + fieldStart[columnSeq],
+							seqName.constData(), seqName.size()) != 0)
+				continue;
+
+			featureBegin = (int) strtol(data + fieldStart[columnBegin], NULL, 10);
+			if (!isZeroBased)
+				--featureBegin;
+			if (columnEnd >= 0)
+				featureEnd = (int) strtol(data + fieldStart[columnEnd], NULL, 10);
+			else
+				featureEnd = featureBegin + 1;
+
+			/* Features are sorted by start position */
+			if (featureBegin >= end)
+				break;
+			if (featureEnd <= begin)
+				continue;
+
+			list.append(new Annotation(
+					0,
+					(numFields > nameColumn)
+						? QString::fromAscii(data + fieldStart[nameColumn],
+								fieldEnd[nameColumn] - fieldStart[nameColumn])
+						: QString(),
+					featureBegin,
+					featureEnd));
+		}
+	}
+	return true;
+}
+
+
+/*
+ * Opens the given compressed file and reads its index
+ */
+bool IndexedTrack::open(const QString &path)
+{
+	if (!QFileInfo(path + ".tbi").exists())
+	{
+		qCritical() << "Cannot find index file " << path + ".tbi";
+		return false;
+	}
+	if (!readIndex(path + ".tbi"))
+		return false;
+	return reader.open(path);
+}
+
+
+/*
+ * Reads the given tabix index
+ */
+bool IndexedTrack::readIndex(const QString &indexPath)
+{
+	BgzfReader indexReader;
+	QByteArray bytes;
+	char buffer[READ_BUFFER_SIZE];
+	qint64 numRead;
+	qint32 numRefs, format, colSeq, colBegin, colEnd, meta, skip, namesLength;
+	qint32 numBins, numChunks, numIntervals;
+	quint32 bin;
+	quint64 chunkBegin, chunkEnd, offset;
+	int i, j, k;
+	QList<QByteArray> names;
+	char magic[4];
+
+	/* The index itself is BGZF compressed */
+	if (!indexReader.open(indexPath))
+		return false;
+	while ((numRead = indexReader.read(buffer, READ_BUFFER_SIZE)) > 0)
+		bytes.append(buffer, (int) numRead);
+	indexReader.close();
+
+	QDataStream in(bytes);
+	in.setByteOrder(QDataStream::LittleEndian);
+	if (in.readRawData(magic, 4) != 4 || memcmp(magic, "TBI\1", 4) != 0)
+	{
+		qCritical() << "Not a tabix index: " << indexPath;
+		return false;
+	}
+	in >> numRefs >> format >> colSeq >> colBegin >> colEnd >> meta >> skip
+		>> namesLength;
+	if (in.status() != QDataStream::Ok || numRefs < 0 || namesLength < 0)
+		return false;
+
+	/* Column numbers are 1-based in the index */
+	columnSeq = colSeq - 1;
+	columnBegin = colBegin - 1;
+	columnEnd = colEnd - 1;
+	metaChar = (char) meta;
+	isZeroBased = ((format & TABIX_ZERO_BASED) != 0);
+
+	bytes = QByteArray(namesLength, '\0');
+	in.readRawData(bytes.data(), namesLength);
+	names = bytes.split('\0');
+	for (i = 0; i < numRefs && i < names.size(); ++i)
+		refIdHash.insert(names.at(i), i);
+
+	refList.resize(numRefs);
+	for (i = 0; i < numRefs; ++i)
+	{
+		in >> numBins;
+		for (j = 0; j < numBins && in.status() == QDataStream::Ok; ++j)
+		{
+			in >> bin >> numChunks;
+			QVector<Chunk> &chunks = refList[i].binHash[bin];
+			for (k = 0; k < numChunks && in.status() == QDataStream::Ok; ++k)
+			{
+				in >> chunkBegin >> chunkEnd;
+				chunks.append(qMakePair(chunkBegin, chunkEnd));
+			}
+		}
+		in >> numIntervals;
+		for (j = 0; j < numIntervals && in.status() == QDataStream::Ok; ++j)
+		{
+			in >> offset;
+			refList[i].linearIndex.append(offset);
+		}
+		if (in.status() != QDataStream::Ok)
+		{
+			qCritical() << "Truncated tabix index: " << indexPath;
+			return false;
+		}
+	}
+	return true;
+}
+
+
+/*
+ * Collects the chunks of the file that may contain features overlapping
+ * the given range, sorted and merged
+ */
+void IndexedTrack::getChunks(
+		const int refId,
+		const int begin,
+		const int end,
+		QList<Chunk> &chunks) const
+{
+	const Reference &ref = refList.at(refId);
+	QList<quint32> bins;
+	quint32 bin, first, last;
+	quint64 minOffset;
+	int i, intervalIndex;
+	static const int levelOffsets[] = {1, 9, 73, 585, 4681};
+	static const int levelShifts[] = {26, 23, 20, 17, 14};
+
+	/* Bins overlapping [begin, end) in the UCSC binning scheme */
+	bins.append(0);
+	for (i = 0; i < 5; ++i)
+	{
+		first = levelOffsets[i] + (begin >> levelShifts[i]);
+		last = levelOffsets[i] + ((end - 1) >> levelShifts[i]);
+		for (bin = first; bin <= last; ++bin)
+			bins.append(bin);
+	}
+
+	/* Chunks that end before the smallest offset of the 16 kb window
+	 * containing 'begin' cannot contain overlapping features */
+	minOffset = 0;
+	intervalIndex = begin >> TABIX_MIN_SHIFT;
+	if (!ref.linearIndex.isEmpty())
+		minOffset = ref.linearIndex.at(qMin(intervalIndex, ref.linearIndex.size() - 1));
+
+	chunks.clear();
+	foreach (bin, bins)
+	{
+		if (!ref.binHash.contains(bin))
+			continue;
+		foreach (const Chunk &chunk, ref.binHash.value(bin))
+		{
+			if (chunk.second > minOffset)
+				chunks.append(chunk);
+		}
+	}
+
+	/* Merge overlapping chunks */
+	qSort(chunks.begin(), chunks.end(), chunkLessThan);
+	for (i = 1; i < chunks.size(); )
+	{
+		if (chunks.at(i).first <= chunks.at(i - 1).second)
+		{
+			chunks[i - 1].second = qMax(chunks.at(i - 1).second, chunks.at(i).second);
+			chunks.removeAt(i);
+		}
+		else
+			++i;
+	}
+}
@@ -0,0 +1,52 @@
+#ifndef INDEXEDTRACK_H_
+#define INDEXEDTRACK_H_
+
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QVector>
+#include <QString>
+#include "bgzfReader.h"
+#include "annotation.h"
+
+class IndexedTrack
+{
+public:
+	~IndexedTrack();
+	static IndexedTrack *getTrack(const QString &);
+	static void closeAll();
+	bool fetch(
+			const QByteArray &,
+			const int,
+			const int,
+			QList<Annotation *> &);
+
+private:
+	/* Chunk of the file, given as a pair of virtual offsets */
+	typedef QPair<quint64, quint64> Chunk;
+
+	/* Binning and linear index of one sequence */
+	struct Reference
+	{
+		QHash<quint32, QVector<Chunk> > binHash;
+		QVector<quint64> linearIndex;
+	};
+
+	BgzfReader reader;
+	QHash<QByteArray, int> refIdHash;	/* Maps sequence name => reference index */
+	QVector<Reference> refList;
+	int columnSeq;			/* 0-based column of the sequence name */
+	int columnBegin;		/* 0-based column of the start position */
+	int columnEnd;			/* 0-based column of the end position */
+	char metaChar;			/* Lines beginning with this character are skipped */
+	bool isZeroBased;		/* Whether start positions are 0-based */
+
+	static QHash<QString, IndexedTrack *> trackHash;
+
+	IndexedTrack();
+	bool open(const QString &);
+	bool readIndex(const QString &);
+	void getChunks(const int, const int, const int, QList<Chunk> &) const;
+};
+
+#endif /* INDEXEDTRACK_H_ */
@@ -12,6 +12,7 @@
 #define	PADDING				2
 #define	DBL_PADDING			4
 #define MAX_DEPTH			20
+#define COVERAGE_HEIGHT		12
 
 
 /**
@@ -62,9 +63,10 @@ void IntermediateViewPainterThread::run()
 
 	int contigStartX, contigMidX, contigEndX, contigOffsetY;
 	int lineSize, fragYPos, numFrags, x1, x2, y1, y2;
-	int maxDepth;
+	int maxDepth, maxCoverage, x, start, end, barHeight;
 	float ratio, maxYPos_logValue, maxYPos_log10Value;
 	Fragment *frag;
+	QList<Fragment *> displayList;
 	QBrush brush;
 	enum ScaleType {Linear, LogBaseE, LogBase10};
 	ScaleType yPosScale;
@@ -78,7 +80,13 @@ void IntermediateViewPainterThread::run()
 	labelPos.ry() = contigOffsetY - 2;
 	lineSize = width - (2 * HORIZONTAL_MARGIN) - 20;
 	ratio = (float) lineSize / contig->size;
-	numFrags = contig->fragList->size();
+
+	/* Paint a sample of the reads that start in each pixel column. The
+	 * GUI thread waits for this thread to finish, so the contig does not
+	 * change while it is sampled; the view is only repainted when the
+	 * contig changes or the view is resized. */
+	contig->fragList->sample(qMax(1, (int) ceil(1.0 / ratio)), displayList);
+	numFrags = displayList.size();
 	maxDepth = (int) floor((float) (height - contigOffsetY) / 2) - 2;
 	maxYPos_logValue = log(contig->maxFragRows);
 	maxYPos_log10Value = log10(contig->maxFragRows);
@@ -88,6 +96,27 @@ void IntermediateViewPainterThread::run()
 	QPainter painter(&image);
 	painter.fillRect(QRect(0, 0, width, height), QBrush(QColor(Qt::white)));
 
+	/* Draw coverage as a histogram above the contig; each column shows
+	 * the maximum depth of the bases it covers */
+	maxCoverage = contig->coverageProfile.getMaxDepth(0, contig->size - 1);
+	if (maxCoverage > 0)
+	{
+		painter.setPen(QColor(Qt::darkCyan));
+		for (x = contigStartX; x <= contigEndX; ++x)
+		{
+			start = (int) floor((x - contigStartX) / ratio);
+			if (start >= contig->size)
+				break;
+			end = (int) floor((x - contigStartX + 1) / ratio) - 1;
+			if (end < start)
+				end = start;
+			barHeight = contig->coverageProfile.getMaxDepth(start, end)
+				* COVERAGE_HEIGHT / maxCoverage;
+			if (barHeight > 0)
+				painter.drawLine(x, contigOffsetY - 3, x, contigOffsetY - 3 - barHeight);
+		}
+	}
+
 	/* Draw contig */
 	QRect rect(
 			QPoint(contigStartX, contigOffsetY),
@@ -112,7 +141,7 @@ void IntermediateViewPainterThread::run()
 	/* Draw fragments */
 	for (int i = 0; i < numFrags; ++i)
 	{
-		frag = contig->fragList->at(i);
+		frag = displayList.at(i);
 		x1 = contigStartX + (frag->startPos * ratio);
 		x2 = contigStartX + (frag->endPos * ratio);
 
@@ -1,11 +1,26 @@
 #include <QApplication>
 
 #include "mainwindow.h"
+#include "database.h"
+#include "trace.h"
 #include <QtGui>
 
 int main(int argc, char *argv[])
 {
     QApplication app(argc, argv);
+    QStringList args = app.arguments();
+    int index, exitCode;
+
+    /* 'basejumper --project <dir>' opens a project built by the
+     * command-line importer */
+    index = args.indexOf("--project");
+    if (index >= 0 && index + 1 < args.size())
+    	Database::setDirectory(args.at(index + 1));
+
+    /* 'basejumper --trace <file>' records a trace from the start */
+    index = args.indexOf("--trace");
+    if (index >= 0 && index + 1 < args.size())
+    	Trace::start(args.at(index + 1));
 
     //QPixmap pixmap(":/images/basejumper.png");
     //QSplashScreen splash(pixmap, Qt::WindowStaysOnTopHint);
@@ -14,9 +29,12 @@ int main(int argc, char *argv[])
 
     MainWindow mainWin;
     mainWin.show();
+    if (Database::hasDirectory())
+    	mainWin.openProject();
 
     //splash.finish(&mainWin);
 
-    return app.exec();
+    exitCode = app.exec();
+    Trace::stop();
+    return exitCode;
 }
-
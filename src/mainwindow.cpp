@@ -9,10 +9,25 @@
 #include <QSqlError>
 #include <QFileInfo>
 #include "file.h"
+#include "indexedTrack.h"
+#include "contigAnalyzer.h"
+#include "fragmentList.h"
+#include "trace.h"
+#include "perfMonitor.h"
+#include "slowQueryDialog.h"
+#include "slowQueryLog.h"
+#include "alignmentExporterThread.h"
 #include "iostream"
 
 #define	FIRST_FILE_INDEX		1
 #define	SNP_THRESHOLD			30
+#define	CONTIG_CACHE_SIZE		512		/* In megabytes */
+#define	MAX_READ_ROWS			500
+#define	MAX_READ_ROWS_LIMIT		100000
+#define	READS_PER_BIN			50
+#define	READS_PER_BIN_LIMIT		10000
+#define	SLOW_QUERY_THRESHOLD	100		/* In milliseconds */
+#define	BROWSE_REDRAW_INTERVAL	250		/* In milliseconds */
 
 QString MainWindow::APPLICATION_ORGANIZATION = "SJCRH";
 QString MainWindow::APPLICATION_NAME = "Basejumper";
@@ -22,8 +37,13 @@ QString MainWindow::VERSION_NUMBER = "0.01";
 QString MainWindow::SETTINGS_GEOMETRY = "geometry";
 QString MainWindow::SETTINGS_RECENT_FILES = "recentFiles";
 QString MainWindow::SETTINGS_SNP_THRESHOLD = QString(SNP_THRESHOLD);
+QString MainWindow::SETTINGS_CONTIG_CACHE_SIZE = "contigCacheSize";
+QString MainWindow::SETTINGS_MAX_READ_ROWS = "maxReadRows";
+QString MainWindow::SETTINGS_READS_PER_BIN = "readsPerBin";
+QString MainWindow::SETTINGS_READ_SAMPLE_SEED = "readSampleSeed";
 QString MainWindow::SETTINGS_OPEN_FILE_DIRECTORY = "openFileDirectory";
 QString MainWindow::SETTINGS_OPEN_REF_FILE_DIRECTORY = ".";
+QString MainWindow::SETTINGS_SLOW_QUERY_THRESHOLD = "slowQueryThreshold";
 
 /**
  * Constructor
@@ -71,6 +91,13 @@ MainWindow::MainWindow()
     //		db, SLOT(deleteAll()));
     connect(parser, SIGNAL(parsingFinished()),
     		this, SLOT(finishParsing()));
+    connect(parser, SIGNAL(contigsAvailable(int)),
+    		this, SLOT(browseAvailableContigs(int)));
+    isBrowsingDuringParse = false;
+    browseRedrawTimer.setSingleShot(true);
+    browseRedrawTimer.setInterval(BROWSE_REDRAW_INTERVAL);
+    connect(&browseRedrawTimer, SIGNAL(timeout()),
+    		this, SLOT(redrawAvailableContigs()));
 
     /* Maparea or Contig View widget */
 	mapArea = new MapArea(this, centralWidget);
@@ -217,6 +244,17 @@ MainWindow::MainWindow()
 	centralWidget->setLayout(hBoxLayout);
 	setCentralWidget(centralWidget);
 
+	/* Performance monitor, hidden until the user opens it */
+	perfMonitor = new PerfMonitor(mapArea);
+	perfMonitorDock = new QDockWidget(tr("Performance Monitor"), this);
+	perfMonitorDock->setObjectName("perfMonitorDock");
+	perfMonitorDock->setWidget(perfMonitor);
+	addDockWidget(Qt::RightDockWidgetArea, perfMonitorDock);
+	perfMonitorDock->hide();
+
+	/* Slow query summary, shown from the Edit menu */
+	slowQueryDialog = new SlowQueryDialog(this);
+
     createActions();
     createMenus();
     createToolBars();
@@ -230,9 +268,9 @@ MainWindow::MainWindow()
     connect(parser, SIGNAL(totalSize(int)),
     		progressDialog, SLOT(setMaximum(int)));
     connect(parser, SIGNAL(parsingProgress(int)),
-    		progressDialog, SLOT(setValue(int)));
+    		this, SLOT(setProgressDialogValue(const int)));
     connect(parser, SIGNAL(messageChanged(const QString &)),
-    		progressDialog, SLOT(setLabelText(const QString &)));
+    		this, SLOT(setProgressDialogLabel(const QString &)));
     connect(parser, SIGNAL(parsingFinished()),
     		progressDialog, SLOT(reset()));
     connect(parser, SIGNAL(annotationParsingFinished()),
@@ -254,6 +292,11 @@ MainWindow::MainWindow()
     geneExporter = new GeneOverlapExporter;
     connect(exportGeneOverlapAction, SIGNAL(triggered()),
     		geneExporter, SLOT(exportGenes()));
+
+    /* SAM/BAM exporter, which runs in the background */
+    alignmentExporterThread = new AlignmentExporterThread;
+    connect(alignmentExporterThread, SIGNAL(messageChanged(const QString &)),
+    		statusBar(), SLOT(showMessage(const QString &)));
 }
 
 
@@ -262,6 +305,7 @@ MainWindow::MainWindow()
  */
 MainWindow::~MainWindow()
 {
+	IndexedTrack::closeAll();
 	delete coverageMessageBox;
 	delete locationLabel;
 	delete progressBar;
@@ -280,8 +324,13 @@ MainWindow::~MainWindow()
     delete whatsThisAction;
     delete exportAction;
     delete exportGeneOverlapAction;
+    delete exportAlignmentsAction;
     delete bookmarkAction;
     delete snpThresholdAction;
+    delete readRowLimitAction;
+    delete readSamplingAction;
+    delete traceAction;
+    delete slowQueryAction;
     delete searchAction;
 	foreach (QAction *action, bookmarkVector)
 		delete action;
@@ -291,9 +340,12 @@ MainWindow::~MainWindow()
     delete snpNavWidget;
     delete annotNavWidget;
     delete zoomWidget;
+    delete perfMonitorDock;
+    delete slowQueryDialog;
 
 	delete parser;
 	delete geneExporter;
+	delete alignmentExporterThread;
 
     delete intermediateView;
     delete globalView;
@@ -320,8 +372,10 @@ void MainWindow::closeEvent(QCloseEvent *event)
      * of memory and temporary files */
     emit messageChanged("Cleaning up...");
 
+    /* The DBs of a project directory are kept for the next session */
     //db->closeConnection();
-    db->deleteAll();
+    if (!Database::hasDirectory())
+    	db->deleteAll();
 }
 
 
@@ -338,7 +392,11 @@ void MainWindow::open()
     		this,
     		tr("Select one or more files to open"),
     		directory,
-    		tr("ACE files (*.ace)"));
+    		tr("Assembly files (*.ace *.ace.gz *.ace.bgz *.sam *.sam.gz *.bam "
+    				"*.fa *.fasta *.fna);;"
+    			"ACE files (*.ace *.ace.gz *.ace.bgz);;"
+    			"SAM/BAM files with a FASTA reference (*.sam *.sam.gz *.bam "
+    				"*.fa *.fasta *.fna)"));
     selectedFilesNum = selectedFiles.count();
     if (selectedFilesNum == 0) return;
 
@@ -485,6 +543,19 @@ void MainWindow::open(const QStringList &fileList)
 }
 
 
+/*
+ * Shows the contigs of the project directory given on the command line
+ */
+void MainWindow::openProject()
+{
+	if (!parser->openProject())
+		QMessageBox::critical(
+				this,
+				MainWindow::APPLICATION_NAME,
+				tr("Error: The project directory does not contain any contigs."));
+}
+
+
 /*
  * This function is invoked when a new contig file is to be parsed.
  */
@@ -507,6 +578,8 @@ void MainWindow::parseFile()
 		/* Disable certain buttons and actions */
 		zoomWidget->setEnabled(false);
 		bookmarkAction->setDisabled(true);
+		exportAction->setDisabled(true);
+		exportAlignmentsAction->setDisabled(true);
 
 		/* Restore the normal cursor */
 		QApplication::restoreOverrideCursor();
@@ -541,13 +614,27 @@ void MainWindow::finishParsing()
 {
 	qDebug() << "Parsing finished...";
     progressBar->hide();
-    QApplication::restoreOverrideCursor();
     zoomWidget->setDisabled(false);
     bookmarkAction->setDisabled(false);
+    exportAction->setDisabled(false);
+    exportAlignmentsAction->setDisabled(false);
     mapArea->getHScrollBar()->setDisabled(false);
     mapArea->getVScrollBar()->setDisabled(false);
     qDebug() << "End of parseFile()";
-	emit resetZoom();
+
+    /* If the user has been browsing during the import, keep the current
+     * view and only redraw Global View with all the contigs */
+    browseRedrawTimer.stop();
+    if (isBrowsingDuringParse)
+    {
+    	isBrowsingDuringParse = false;
+    	globalView->createContigPixmap();
+    }
+    else
+    {
+    	QApplication::restoreOverrideCursor();
+    	emit resetZoom();
+    }
 	qDebug() << "Exiting parseFile()";
 
 	/* Set main window title */
@@ -560,6 +647,51 @@ void MainWindow::finishParsing()
 }
 
 
+/*
+ * Invoked while contigs are being imported, every time more contigs
+ * (along with their reads) have been committed to the DB.
+ *
+ * The first time this is invoked, the progress dialog is dismissed and
+ * the Base View is enabled so that the user can start browsing the
+ * contigs that are available while the rest are being imported.
+ *
+ * @param numContigs : Number of contigs available
+ */
+void MainWindow::browseAvailableContigs(int numContigs)
+{
+	/* Each redraw costs time proportional to the number of contigs, so
+	 * batches arriving close together share one redraw */
+	if (isBrowsingDuringParse)
+	{
+		if (!browseRedrawTimer.isActive())
+			browseRedrawTimer.start();
+	}
+	else
+	{
+		redrawAvailableContigs();
+		isBrowsingDuringParse = true;
+		progressDialog->reset();
+		QApplication::restoreOverrideCursor();
+		zoomWidget->setDisabled(false);
+		mapArea->getHScrollBar()->setDisabled(false);
+		mapArea->getVScrollBar()->setDisabled(false);
+		emit resetZoom();
+	}
+	progressBar->setToolTip(tr("%1 contigs available").arg(numContigs));
+}
+
+
+/*
+ * Redraws the contig order and Global View with the contigs that are
+ * available so far
+ */
+void MainWindow::redrawAvailableContigs()
+{
+	mapArea->getContigOrderIdHash();
+	globalView->createContigPixmap();
+}
+
+
 /*
  * Function to create action items in the File menu
  */
@@ -574,7 +706,10 @@ void MainWindow::createActions()
     openAction->setToolTip(tr("Open an ACE file"));
     openAction->setIcon(QIcon(":/images/folder_page.png"));
 	tmp = "<b>Open</b> action allows the user to select "
-			"the sequence files to be loaded into " + MainWindow::APPLICATION_NAME + ".";
+			"the sequence files to be loaded into " + MainWindow::APPLICATION_NAME + ". "
+			"SAM and BAM files sorted by coordinate are selected together with "
+			"the FASTA file of their reference sequences. ACE files may be "
+			"gzip- or bgzip-compressed.";
 	openAction->setWhatsThis(tmp);
     connect(openAction, SIGNAL(triggered()), this, SLOT(open()));
 
@@ -595,7 +730,9 @@ void MainWindow::createActions()
     exportAction->setStatusTip(tr("Export the selected region as an ACE file"));
     exportAction->setDisabled(true);
 	tmp = tr("<b>Export</b> action allows the user to "
-			"export the displayed sequence into a text file.");
+			"export a region of the displayed contig, by default the one "
+			"shown in Base View, and the reads overlapping it into an ACE "
+			"file.");
 	exportAction->setWhatsThis(tmp);
 	connect(exportAction, SIGNAL(triggered()),
 			mapArea, SLOT(exportSelection()));
@@ -610,6 +747,19 @@ void MainWindow::createActions()
     connect(parser, SIGNAL(annotationLoaded()),
     		this, SLOT(enableExportGeneOverlapAction()));
 
+    /* Export SAM/BAM action */
+    exportAlignmentsAction = new QAction(tr("Export Reads as SAM/BAM..."), this);
+    exportAlignmentsAction->setStatusTip(
+    		tr("Export all the reads to a sorted SAM or BAM file"));
+    exportAlignmentsAction->setDisabled(true);
+    tmp = tr("<b>Export Reads as SAM/BAM</b> action allows the user to "
+    		"export all the reads of the loaded contigs, sorted by position, "
+    		"into a SAM file or a BAM file with a '.bai' index, which can "
+    		"be read by variant callers.");
+    exportAlignmentsAction->setWhatsThis(tmp);
+    connect(exportAlignmentsAction, SIGNAL(triggered()),
+    		this, SLOT(exportAlignments()));
+
     /* SNP threshold modification action */
     QByteArray statusTip = "Change SNP threshold value";
     snpThresholdAction = new QAction(tr("Change SNP Threshold"), this);
@@ -620,6 +770,55 @@ void MainWindow::createActions()
     connect(snpThresholdAction, SIGNAL(triggered()),
     		this, SLOT(getSnpThresholdInput()));
 
+    /* Read row limit modification action */
+    readRowLimitAction = new QAction(tr("Change Read Row Limit"), this);
+    readRowLimitAction->setStatusTip(
+    		tr("Change the maximum number of read rows of imported contigs"));
+	tmp = tr("<b>Change Read Row Limit</b> action allows the user to "
+			"change the maximum number of rows the reads of a contig are "
+			"laid out in. Reads beyond the limit are shown as a density "
+			"strip. The limit applies to files opened afterwards.");
+	readRowLimitAction->setWhatsThis(tmp);
+    connect(readRowLimitAction, SIGNAL(triggered()),
+    		this, SLOT(getReadRowLimitInput()));
+
+    /* Read downsampling modification action */
+    readSamplingAction = new QAction(tr("Change Read Downsampling"), this);
+    readSamplingAction->setStatusTip(
+    		tr("Change the maximum number of reads shown per pixel column"));
+	tmp = tr("<b>Change Read Downsampling</b> action allows the user to "
+			"change the maximum number of reads painted per pixel column. "
+			"Reads that support a SNP are always painted.");
+	readSamplingAction->setWhatsThis(tmp);
+    connect(readSamplingAction, SIGNAL(triggered()),
+    		this, SLOT(getReadSamplingInput()));
+
+    /* Trace recording action */
+    traceAction = new QAction(tr("Record Trace..."), this);
+    traceAction->setCheckable(true);
+    traceAction->setChecked(Trace::isEnabled());
+    traceAction->setStatusTip(
+    		tr("Record what the import threads are doing into a trace file"));
+	tmp = tr("<b>Record Trace</b> action allows the user to record the "
+			"activity of the import threads, such as queue depths, lock "
+			"waits and DB writes, into a file that can be opened in "
+			"chrome://tracing or Perfetto. Uncheck it to stop recording.");
+	traceAction->setWhatsThis(tmp);
+    connect(traceAction, SIGNAL(toggled(bool)),
+    		this, SLOT(toggleTrace(bool)));
+
+    /* Slow query action */
+    slowQueryAction = new QAction(tr("Slow Queries..."), this);
+    slowQueryAction->setStatusTip(
+    		tr("Show the DB statements that took longest"));
+	tmp = tr("<b>Slow Queries</b> action shows the DB statements that took "
+			"longer than a threshold, grouped by the code that issued them, "
+			"with their query plans and row counts. The statements are also "
+			"written to a log file next to the DBs.");
+	slowQueryAction->setWhatsThis(tmp);
+    connect(slowQueryAction, SIGNAL(triggered()),
+    		slowQueryDialog, SLOT(show()));
+
     /* Search action */
     searchAction = new QAction(tr("Search"), this);
     searchAction->setStatusTip(tr("Search sequence, gene, or position"));
@@ -695,6 +894,7 @@ void MainWindow::createMenus()
     fileMenu->addSeparator();
     fileMenu->addAction(exportAction);
     fileMenu->addAction(exportGeneOverlapAction);
+    fileMenu->addAction(exportAlignmentsAction);
     fileMenu->addSeparator();
     fileMenu->addAction(coverageAction);
     fileMenu->addSeparator();
@@ -708,6 +908,12 @@ void MainWindow::createMenus()
     /* Edit menu */
     editMenu = menuBar()->addMenu(tr("&Edit"));
     editMenu->addAction(snpThresholdAction);
+    editMenu->addAction(readRowLimitAction);
+    editMenu->addAction(readSamplingAction);
+    editMenu->addSeparator();
+    editMenu->addAction(perfMonitorDock->toggleViewAction());
+    editMenu->addAction(traceAction);
+    editMenu->addAction(slowQueryAction);
     editMenu->addAction(searchAction);
 
     /* Bookmark menu */
@@ -797,6 +1003,16 @@ void MainWindow::readSettings()
     		settings.value(MainWindow::SETTINGS_SNP_THRESHOLD, SNP_THRESHOLD).toInt());
     snpNavWidget->setThreshold(
     		settings.value(MainWindow::SETTINGS_SNP_THRESHOLD, SNP_THRESHOLD).toInt());
+    mapArea->setContigCacheSize(
+    		settings.value(MainWindow::SETTINGS_CONTIG_CACHE_SIZE, CONTIG_CACHE_SIZE).toInt());
+    ContigAnalyzer::setMaxRows(
+    		settings.value(MainWindow::SETTINGS_MAX_READ_ROWS, MAX_READ_ROWS).toInt());
+    FragmentList::setMaxReadsPerBin(
+    		settings.value(MainWindow::SETTINGS_READS_PER_BIN, READS_PER_BIN).toInt());
+    FragmentList::setSampleSeed(
+    		settings.value(MainWindow::SETTINGS_READ_SAMPLE_SEED, 0).toUInt());
+    SlowQueryLog::setThreshold(
+    		settings.value(MainWindow::SETTINGS_SLOW_QUERY_THRESHOLD, SLOW_QUERY_THRESHOLD).toInt());
 }
 
 
@@ -810,6 +1026,11 @@ void MainWindow::writeSettings()
     settings.setValue(MainWindow::SETTINGS_GEOMETRY, geometry());
     settings.setValue(MainWindow::SETTINGS_RECENT_FILES, recentFiles);
     settings.setValue(MainWindow::SETTINGS_SNP_THRESHOLD, mapArea->getSnpThreshold());
+    settings.setValue(MainWindow::SETTINGS_CONTIG_CACHE_SIZE, mapArea->getContigCacheSize());
+    settings.setValue(MainWindow::SETTINGS_MAX_READ_ROWS, ContigAnalyzer::getMaxRows());
+    settings.setValue(MainWindow::SETTINGS_READS_PER_BIN, FragmentList::getMaxReadsPerBin());
+    settings.setValue(MainWindow::SETTINGS_READ_SAMPLE_SEED, FragmentList::getSampleSeed());
+    settings.setValue(MainWindow::SETTINGS_SLOW_QUERY_THRESHOLD, SlowQueryLog::getThreshold());
 }
 
 
@@ -977,7 +1198,7 @@ void MainWindow::getAllBookmarkNames(QList<QString> &bookmarkList)
 	QSqlQuery query(db);
 
 	str = "select name from bookmark";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 			reinterpret_cast<QWidget *>(this),
@@ -1031,32 +1252,180 @@ void MainWindow::addBookmarkAction(const QString &name)
  */
 void MainWindow::getSnpThresholdInput()
 {
-	int snpThreshold, existingSnpThreshold;
-	bool ok;
-	QByteArray label;
+	int existingSnpThreshold;
+	QDialog dialog(this);
+	QLabel *label;
+	QSlider *slider;
+	QSpinBox *spinBox;
+	QDialogButtonBox *buttonBox;
+	QHBoxLayout *sliderLayout;
+	QVBoxLayout *layout;
 
 	existingSnpThreshold = mapArea->getSnpThreshold();
-	label = "Enter SNP threshold percent value (current threshold = "
-		+ QByteArray::number(existingSnpThreshold) + "%): ";
-	snpThreshold = QInputDialog::getInteger(
+
+	/* The view is updated as the slider is dragged; the SNP profile
+	 * of the contig is in memory, so this does not hit the DB */
+	label = new QLabel(tr("SNP threshold percent value:"));
+	slider = new QSlider(Qt::Horizontal);
+	slider->setRange(10, 100);
+	slider->setValue(existingSnpThreshold);
+	spinBox = new QSpinBox;
+	spinBox->setRange(10, 100);
+	spinBox->setSuffix("%");
+	spinBox->setValue(existingSnpThreshold);
+	connect(slider, SIGNAL(valueChanged(int)), spinBox, SLOT(setValue(int)));
+	connect(spinBox, SIGNAL(valueChanged(int)), slider, SLOT(setValue(int)));
+	connect(slider, SIGNAL(valueChanged(int)), mapArea, SLOT(setSnpThreshold(const int)));
+
+	buttonBox = new QDialogButtonBox(QDialogButtonBox::Ok | QDialogButtonBox::Cancel);
+	connect(buttonBox, SIGNAL(accepted()), &dialog, SLOT(accept()));
+	connect(buttonBox, SIGNAL(rejected()), &dialog, SLOT(reject()));
+
+	sliderLayout = new QHBoxLayout;
+	sliderLayout->addWidget(slider);
+	sliderLayout->addWidget(spinBox);
+	layout = new QVBoxLayout;
+	layout->addWidget(label);
+	layout->addLayout(sliderLayout);
+	layout->addWidget(buttonBox);
+	dialog.setLayout(layout);
+	dialog.setWindowTitle(tr("Change SNP threshold"));
+
+	if (dialog.exec() == QDialog::Accepted)
+		snpNavWidget->setThreshold(slider->value());
+	else
+		mapArea->setSnpThreshold(existingSnpThreshold);
+}
+
+
+/*
+ * Get the read row limit from the user. The limit is applied when
+ * contigs are parsed, so it affects files opened afterwards.
+ */
+void MainWindow::getReadRowLimitInput()
+{
+	int rows;
+	bool ok;
+
+	rows = QInputDialog::getInteger(
 			this,
-			tr("Enter SNP threshold"),
-			tr(label),
-			existingSnpThreshold, 10, 100, 10, &ok);
+			tr("Change read row limit"),
+			tr("Maximum number of read rows per contig (0 for no limit):"),
+			ContigAnalyzer::getMaxRows(),
+			0,
+			MAX_READ_ROWS_LIMIT,
+			100,
+			&ok);
+	if (ok)
+		ContigAnalyzer::setMaxRows(rows);
+}
+
 
+/*
+ * Get the maximum number of reads painted per pixel column from the
+ * user
+ */
+void MainWindow::getReadSamplingInput()
+{
+	int n;
+	bool ok;
+
+	n = QInputDialog::getInteger(
+			this,
+			tr("Change read downsampling"),
+			tr("Maximum number of reads shown per pixel column (0 to show all):"),
+			FragmentList::getMaxReadsPerBin(),
+			0,
+			READS_PER_BIN_LIMIT,
+			10,
+			&ok);
 	if (ok)
 	{
-		mapArea->setSnpThreshold(snpThreshold);
-		snpNavWidget->setThreshold(snpThreshold);
+		FragmentList::setMaxReadsPerBin(n);
+		mapArea->update();
 	}
 }
 
 
+/*
+ * Starts recording a trace into a file chosen by the user, or stops
+ * recording
+ */
+void MainWindow::toggleTrace(bool checked)
+{
+	QString fileName;
+
+	if (!checked)
+	{
+		if (Trace::isEnabled())
+		{
+			Trace::stop();
+			emit messageChanged("Trace saved to " + Trace::getFileName());
+		}
+		return;
+	}
+	if (Trace::isEnabled())
+		return;
+
+	fileName = QFileDialog::getSaveFileName(
+			this,
+			tr("Record Trace"),
+			"basejumper-trace.json",
+			tr("Trace files (*.json)"));
+	if (fileName.isEmpty() || !Trace::start(fileName))
+	{
+		if (!fileName.isEmpty())
+			QMessageBox::critical(
+					this,
+					tr("Basejumper"),
+					tr("Cannot write trace file ") + fileName);
+		traceAction->setChecked(false);
+		return;
+	}
+	emit messageChanged("Recording trace to " + fileName);
+}
+
+
+/*
+ * Exports all the reads to a SAM or BAM file chosen by the user
+ */
+void MainWindow::exportAlignments()
+{
+	QString fileName;
+
+	if (alignmentExporterThread->isRunning())
+	{
+		QMessageBox::information(
+				this,
+				tr("Basejumper"),
+				tr("Reads are already being exported."));
+		return;
+	}
+
+	fileName = QFileDialog::getSaveFileName(
+			this,
+			tr("Export Reads as SAM/BAM"),
+			"basejumper.bam",
+			tr("BAM files (*.bam);;SAM files (*.sam)"));
+	if (fileName.isEmpty())
+		return;
+
+	alignmentExporterThread->setFile(
+			fileName,
+			fileName.endsWith(".sam", Qt::CaseInsensitive)?
+					AlignmentExporterThread::Sam: AlignmentExporterThread::Bam);
+	alignmentExporterThread->start(QThread::LowPriority);
+}
+
+
 /*
  * Set the current value of the progress dialog
  */
 void MainWindow::setProgressDialogValue(const int val)
 {
+	/* The status bar shows progress while the user is browsing */
+	if (isBrowsingDuringParse)
+		return;
 	progressDialog->setValue(val);
 }
 
@@ -1075,6 +1444,8 @@ void MainWindow::setProgressDialogMax(const int max)
  */
 void MainWindow::setProgressDialogLabel(const QString &label)
 {
+	if (isBrowsingDuringParse)
+		return;
 	progressDialog->setLabelText(label);
 }
 
@@ -1165,7 +1536,7 @@ void MainWindow::showCoverage()
 	str = "select contigOrder, coverage "
 			" from contig "
 			" order by contigOrder";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 			this,
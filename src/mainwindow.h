@@ -2,6 +2,7 @@
 #define MAINWINDOW_H
 
 #include <QMainWindow>
+#include <QTimer>
 #include "globalview.h"
 #include "intermediateview.h"
 #include "search.h"
@@ -27,6 +28,10 @@ class QPushButton;
 class QLineEdit;
 class QScrollArea;
 class QProgressDialog;
+class QDockWidget;
+class PerfMonitor;
+class SlowQueryDialog;
+class AlignmentExporterThread;
 
 class MainWindow : public QMainWindow
 {
@@ -48,14 +53,20 @@ public:
     static QString SETTINGS_GEOMETRY;
     static QString SETTINGS_RECENT_FILES;
     static QString SETTINGS_SNP_THRESHOLD;
+    static QString SETTINGS_CONTIG_CACHE_SIZE;
+    static QString SETTINGS_MAX_READ_ROWS;
+    static QString SETTINGS_READS_PER_BIN;
+    static QString SETTINGS_READ_SAMPLE_SEED;
     static QString SETTINGS_OPEN_FILE_DIRECTORY;
     static QString SETTINGS_OPEN_REF_FILE_DIRECTORY;
+    static QString SETTINGS_SLOW_QUERY_THRESHOLD;
 
 	public slots:
 	void enableOpenRefAction();
 	void disableOpenRefAction();
 	void enableBookmarkAction();
 	void open(const QStringList &);
+	void openProject();
 	void setProgressDialogValue(const int);
 	void setProgressDialogMax(const int);
 	void setProgressDialogLabel(const QString &);
@@ -112,10 +123,15 @@ private:
     QAction *openRefAction;
     QAction *exportAction;
     QAction *exportGeneOverlapAction;
+    QAction *exportAlignmentsAction;
     QAction *exitAction;
     QAction *aboutAction;
     QAction *whatsThisAction;
     QAction *snpThresholdAction;
+    QAction *readRowLimitAction;
+    QAction *readSamplingAction;
+    QAction *traceAction;
+    QAction *slowQueryAction;
     QAction *searchAction;
     QAction *bookmarkAction;
     QAction *coverageAction;
@@ -137,6 +153,12 @@ private:
     Database *db;
     QMessageBox *coverageMessageBox;
     GeneOverlapExporter *geneExporter;
+    AlignmentExporterThread *alignmentExporterThread;
+    PerfMonitor *perfMonitor;
+    QDockWidget *perfMonitorDock;
+    SlowQueryDialog *slowQueryDialog;
+    bool isBrowsingDuringParse;
+    QTimer browseRedrawTimer;		/* Coalesces redraws while contigs become available */
 
     private slots:
     void open();
@@ -147,9 +169,15 @@ private:
     void addBookmarkAction(const QString &);
     void addRecentFile(const QString &);
     void getSnpThresholdInput();
+    void getReadRowLimitInput();
+    void getReadSamplingInput();
+    void toggleTrace(bool);
+    void exportAlignments();
     void enterWhatsThisMode();
     void showCoverage();
     void finishParsing();
+    void browseAvailableContigs(int);
+    void redrawAvailableContigs();
 
     signals:
     void messageChanged(const QString &);
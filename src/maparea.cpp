@@ -13,6 +13,8 @@
 #include "file.h"
 #include "search.h"
 #include "annotationList.h"
+#include "perfMetrics.h"
+#include "database.h"
 #include <iostream>
 
 #define POINT_SIZE			8
@@ -32,6 +34,8 @@
 #define FONT_FAMILY			"Sans Serif"
 #define SCROLL_STEP			120
 #define	SEARCH_HIGHLIGHT_HT	15
+#define	COVERAGE_TRACK_HEIGHT	30
+#define	OVERFLOW_STRIP_HEIGHT	8
 
 
 /*
@@ -99,6 +103,10 @@ MapArea::MapArea(MainWindow *mainWindow, QWidget *parent)
     		contigList, SLOT(setLoadSequenceFlag(bool)),
     		Qt::DirectConnection);
 
+    regionExporterThread = new RegionExporterThread;
+    connect(regionExporterThread, SIGNAL(messageChanged(const QString &)),
+    		this, SIGNAL(messageChanged(const QString &)));
+
     contig = NULL;
     fragAreaMinX = 0;
     fragAreaMaxX = width();
@@ -106,6 +114,7 @@ MapArea::MapArea(MainWindow *mainWindow, QWidget *parent)
     fragAreaMaxY = height();
     numFragsDisplayed = 0;
     fragOffset = 0;
+    drawTimes.fill(0, NumDrawStages);
 
     initialize();
 }
@@ -118,6 +127,7 @@ MapArea::~MapArea()
 {
 	delete vScrollBar;
 	delete hScrollBar;
+	delete regionExporterThread;
 	delete contigList;
 	delete layout;
 	//delete groupBox;
@@ -258,7 +268,7 @@ void MapArea::paintEvent(QPaintEvent */*event*/)
     int offset, vScrollbarOffset;
 
     /* If there are no contigs, return */
-    if (Contig::getNumContigs() == 0)
+    if (Contig::getNumAvailableContigs() == 0)
     {
     	hScrollBar->hide();
     	vScrollBar->hide();
@@ -270,6 +280,7 @@ void MapArea::paintEvent(QPaintEvent */*event*/)
     }
 
     /* Initialize the painter/canvas */
+    frameTimer.start();
     QPainter painter(this);
     painter.setPen(penGray);
 	font.setPointSizeF(pointSize);
@@ -278,47 +289,52 @@ void MapArea::paintEvent(QPaintEvent */*event*/)
     painter.setRenderHint(QPainter::TextAntialiasing, false);
 
 	offset = 0;
+	drawTimes.fill(0);
 
 	AnnotationList *annotList;
 	for (int j = 0; j < contig->annotationLists.size(); ++j)
 	{
 		annotList = contig->annotationLists.at(j);
+		annotList->fetchRegion(contigStartPos, contigEndPos);
 		if (annotList->getType() == AnnotationList::Snp)
 		{
 			offset += THRICE_HEIGHT;
-			drawSnps(
-					painter,
-					annotList->getList(),
-					offset,
-					annotList->getAlias());
+			drawTimer.start();
+			drawSnps(painter, annotList, offset);
+			drawTimes[SnpDraw] += drawTimer.nsecsElapsed();
 		}
 		else if (annotList->getType() == AnnotationList::Gene)
 		{
 			offset += THRICE_HEIGHT;
-			drawGenes(
-					painter,
-					annotList->getList(),
-					offset,
-					annotList->getAlias());
+			drawTimer.start();
+			drawGenes(painter, annotList, offset);
+			drawTimes[GeneDraw] += drawTimer.nsecsElapsed();
 			offset += contig->maxGeneRows * LINE_HEIGHT;
 		}
 		else
 		{
 			offset += THRICE_HEIGHT;
-			drawCustomTrack(
-					painter,
-					annotList->getList(),
-					offset,
-					annotList->getAlias());
+			drawCustomTrack(painter, annotList, offset);
 		}
 	}
 	annotList = NULL;
 
 	offset += THRICE_HEIGHT;
 	vScrollbarOffset = offset;
+	drawTimer.start();
 	drawContig(painter, offset);
+	drawTimes[ContigDraw] = drawTimer.nsecsElapsed();
+	offset += TWICE_HEIGHT + COVERAGE_TRACK_HEIGHT;
+	drawCoverage(painter, offset);
+	if (!contig->overflowProfile.isEmpty())
+	{
+		offset += TWICE_HEIGHT + OVERFLOW_STRIP_HEIGHT;
+		drawOverflow(painter, offset);
+	}
 	offset += THRICE_HEIGHT;
+	drawTimer.start();
 	drawFragments(painter, offset);
+	drawTimes[FragmentDraw] = drawTimer.nsecsElapsed();
 
     /* Align scrollbars with the main window */
 	hScrollBar->setGeometry(
@@ -335,6 +351,7 @@ void MapArea::paintEvent(QPaintEvent */*event*/)
 	fragAreaMinY = offset;
 	fragAreaMaxY = height() - SCROLLBAR_WIDTH;
 	fragAreaMaxX = width() - SCROLLBAR_WIDTH;
+	PerfMetrics::recordFrame(frameTimer.nsecsElapsed());
 }
 
 
@@ -364,7 +381,12 @@ void MapArea::drawContig(QPainter &painter, const int &yPos)
 			" (Viewing: " + QString("%L2").arg(contigStartPos+1) + ""
 			" - " + QString("%L2").arg(contigEndPos+1) + ""
 			" of " + QString("%L2").arg(contig->size) + ";"
-			" Size: " + QString("%L2").arg(contigEndPos-contigStartPos+1) + ")";
+			" Size: " + QString("%L2").arg(contigEndPos-contigStartPos+1);
+	if (!contig->padIndex.isEmpty())
+		str += "; Unpadded: "
+			+ QString("%L2").arg(contig->padIndex.toUnpadded(contigStartPos)+1) + ""
+			" - " + QString("%L2").arg(contig->padIndex.toUnpadded(contigEndPos)+1);
+	str += ")";
 	painter.setPen(penBlue);
 	painter.drawText(occupiedLen * POINT_SIZE, yPos - TWICE_HEIGHT + 1, str);
 
@@ -421,7 +443,7 @@ void MapArea::drawContig(QPainter &painter, const int &yPos)
 		point.rx() += floor(pointSize + DBL_PADDING);
 
 		/* If this is a SNP, then paint a background */
-		if (contig->snpPosHash[k] == 1)
+		if (contig->isSnp(k))
 		{
 			QRect rect(
 					point.x() - padding,
@@ -454,6 +476,143 @@ void MapArea::drawContig(QPainter &painter, const int &yPos)
 }
 
 
+/*
+ * Draws the read depth of the displayed region as a histogram whose
+ * baseline is at the given y-position
+ */
+void MapArea::drawCoverage(QPainter &painter, const int &yPos)
+{
+	int k, x, xOffset, step, numColumns, start, end, depth, maxDepth, barHeight;
+	QString str;
+	QBrush coverageBrush(QColor(Qt::darkCyan));
+	CoverageProfile *profile;
+
+	profile = &contig->coverageProfile;
+	maxDepth = profile->getMaxDepth(contigStartPos, contigEndPos);
+
+	/* Draw header */
+	str = "COVERAGE: ";
+	painter.setPen(penBlack);
+	painter.setFont(QFont(FONT_FAMILY, POINT_SIZE));
+	painter.drawText(POINT_SIZE, yPos - COVERAGE_TRACK_HEIGHT - PADDING, str);
+	if (!profile->isEmpty())
+	{
+		painter.setPen(penBlue);
+		painter.drawText(
+				str.length() * POINT_SIZE,
+				yPos - COVERAGE_TRACK_HEIGHT - PADDING,
+				QString("mean %L1, min %L2, max %L3")
+					.arg(profile->getMeanDepth(contigStartPos, contigEndPos), 0, 'f', 1)
+					.arg(profile->getMinDepth(contigStartPos, contigEndPos))
+					.arg(maxDepth));
+	}
+	painter.setPen(penGray);
+	painter.drawLine(0, yPos, width(), yPos);
+
+	if (maxDepth <= 0)
+		return;
+
+	/* When the bases are drawn, draw one bar per base */
+	if (pointSize >= POINT_SIZE_MIN)
+	{
+		step = (int) floor(pointSize + DBL_PADDING);
+		x = 0;
+		for (k = contigStartPos; k < contigEndPos; ++k)
+		{
+			x += step;
+			depth = profile->getDepth(k);
+			barHeight = depth * COVERAGE_TRACK_HEIGHT / maxDepth;
+			if (barHeight > 0)
+				painter.fillRect((int) (x - padding), yPos - barHeight, step, barHeight, coverageBrush);
+		}
+		return;
+	}
+
+	/* Otherwise, draw the maximum depth of the bases in each column */
+	painter.setPen(QPen(coverageBrush, 1));
+	xOffset = (int) floor(pointSize + DBL_PADDING);
+	numColumns = (int) ceil((contigEndPos - contigStartPos) * pointSize) + 1;
+	for (x = 0; x < numColumns; ++x)
+	{
+		start = contigStartPos + (int) floor(x / pointSize);
+		if (start > contigEndPos)
+			break;
+		end = contigStartPos + (int) floor((x + 1) / pointSize) - 1;
+		end = max(start, min(end, contigEndPos));
+		depth = profile->getMaxDepth(start, end);
+		barHeight = depth * COVERAGE_TRACK_HEIGHT / maxDepth;
+		if (barHeight > 0)
+			painter.drawLine(xOffset + x, yPos, xOffset + x, yPos - barHeight);
+	}
+}
+
+
+/*
+ * Draws the number of reads that were left out of the row layout as a
+ * density strip whose bottom is at the given y-position; the darker
+ * the strip, the more reads are hidden at that position
+ */
+void MapArea::drawOverflow(QPainter &painter, const int &yPos)
+{
+	int k, x, xOffset, step, numColumns, start, end, count, maxCount;
+	CoverageProfile *profile;
+	QColor color(Qt::darkRed);
+
+	profile = &contig->overflowProfile;
+	maxCount = profile->getMaxDepth(contigStartPos, contigEndPos);
+
+	/* Draw header */
+	painter.setPen(penBlack);
+	painter.setFont(QFont(FONT_FAMILY, POINT_SIZE));
+	painter.drawText(
+			POINT_SIZE,
+			yPos - OVERFLOW_STRIP_HEIGHT - PADDING,
+			QString("READS NOT SHOWN: max %L1").arg(maxCount));
+
+	if (maxCount <= 0)
+		return;
+
+	/* When the bases are drawn, shade one cell per base */
+	if (pointSize >= POINT_SIZE_MIN)
+	{
+		step = (int) floor(pointSize + DBL_PADDING);
+		x = 0;
+		for (k = contigStartPos; k < contigEndPos; ++k)
+		{
+			x += step;
+			count = profile->getDepth(k);
+			if (count <= 0)
+				continue;
+			color.setAlpha(55 + (200 * count) / maxCount);
+			painter.fillRect(
+					(int) (x - padding), yPos - OVERFLOW_STRIP_HEIGHT,
+					step, OVERFLOW_STRIP_HEIGHT, QBrush(color));
+		}
+		return;
+	}
+
+	/* Otherwise, shade each column by the largest count of its bases */
+	xOffset = (int) floor(pointSize + DBL_PADDING);
+	numColumns = (int) ceil((contigEndPos - contigStartPos) * pointSize) + 1;
+	for (x = 0; x < numColumns; ++x)
+	{
+		start = contigStartPos + (int) floor(x / pointSize);
+		if (start > contigEndPos)
+			break;
+		end = contigStartPos + (int) floor((x + 1) / pointSize) - 1;
+		end = max(start, min(end, contigEndPos));
+		count = profile->getMaxDepth(start, end);
+		if (count <= 0)
+			continue;
+		color.setAlpha(55 + (200 * count) / maxCount);
+		painter.setPen(color);
+		painter.drawLine(
+				xOffset + x, yPos,
+				xOffset + x, yPos - OVERFLOW_STRIP_HEIGHT + 1);
+	}
+}
+
+
 /*
  * Draws the fragment sequences
  */
@@ -463,11 +622,20 @@ void MapArea::drawFragments(QPainter &painter, const int &yPos)
 	int fragStartPos = 0;
 	int fragEndPos = 0;
     char ch;
-    int fragsSize, yFrameStart, yFrameEnd, vSliderValue_half, offset;
+    int fragsSize, yFrameStart, yFrameEnd, vSliderValue_half, offset, binSize;
     QPoint point(0, 0);
+    QString str;
+
+    /* Only a sample of the reads is painted where more reads start in
+     * a pixel column than can be told apart */
+    if (pointSize < POINT_SIZE_MIN)
+    	binSize = (int) ceil(1.0 / pointSize);
+    else
+    	binSize = 1;
+    const QList<Fragment *> &displayList = contig->fragList->getDisplayList(binSize);
 
     /* Initialization */
-    fragsSize = contig->fragList->size();
+    fragsSize = displayList.size();
     vSliderValue_half = (int) floor((float) vScrollBar->value() / 2);
     yFrameStart = vSliderValue_half;
     yFrameEnd = vSliderValue_half + (int) floor((float) height() / TOTAL_LINE_HEIGHT);
@@ -478,13 +646,23 @@ void MapArea::drawFragments(QPainter &painter, const int &yPos)
     /* Draw header */
 	painter.setPen(penBlack);
 	painter.setFont(QFont(FONT_FAMILY, POINT_SIZE));
-	painter.drawText(POINT_SIZE, (yPos - TWICE_HEIGHT + 2), "READS:");
+	str = "READS: ";
+	painter.drawText(POINT_SIZE, (yPos - TWICE_HEIGHT + 2), str);
+	if (fragsSize < contig->fragList->size())
+	{
+		painter.setPen(penBlue);
+		painter.drawText(
+				str.length() * POINT_SIZE,
+				(yPos - TWICE_HEIGHT + 2),
+				QString("downsampled, %L1 of %L2 shown (%L3%)")
+					.arg(fragsSize)
+					.arg(contig->fragList->size())
+					.arg(100.0 * fragsSize / contig->fragList->size(), 0, 'f', 1));
+	}
 
-	/* We need to start from 1 instead of 0 because the first
-	 * fragment is a "dummy" object */
 	for (int j = 0; j < fragsSize; ++j)
 	{
-		frag = contig->fragList->at(j);
+		frag = displayList.at(j);
 
 		/* Skip if the fragment cannot be displayed in this window range */
 		if (frag->yPos < yFrameStart
@@ -573,8 +751,8 @@ void MapArea::drawFragments(QPainter &painter, const int &yPos)
 
 
 			/* If this is a SNP, then draw a colored rectangle around it */
-			if (tolower(contig->seq.at(frag->startPos + k - 1)) != tolower(ch)
-					&& contig->snpPosHash.value(frag->startPos + k - 1) == 1)
+			if (contig->isSnp(frag->startPos + k - 1)
+					&& tolower(contig->seq.at(frag->startPos + k - 1)) != tolower(ch))
 			{
 				QRect rect(
 						point.x() - padding,
@@ -608,10 +786,10 @@ void MapArea::drawFragments(QPainter &painter, const int &yPos)
  */
 void MapArea::drawGenes(
 		QPainter &painter,
-		QList<Annotation *> &annotationList,
-		int yPos,
-		const QString &title)
+		AnnotationList *annotList,
+		int yPos)
 {
+	QList<Annotation *> annotationList;
 	Gene *annot;
 	float start, end, geneStartPos, geneEndPos, factor, y, structureStart, structureEnd;
 	QString trackName, geneNamesStr, arrow;
@@ -624,10 +802,11 @@ void MapArea::drawGenes(
 	end = (float) contigEndPos;
 	factor = pointSize + DBL_PADDING;
 	y = 0.0;
-	trackName = title + ": ";
+	trackName = annotList->getAlias() + ": ";
 	occupiedLen = 0;
 	count = 0;
 	geneNamesStr = "";
+	annotList->getOverlapping(contigStartPos, contigEndPos, annotationList);
 	listSize = annotationList.size();
 
 	/* Draw header */
@@ -653,11 +832,6 @@ void MapArea::drawGenes(
 		geneStartPos = annot->getStartPos();
 		geneEndPos = annot->getEndPos();
 
-		/* Filter out structures which cannot be displayed in the
-		 * current window */
-		if (geneStartPos > end || geneEndPos < start)
-			continue;
-
 		/* Append gene names to a string so that the string can be
 		 * displayed later on */
 		if (count < 10)
@@ -731,6 +905,11 @@ void MapArea::drawGenes(
 		/* If gene structure information is available */
 		foreach (substructure, *geneStructures)
 		{
+			/* Filter out substructures which cannot be displayed in
+			 * the current window */
+			if (substructure->start > end || substructure->end < start)
+				continue;
+
 			/* If font size < threshold value */
 			if (pointSize < POINT_SIZE_MIN)
 			{
@@ -815,10 +994,10 @@ void MapArea::drawGenes(
  */
 void MapArea::drawSnps(
 		QPainter &painter,
-		QList<Annotation *> &annotationList,
-		int yPos,
-		const QString &title)
+		AnnotationList *annotList,
+		int yPos)
 {
+	QList<Annotation *> annotationList;
 	Annotation *annot;
 	float start, end, snpStartPos, snpEndPos, factor, y;
 	QString trackName;
@@ -829,7 +1008,7 @@ void MapArea::drawSnps(
 	end = (float) contigEndPos;
 	factor = pointSize + DBL_PADDING;
 	y = (float) (yPos - 15);
-	trackName = title + ": ";
+	trackName = annotList->getAlias() + ": ";
 
 	/* Draw header */
 	painter.setFont(QFont(FONT_FAMILY, POINT_SIZE));
@@ -842,15 +1021,12 @@ void MapArea::drawSnps(
 	painter.drawLine(0, yPos, width(), yPos);
 	painter.setPen(penGray);
 
+	annotList->getOverlapping(contigStartPos, contigEndPos, annotationList);
 	foreach (annot, annotationList)
 	{
 		snpStartPos = (float) annot->getStartPos();
 		snpEndPos = (float) annot->getEndPos();
 
-		/* Filter out SNPs which cannot be displayed in the current window */
-		if (snpStartPos > contigEndPos || snpEndPos < contigStartPos)
-			continue;
-
 		/* Draw SNPs */
 		if (snpEndPos >= snpStartPos)
 		{
@@ -916,10 +1092,10 @@ void MapArea::drawSnps(
  */
 void MapArea::drawCustomTrack(
 		QPainter &painter,
-		QList<Annotation *> &annotationList,
-		int yPos,
-		const QString &title)
+		AnnotationList *annotList,
+		int yPos)
 {
+	QList<Annotation *> annotationList;
 	Annotation *annot;
 	float start, end, annotStartPos, annotEndPos, factor, y;
 	QString trackName;
@@ -929,7 +1105,7 @@ void MapArea::drawCustomTrack(
 	end = (float) contigEndPos;
 	factor = pointSize + DBL_PADDING;
 	y = (float) (yPos - 15);
-	trackName = title + ": ";
+	trackName = annotList->getAlias() + ": ";
 	painter.setPen(penGray);
 
 	/* Draw header */
@@ -943,15 +1119,12 @@ void MapArea::drawCustomTrack(
 	painter.drawLine(0, yPos, width(), yPos);
 	painter.setPen(penGray);
 
+	annotList->getOverlapping(contigStartPos, contigEndPos, annotationList);
 	foreach (annot, annotationList)
 	{
 		annotStartPos = annot->getStartPos();
 		annotEndPos = annot->getEndPos();
 
-		/* Filter out SNPs which cannot be displayed in the current window */
-		if (annotStartPos > contigEndPos || annotEndPos < contigStartPos)
-			continue;
-
 		/* If font size < threshold value, draw line to represent custom tracks */
 		if (pointSize < POINT_SIZE_MIN)
 		{
@@ -1202,7 +1375,7 @@ void MapArea::loadBookmark(const QString &bookmarkName)
 	queryStr = "select filepath, contigName, startPos "
 			" from bookmark "
 			" where name = '" + bookmarkName + "'";
-	if (!query.exec(queryStr))
+	if (!DB_EXEC(query, queryStr))
 	{
 		QMessageBox::critical(
 			this,
@@ -1222,7 +1395,7 @@ void MapArea::loadBookmark(const QString &bookmarkName)
 	queryStr = "select id "
 			" from contig "
 			" where lower(name) = lower('" + contigName + "')";
-	if (!query.exec(queryStr))
+	if (!DB_EXEC(query, queryStr))
 	{
 		QMessageBox::critical(
 			this,
@@ -1267,9 +1440,11 @@ void MapArea::getContigOrderIdHash()
 		QSqlQuery query(db);
 		QString str;
 
+		/* Only contigs whose reads have been saved can be browsed */
 		str = "select id, contigOrder "
-				" from contig ";
-		if (!query.exec(str))
+				" from contig "
+				" where id <= " + QString::number(Contig::getNumAvailableContigs());
+		if (!DB_EXEC(query, str))
 		{
 			QMessageBox::critical(
 				this,
@@ -1292,46 +1467,65 @@ void MapArea::getContigOrderIdHash()
 
 
 /**
- * Export the selected region to an ACE file
+ * Exports a window of the current contig, by default the one shown in
+ * Base View, and the reads overlapping it to an ACE file. The file is
+ * written in the background.
  */
 void MapArea::exportSelection()
 {
-	/*
-	- Open an output file to write to
-	- store the contig(s) into a contig array
-	- store the fragments into a frag array
-	- Write contigs and frags to the output file
-	- save the output file
-	- close the output file
-	*/
-	int numOfContigs, numOfFrags, contigSize, numOfContigReads;
-	QString contigName, contigSeq, fragName;
+	QString str, fileName;
+	QRegExp rx("^\\s*(\\d+)\\s*-\\s*(\\d+)\\s*$");
+	int start, end;
+	bool ok;
 
-	/* Initialize */
-	numOfContigs = 0;
-	numOfFrags = 0;
-	contigSize = 0;
-	numOfContigReads = 0;
-	contigName = "XYZ";
-	contigSeq = "ACGTTAC";
-	fragName = "frag1";
-
-	QFile file("out.txt");
-    if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-        return;
-
-    QTextStream out(&file);
-    out << "AS " << numOfContigs << " " << numOfFrags << endl;
-    out << endl;
-
-    out << "CO " << contigName << " " << contigSize << " " << numOfContigReads << endl;
-    out << contigSeq << endl;
-    out << endl;
-
-    out << "BQ" << endl;
-    out << endl;
-
-    file.close();
+	if (contig == NULL)
+		return;
+	if (regionExporterThread->isRunning())
+	{
+		QMessageBox::information(
+				this,
+				tr("Basejumper"),
+				tr("A region is already being exported."));
+		return;
+	}
+
+	/* Window in padded 1-based positions */
+	str = QInputDialog::getText(
+			this,
+			tr("Export Region"),
+			tr("Region of %1 to export (start-end):").arg(QString(contig->name)),
+			QLineEdit::Normal,
+			QString("%1-%2").arg(contigStartPos + 1).arg(contigEndPos + 1),
+			&ok);
+	if (!ok)
+		return;
+	start = end = 0;
+	if (rx.indexIn(str) >= 0)
+	{
+		start = rx.cap(1).toInt();
+		end = rx.cap(2).toInt();
+	}
+	if (start < 1 || end < start || end > contig->size)
+	{
+		QMessageBox::warning(
+				this,
+				tr("Basejumper"),
+				tr("Enter a region between 1 and %1 as start-end.")
+					.arg(contig->size));
+		return;
+	}
+
+	fileName = QFileDialog::getSaveFileName(
+			this,
+			tr("Export Region"),
+			QString("%1_%2_%3.ace").arg(QString(contig->name)).arg(start).arg(end),
+			tr("ACE files (*.ace);;All files (*)"));
+	if (fileName.isEmpty())
+		return;
+
+	emit messageChanged(tr("Exporting region..."));
+	regionExporterThread->setRegion(contig->id, start, end, fileName);
+	regionExporterThread->start();
 }
 
 
@@ -1343,13 +1537,12 @@ void MapArea::exportSelection()
 void MapArea::setSnpThreshold(const int val)
 {
 	snpThreshold = val;
-	contigList->setSnpThreshold(val);
 
+	/* The current contig filters its in-memory SNP profile, so the view
+	 * only needs to be repainted */
+	contigList->setSnpThreshold(val);
 	if (contig != NULL)
-	{
-		contig = contigList->getContigUsingId(contig->id);
-		goToPos(contig->id, Contig::startPos);
-	}
+		update();
 }
 
 
@@ -1364,6 +1557,28 @@ int MapArea::getSnpThreshold() const
 }
 
 
+/**
+ * Sets the memory budget of the contig cache
+ *
+ * @param megabytes : Memory budget in megabytes
+ */
+void MapArea::setContigCacheSize(const int megabytes)
+{
+	contigList->setMemoryBudget(megabytes);
+}
+
+
+/**
+ * Returns the memory budget of the contig cache
+ *
+ * @return The memory budget in megabytes
+ */
+int MapArea::getContigCacheSize() const
+{
+	return contigList->getMemoryBudget();
+}
+
+
 /**
  * Highlights the given rectangle on a paint device
  *
@@ -1543,7 +1758,7 @@ QGroupBox* MapArea::getGroupBox()
  */
 void MapArea::mouseMoveEvent(QMouseEvent *event)
 {
-	if (Contig::getNumContigs() == 0
+	if (Contig::getNumAvailableContigs() == 0
 			|| event->x() < fragAreaMinX
 			|| event->x() > fragAreaMaxX
 			|| event->y() < fragAreaMinY
@@ -1566,7 +1781,7 @@ void MapArea::mouseMoveEvent(QMouseEvent *event)
 			" and startPos <= " + QString::number(sum) +
 			" and endPos >= " + QString::number(sum) +
 			" order by startPos asc";
-	if (!fragQuery.exec(str))
+	if (!DB_EXEC(fragQuery, str))
 	{
 		QMessageBox::critical(
 			this,
@@ -1593,7 +1808,7 @@ void MapArea::mouseMoveEvent(QMouseEvent *event)
  */
 void MapArea::mouseDoubleClickEvent(QMouseEvent *event)
 {
-	if (Contig::getNumContigs() == 0)
+	if (Contig::getNumAvailableContigs() == 0)
 		return;
 
 	goToPos(currentContigIndex,
@@ -1633,7 +1848,7 @@ int MapArea::convertYPos(const QPoint &p)
  */
 void MapArea::wheelEvent(QWheelEvent *event)
 {
-	if (Contig::getNumContigs() == 0)
+	if (Contig::getNumAvailableContigs() == 0)
 		return;
 
 	int x = event->delta() / SCROLL_STEP;
@@ -8,9 +8,12 @@
 #include "parser.h"
 #include "mainwindow.h"
 #include <QHash>
+#include <QVector>
+#include <QElapsedTimer>
 #include "annotation.h"
 #include "gene.h"
 #include "contigList.h"
+#include "regionExporterThread.h"
 
 using namespace std;
 
@@ -19,6 +22,9 @@ class MapArea : public QWidget
     Q_OBJECT
 
 public:
+    /** Parts of the view whose paint time is recorded */
+    enum DrawStage {ContigDraw, FragmentDraw, GeneDraw, SnpDraw, NumDrawStages};
+
     MapArea(MainWindow *mainWindow, QWidget *parent = 0);
     ~MapArea();
     QSize minimumSizeHint() const;
@@ -29,8 +35,21 @@ public:
     void setCurrentContigIndex(const int);
     void insertContigFile(const int &, const int &);
     int getSnpThreshold() const;
+    int getContigCacheSize() const;
     QGroupBox* getGroupBox();
 
+    /** Returns the cache of loaded contigs */
+    inline ContigList *getContigList() const { return contigList; };
+
+    /** Returns the contig that is being displayed */
+    inline Contig *getContig() const { return contig; };
+
+    /** Returns the number of bases displayed at the current zoom level */
+    inline int getNumBases() const { return numBases; };
+
+    /** Returns the nanoseconds spent in each DrawStage during the last paint */
+    inline const QVector<qint64> &getDrawTimes() const { return drawTimes; };
+
 public slots:
 	void zoomSliderMoved(int);
 	void hScrollbarAction(int);
@@ -43,6 +62,7 @@ public slots:
 	void getContigOrderIdHash();
 	void exportSelection();
 	void setSnpThreshold(const int);
+	void setContigCacheSize(const int);
 	void setMaxVScrollbarValue(const int);
 	//void highlight(const QRect &);
 	void resetHighlighting();
@@ -64,9 +84,11 @@ protected:
 private:
     void drawContig(QPainter &, const int &);
     void drawFragments(QPainter &, const int &);
-    void drawGenes(QPainter &, QList<Annotation *> &, int, const QString &);
-    void drawSnps(QPainter &, QList<Annotation *> &, int, const QString &);
-    void drawCustomTrack(QPainter &, QList<Annotation *> &, int, const QString &);
+    void drawCoverage(QPainter &, const int &);
+    void drawOverflow(QPainter &, const int &);
+    void drawGenes(QPainter &, AnnotationList *, int);
+    void drawSnps(QPainter &, AnnotationList *, int);
+    void drawCustomTrack(QPainter &, AnnotationList *, int);
     int convertPointToBases(const QPoint &);
     int convertYPos(const QPoint &p);
     void highlightSearchResults(QPainter &, const int);
@@ -105,6 +127,10 @@ private:
 	bool isSearchHighlightEnabled;
 	QMap<int, QMap<int, int> *> *searchResultsMap;
 	ContigList *contigList;
+	RegionExporterThread *regionExporterThread;	/* Writes exported regions in the background */
+	QVector<qint64> drawTimes;		/* Nanoseconds spent in each DrawStage during the last paint */
+	QElapsedTimer drawTimer;
+	QElapsedTimer frameTimer;
 
     static QPen penBlue;	/* Blue colored pen */
     static QPen penGreen;	/* Green colored pen */
@@ -0,0 +1,261 @@
+
+#include "padIndex.h"
+#include <QDataStream>
+
+#define	PAD_CHAR			'*'
+#define	WORD_BITS			64
+#define	WORDS_PER_BLOCK		8
+#define	SELECT_SAMPLE_RATE	512
+
+
+/*
+ * Returns the number of set bits in the given word
+ */
+static inline int countBits(quint64 x)
+{
+	x = x - ((x >> 1) & Q_UINT64_C(0x5555555555555555));
+	x = (x & Q_UINT64_C(0x3333333333333333))
+		+ ((x >> 2) & Q_UINT64_C(0x3333333333333333));
+	x = (x + (x >> 4)) & Q_UINT64_C(0x0F0F0F0F0F0F0F0F);
+	return (int) ((x * Q_UINT64_C(0x0101010101010101)) >> 56);
+}
+
+
+/**
+ * Constructor
+ */
+PadIndex::PadIndex()
+{
+	size = 0;
+	numPads = 0;
+}
+
+
+/**
+ * Destructor
+ */
+PadIndex::~PadIndex()
+{
+
+}
+
+
+/**
+ * Builds the index from the given padded sequence. Pads are '*'
+ * characters.
+ *
+ * @param seq : Padded contig sequence
+ */
+void PadIndex::build(const QByteArray &seq)
+{
+	const char *data;
+	int i;
+
+	clear();
+	size = seq.size();
+	data = seq.constData();
+	for (i = 0; i < size; ++i)
+	{
+		if (data[i] != PAD_CHAR)
+			continue;
+		if (words.isEmpty())
+			words.fill(0, (size + WORD_BITS - 1) / WORD_BITS);
+		words[i / WORD_BITS] |= (Q_UINT64_C(1) << (i % WORD_BITS));
+	}
+	buildIndex();
+}
+
+
+/**
+ * Returns the index in a form that can be stored in the DB
+ */
+QByteArray PadIndex::toByteArray() const
+{
+	QByteArray bytes;
+	QDataStream out(&bytes, QIODevice::WriteOnly);
+	out << (qint32) size << words;
+	return bytes;
+}
+
+
+/**
+ * Sets the index from data that was stored using toByteArray()
+ *
+ * @param bytes : Stored index
+ * @return Returns true on success and false if the data is not valid
+ */
+bool PadIndex::fromByteArray(const QByteArray &bytes)
+{
+	QDataStream in(bytes);
+	qint32 storedSize;
+
+	clear();
+	in >> storedSize >> words;
+	if (in.status() != QDataStream::Ok
+			|| (!words.isEmpty()
+					&& words.size() != (storedSize + WORD_BITS - 1) / WORD_BITS))
+	{
+		clear();
+		return false;
+	}
+	size = storedSize;
+	buildIndex();
+	return true;
+}
+
+
+/**
+ * Empties the index. An empty index maps each position to itself.
+ */
+void PadIndex::clear()
+{
+	size = 0;
+	numPads = 0;
+	words.clear();
+	blockRanks.clear();
+	selectSamples.clear();
+}
+
+
+/**
+ * Converts a padded position to an unpadded one. A pad maps to the
+ * unpadded position of the next base.
+ *
+ * @param pos : 0-based padded position
+ * @return 0-based unpadded position
+ */
+int PadIndex::toUnpadded(const int pos) const
+{
+	if (numPads == 0 || pos <= 0)
+		return pos;
+	if (pos >= size)
+		return pos - numPads;
+	return pos - rank(pos);
+}
+
+
+/**
+ * Converts an unpadded position to the padded position of the same
+ * base
+ *
+ * @param pos : 0-based unpadded position
+ * @return 0-based padded position
+ */
+int PadIndex::toPadded(const int pos) const
+{
+	int word, remaining, bases;
+	quint64 bits;
+
+	if (numPads == 0 || pos < 0)
+		return pos;
+	if (pos >= size - numPads)
+		return pos + numPads;
+
+	/* Start from the sampled word before the base and skip whole words
+	 * until the word holding the base is reached */
+	word = selectSamples.at(pos / SELECT_SAMPLE_RATE);
+	remaining = pos - (word * WORD_BITS - rank(word * WORD_BITS));
+	forever
+	{
+		bases = WORD_BITS - countBits(words.at(word));
+		if (remaining < bases)
+			break;
+		remaining -= bases;
+		++word;
+	}
+
+	/* Find the base within the word */
+	bits = ~words.at(word);
+	while (remaining-- > 0)
+		bits &= bits - 1;
+	return word * WORD_BITS + countBits((bits & (~bits + 1)) - 1);
+}
+
+
+/**
+ * Converts an unpadded range to a padded one. The end is exclusive, so
+ * it is mapped to one past the padded position of the last base.
+ *
+ * @param start : Start of the range; converted in place
+ * @param end : End of the range; converted in place
+ */
+void PadIndex::toPaddedRange(int &start, int &end) const
+{
+	int paddedStart;
+
+	paddedStart = toPadded(start);
+	if (end > start)
+		end = toPadded(end - 1) + 1;
+	else
+		end = paddedStart + (end - start);
+	start = paddedStart;
+}
+
+
+/**
+ * Returns the approximate number of bytes used by the index
+ */
+qint64 PadIndex::getMemoryUsage() const
+{
+	return sizeof(PadIndex)
+		+ words.size() * sizeof(quint64)
+		+ (blockRanks.size() + selectSamples.size()) * sizeof(int);
+}
+
+
+/*
+ * Builds the rank directory and the select samples from the bit words
+ */
+void PadIndex::buildIndex()
+{
+	int i, numWords, count, bases, nextSample;
+
+	numWords = words.size();
+	blockRanks.resize((numWords + WORDS_PER_BLOCK - 1) / WORDS_PER_BLOCK);
+	selectSamples.clear();
+	count = 0;
+	bases = 0;
+	nextSample = 0;
+	for (i = 0; i < numWords; ++i)
+	{
+		if (i % WORDS_PER_BLOCK == 0)
+			blockRanks[i / WORDS_PER_BLOCK] = count;
+		count += countBits(words.at(i));
+
+		/* Word holding each sampled base */
+		bases = (i + 1) * WORD_BITS - count;
+		while (nextSample < bases && nextSample < size - count)
+		{
+			selectSamples.append(i);
+			nextSample += SELECT_SAMPLE_RATE;
+		}
+	}
+	numPads = count;
+	if (numPads == 0)
+	{
+		/* Nothing to translate */
+		words.clear();
+		blockRanks.clear();
+		selectSamples.clear();
+	}
+	words.squeeze();
+	blockRanks.squeeze();
+	selectSamples.squeeze();
+}
+
+
+/*
+ * Returns the number of pads before the given padded position
+ */
+int PadIndex::rank(const int pos) const
+{
+	int word, i, count;
+
+	word = pos / WORD_BITS;
+	count = blockRanks.at(word / WORDS_PER_BLOCK);
+	for (i = word - word % WORDS_PER_BLOCK; i < word; ++i)
+		count += countBits(words.at(i));
+	if (pos % WORD_BITS != 0)
+		count += countBits(words.at(word) & ((Q_UINT64_C(1) << (pos % WORD_BITS)) - 1));
+	return count;
+}
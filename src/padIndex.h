@@ -0,0 +1,49 @@
+#ifndef PADINDEX_H_
+#define PADINDEX_H_
+
+#include <QVector>
+#include <QByteArray>
+
+class PadIndex
+{
+public:
+	PadIndex();
+	~PadIndex();
+	void build(const QByteArray &);
+	QByteArray toByteArray() const;
+	bool fromByteArray(const QByteArray &);
+	void clear();
+	int toUnpadded(const int) const;
+	int toPadded(const int) const;
+	void toPaddedRange(int &, int &) const;
+	qint64 getMemoryUsage() const;
+
+	/** Returns whether the sequence has no pads */
+	inline bool isEmpty() const { return (numPads == 0); };
+
+	/** Returns the number of pads in the sequence */
+	inline int getNumPads() const { return numPads; };
+
+	/** Returns the padded length of the sequence */
+	inline int getSize() const { return size; };
+
+	/** Returns whether the given 0-based padded position is a pad */
+	inline bool isPad(const int pos) const
+	{
+		if (numPads == 0 || pos < 0 || pos >= size)
+			return false;
+		return (words.at(pos / 64) >> (pos % 64)) & 1;
+	};
+
+private:
+	int size;						/* Padded length of the sequence */
+	int numPads;					/* Number of pads in the sequence */
+	QVector<quint64> words;			/* Bit i is set if position i is a pad */
+	QVector<int> blockRanks;		/* Number of pads before each block of words */
+	QVector<int> selectSamples;		/* Word holding every SELECT_SAMPLE_RATE-th base */
+
+	void buildIndex();
+	int rank(const int) const;
+};
+
+#endif /* PADINDEX_H_ */
@@ -14,10 +14,17 @@
 #include "database.h"
 #include "geneStructure.h"
 #include "parserThread.h"
+#include "contigPlacementIndex.h"
+#include <stdlib.h>
+#include <string.h>
 
 #define	BYTE_TO_MBYTE	1048576
 #define	MAX_CONTIG_PARTITION	500
 #define	FRAG_DESC_GAP	20
+#define	BED_MAX_FIELDS	12
+#define	ANNOTATION_BATCH_SIZE	10000
+#define	NUM_ANNOTATION_COLUMNS	6
+#define	NUM_STRUCTURE_COLUMNS	5
 
 using namespace std;
 
@@ -48,7 +55,7 @@ QWaitCondition fragQueueNotEmpty;
 const int fragQueueSizeMax = 50000;
 bool moreContigs = true;
 
-QList<quint16> partitionList;
+QList<int> partitionList;
 int contigPartitions;
 const int maxPartitionSize = 100;
 QMutex partitionListMutex;
@@ -56,13 +63,74 @@ QMutex partitionListMutex;
 
 
 
+/*
+ * Splits the given line at the given separator without copying it.
+ * The offsets of the first character and of one past the last
+ * character of each field are stored in the given arrays.
+ *
+ * @return Returns the number of fields found (at most maxFields)
+ */
+static int tokenizeLine(
+		const QByteArray &line,
+		const char separator,
+		int *fieldStart,
+		int *fieldEnd,
+		const int maxFields)
+{
+	const char *data = line.constData();
+	int size = line.size();
+	int numFields = 0;
+	int pos = 0;
+	const char *next;
+
+	while (numFields < maxFields && pos <= size)
+	{
+		fieldStart[numFields] = pos;
+		next = (const char *) memchr(data + pos, separator, size - pos);
+		pos = (next == NULL)? size: (next - data);
+		fieldEnd[numFields] = pos;
+		++numFields;
+		++pos;
+	}
+	return numFields;
+}
+
+
+/* Gene sub-structure waiting to be saved */
+struct StructureRow
+{
+	int geneId;
+	int type;
+	int start;
+	int end;
+	QString name;
+};
+
+
+/*
+ * Orders sub-structures by gene and then by start position
+ */
+static bool structureRowLessThan(const StructureRow &r1, const StructureRow &r2)
+{
+	if (r1.geneId != r2.geneId)
+		return (r1.geneId < r2.geneId);
+	return (r1.start < r2.start);
+}
+
+
 /**
  * Constructor
  */
 Parser::Parser()
 {
 	isOrderFileLoaded = false;
+	lastContigSaved = 0;
+	lastContigFragsSaved = 0;
+	lastContigAvailable = 0;
+	availableContigsSize = 0;
+	hasFinalTotals = false;
 
+	qRegisterMetaType<qint64>("qint64");
 	connect(&parserThread, SIGNAL(totalSize(int)),
 			this, SLOT(totalSizeSignaled(int)));
 	connect(&parserThread, SIGNAL(messageChanged(const QString &)),
@@ -79,6 +147,12 @@ Parser::Parser()
 			this, SLOT(signalParsingFinished()));
 	connect(&fragSaverThread, SIGNAL(finished()),
 			this, SLOT(signalParsingFinished()));
+	connect(&contigSaverThread, SIGNAL(contigSaved(int, int)),
+			this, SLOT(contigSavedSignaled(int, int)));
+	connect(&fragSaverThread, SIGNAL(fragsSaved(int)),
+			this, SLOT(fragsSavedSignaled(int)));
+	connect(&parserThread, SIGNAL(totalsParsed(int, qint64)),
+			this, SLOT(totalsParsedSignaled(int, qint64)));
 }
 
 
@@ -93,6 +167,16 @@ Parser::~Parser()
 
 bool Parser::readAce(const QStringList &files, int filesSize)
 {
+	lastContigSaved = 0;
+	lastContigFragsSaved = 0;
+	lastContigAvailable = 0;
+	availableContigsSize = 0;
+	hasFinalTotals = false;
+	savedContigSizeHash.clear();
+	Contig::setNumContigs(0);
+	Contig::setNumAvailableContigs(0);
+	Contig::setTotalSize(0);
+
 	parserThread.setFileList(files);
 	parserThread.start();
 	contigSaverThread.start();
@@ -102,6 +186,62 @@ bool Parser::readAce(const QStringList &files, int filesSize)
 }
 
 
+/**
+ * Shows the contigs that are already in the DB, e.g. a project built by
+ * the command-line importer, as if they had just been parsed
+ *
+ * @return Returns false if the DB contains no contigs
+ */
+bool Parser::openProject()
+{
+	QString connectionName = "Parser_openProject";
+	int numContigs = 0, numTracks = 0;
+	qint64 totalContigSize = 0;
+
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getContigDBName());
+		QSqlQuery query(db);
+
+		if (query.exec("select count(*), sum(size) from contig") && query.next())
+		{
+			numContigs = query.value(0).toInt();
+			totalContigSize = query.value(1).toLongLong();
+		}
+		if (query.exec("select count(*) from chrom_contig") && query.next())
+			isOrderFileLoaded = (query.value(0).toInt() > 0);
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getAnnotationDBName());
+		QSqlQuery query(db);
+
+		if (query.exec("select count(*) from annotationType") && query.next())
+			numTracks = query.value(0).toInt();
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+
+	if (numContigs == 0)
+		return false;
+
+	Contig::setNumContigs(numContigs);
+	Contig::setNumAvailableContigs(numContigs);
+	Contig::setTotalSize(totalContigSize);
+	emit parsingFinished();
+	if (numTracks > 0)
+		emit annotationLoaded();
+	return true;
+}
+
+
 void Parser::totalSizeSignaled(int size)
 {
 	emit totalSize(size);
@@ -134,6 +274,13 @@ void Parser::parsingProgressSignaled(int parsedSize)
 
 void Parser::signalParsingFinished()
 {
+	if (sender() == &parserThread)
+		emit stageFinished(AceParsing);
+	else if (sender() == &contigSaverThread)
+		emit stageFinished(ContigSaving);
+	else if (sender() == &fragSaverThread)
+		emit stageFinished(FragmentSaving);
+
 	if (parserThread.isFinished()
 			&& contigSaverThread.isFinished()
 			&& fragSaverThread.isFinished())
@@ -141,6 +288,116 @@ void Parser::signalParsingFinished()
 }
 
 
+/*
+ * Invoked when a contig has been committed to the DB
+ *
+ * @param contigId : ID of the contig
+ * @param size : Size of the contig
+ */
+void Parser::contigSavedSignaled(int contigId, int size)
+{
+	savedContigSizeHash.insert(contigId, size);
+	if (contigId > lastContigSaved)
+		lastContigSaved = contigId;
+	updateAvailableContigs();
+}
+
+
+/*
+ * Invoked when the parser thread has parsed all the files
+ *
+ * @param numContigs : Number of parsed contigs
+ * @param totalContigSize : Total size of the parsed contigs
+ */
+void Parser::totalsParsedSignaled(int numContigs, qint64 totalContigSize)
+{
+	hasFinalTotals = true;
+	Contig::setNumContigs(numContigs);
+	Contig::setTotalSize(totalContigSize);
+}
+
+
+/*
+ * Invoked when the fragments of all contigs up to the given contig
+ * have been committed to the DB
+ *
+ * @param contigId : ID of the last contig whose fragments were committed
+ */
+void Parser::fragsSavedSignaled(int contigId)
+{
+	if (contigId > lastContigFragsSaved)
+		lastContigFragsSaved = contigId;
+	updateAvailableContigs();
+}
+
+
+/*
+ * Shows the given error message. Without a GUI (e.g. in the
+ * command-line importer) the message is written to the error output.
+ */
+void Parser::showError(const QString &message)
+{
+	QMainWindow *mainWindow = qobject_cast<QMainWindow *>(parent());
+
+	if (QApplication::type() == QApplication::Tty)
+		qCritical() << qPrintable(message);
+	else
+		QMessageBox::critical(
+				(mainWindow != NULL)? mainWindow->centralWidget(): QApplication::activeWindow(),
+				tr("Basejumper"),
+				message);
+}
+
+
+/*
+ * Shows the given warning message; see showError()
+ */
+void Parser::showWarning(const QString &message)
+{
+	QMainWindow *mainWindow = qobject_cast<QMainWindow *>(parent());
+
+	if (QApplication::type() == QApplication::Tty)
+		qWarning() << qPrintable(message);
+	else
+		QMessageBox::warning(
+				(mainWindow != NULL)? mainWindow->centralWidget(): QApplication::activeWindow(),
+				tr("Basejumper"),
+				message);
+}
+
+
+/*
+ * A contig can be browsed once both its own row and all its fragments
+ * have been committed. Contigs and fragments are saved in parse order,
+ * so the contigs with IDs up to the lesser of the two saved IDs are
+ * available.
+ */
+void Parser::updateAvailableContigs()
+{
+	int available = qMin(lastContigSaved, lastContigFragsSaved);
+
+	if (available <= lastContigAvailable)
+		return;
+
+	while (lastContigAvailable < available)
+	{
+		++lastContigAvailable;
+		availableContigsSize += savedContigSizeHash.take(lastContigAvailable);
+	}
+
+	/* Only the available contigs are browsed; the totals only grow
+	 * while parsing, and once the parser thread has reported them they
+	 * are final even though the savers may still be behind */
+	Contig::setNumAvailableContigs(lastContigAvailable);
+	if (!hasFinalTotals && lastContigAvailable > Contig::getNumContigs())
+	{
+		Contig::setNumContigs(lastContigAvailable);
+		Contig::setTotalSize(qMax(availableContigsSize, Contig::getTotalSize()));
+	}
+	emit contigsAvailable(lastContigAvailable);
+}
+
+
 /**
  * Reads the contig and fragment sequences from the given files in ACE format.
  *
@@ -949,10 +1206,10 @@ bool Parser::readBedFiles(
 {
 	QString filename, filenameFull, genesTrack, snpsTrack, message;
 	QString exonTrack, intronTrack, utr5pTrack, utr3pTrack;
-	QByteArray line;
+	QByteArray line, chromName;
 	QList<QByteArray> fieldList;
-	QSqlQuery query, query2, query3, query4, query5, query6;
-	int index, annotId, contigId, fileId;
+	QSqlQuery query, query2, query3, query4, query5, query6, query7;
+	int index, annotId, fileId;
 	int parsedFileIndex, annotationTypeId;
 	int tmpParsedSize, maxPartitionSize, numPartitions, binNum1, binNum2;
 	bool isTrackKnown, isGeneFileLoaded;
@@ -963,13 +1220,16 @@ bool Parser::readBedFiles(
 	QHash<int, QList<Gene *> *> contig_geneList_map;
 	Gene::Strand direction;
 	AnnotationList::Type trackType;
-	QList<QString> chromList;
-	QList<int> startPosList;
-	QList<int> endPosList;
-	QList<int> contigIdList;
-	QString chromName, annotName, contigChromName, str;
-	int annotStartPos, annotEndPos, contigIdListSize;
-	int chromStartPos, chromEndPos, startPosWithinContig, endPosWithinContig;
+	const ContigPlacementIndex *placementIndex;
+	QVector<ContigPlacementIndex::Placement> placements;
+	ContigPlacementIndex::Placement placement;
+	QHash<int, PadIndex> padIndexHash;
+	QVector<QVariantList> annotBatch(NUM_ANNOTATION_COLUMNS);
+	QString annotName, str;
+	int annotStartPos, annotEndPos, numFields, lineSize;
+	int startPosWithinContig, endPosWithinContig;
+	int fieldStart[BED_MAX_FIELDS], fieldEnd[BED_MAX_FIELDS];
+	const char *data;
 
 	/* Initialize variables */
 	genesTrack = "name=\"Genes\"";
@@ -1025,10 +1285,7 @@ bool Parser::readBedFiles(
 		 * an error. */
 		else
 		{
-			QMessageBox::critical(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Error: Couldn't find file 'order.txt'. 'order.txt' file"
+			showError(tr("Error: Couldn't find file 'order.txt'. 'order.txt' file"
 						" should either exist in the directory containing"
 						" ACE files or in the directory containing"
 						" annotation files."));
@@ -1039,42 +1296,29 @@ bool Parser::readBedFiles(
 	/* Send a signal to indicate parsing of annotation files */
 	emit messageChanged("Parsing annotation files...");
 
-	/* Create a matrix or a table consisting of chromosome name,
-	 * contig start position, contig end position and contig ID.
-	 * This matrix will be used in determining the contig to
-	 * which an annotation belongs to. */
-	str = "select chromosome.name, "
-			" chrom_contig.contigId, "
-			" chrom_contig.chromStart,"
-			" chrom_contig.chromEnd "
-			" from chrom_contig, chromosome "
-			" where chrom_contig.chromId = chromosome.id ";
-	if (!query2.exec(str))
+	/* The contig placements are used in determining the contig to
+	 * which an annotation belongs to */
+	placementIndex = ContigPlacementIndex::getShared();
+	if (placementIndex == NULL)
 	{
-		QMessageBox::critical(
-			(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-			tr("Basejumper"),
-			tr("Error fetching from 'chrom_contig' and 'chromosome' tables.\nReason: "
-					+ query2.lastError().text().toAscii()));
+		showError(tr("Error fetching from 'chrom_contig' and 'chromosome' tables."));
 		return false;
 	}
-	while (query2.next())
+
+	/* Annotation IDs are assigned here, so that genes can refer to
+	 * annotations that are still waiting in the insert batch */
+	if (!query2.exec("select max(id) from annotation"))
 	{
-		chromList.append(query2.value(0).toString());
-		startPosList.append(query2.value(2).toInt());
-		endPosList.append(query2.value(3).toInt());
-		contigIdList.append(query2.value(1).toInt());
+		showError(tr("Error fetching from 'annotation' table.\nReason: "
+					+ query2.lastError().text().toAscii()));
+		return false;
 	}
-	contigIdListSize = contigIdList.size();
+	if (query2.next())
+		annotId = query2.value(0).toInt();
 
 	query.prepare("insert into annotation "
-			" (contigId, startPos, endPos, name, annotationTypeId) "
-			" values("
-			" :contigId, "
-			" :startPos, "
-			" :endPos, "
-			" :name, "
-			" :annotationTypeId) ");
+			" (id, contigId, startPos, endPos, name, annotationTypeId) "
+			" values (?, ?, ?, ?, ?, ?)");
 
 	query3.prepare("insert or replace into file "
 			" (file_name, filepath) "
@@ -1093,7 +1337,8 @@ bool Parser::readBedFiles(
 			" and annotationType.type = :type");
 
 	/* Begin transaction */
-	//Database::beginTransaction();
+	if (!Database::beginTransaction(QSqlDatabase::database()))
+		return false;
 
 	/* Parse each file in the list */
 	for (int i = 0; i < listSize; ++i)
@@ -1116,14 +1361,11 @@ bool Parser::readBedFiles(
 		query3.bindValue(":filePath", path + filename);
 		if (!query3.exec())
 		{
-			QMessageBox::critical(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Error inserting filename into DB.\nReason: "
+			showError(tr("Error inserting filename into DB.\nReason: "
 						+ query3.lastError().text().toAscii()));
 			query2.clear();
 			query6.clear();
-			//Database::rollbackTransaction();
+			Database::rollbackTransaction(QSqlDatabase::database());
 			return false;
 		}
 		fileId = query3.lastInsertId().toInt();
@@ -1133,29 +1375,26 @@ bool Parser::readBedFiles(
 		QFile file(filenameFull);
 		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
 		{
-			QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Cannot read file %1:\n%2.")
+			showError(tr("Cannot read file %1:\n%2.")
 					.arg(file.fileName())
 					.arg(file.errorString()));
 			query2.clear();
 			query6.clear();
-			//Database::rollbackTransaction();
+			Database::rollbackTransaction(QSqlDatabase::database());
 			return false;
 		}
 
-		/* Create a text stream */
-		QTextStream in(&file);
-		in.setIntegerBase(10);
-		in.setCodec("UTF-8");
-
 		/* Read each line and store data in DB */
-		while (!in.atEnd())
+		while (!file.atEnd())
 		{
-			line = in.readLine().toAscii();
-			parsedSize += line.size();
-			tmpParsedSize += line.size();
+			line = file.readLine();
+			lineSize = line.size();
+			parsedSize += lineSize;
+			tmpParsedSize += lineSize;
+			while (lineSize > 0
+					&& (line.at(lineSize - 1) == '\n' || line.at(lineSize - 1) == '\r'))
+				--lineSize;
+			line.truncate(lineSize);
 
 			/* Find what track this file contains */
 			if (line == "")
@@ -1190,93 +1429,112 @@ bool Parser::readBedFiles(
 				query6.bindValue(":type", (int) trackType);
 				if (!query6.exec())
 				{
-					QMessageBox::critical(
-						(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-						tr("Basejumper"),
-						tr("Error fetching data from DB.\nReason: "
+					showError(tr("Error fetching data from DB.\nReason: "
 								+ query6.lastError().text().toAscii()));
 					query2.clear();
 					query6.clear();
-					//Database::rollbackTransaction();
+					Database::rollbackTransaction(QSqlDatabase::database());
 					return false;
 				}
 				if (query6.next())
 					annotationTypeId = query6.value(0).toInt();
 				else
 				{
-					QMessageBox::critical(
-						QApplication::activeWindow(),
-						tr("Basejumper"),
-						tr("Error: Couldn't find 'annotationTypeId'"));
+					showError(tr("Error: Couldn't find 'annotationTypeId'"));
 					query2.clear();
 					query6.clear();
-					//Database::rollbackTransaction();
+					Database::rollbackTransaction(QSqlDatabase::database());
 					return false;
 				}
 
 				continue;
 			}
-			fieldList = line.split('\t');
-			chromName = QString(fieldList.at(0));
-			annotStartPos = fieldList.at(1).toInt();
-			annotEndPos = fieldList.at(2).toInt();
-			annotName = QString(fieldList.at(3));
+			/* Split the line into fields without copying it */
+			numFields = tokenizeLine(line, '\t', fieldStart, fieldEnd, BED_MAX_FIELDS);
+			if (numFields < 4)
+				continue;
+			data = line.constData();
+			chromName = QByteArray::fromRawData(
+					data + fieldStart[0], fieldEnd[0] - fieldStart[0]);
+			annotStartPos = (int) strtol(data + fieldStart[1], NULL, 10);
+			annotEndPos = (int) strtol(data + fieldStart[2], NULL, 10);
+
+			/* Find the contigs on which the annotation lies */
+			placementIndex->findContaining(
+					chromName,
+					annotStartPos,
+					annotEndPos,
+					placements);
+			if (placements.isEmpty())
+				continue;
+			annotName = QString::fromAscii(
+					data + fieldStart[3], fieldEnd[3] - fieldStart[3]);
 
-			for (int j = 0; j < contigIdListSize; ++j)
+			foreach (placement, placements)
 			{
-				chromStartPos = startPosList.at(j);
-				chromEndPos = endPosList.at(j);
-				contigChromName = chromList.at(j);
-				contigId = contigIdList.at(j);
-
-				if (annotStartPos >= chromStartPos
-						&& annotEndPos <= chromEndPos
-						&& chromName.compare(contigChromName) == 0)
+				/* Add to the 'annotation' insert batch */
+				++annotId;
+				ContigPlacementIndex::toContigRange(
+						placement,
+						annotStartPos,
+						annotEndPos,
+						startPosWithinContig,
+						endPosWithinContig);
+
+				/* BED positions are unpadded; contig positions are padded */
+				if (!padIndexHash.contains(placement.contigId)
+						&& !ContigList::fetchPadIndex(
+								query7,
+								placement.contigId,
+								padIndexHash[placement.contigId]))
 				{
-					/* Insert into Annotation table */
-					++annotId;
-					startPosWithinContig = annotStartPos - chromStartPos;
-					endPosWithinContig = annotEndPos - chromStartPos;
-					query.bindValue(":contigId", contigId);
-					query.bindValue(":startPos", startPosWithinContig);
-					query.bindValue(":endPos", endPosWithinContig);
-					query.bindValue(":name", annotName);
-					query.bindValue(":annotationTypeId", annotationTypeId);
-					if (!query.exec())
-					{
-						QMessageBox::critical(
-							(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-							tr("Basejumper"),
-							tr("Error inserting data into 'annotation' table.\nReason: "
-									+ query.lastError().text().toAscii()));
-						query2.clear();
-						query6.clear();
-						//Database::rollbackTransaction();
-						return false;
-					}
-
-					/* If this is a gene track, put genes in appropriate bins */
-					if (trackType == AnnotationList::Gene)
-					{
-						if (fieldList.at(5) == "+")
-							direction = Gene::Downstream;
-						else
-							direction = Gene::Upstream;
-
-						gene = new Gene(annotId,
-								chromName,
-								startPosWithinContig,
-								endPosWithinContig,
-								-1,
-								direction);
-						if (!contig_geneList_map.contains(contigId))
-							contig_geneList_map.insert(contigId, new QList<Gene *>);
-						contig_geneList_map.value(contigId)->append(gene);
-					}
+					showError(tr("Error fetching from 'contigPads' table.\nReason: "
+								+ query7.lastError().text().toAscii()));
+					query2.clear();
+					query6.clear();
+					Database::rollbackTransaction(QSqlDatabase::database());
+					return false;
+				}
+				padIndexHash[placement.contigId].toPaddedRange(
+						startPosWithinContig,
+						endPosWithinContig);
+				annotBatch[0].append(annotId);
+				annotBatch[1].append(placement.contigId);
+				annotBatch[2].append(startPosWithinContig);
+				annotBatch[3].append(endPosWithinContig);
+				annotBatch[4].append(annotName);
+				annotBatch[5].append(annotationTypeId);
+
+				/* If this is a gene track, put genes in appropriate bins */
+				if (trackType == AnnotationList::Gene)
+				{
+					if (numFields > 5
+							&& fieldEnd[5] - fieldStart[5] == 1
+							&& data[fieldStart[5]] == '+')
+						direction = Gene::Downstream;
+					else
+						direction = Gene::Upstream;
+
+					gene = new Gene(annotId,
+							QString(chromName),
+							startPosWithinContig,
+							endPosWithinContig,
+							-1,
+							direction);
+					if (!contig_geneList_map.contains(placement.contigId))
+						contig_geneList_map.insert(placement.contigId, new QList<Gene *>);
+					contig_geneList_map.value(placement.contigId)->append(gene);
 				}
 			}
 
-			fieldList.clear();
+			if (annotBatch.at(0).size() >= ANNOTATION_BATCH_SIZE
+					&& !insertAnnotationBatch(query, annotBatch, "annotation"))
+			{
+				query2.clear();
+				query6.clear();
+				Database::rollbackTransaction(QSqlDatabase::database());
+				return false;
+			}
 
 			/* Emit signal indicating the size that has been already parsed */
 			if (tmpParsedSize >= 5000)
@@ -1288,6 +1546,15 @@ bool Parser::readBedFiles(
 		}
 	}
 
+	/* Insert the remaining annotations */
+	if (!insertAnnotationBatch(query, annotBatch, "annotation"))
+	{
+		query2.clear();
+		query6.clear();
+		Database::rollbackTransaction(QSqlDatabase::database());
+		return false;
+	}
+
 	QList<int> keys = contig_geneList_map.keys();
 	if (keys.size() > 0)
 	{
@@ -1331,14 +1598,11 @@ bool Parser::readBedFiles(
 				query4.bindValue(":strand", g->direction);
 				if (!query4.exec())
 				{
-					QMessageBox::critical(
-						(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-						tr("Basejumper"),
-						tr("Error inserting data into 'gene' table.\nReason: "
+					showError(tr("Error inserting data into 'gene' table.\nReason: "
 								+ query4.lastError().text().toAscii()));
 					query2.clear();
 					query6.clear();
-					//Database::rollbackTransaction();
+					Database::rollbackTransaction(QSqlDatabase::database());
 					return false;
 				}
 			}
@@ -1348,14 +1612,11 @@ bool Parser::readBedFiles(
 			query5.bindValue(":contigId", key);
 			if (!query5.exec())
 			{
-				QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Error updating 'contig' table.\nReason: "
+				showError(tr("Error updating 'contig' table.\nReason: "
 							+ query5.lastError().text().toAscii()));
 				query2.clear();
 				query6.clear();
-				//Database::rollbackTransaction();
+				Database::rollbackTransaction(QSqlDatabase::database());
 				return false;
 			}
 
@@ -1379,7 +1640,8 @@ bool Parser::readBedFiles(
 
 	query2.clear();
 	query6.clear();
-	//Database::endTransaction();
+	if (!Database::endTransaction(QSqlDatabase::database()))
+		return false;
 
 	/* Parse gene structure files */
 	readStructureFiles(
@@ -1399,6 +1661,42 @@ bool Parser::readBedFiles(
 }
 
 
+/*
+ * Inserts the given rows into an annotation DB table and empties the
+ * given columns
+ *
+ * @param query : Prepared insert query
+ * @param columns : Column values of the rows, in the order of the
+ * query's placeholders
+ * @param tableName : Name of the table, used in error messages
+ *
+ * @return Returns true on success and false on failure
+ */
+bool Parser::insertAnnotationBatch(
+		QSqlQuery &query,
+		QVector<QVariantList> &columns,
+		const QString &tableName)
+{
+	int i;
+
+	if (columns.isEmpty() || columns.at(0).isEmpty())
+		return true;
+
+	for (i = 0; i < columns.size(); ++i)
+		query.addBindValue(columns.at(i));
+	if (!query.execBatch())
+	{
+		showError(tr("Error inserting data into '%1' table.\nReason: %2")
+				.arg(tableName)
+				.arg(query.lastError().text()));
+		return false;
+	}
+	for (i = 0; i < columns.size(); ++i)
+		columns[i].clear();
+	return true;
+}
+
+
 /**
  * Reads gene sub-structure files.
  *
@@ -1421,67 +1719,50 @@ bool Parser::readStructureFiles(
 {
 	QSqlQuery query, query2, query3;
 	QString filename, filenameFull, exonTrack, intronTrack, utr5pTrack, utr3pTrack;
-	QString geneName, geneStructureName, chromName, tmp, message, str;
-	QByteArray line;
+	QString geneStructureName, lowerName, message, str;
+	QByteArray line, chromName;
 	QList<QByteArray> fieldList;
 	bool isTrackKnown;
-	int start, end, geneId, contigId, tmpParsedSize;
+	int start, end, geneId, tmpParsedSize, lineSize, numFields, len, k, match;
+	int startPosWithinContig, endPosWithinContig;
+	int fieldStart[BED_MAX_FIELDS], fieldEnd[BED_MAX_FIELDS];
+	const char *data;
 	GeneStructure::SubstructureType subStructureType;
-	QList<QString> chromList;
-	QList<int> startPosList;
-	QList<int> endPosList;
-	int contigIdListSize, annotIdListSize, startPosWithinContig, endPosWithinContig;
-	QList<QString> contigChromList;
-	QList<int> contigIdList;
-	QList<int> contigStartPosList;
-	QList<int> contigEndPosList;
-	QList<int> annotIdList;
-	QList<int> annotContigIdList;
-	QList<int> annotStartPosList;
-	QList<int> annotEndPosList;
-	QList<QString> annotNameList;
-
-
-	contigId = 0;
+	const ContigPlacementIndex *placementIndex;
+	QVector<ContigPlacementIndex::Placement> placements;
+	ContigPlacementIndex::Placement placement;
+	QHash<int, PadIndex> padIndexHash;
+	QHash<QString, QList<int> > geneNameHash;
+	QList<int> nameLengthList;
+	QVector<int> annotIdList;
+	QVector<int> annotContigIdList;
+	QVector<int> annotStartPosList;
+	QVector<int> annotEndPosList;
+	QVector<StructureRow> structureList;
+	StructureRow row;
+	QVector<QVariantList> structureBatch(NUM_STRUCTURE_COLUMNS);
+
+
 	tmpParsedSize = 0;
+	subStructureType = GeneStructure::EXON;
 	exonTrack = "name=\"Exons\"";
 	intronTrack = "name=\"Introns\"";
 	utr5pTrack = "name=\"5PUTR\"";
 	utr3pTrack = "name=\"3PUTR\"";
 
-	/* Create a matrix or a table consisting of chromosome name,
-	 * contig start position, contig end position and contig ID.
-	 * This matrix will be used in determining the contig to
-	 * which an gene structure belongs to. */
-	str = "select chromosome.name, "
-			" chrom_contig.contigId, "
-			" chrom_contig.chromStart,"
-			" chrom_contig.chromEnd "
-			" from chrom_contig, chromosome "
-			" where chrom_contig.chromId = chromosome.id ";
-	if (!query3.exec(str))
+	/* The contig placements are used in determining the contig to
+	 * which a gene structure belongs to */
+	placementIndex = ContigPlacementIndex::getShared();
+	if (placementIndex == NULL)
 	{
-		QMessageBox::critical(
-			(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-			tr("Basejumper"),
-			tr("Error fetching from 'chrom_contig' and 'chromosome' tables.\nReason: "
-					+ query3.lastError().text().toAscii()));
+		showError(tr("Error fetching from 'chrom_contig' and 'chromosome' tables."));
 		return false;
 	}
-	while (query3.next())
-	{
-		contigChromList.append(query3.value(0).toString());
-		contigIdList.append(query3.value(1).toInt());
-		contigStartPosList.append(query3.value(2).toInt());
-		contigEndPosList.append(query3.value(3).toInt());
-	}
-	contigIdListSize = contigIdList.size();
 
-	/* Create a matrix or a table consisting of annotation ID,
-	 * contig ID associated with the annotation, annotation start position,
-	 * annotation end position, and annotation name. This matrix will be
-	 * used in determining the annotation to which a gene sub structure
-	 * belongs to. */
+	/* Hash the genes by their lower-case name. A gene sub-structure
+	 * belongs to a gene whose name is a prefix of the structure name,
+	 * so the structure name is looked up once for each distinct gene
+	 * name length. */
 	str = "select annotation.id, annotation.contigId, annotation.startPos, "
 			" annotation.endPos, annotation.name "
 			" from annotationType, annotation "
@@ -1490,28 +1771,22 @@ bool Parser::readStructureFiles(
 			" order by annotation.contigId asc";
 	if (!query2.exec(str))
 	{
-		QMessageBox::critical(
-			(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-			tr("Basejumper"),
-			tr("Error fetching from 'chrom_contig' and 'chromosome' tables.\nReason: "
+		showError(tr("Error fetching from 'annotation' and 'annotationType' tables.\nReason: "
 					+ query2.lastError().text().toAscii()));
 		return false;
 	}
 	while (query2.next())
 	{
+		lowerName = query2.value(4).toString().toLower();
+		geneNameHash[lowerName].append(annotIdList.size());
+		if (!nameLengthList.contains(lowerName.length()))
+			nameLengthList.append(lowerName.length());
 		annotIdList.append(query2.value(0).toInt());
 		annotContigIdList.append(query2.value(1).toInt());
 		annotStartPosList.append(query2.value(2).toInt());
 		annotEndPosList.append(query2.value(3).toInt());
-		annotNameList.append(query2.value(4).toString());
 	}
-	annotIdListSize = annotIdList.size();
-
-	//Database::beginTransaction();
-	query.prepare("insert into geneStructure "
-			" (type, geneId, name, start, end) "
-			" values "
-			" (:type, :geneId, :name, :start, :end) ");
+	qSort(nameLengthList);
 
 	/* Parse each file in the list */
 	for (int i = 0; i < listSize; ++i)
@@ -1526,10 +1801,7 @@ bool Parser::readStructureFiles(
 		QFile file(filenameFull);
 		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
 		{
-			QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Cannot read file %1:\n%2.")
+			showError(tr("Cannot read file %1:\n%2.")
 					.arg(file.fileName())
 					.arg(file.errorString()));
 			return false;
@@ -1543,17 +1815,17 @@ bool Parser::readStructureFiles(
 		emit messageChanged(message);
 		QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 
-		/* Create a text stream */
-		QTextStream in(&file);
-		in.setIntegerBase(10);
-		in.setCodec("UTF-8");
-
-		/* Read each line and store data in DB */
-		while (!in.atEnd())
+		/* Read each line and match it to a gene */
+		while (!file.atEnd())
 		{
-			line = in.readLine().toAscii();
-			parsedSize += line.size();
-			tmpParsedSize += line.size();
+			line = file.readLine();
+			lineSize = line.size();
+			parsedSize += lineSize;
+			tmpParsedSize += lineSize;
+			while (lineSize > 0
+					&& (line.at(lineSize - 1) == '\n' || line.at(lineSize - 1) == '\r'))
+				--lineSize;
+			line.truncate(lineSize);
 
 			/* Find what track this file contains */
 			if (line == "")
@@ -1575,51 +1847,74 @@ bool Parser::readStructureFiles(
 
 				continue;
 			}
-			fieldList = line.split('\t');
-			chromName = QString(fieldList.at(0));
-			start = fieldList.at(1).toInt();
-			end = fieldList.at(2).toInt();
-			geneStructureName = QString(fieldList.at(3));
+			numFields = tokenizeLine(line, '\t', fieldStart, fieldEnd, BED_MAX_FIELDS);
+			if (numFields < 4)
+				continue;
+			data = line.constData();
+			chromName = QByteArray::fromRawData(
+					data + fieldStart[0], fieldEnd[0] - fieldStart[0]);
+			start = (int) strtol(data + fieldStart[1], NULL, 10);
+			end = (int) strtol(data + fieldStart[2], NULL, 10);
+
+			placementIndex->findContaining(chromName, start, end, placements);
+			if (placements.isEmpty())
+				continue;
+			geneStructureName = QString::fromAscii(
+					data + fieldStart[3], fieldEnd[3] - fieldStart[3]);
+			lowerName = geneStructureName.toLower();
 
-			for (int j = 0; j < contigIdListSize; ++j)
+			foreach (placement, placements)
 			{
-				if (start >= contigStartPosList.at(j)
-						&& end <= contigEndPosList.at(j)
-						&& chromName.compare(contigChromList.at(j), Qt::CaseInsensitive) == 0)
+				ContigPlacementIndex::toContigRange(
+						placement,
+						start,
+						end,
+						startPosWithinContig,
+						endPosWithinContig);
+
+				/* BED positions are unpadded; contig positions are padded */
+				if (!padIndexHash.contains(placement.contigId)
+						&& !ContigList::fetchPadIndex(
+								query3,
+								placement.contigId,
+								padIndexHash[placement.contigId]))
 				{
-					contigId = contigIdList.at(j);
-					startPosWithinContig = start - contigStartPosList.at(j);
-					endPosWithinContig = end - contigStartPosList.at(j);
-
-					for (int k = 0; k < annotIdListSize; ++k)
+					showError(tr("Error fetching from 'contigPads' table.\nReason: "
+								+ query3.lastError().text().toAscii()));
+					return false;
+				}
+				padIndexHash[placement.contigId].toPaddedRange(
+						startPosWithinContig,
+						endPosWithinContig);
+
+				/* Of the genes on this contig that contain the structure
+				 * and whose name is a prefix of the structure name, pick
+				 * the one that comes first in the gene list */
+				match = -1;
+				foreach (len, nameLengthList)
+				{
+					if (len > lowerName.length())
+						break;
+					if (!geneNameHash.contains(lowerName.left(len)))
+						continue;
+					foreach (k, geneNameHash.value(lowerName.left(len)))
 					{
-						if (contigId == annotContigIdList.at(k)
-							&& startPosWithinContig >= annotStartPosList.at(k)
-							&& endPosWithinContig <= annotEndPosList.at(k)
-							&& geneStructureName.startsWith(annotNameList.at(k), Qt::CaseInsensitive))
-						{
-							geneId = annotIdList.at(k);
-
-							/* Save gene sub-structure in DB */
-							query.bindValue(":type", (int) subStructureType);
-							query.bindValue(":geneId", geneId);
-							query.bindValue(":name", geneStructureName);
-							query.bindValue(":start", startPosWithinContig);
-							query.bindValue(":end", endPosWithinContig);
-							if (!query.exec())
-							{
-								QMessageBox::critical(
-									(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-									tr("Basejumper"),
-									tr("Error inserting data into geneStructure table.\nReason: "
-											+ query.lastError().text().toAscii()));
-								//Database::rollbackTransaction();
-								return false;
-							}
-							break;
-						}
+						if (annotContigIdList.at(k) == placement.contigId
+								&& startPosWithinContig >= annotStartPosList.at(k)
+								&& endPosWithinContig <= annotEndPosList.at(k)
+								&& (match < 0 || k < match))
+							match = k;
 					}
 				}
+				if (match < 0)
+					continue;
+
+				row.geneId = annotIdList.at(match);
+				row.type = (int) subStructureType;
+				row.start = startPosWithinContig;
+				row.end = endPosWithinContig;
+				row.name = geneStructureName;
+				structureList.append(row);
 			}
 
 			/* Emit signal indicating the size that has been already parsed */
@@ -1631,8 +1926,36 @@ bool Parser::readStructureFiles(
 			}
 		}
 	}
-	//Database::endTransaction();
-	return true;
+
+	/* Save the structures grouped by gene, so that the substructures of
+	 * a gene are adjacent in the table and can be read with one range
+	 * scan of the 'geneStructure_geneId' index */
+	qStableSort(structureList.begin(), structureList.end(), structureRowLessThan);
+	query.prepare("insert into geneStructure "
+			" (type, geneId, name, start, end) "
+			" values (?, ?, ?, ?, ?)");
+	if (!Database::beginTransaction(QSqlDatabase::database()))
+		return false;
+	foreach (row, structureList)
+	{
+		structureBatch[0].append(row.type);
+		structureBatch[1].append(row.geneId);
+		structureBatch[2].append(row.name);
+		structureBatch[3].append(row.start);
+		structureBatch[4].append(row.end);
+		if (structureBatch.at(0).size() >= ANNOTATION_BATCH_SIZE
+				&& !insertAnnotationBatch(query, structureBatch, "geneStructure"))
+		{
+			Database::rollbackTransaction(QSqlDatabase::database());
+			return false;
+		}
+	}
+	if (!insertAnnotationBatch(query, structureBatch, "geneStructure"))
+	{
+		Database::rollbackTransaction(QSqlDatabase::database());
+		return false;
+	}
+	return Database::endTransaction(QSqlDatabase::database());
 }
 
 
@@ -1648,18 +1971,17 @@ bool Parser::readOrderFile(const QString &filename)
 	QSqlQuery query, query1, query2, query3, query4, query5, query7, query11;
 	QList<QString> tokenList;
 	int annotOrder, contigOrder;
-	QString line, queryStr, chromName;
+	QString line, queryStr, chromName, indexedFile;
 	bool annotationSection, sequenceSection;
 	QRegExp commentRegExp;
 	QRegExp annotationRegExp, annotationItemsRegExp, annotationEndRegExp;
 	QRegExp sequenceRegExp, sequenceItemsRegExp, sequenceEndRegExp;
 	QHash<int, int> contigOrderSizeHash, contigIdDistanceHash, contigOrderIdHash;
-	QHash<QString, QString> fileAliasHash, contigChromHash;
-	QHash<QString, QString> contigStartPosHash, contigEndPosHash;
+	QHash<QString, QString> fileAliasHash;
 	QHash<QString, int> contigOrderHash;
 	QSet<QString> contigsSet;
 	QList<QString> annotationFileList, annotationTypeList, annotationAliasList;
-	QList<QString> chromList, startPosList, endPosList, contigNameList;
+	QList<QString> chromList, startPosList, endPosList, contigNameList, strandList;
 	int tokenListSize;
 
 	/* Initialization */
@@ -1673,7 +1995,7 @@ bool Parser::readOrderFile(const QString &filename)
 
 	annotationRegExp.setPattern(QRegExp::escape("[annotation files]"));
 	annotationRegExp.setCaseSensitivity(Qt::CaseInsensitive);
-	annotationItemsRegExp.setPattern("^.+\\.[a-z]{3}\\t[(snp)|(gene)|(custom)]\\t?.*$");
+	annotationItemsRegExp.setPattern("^.+\\.[a-z]{3}(\\.gz)?\\t[(snp)|(gene)|(custom)]\\t?.*$");
 	annotationItemsRegExp.setCaseSensitivity(Qt::CaseInsensitive);
 	annotationEndRegExp.setPattern(QRegExp::escape("[/annotation files]"));
 
@@ -1692,10 +2014,7 @@ bool Parser::readOrderFile(const QString &filename)
 	QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
 	{
-		QMessageBox::critical(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Cannot read file %1:\n%2.")
+		showError(tr("Cannot read file %1:\n%2.")
 				.arg(file.fileName())
 				.arg(file.errorString()));
 		emit messageChanged("");
@@ -1741,10 +2060,7 @@ bool Parser::readOrderFile(const QString &filename)
 			/* If there are less than 2 columns or more than 3 columns */
 			else
 			{
-				QMessageBox::critical(
-						QApplication::activeWindow(),
-						tr("Basejumper"),
-						tr("In order.txt file, annotation section has either "
+				showError(tr("In order.txt file, annotation section has either "
 								"more than 3 columns or less than 2 columns. The "
 								"required 2 columns are annotation file name "
 								"and annotation type. The optional third "
@@ -1763,15 +2079,16 @@ bool Parser::readOrderFile(const QString &filename)
 		else if (sequenceSection && sequenceItemsRegExp.exactMatch(line))
 		{
 			tokenList = line.split('\t');
-			if (tokenList.size() != 4)
+			if ((tokenList.size() != 4 && tokenList.size() != 5)
+					|| (tokenList.size() == 5
+							&& tokenList.at(4) != "+" && tokenList.at(4) != "-"))
 			{
-				QMessageBox::critical(
-						QApplication::activeWindow(),
-						tr("Basejumper"),
-						tr("In order.txt file, sequence section does not have "
+				showError(tr("In order.txt file, sequence section does not have "
 								"4 columns. The 4 columns needed are: "
 								"chromosome name, start position of contig, "
-								"end position of contig, and contig name. "));
+								"end position of contig, and contig name. "
+								"The optional fifth column is the strand "
+								"of the contig ('+' or '-'). "));
 				emit messageChanged("");
 				return false;
 			}
@@ -1780,6 +2097,7 @@ bool Parser::readOrderFile(const QString &filename)
 			startPosList.append(tokenList.at(1));
 			endPosList.append(tokenList.at(2));
 			contigNameList.append(tokenList.at(3));
+			strandList.append((tokenList.size() == 5)? tokenList.at(4): "+");
 		}
 		/* Matches sequence end section */
 		else if (sequenceSection && sequenceEndRegExp.exactMatch(line))
@@ -1796,10 +2114,7 @@ bool Parser::readOrderFile(const QString &filename)
 			contigsSet, contigsSet.size()))
 	{
 		QApplication::restoreOverrideCursor();
-		QMessageBox::warning(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Loaded contigs and the contigs in"
+		showWarning(tr("Loaded contigs and the contigs in"
 						" 'order.txt' file do not match. You will not"
 						" be able to load annotation files without"
 						" fixing this first. "));
@@ -1818,19 +2133,33 @@ bool Parser::readOrderFile(const QString &filename)
 			" values "
 			" (:fileName)");
 	query4.prepare("insert into annotationType "
-			" (type, annotOrder, alias, fileId) "
+			" (type, annotOrder, alias, indexedFile, fileId) "
 			" values "
-			" (:type, :order, :alias, :fileId) ");
+			" (:type, :order, :alias, :indexedFile, :fileId) ");
 	for (int i = 0; i < annotationFileList.size(); ++i)
 	{
+		/* Compressed files are not imported; they must have a tabix
+		 * index next to them and are read region by region */
+		indexedFile = QString();
+		if (annotationFileList.at(i).endsWith(".gz"))
+		{
+			indexedFile = QFileInfo(filename).absolutePath()
+				+ "/" + annotationFileList.at(i);
+			if (!QFile::exists(indexedFile + ".tbi"))
+			{
+				showError(tr("Error: Couldn't find index file '%1'. Compressed "
+								"annotation files must be indexed with tabix.")
+						.arg(annotationFileList.at(i) + ".tbi"));
+				emit messageChanged("");
+				return false;
+			}
+		}
+
 		/* Insert filename into 'file' table */
 		query3.bindValue(":fileName", annotationFileList.at(i));
 		if (!query3.exec())
 		{
-			QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Error inserting data into 'file' table.\nReason: "
+			showError(tr("Error inserting data into 'file' table.\nReason: "
 							+ query3.lastError().text().toAscii()));
 			emit messageChanged("");
 			//Database::rollbackTransaction();
@@ -1839,10 +2168,7 @@ bool Parser::readOrderFile(const QString &filename)
 		if (query3.lastInsertId().isNull()
 				|| query3.lastInsertId().toInt() <= 0)
 		{
-			QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Error fetching file ID "));
+			showError(tr("Error fetching file ID "));
 			emit messageChanged("");
 			//Database::rollbackTransaction();
 			return false;
@@ -1850,21 +2176,22 @@ bool Parser::readOrderFile(const QString &filename)
 		fileId = query3.lastInsertId().toInt();
 
 		/* Insert annotation types into 'annotationType' table */
+		/* Indexed gene tracks are shown as custom tracks, since gene
+		 * rows are laid out at import time */
 		if (annotationTypeList.at(i) == "snp")
 			query4.bindValue(":type", (int) AnnotationList::Snp);
-		else if (annotationTypeList.at(i) == "gene")
+		else if (annotationTypeList.at(i) == "gene" && indexedFile.isEmpty())
 			query4.bindValue(":type", (int) AnnotationList::Gene);
 		else
 			query4.bindValue(":type", (int) AnnotationList::Custom);
 		query4.bindValue(":order", i+1);
 		query4.bindValue(":alias", annotationAliasList.at(i));
+		query4.bindValue(":indexedFile",
+				indexedFile.isEmpty()? QVariant(QVariant::String): QVariant(indexedFile));
 		query4.bindValue(":fileId", fileId);
 		if (!query4.exec())
 		{
-			QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Error inserting data into 'annotationType' table.\nReason: "
+			showError(tr("Error inserting data into 'annotationType' table.\nReason: "
 							+ query4.lastError().text().toAscii()));
 			emit messageChanged("");
 			//Database::rollbackTransaction();
@@ -1885,10 +2212,7 @@ bool Parser::readOrderFile(const QString &filename)
 		query1.bindValue(":name", chromName);
 		if (!query1.exec())
 		{
-			QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Error inserting data into 'chromosome' table.\nReason: "
+			showError(tr("Error inserting data into 'chromosome' table.\nReason: "
 							+ query1.lastError().text().toAscii()));
 			emit messageChanged("");
 			//Database::rollbackTransaction();
@@ -1898,30 +2222,30 @@ bool Parser::readOrderFile(const QString &filename)
 
 	/* Insert chromosome-contig mapping into 'chrom_contig' table */
 	query2.prepare(" insert into chrom_contig "
-			" (chromId, contigId, chromStart, chromEnd) "
+			" (chromId, contigId, chromStart, chromEnd, strand) "
 			" values("
 			" (select id from chromosome where name = :chromName), "
 			" (select id from contig where name = :contigName), "
 			" :chromStart, "
-			" :chromEnd) ");
+			" :chromEnd, "
+			" :strand) ");
 	for (int i = 0; i < contigNameList.size(); ++i)
 	{
 		query2.bindValue(":chromName", chromList.at(i));
 		query2.bindValue(":contigName", contigNameList.at(i));
 		query2.bindValue(":chromStart", startPosList.at(i));
 		query2.bindValue(":chromEnd", endPosList.at(i));
+		query2.bindValue(":strand", strandList.at(i));
 		if (!query2.exec())
 		{
-			QMessageBox::critical(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Error inserting data into 'chrom_contig' table.\nReason: "
+			showError(tr("Error inserting data into 'chrom_contig' table.\nReason: "
 						+ query2.lastError().text().toAscii()));
 			emit messageChanged("");
 			//Database::rollbackTransaction();
 			return false;
 		}
 	}
+	ContigPlacementIndex::resetShared();
 
 	/* Update 'contigOrder' column in 'contig' table */
 	query7.prepare("update contig "
@@ -1933,10 +2257,7 @@ bool Parser::readOrderFile(const QString &filename)
 		query7.bindValue(":contigName", contigNameList.at(i));
 		if (!query7.exec())
 		{
-			QMessageBox::critical(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Error updating 'contig' table.\nReason: "
+			showError(tr("Error updating 'contig' table.\nReason: "
 						+ query7.lastError().text().toAscii()));
 			emit messageChanged("");
 			//Database::rollbackTransaction();
@@ -1950,10 +2271,7 @@ bool Parser::readOrderFile(const QString &filename)
 			" order by contigOrder asc";
 	if (!query.exec(queryStr))
 	{
-		QMessageBox::critical(
-			(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-			tr("Basejumper"),
-			tr("Error fetching from contig table.\nReason: "
+		showError(tr("Error fetching from contig table.\nReason: "
 					+ query.lastError().text().toAscii()));
 		emit messageChanged("");
 		//Database::rollbackTransaction();
@@ -2015,21 +2333,15 @@ bool Parser::readCytoband(const QString &filename)
 			" from chromosome ";
 	if (!query2.exec(str))
 	{
-		QMessageBox::critical(
-				QApplication::activeWindow(),
-				tr("Basejumper"),
-				tr("Error fetching data from 'chromosome' table.\nReason: "
+		showError(tr("Error fetching data from 'chromosome' table.\nReason: "
 						+ query2.lastError().text().toAscii()));
 		return false;
 	}
-	while (query.next())
+	while (query2.next())
 		chromNameIdHash.insert(query2.value(1).toString(), query2.value(0).toInt());
 	if (chromNameIdHash.size() < 1)
 	{
-		QMessageBox::critical(
-				QApplication::activeWindow(),
-				tr("Basejumper"),
-				tr("No existing chromosomes found in database"));
+		showError(tr("No existing chromosomes found in database"));
 		return false;
 	}
 
@@ -2037,10 +2349,7 @@ bool Parser::readCytoband(const QString &filename)
 	QFile file(filename);
 	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
 	{
-		QMessageBox::critical(
-				QApplication::activeWindow(),
-				tr("Basejumper"),
-				tr("Cannot read file %1:\n%2.")
+		showError(tr("Cannot read file %1:\n%2.")
 				.arg(file.fileName())
 				.arg(file.errorString()));
 		emit messageChanged("");
@@ -2061,10 +2370,7 @@ bool Parser::readCytoband(const QString &filename)
 
 		if (!pattern.exactMatch(line))
 		{
-			QMessageBox::critical(
-					QApplication::activeWindow(),
-					tr("Basejumper"),
-					tr("Invalid data at line %1 in %2.")
+			showError(tr("Invalid data at line %1 in %2.")
 					.arg(lineNum)
 					.arg(file.fileName()));
 			emit messageChanged("");
@@ -2079,10 +2385,7 @@ bool Parser::readCytoband(const QString &filename)
 		query.bindValue(":stain", tokenList.at(4));
 		if (!query.exec())
 		{
-			QMessageBox::critical(
-					QApplication::activeWindow(),
-					tr("Basejumper"),
-					tr("Error inserting data into 'cytoband' table.\nReason: "
+			showError(tr("Error inserting data into 'cytoband' table.\nReason: "
 							+ query.lastError().text().toAscii()));
 			emit messageChanged("");
 			//Database::rollbackTransaction();
@@ -2138,10 +2441,7 @@ bool Parser::insertContigIntoDB(const Contig *contig)
 	sqlQuery.bindValue(":fileId", contig->fileId);
 	if (!sqlQuery.exec())
 	{
-		QMessageBox::critical(
-			(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-			tr("Basejumper"),
-			tr("Error inserting contig into DB.\nReason: "
+		showError(tr("Error inserting contig into DB.\nReason: "
 					+ sqlQuery.lastError().text().toAscii()));
 		//Database::rollbackTransaction();
 		return false;
@@ -2152,10 +2452,7 @@ bool Parser::insertContigIntoDB(const Contig *contig)
 	sqlQuery2.bindValue(":seq", contig->seq);
 	if (!sqlQuery2.exec())
 	{
-		QMessageBox::critical(
-			(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-			tr("Basejumper"),
-			tr("Error inserting contigSeq into DB.\nReason: "
+		showError(tr("Error inserting contigSeq into DB.\nReason: "
 					+ sqlQuery2.lastError().text().toAscii()));
 		//Database::rollbackTransaction();
 		return false;
@@ -2217,10 +2514,7 @@ bool Parser::insertFragsIntoDB(const QList<Fragment *> &list)
 		query.bindValue(":numMappings", frag->numMappings);
 		if (!query.exec())
 		{
-			QMessageBox::critical(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Error inserting fragment into DB.\nReason: "
+			showError(tr("Error inserting fragment into DB.\nReason: "
 						+ query.lastError().text().toAscii()));
 			//Database::rollbackTransaction();
 			return false;
@@ -2273,10 +2567,7 @@ bool Parser::updateFragMapping(const QHash<QByteArray, int> &hash)
 			query.bindValue(":name", name);
 			if (!query.exec())
 			{
-				QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Error inserting fragment into DB.\nReason: "
+				showError(tr("Error inserting fragment into DB.\nReason: "
 							+ query.lastError().text().toAscii()));
 				db.rollback();
 				return false;
@@ -2308,10 +2599,7 @@ bool Parser::insertFileIntoDB(const QString &fileName, const int fileNum)
 		+ fileName + "')";
 	if (!sqlQuery.exec(str))
 	{
-		QMessageBox::critical(
-			(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-			tr("Basejumper"),
-			tr("Error inserting file into DB.\nReason: "
+		showError(tr("Error inserting file into DB.\nReason: "
 					+ sqlQuery.lastError().text().toAscii()));
 		return false;
 	}
@@ -2431,10 +2719,7 @@ bool Parser::insertSnpIntoDB(const Contig *contig,
 		query.bindValue(":percentList", percentList);
 		if (!query.execBatch())
 		{
-			QMessageBox::critical(
-				(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-				tr("Basejumper"),
-				tr("Error inserting SNP positions into DB.\nReason: "
+			showError(tr("Error inserting SNP positions into DB.\nReason: "
 						+ query.lastError().text().toAscii()));
 			//Database::rollbackTransaction();
 			return false;
@@ -2478,10 +2763,7 @@ void Parser::insertSnpIntoDB(
 		query.bindValue(":percentList", posVariationPercentHash.value(key));
 		if (!query.exec())
 		{
-			QMessageBox::critical(
-				QApplication::activeWindow(),
-				tr("Basejumper"),
-				tr("Error inserting SNP positions into DB.\nReason: "
+			showError(tr("Error inserting SNP positions into DB.\nReason: "
 						+ query.lastError().text().toAscii()));
 			//Database::rollbackTransaction();
 			return;
@@ -2939,10 +3221,7 @@ void Parser::insertSnpIntoDB(const Contig *contig, const int avgFragSize)
 			query.bindValue(":variationPercent", variationPercent);
 			if (!query.exec())
 			{
-				QMessageBox::critical(
-					(reinterpret_cast<QMainWindow *>(parent()))->centralWidget(),
-					tr("Basejumper"),
-					tr("Error inserting SNP positions into DB.\nReason: "
+				showError(tr("Error inserting SNP positions into DB.\nReason: "
 							+ query.lastError().text().toAscii()));
 				return;
 			}
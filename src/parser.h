@@ -4,6 +4,7 @@
 
 #include <QWidget>
 #include <QSqlDatabase>
+#include <QSqlQuery>
 #include <QMultiHash>
 #include <QFile>
 #include "contig.h"
@@ -25,12 +26,16 @@ class Parser : public QObject
 	Q_OBJECT
 
 public:
+	/* Stages of the contig import, each run by its own thread */
+	enum Stage {AceParsing, ContigSaving, FragmentSaving};
+
 	Parser();
     ~Parser();
     bool readAce(const QStringList &, int);
     bool readBedFiles(const QStringList &, int, QString &);
     bool readOrderFile(const QString &);
     bool readCytoband(const QString &);
+    bool openProject();
     bool readStructureFiles(
     		const QStringList &,
     		int,
@@ -39,6 +44,10 @@ public:
     		int,
     		int);
 
+    /** Returns whether the last import stopped on an error in the input
+     * files; only valid once parsingFinished() has been emitted */
+    inline bool hasParseError() const { return parserThread.hasError(); };
+
     public slots:
     void totalSizeSignaled(int);
     void messageChangeSignaled(const QString &);
@@ -46,6 +55,9 @@ public:
     void parsingStartedSignaled();
     void parsingProgressSignaled(int);
     void signalParsingFinished();
+    void contigSavedSignaled(int, int);
+    void fragsSavedSignaled(int);
+    void totalsParsedSignaled(int, qint64);
 
     signals:
     void messageChanged(const QString &);
@@ -62,8 +74,13 @@ public:
     void orderParsingFinished();
     void annotationParsingFinished();
     void maxYPosChanged(const int);
+    void contigsAvailable(int);
+    void stageFinished(int);
 
 private:
+	void updateAvailableContigs();
+	void showError(const QString &);
+	void showWarning(const QString &);
 	void assignFragYPos(QList<QList <Fragment *>*> &, int &);
 	void assignFragYPos(Contig *, const int, int &);
 	void assignGeneYPos(QList<QList <Gene *>*> &, int &);
@@ -71,6 +88,7 @@ private:
 	bool insertContigIntoDB(const Contig *);
 	bool insertFragsIntoDB(const QList<Fragment *> &);
 	bool insertFileIntoDB(const QString &, const int);
+	bool insertAnnotationBatch(QSqlQuery &, QVector<QVariantList> &, const QString &);
     bool insertSnpIntoDB(
     		const Contig *,
     		const QList<QList <Fragment *>*> &,
@@ -90,6 +108,12 @@ private:
 	ParserThread parserThread;
 	FragmentSaverThread fragSaverThread;
 	ContigSaverThread contigSaverThread;
+	int lastContigSaved;
+	int lastContigFragsSaved;
+	int lastContigAvailable;
+	qint64 availableContigsSize;
+	bool hasFinalTotals;		/* Whether the parser thread has reported its totals */
+	QHash<int, int> savedContigSizeHash;
 
 private slots:
 	void insertSnpIntoDB(const int, const QHash<int, int> &);
@@ -2,14 +2,39 @@
 #include "parserThread.h"
 #include "contig.h"
 #include "fragment.h"
+#include "contigAnalyzer.h"
 #include "math.h"
 #include <QSqlDatabase>
 #include <QSqlQuery>
 #include <QSqlError>
 #include "database.h"
+#include "trace.h"
+#include "perfMetrics.h"
+#include "samReader.h"
+#include "fastaReader.h"
+#include "gzipReader.h"
 
 #define	BYTE_TO_MBYTE	1048576
 #define	MAX_CONTIG_PARTITION	500
+#define	MAX_QUEUED_READS		50000
+#define	PARSED_SIZE_INTERVAL	1048576	/* Bytes parsed between progress updates */
+
+/* SAM flags of the alignments that are not imported */
+#define	SAM_FLAG_UNMAPPED		0x4
+#define	SAM_FLAG_REVERSE		0x10
+#define	SAM_FLAG_SECONDARY		0x100
+#define	SAM_FLAG_SUPPLEMENTARY	0x800
+
+/* CIGAR operations */
+#define	CIGAR_MATCH		0
+#define	CIGAR_INS		1
+#define	CIGAR_DEL		2
+#define	CIGAR_SKIP		3
+#define	CIGAR_SOFT_CLIP	4
+#define	CIGAR_HARD_CLIP	5
+#define	CIGAR_PAD		6
+#define	CIGAR_EQUAL		7
+#define	CIGAR_DIFF		8
 
 extern QQueue<Contig *> contigQueue;
 extern QQueue<Fragment *> fragQueue;
@@ -20,14 +45,113 @@ extern QWaitCondition contigQueueNotEmpty;
 extern QWaitCondition fragQueueNotFull;
 extern QWaitCondition fragQueueNotEmpty;
 
-const int fragQueueSizeMax = 50000;
 extern bool moreContigs;
 
-extern QList<quint16> partitionList;
+extern QList<int> partitionList;
 extern int contigPartitions;
 extern QMutex partitionListMutex;
 extern const int maxPartitionSize;
 
+int ParserThread::maxQueuedReads = MAX_QUEUED_READS;
+
+
+/*
+ * Returns whether the given file is a SAM or BAM file
+ */
+static bool isAlignmentFile(const QString &fileName)
+{
+	QString suffix = QFileInfo(fileName).suffix().toLower();
+
+	/* Bgzipped SAM files are read by SamReader as well */
+	if (suffix == "gz")
+		suffix = QFileInfo(QFileInfo(fileName).completeBaseName()).suffix().toLower();
+	return (suffix == "sam" || suffix == "bam");
+}
+
+
+/*
+ * Returns whether the given file is a FASTA file
+ */
+static bool isFastaFile(const QString &fileName)
+{
+	QString suffix = QFileInfo(fileName).suffix().toLower();
+
+	return (suffix == "fa" || suffix == "fasta" || suffix == "fna");
+}
+
+
+/*
+ * Turns the given alignment into a read laid out on the unpadded
+ * reference: soft-clipped bases are kept and marked as low quality,
+ * deleted and skipped reference bases become pads and inserted bases
+ * are dropped. Returns false if the alignment has no aligned bases.
+ */
+static bool toFragment(const SamReader::Record &record, Fragment *frag)
+{
+	int i, length, readPos, leftClip, rightClip;
+	bool isAligned;
+
+	frag->seq.clear();
+	frag->seq.reserve(record.seq.size());
+	readPos = 0;
+	leftClip = 0;
+	rightClip = 0;
+	isAligned = false;
+	for (i = 0; i < record.cigar.size(); ++i)
+	{
+		length = (int) (record.cigar.at(i) >> 4);
+		switch (record.cigar.at(i) & 0xF)
+		{
+			case CIGAR_MATCH:
+			case CIGAR_EQUAL:
+			case CIGAR_DIFF:
+				if (readPos + length > record.seq.size())
+					return false;
+				frag->seq += record.seq.mid(readPos, length);
+				readPos += length;
+				isAligned = true;
+				rightClip = 0;
+				break;
+			case CIGAR_SOFT_CLIP:
+				if (readPos + length > record.seq.size())
+					return false;
+				frag->seq += record.seq.mid(readPos, length);
+				readPos += length;
+				if (isAligned)
+					rightClip += length;
+				else
+					leftClip += length;
+				break;
+			case CIGAR_INS:
+				readPos += length;
+				break;
+			case CIGAR_DEL:
+			case CIGAR_SKIP:
+				frag->seq += QByteArray(length, '*');
+				break;
+			default:
+				break;
+		}
+	}
+	if (!isAligned)
+		return false;
+
+	frag->name = record.name;
+	frag->size = frag->seq.size();
+	frag->startPos = record.pos + 1 - leftClip;
+	frag->endPos = frag->startPos + frag->size - 1;
+	frag->qualStart = leftClip + 1;
+	frag->qualEnd = frag->size - rightClip;
+	frag->alignStart = frag->qualStart;
+	frag->alignEnd = frag->qualEnd;
+	frag->complement = (record.flag & SAM_FLAG_REVERSE)? 'C': 'U';
+
+	/* A mapping quality of 0 means that the read maps equally well
+	 * elsewhere */
+	frag->numMappings = (record.mapq == 0)? 2: 1;
+	return true;
+}
+
 
 /**
  * Constructor
@@ -36,6 +160,7 @@ extern const int maxPartitionSize;
 ParserThread::ParserThread()
 {
 	isOrderFileLoaded = false;
+	error = false;
 }
 
 
@@ -62,16 +187,15 @@ void ParserThread::run()
 	int contigNum, fragNum, afNum, fileNum, lineCount, lineSize;
 	int numContigs, numFrags, numFragsContig, tmpParsedSize;
 	int fragsInCurrentContig, i;
-	int totalFragSize, avgFragSize;
-	long totalContigSize;
+	qint64 totalContigSize;
 	QString fileName, filesSizeStr, message, orderFile;
 	QHash<QByteArray, int> fragNumMappings;
 	QByteArray line;
-	bool parsedASLine;
+	bool parsedASLine, isContigComplete, isContigOpen;
 	Fragment *frag;
 	Contig *contig;
 	File *fileObject;
-	quint64 parsedSize, totalFileSize;
+	quint64 parsedSize, totalFileSize, fileStartSize, reportedSize;
 	//QHash<QByteArray, int> fragNameOccurenceHash;
 	QString fileBaseName;
 	QList<Fragment *> fragList;
@@ -79,6 +203,20 @@ void ParserThread::run()
 	QByteArray emptyByteArray;
 	int filesSize;
 
+	error = false;
+
+	/* SAM and BAM files are imported together with a FASTA file */
+	foreach (QString str, files)
+	{
+		if (isAlignmentFile(str))
+		{
+			parseAlignments();
+			return;
+		}
+	}
+
+	TRACE_SPAN("parse ACE files");
+
 	/* Initialization */
 	contigNum = 0;
 	fragNum = 0;
@@ -88,19 +226,19 @@ void ParserThread::run()
 	lineCount = 0;
 	tmpParsedSize = 0;
 	parsedSize = Q_UINT64_C(0);
+	reportedSize = Q_UINT64_C(0);
 	totalFileSize = Q_UINT64_C(0);
     QFileInfo fileInfo(files.at(0));
     orderFile = fileInfo.absolutePath() + "/order.txt";
     totalContigSize = 0;
-    totalFragSize = 0;
-    avgFragSize = 0;
+    isContigComplete = false;
+    isContigOpen = false;
     ASLineFormat = "AS %d %d";
     COLineFormat = "CO %s %d %d %*d %*c";
     AFLineFormat = "AF %s %c %d";
     RDLineFormat = "RD %s %d %*d %*d";
     QALineFormat = "QA %d %d %d %d";
     emptyByteArray = "";
-    const int parsedSizeInterval = 5000;
     filesSize = files.size();
     moreContigs = true;
 
@@ -115,7 +253,6 @@ void ParserThread::run()
 	//Database::deleteAll();
 
 	loadedContigsSet.clear();
-	Contig::setNumContigs(0);
 
 	/* Emit signal to indicate file parsing */
 	emit messageChanged("Parsing contig files...");
@@ -129,7 +266,10 @@ void ParserThread::run()
 		/* File I/O */
 		fileName = files.at(i);
 		QFile file(fileName);
-		QTextStream in(&file);
+		GzipReader gzipFile(fileName);
+		const bool isCompressed = GzipReader::isCompressed(fileName);
+		QIODevice *device = isCompressed? (QIODevice *) &gzipFile: (QIODevice *) &file;
+		QTextStream in(device);
 		in.setIntegerBase(10);
 		in.setCodec("UTF-8");
 		fileBaseName = QFileInfo(fileName).baseName();
@@ -155,14 +295,20 @@ void ParserThread::run()
 		//QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 
 		/* Try opening the file */
-		if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+		if (!device->open(QIODevice::ReadOnly | QIODevice::Text))
 		{
 			qCritical() << tr("Cannot read file %1:\n%2.")
-					.arg(file.fileName())
-					.arg(file.errorString());
+					.arg(fileName)
+					.arg(device->errorString());
+			error = true;
+			finishParsing(contigNum, totalContigSize);
 			return;
 		}
 
+		/* Progress through a compressed file is measured in compressed
+		 * bytes, which is what totalSize counts */
+		fileStartSize = parsedSize;
+
 		/* Get each line from the input file */
 		while(!in.atEnd())
 		{
@@ -185,6 +331,14 @@ void ParserThread::run()
 							&refSize,
 							&numFragsContig) == 3)
 			{
+				/* The previous contig had no QA line after its last read */
+				if (isContigComplete)
+				{
+					closeContig(contig, fragList);
+					isContigComplete = false;
+					isContigOpen = false;
+				}
+
 				contigNum++;
 				contigIndex++;
 				fragsInCurrentContig = 0;
@@ -193,6 +347,7 @@ void ParserThread::run()
 
 				contig = new Contig;
 				fileObject = new File(fileNum, fileBaseName, fileName);
+				isContigOpen = true;
 
 				/* Store id, name, size, and number of reads for this contig */
 				contig->id = contigNum;
@@ -230,15 +385,18 @@ void ParserThread::run()
 					lineSize = line.size();
 					parsedSize += lineSize;
 					tmpParsedSize += lineSize;
-					if (tmpParsedSize >= parsedSizeInterval)
+					if (tmpParsedSize >= PARSED_SIZE_INTERVAL)
 					{
 						tmpParsedSize = 0;
-						emit parsingProgress(parsedSize / BYTE_TO_MBYTE);
+						if (isCompressed)
+							parsedSize = fileStartSize + gzipFile.getCompressedPos();
+						emit parsingProgress((int) (parsedSize / BYTE_TO_MBYTE));
 						//QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 					}
 				}
 				contigFlag = 0;
 				totalContigSize += contig->size;
+				analyzer.begin(contig);
 			}
 			/* Get name, complement status, and mapped position of each read */
 			else if (sscanf(line, AFLineFormat, fragName, &complement, &startPos) == 3)
@@ -285,12 +443,17 @@ void ParserThread::run()
 					if (strcmp(frag->name, fragName) != 0)
 					{
 						qCritical() << tr("Reads in AF section are in a different order than in RD section.\n");
+						device->close();
+						totalContigSize -= contig->size;
+						--contigNum;
+						discardContig(contig, fragList);
+						error = true;
+						finishParsing(contigNum, totalContigSize);
 						return;
 					}
 
 					/* Store fragment length in array */
 					frag->size = fragLength;
-					totalFragSize += frag->size;
 					frag->seq.reserve(frag->size);
 					frag->endPos = frag->startPos + frag->size - 1;
 
@@ -304,30 +467,16 @@ void ParserThread::run()
 					parsedSize += frag->size;
 					tmpParsedSize += frag->size;
 
-					fragMutex.lock();
-					if (fragQueue.size() >= fragQueueSizeMax)
-						fragQueueNotFull.wait(&fragMutex);
-					fragQueue.enqueue(frag);
-					fragQueueNotEmpty.wakeAll();
-					fragMutex.unlock();
+					/* Add the read to the pileup, coverage and layout
+					 * state of the contig while it is still in memory */
+					analyzer.addRead(frag);
 
 					/* If all fragments belonging to the current contig
-					 * have been parsed */
+					 * have been parsed, the contig is closed once the
+					 * QA line of its last read has been read */
 					if (contig->numberReads == fragsInCurrentContig)
 					{
-						//qDebug() << "Last leg of parsing contig " << contig->id;
-						/* Calculate contig coverage */
-						contig->coverage = ((float) totalFragSize) / contig->size;
-
-						/* Calculate average fragment size */
-						avgFragSize = (int) ceil(((float) totalFragSize) / contig->numberReads);
-
-						//contigSaverThread.addContig(contig);
-						contigMutex.lock();
-						contigQueue.append(contig);
-						contigQueueNotEmpty.wakeAll();
-						contigMutex.unlock();
-
+						isContigComplete = true;
 						fragIndex = -1;
 						fragIndex2 = -1;
 					}
@@ -340,6 +489,13 @@ void ParserThread::run()
 				frag->qualEnd = qualEnd;
 				frag->alignStart = alignStart;
 				frag->alignEnd = alignEnd;
+
+				if (isContigComplete)
+				{
+					closeContig(contig, fragList);
+					isContigComplete = false;
+					isContigOpen = false;
+				}
 			}
 			/* When any blank line is detected, stop sequence collection */
 			else if (line.isEmpty())
@@ -347,28 +503,51 @@ void ParserThread::run()
 
 			}
 
-			if (tmpParsedSize >= parsedSizeInterval)
+			if (tmpParsedSize >= PARSED_SIZE_INTERVAL)
 			{
+				if (isCompressed)
+					parsedSize = fileStartSize + gzipFile.getCompressedPos();
+				PerfMetrics::add(PerfMetrics::BytesParsed, parsedSize - reportedSize);
+				reportedSize = parsedSize;
 				tmpParsedSize = 0;
-				emit parsingProgress(parsedSize / BYTE_TO_MBYTE);
+				TRACE_COUNTER("bytesParsed", (qint64) parsedSize);
+				emit parsingProgress((int) (parsedSize / BYTE_TO_MBYTE));
 				//QApplication::processEvents(QEventLoop::ExcludeUserInputEvents);
 			}
 		} /* end while */
-		file.close();
-		fileNum++;
-	} /* end for */
 
-	contigMutex.lock();
-	moreContigs = false;
-	contigQueueNotEmpty.wakeAll();
-	contigMutex.unlock();
+		/* A truncated or corrupt compressed file ends early, like an
+		 * ordinary end of file. The reads of the contig being parsed are
+		 * discarded; the contigs before it have already been queued. */
+		if (isCompressed && gzipFile.hasError())
+		{
+			qCritical() << tr("Cannot read file %1:\nThe file is truncated or corrupt.")
+					.arg(fileName);
+			device->close();
+			if (isContigOpen)
+			{
+				totalContigSize -= contig->size;
+				--contigNum;
+				discardContig(contig, fragList);
+			}
+			error = true;
+			finishParsing(contigNum, totalContigSize);
+			return;
+		}
 
-	fragMutex.lock();
-	fragQueue.append(NULL);
-	fragQueueNotEmpty.wakeAll();
-	fragMutex.unlock();
+		if (isContigComplete)
+		{
+			closeContig(contig, fragList);
+			isContigComplete = false;
+			isContigOpen = false;
+		}
+		device->close();
+		if (isCompressed)
+			parsedSize = fileStartSize + QFileInfo(fileName).size();
+		fileNum++;
+	} /* end for */
 
-    Contig::setTotalSize(totalContigSize);
+	finishParsing(contigNum, totalContigSize);
 
    //emit parsingFinished();
 
@@ -378,8 +557,326 @@ void ParserThread::run()
 		qCritical() << tr("No contigs found in selected file(s).");
 		return;
 	}
-	Contig::setNumContigs(contigNum);
 
 	//qDebug() << "ParserThread end***";
 }
 
+
+
+/**
+ * Sets the maximum number of parsed reads that may wait for the
+ * fragment saver thread. This bounds the memory used by the save queue
+ * only; the reads of the contig being parsed are held until the contig
+ * is complete, however many there are.
+ *
+ * @param n : Maximum number of queued reads
+ */
+void ParserThread::setMaxQueuedReads(const int n)
+{
+	maxQueuedReads = (n < 1)? 1: n;
+}
+
+
+/*
+ * Finishes the analysis of the given contig and hands the contig and
+ * its reads over to the saver threads. The reads are queued only now
+ * because their y-positions are known only after the whole contig
+ * has been parsed.
+ *
+ * @param contig : Contig whose reads have all been parsed
+ * @param fragList : Reads belonging to the contig
+ */
+void ParserThread::closeContig(Contig *contig, QList<Fragment *> &fragList)
+{
+	Fragment *frag;
+	int queueSize = 0;
+
+	TRACE_SPAN("close contig");
+	{
+		TRACE_SPAN("analyze contig");
+		analyzer.finish(fragList);
+	}
+
+	foreach (frag, fragList)
+	{
+		fragMutex.lock();
+		if (fragQueue.size() >= maxQueuedReads)
+		{
+			TRACE_SPAN("wait fragQueueNotFull");
+			fragQueueNotFull.wait(&fragMutex);
+		}
+		fragQueue.enqueue(frag);
+		queueSize = fragQueue.size();
+		fragQueueNotEmpty.wakeAll();
+		fragMutex.unlock();
+	}
+	TRACE_COUNTER("fragQueue", queueSize);
+	fragList.clear();
+
+	contigMutex.lock();
+	contigQueue.append(contig);
+	TRACE_COUNTER("contigQueue", contigQueue.size());
+	contigQueueNotEmpty.wakeAll();
+	contigMutex.unlock();
+}
+
+
+/*
+ * Imports the SAM and BAM files in the file list. Each reference that
+ * has alignments becomes a contig whose sequence is read from the FASTA
+ * file in the list, and each alignment becomes a read, so the contigs
+ * and reads go through the same analysis and saver threads as those of
+ * ACE files. The alignments must be sorted by coordinate, and each
+ * reference may only have alignments in one of the files; the import
+ * stops with an error otherwise. Progress is counted in bytes of the
+ * (compressed) alignment files.
+ */
+void ParserThread::parseAlignments()
+{
+	SamReader reader;
+	SamReader::Record record;
+	FastaReader fasta;
+	QStringList alignmentFiles;
+	QString fastaFile, fileName, fileBaseName, message;
+	QList<Fragment *> fragList;
+	QByteArray refName;
+	Contig *contig;
+	Fragment *frag;
+	qint64 totalContigSize, totalFileSize, parsedSize, filePos, lastFilePos;
+	int contigNum, fragNum, fileNum, refId, lastPos, numSkipped, i;
+	bool hasError;
+
+	TRACE_SPAN("parse alignment files");
+
+	contigNum = 0;
+	fragNum = 0;
+	fileNum = 1;
+	numSkipped = 0;
+	totalContigSize = 0;
+	totalFileSize = 0;
+	parsedSize = 0;
+	contig = NULL;
+	hasError = false;
+	moreContigs = true;
+
+	foreach (QString str, files)
+	{
+		if (isAlignmentFile(str))
+		{
+			alignmentFiles.append(str);
+			totalFileSize += QFileInfo(str).size();
+		}
+		else if (isFastaFile(str))
+			fastaFile = str;
+	}
+	emit totalSize((int) ((qreal) totalFileSize / BYTE_TO_MBYTE));
+
+	loadedContigsSet.clear();
+
+	emit messageChanged("Parsing alignment files...");
+	emit cleanWidgets();
+	emit parsingStarted();
+
+	if (fastaFile.isEmpty())
+	{
+		qCritical() << tr("SAM and BAM files must be opened together with a "
+				"FASTA file containing the reference sequences.");
+		error = true;
+		finishParsing(0, 0);
+		return;
+	}
+	if (!fasta.open(fastaFile))
+	{
+		error = true;
+		finishParsing(0, 0);
+		return;
+	}
+
+	for (i = 0; i < alignmentFiles.size() && !hasError; ++i)
+	{
+		fileName = alignmentFiles.at(i);
+		fileBaseName = QFileInfo(fileName).baseName();
+		message = "Parsing alignment file "
+			+ QString::number(i + 1)
+			+ " of " + QString::number(alignmentFiles.size()) + "..."
+			+ "\n(File: " + fileBaseName + ")";
+		emit messageChanged(message);
+		qDebug() << message;
+
+		if (!reader.open(fileName))
+		{
+			hasError = true;
+			break;
+		}
+		refId = -1;
+		lastPos = 0;
+		lastFilePos = 0;
+
+		while (reader.next(record))
+		{
+			filePos = reader.getCompressedPos();
+			if (filePos - lastFilePos >= PARSED_SIZE_INTERVAL)
+			{
+				PerfMetrics::add(PerfMetrics::BytesParsed, filePos - lastFilePos);
+				lastFilePos = filePos;
+				TRACE_COUNTER("bytesParsed", parsedSize + filePos);
+				emit parsingProgress((int) ((parsedSize + filePos) / BYTE_TO_MBYTE));
+			}
+
+			if (record.refId < 0)
+				continue;
+			if (record.refId < refId || (record.refId == refId && record.pos < lastPos))
+			{
+				qCritical() << tr("%1 is not sorted by coordinate.").arg(fileName);
+				hasError = true;
+				break;
+			}
+			if (record.flag & (SAM_FLAG_UNMAPPED | SAM_FLAG_SECONDARY | SAM_FLAG_SUPPLEMENTARY))
+				continue;
+
+			frag = new Fragment();
+			if (!toFragment(record, frag))
+			{
+				delete frag;
+				++numSkipped;
+				continue;
+			}
+
+			/* Start a contig at the first alignment to each reference */
+			if (record.refId != refId)
+			{
+				if (contig != NULL)
+					closeContig(contig, fragList);
+
+				refId = record.refId;
+				refName = reader.getReferenceName(refId);
+
+				/* The reads of each file are saved as soon as a reference
+				 * is complete, so a reference that already got its reads
+				 * from an earlier file cannot be extended any more */
+				if (loadedContigsSet.contains(refName))
+				{
+					qCritical() << tr("%1 has alignments to %2, which already has "
+							"alignments in an earlier file. Merge the files, e.g. "
+							"with 'samtools merge', before opening them.")
+							.arg(fileName).arg(QString(refName));
+					delete frag;
+					contig = NULL;
+					hasError = true;
+					break;
+				}
+				contig = new Contig;
+				if (!fasta.readSequence(refName, contig->seq)
+						|| contig->seq.size() != reader.getReferenceLength(refId))
+				{
+					qCritical() << tr("Reference %1 is missing from %2 or has a "
+							"different length.").arg(QString(refName)).arg(fastaFile);
+					delete contig;
+					delete frag;
+					contig = NULL;
+					hasError = true;
+					break;
+				}
+
+				contigNum++;
+				contig->id = contigNum;
+				contig->name = refName;
+				loadedContigsSet.insert(contig->name);
+				contig->size = contig->seq.size();
+				contig->numberReads = 0;
+				contig->order = contigNum;
+				contig->readStartIndex = fragNum + 1;
+				contig->readEndIndex = fragNum;
+				contig->zoomLevels = (int) log((double) contig->size);
+				contig->fileId = fileNum;
+				contig->file = new File(fileNum, fileBaseName, fileName);
+				Contig::orderMap[contig->order] = contig->id;
+				totalContigSize += contig->size;
+				analyzer.begin(contig);
+			}
+			lastPos = record.pos;
+
+			fragNum++;
+			frag->id = fragNum;
+			frag->contigNumber = contigNum;
+			frag->yPos = -1;
+			fragList.append(frag);
+			contig->numberReads++;
+			contig->readEndIndex++;
+			analyzer.addRead(frag);
+		}
+		if (reader.hasError())
+		{
+			qCritical() << tr("Malformed alignment record in %1, or the file is "
+					"truncated or corrupt.").arg(fileName);
+			hasError = true;
+		}
+
+		/* A reference whose alignments were cut short by an error is not
+		 * saved as if it were complete */
+		if (contig != NULL && hasError)
+		{
+			totalContigSize -= contig->size;
+			--contigNum;
+			discardContig(contig, fragList);
+			contig = NULL;
+		}
+		else if (contig != NULL)
+		{
+			closeContig(contig, fragList);
+			contig = NULL;
+		}
+
+		PerfMetrics::add(PerfMetrics::BytesParsed, QFileInfo(fileName).size() - lastFilePos);
+		parsedSize += QFileInfo(fileName).size();
+		emit parsingProgress((int) (parsedSize / BYTE_TO_MBYTE));
+		reader.close();
+		fileNum++;
+	}
+
+	if (numSkipped > 0)
+		qDebug() << numSkipped << " alignments without aligned bases were skipped";
+	error = hasError;
+	finishParsing(contigNum, totalContigSize);
+	if (contigNum == 0 && !hasError)
+		qCritical() << tr("No aligned reads found in selected file(s).");
+}
+
+
+/*
+ * Deletes a contig whose reads were cut short by an error, along with
+ * its reads, instead of handing it over to the saver threads
+ *
+ * @param contig : Contig that has not been closed
+ * @param fragList : Reads belonging to the contig
+ */
+void ParserThread::discardContig(Contig *contig, QList<Fragment *> &fragList)
+{
+	qDeleteAll(fragList);
+	fragList.clear();
+	Contig::orderMap.remove(contig->order);
+	loadedContigsSet.remove(contig->name);
+	delete contig;
+}
+
+
+/*
+ * Tells the saver threads that no more contigs and reads will be
+ * queued, and reports the number and total size of the parsed contigs.
+ * The totals are delivered to the GUI thread, which owns the static
+ * contig counts.
+ */
+void ParserThread::finishParsing(const int numContigs, const qint64 totalContigSize)
+{
+	contigMutex.lock();
+	moreContigs = false;
+	contigQueueNotEmpty.wakeAll();
+	contigMutex.unlock();
+
+	fragMutex.lock();
+	fragQueue.append(NULL);
+	fragQueueNotEmpty.wakeAll();
+	fragMutex.unlock();
+
+	emit totalsParsed(numContigs, totalContigSize);
+}
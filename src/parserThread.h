@@ -6,6 +6,7 @@
 #include <QHash>
 #include <QSet>
 #include <QStringList>
+#include "contigAnalyzer.h"
 
 class ParserThread : public QThread
 {
@@ -15,6 +16,14 @@ public:
 	ParserThread();
 	~ParserThread();
 	inline void setFileList(const QStringList &fileList) { files = fileList; }
+	static void setMaxQueuedReads(const int);
+
+	/** Returns the maximum number of parsed reads waiting to be saved */
+	inline static int getMaxQueuedReads() { return maxQueuedReads; };
+
+	/** Returns whether the last parse stopped on an error; only valid
+	 * once the thread has finished */
+	inline bool hasError() const { return error; };
 
     signals:
     void messageChanged(const QString &);
@@ -26,6 +35,7 @@ public:
     void fileSize(int);
     void totalSize(int);
     void parsedSize(int);
+    void totalsParsed(int, qint64);
 
 protected:
 	void run();
@@ -36,8 +46,15 @@ private:
 	int numberOfContigs;
 	bool isOrderFileLoaded;
 	bool hasContigMismatch;
+	bool error;					/* Whether the last parse stopped on an error */
 	QSet<QString> loadedContigsSet;
+	ContigAnalyzer analyzer;
+	static int maxQueuedReads;	/* Maximum number of reads waiting for the fragment saver */
 
 	bool readAce(const QStringList &files, const int filesSize);
+	void parseAlignments();
+	void closeContig(Contig *, QList<Fragment *> &);
+	void discardContig(Contig *, QList<Fragment *> &);
+	void finishParsing(const int, const qint64);
 };
 #endif /* PARSERTHREAD_H_ */
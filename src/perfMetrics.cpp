@@ -0,0 +1,128 @@
+#include "perfMetrics.h"
+#include <QMutexLocker>
+
+#define	FRAME_BUDGET_MS		33			/* Frames slower than this drop below 30 per second */
+#define	NSEC_TO_MSEC		1000000
+
+/* Upper limits of the query latency buckets in milliseconds; the last
+ * bucket has no limit */
+static const int latencyBucketLimits[] = {1, 4, 16, 64, 256};
+static const int numLatencyBuckets =
+	sizeof(latencyBucketLimits) / sizeof(latencyBucketLimits[0]) + 1;
+
+
+/*
+ * Static member definitions
+ */
+QMutex PerfMetrics::mutex;
+qint64 PerfMetrics::numFrames = 0;
+qint64 PerfMetrics::numSlowFrames = 0;
+qint64 PerfMetrics::totalFrameTime = 0;
+qint64 PerfMetrics::lastFrameTime = 0;
+qint64 PerfMetrics::numQueries = 0;
+qint64 PerfMetrics::totalQueryTime = 0;
+QVector<qint64> PerfMetrics::queryHistogram(numLatencyBuckets, 0);
+QVector<qint64> PerfMetrics::counters(PerfMetrics::NumCounters, 0);
+
+
+/**
+ * Records the time taken to paint one frame
+ *
+ * @param nsecs : Paint time in nanoseconds
+ */
+void PerfMetrics::recordFrame(const qint64 nsecs)
+{
+	QMutexLocker locker(&mutex);
+
+	++numFrames;
+	totalFrameTime += nsecs;
+	lastFrameTime = nsecs;
+	if (nsecs > (qint64) FRAME_BUDGET_MS * NSEC_TO_MSEC)
+		++numSlowFrames;
+}
+
+
+/**
+ * Records the time taken by one DB query
+ *
+ * @param nsecs : Query time in nanoseconds
+ */
+void PerfMetrics::recordQuery(const qint64 nsecs)
+{
+	QMutexLocker locker(&mutex);
+	int i;
+
+	for (i = 0; i < numLatencyBuckets - 1; ++i)
+	{
+		if (nsecs < (qint64) latencyBucketLimits[i] * NSEC_TO_MSEC)
+			break;
+	}
+	++queryHistogram[i];
+	++numQueries;
+	totalQueryTime += nsecs;
+}
+
+
+/**
+ * Adds to one of the import counters
+ *
+ * @param counter : Counter
+ * @param n : Amount to add
+ */
+void PerfMetrics::add(const Counter counter, const qint64 n)
+{
+	QMutexLocker locker(&mutex);
+
+	counters[counter] += n;
+}
+
+
+/**
+ * Copies the current values of all the counters
+ *
+ * @param snapshot : Receives the values
+ */
+void PerfMetrics::getSnapshot(Snapshot &snapshot)
+{
+	QMutexLocker locker(&mutex);
+
+	snapshot.numFrames = numFrames;
+	snapshot.numSlowFrames = numSlowFrames;
+	snapshot.totalFrameTime = totalFrameTime;
+	snapshot.lastFrameTime = lastFrameTime;
+	snapshot.numQueries = numQueries;
+	snapshot.totalQueryTime = totalQueryTime;
+	snapshot.queryHistogram = queryHistogram;
+	snapshot.counters = counters;
+}
+
+
+/**
+ * Returns the number of query latency buckets
+ */
+int PerfMetrics::getNumLatencyBuckets()
+{
+	return numLatencyBuckets;
+}
+
+
+/**
+ * Returns the upper limit of the given query latency bucket in
+ * milliseconds, or -1 for the last bucket, which has no limit
+ */
+int PerfMetrics::getLatencyBucketLimit(const int bucket)
+{
+	if (bucket < 0 || bucket >= numLatencyBuckets - 1)
+		return -1;
+	return latencyBucketLimits[bucket];
+}
+
+
+/**
+ * Returns the paint time in milliseconds above which a frame is counted
+ * as slow
+ */
+int PerfMetrics::getFrameBudget()
+{
+	return FRAME_BUDGET_MS;
+}
@@ -0,0 +1,51 @@
+#ifndef PERFMETRICS_H_
+#define PERFMETRICS_H_
+
+#include <QMutex>
+#include <QVector>
+
+/*
+ * Performance counters fed by the views, the DB code and the import
+ * threads, and shown by the performance monitor. All methods are thread
+ * safe.
+ */
+class PerfMetrics
+{
+public:
+	/** Running totals of the import */
+	enum Counter {BytesParsed, ContigsSaved, ReadsSaved, NumCounters};
+
+	/** Values of all the counters at one moment */
+	struct Snapshot
+	{
+		qint64 numFrames;			/* Frames painted by Base View */
+		qint64 numSlowFrames;		/* Frames that took longer than the frame budget */
+		qint64 totalFrameTime;		/* Nanoseconds spent painting all the frames */
+		qint64 lastFrameTime;		/* Nanoseconds spent painting the last frame */
+		qint64 numQueries;			/* DB queries timed */
+		qint64 totalQueryTime;		/* Nanoseconds spent in all the timed queries */
+		QVector<qint64> queryHistogram;	/* Number of queries in each latency bucket */
+		QVector<qint64> counters;	/* Value of each Counter */
+	};
+
+	static void recordFrame(const qint64);
+	static void recordQuery(const qint64);
+	static void add(const Counter, const qint64);
+	static void getSnapshot(Snapshot &);
+	static int getNumLatencyBuckets();
+	static int getLatencyBucketLimit(const int);
+	static int getFrameBudget();
+
+private:
+	static QMutex mutex;
+	static qint64 numFrames;
+	static qint64 numSlowFrames;
+	static qint64 totalFrameTime;
+	static qint64 lastFrameTime;
+	static qint64 numQueries;
+	static qint64 totalQueryTime;
+	static QVector<qint64> queryHistogram;
+	static QVector<qint64> counters;
+};
+
+#endif /* PERFMETRICS_H_ */
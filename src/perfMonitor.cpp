@@ -0,0 +1,164 @@
+
+#include "perfMonitor.h"
+#include "maparea.h"
+#include "contigList.h"
+
+#define	REFRESH_INTERVAL	1000		/* In milliseconds */
+#define	BYTE_TO_MBYTE		1048576.0
+#define	NSEC_TO_MSEC		1000000.0
+
+
+/**
+ * Constructor
+ *
+ * @param mapArea : Base View, whose contig cache is monitored
+ * @param parent : Parent widget
+ */
+PerfMonitor::PerfMonitor(MapArea *mapArea, QWidget *parent)
+	: QWidget(parent)
+{
+	this->mapArea = mapArea;
+
+	label = new QLabel;
+	label->setTextFormat(Qt::RichText);
+	label->setAlignment(Qt::AlignTop | Qt::AlignLeft);
+	label->setTextInteractionFlags(Qt::TextSelectableByMouse);
+	layout = new QVBoxLayout;
+	layout->addWidget(label);
+	layout->addStretch(1);
+	setLayout(layout);
+
+	QString tmp = tr("<b>Performance Monitor</b> shows how long Base View "
+			"takes to paint, how long DB queries take, how well the contig "
+			"cache works, how much memory loaded contigs use and how fast "
+			"files are imported. Rates are per second over the last refresh.");
+	setWhatsThis(tmp);
+
+	PerfMetrics::getSnapshot(lastSnapshot);
+	timer.setInterval(REFRESH_INTERVAL);
+	connect(&timer, SIGNAL(timeout()), this, SLOT(refresh()));
+}
+
+
+/**
+ * Destructor
+ */
+PerfMonitor::~PerfMonitor()
+{
+	delete label;
+	delete layout;
+	mapArea = NULL;
+}
+
+
+/**
+ * Starts refreshing when the panel is shown
+ */
+void PerfMonitor::showEvent(QShowEvent *event)
+{
+	PerfMetrics::getSnapshot(lastSnapshot);
+	intervalTimer.start();
+	refresh();
+	timer.start();
+	QWidget::showEvent(event);
+}
+
+
+/**
+ * Stops refreshing when the panel is hidden
+ */
+void PerfMonitor::hideEvent(QHideEvent *event)
+{
+	timer.stop();
+	QWidget::hideEvent(event);
+}
+
+
+/*
+ * Updates the panel from the current counters
+ */
+void PerfMonitor::refresh()
+{
+	PerfMetrics::Snapshot snapshot;
+	ContigList *contigList;
+	QString str, row;
+	qint64 numFrames, numQueries, fragBytes, seqBytes, annotBytes, totalBytes;
+	qint64 numHits, numRequests;
+	qreal seconds;
+	int i, limit;
+
+	PerfMetrics::getSnapshot(snapshot);
+	seconds = qMax((qint64) 1, intervalTimer.restart()) / 1000.0;
+	row = "<tr><td>%1</td><td align=\"right\">%2</td></tr>";
+
+	/* Painting */
+	numFrames = snapshot.numFrames - lastSnapshot.numFrames;
+	str = "<table cellspacing=\"2\">";
+	str += "<tr><td colspan=\"2\"><b>Base View painting</b></td></tr>";
+	str += row.arg(tr("Last frame")).arg(
+			tr("%1 ms").arg(snapshot.lastFrameTime / NSEC_TO_MSEC, 0, 'f', 1));
+	str += row.arg(tr("Mean frame")).arg((numFrames > 0)?
+			tr("%1 ms").arg((snapshot.totalFrameTime - lastSnapshot.totalFrameTime)
+					/ NSEC_TO_MSEC / numFrames, 0, 'f', 1): QString("-"));
+	str += row.arg(tr("Frames per second")).arg(numFrames / seconds, 0, 'f', 1);
+	str += row.arg(tr("Frames over %1 ms").arg(PerfMetrics::getFrameBudget()))
+		.arg(tr("%L1 (%L2 total)")
+			.arg(snapshot.numSlowFrames - lastSnapshot.numSlowFrames)
+			.arg(snapshot.numSlowFrames));
+
+	/* DB query latency; the histogram covers the whole session */
+	numQueries = snapshot.numQueries - lastSnapshot.numQueries;
+	str += "<tr><td colspan=\"2\"><b>DB queries</b></td></tr>";
+	str += row.arg(tr("Queries per second")).arg(numQueries / seconds, 0, 'f', 1);
+	str += row.arg(tr("Mean latency")).arg((snapshot.numQueries > 0)?
+			tr("%1 ms").arg(snapshot.totalQueryTime / NSEC_TO_MSEC
+					/ snapshot.numQueries, 0, 'f', 1): QString("-"));
+	for (i = 0; i < PerfMetrics::getNumLatencyBuckets(); ++i)
+	{
+		limit = PerfMetrics::getLatencyBucketLimit(i);
+		str += row.arg((limit < 0)?
+				tr("&ge; %1 ms").arg(PerfMetrics::getLatencyBucketLimit(i - 1)):
+				tr("&lt; %1 ms").arg(limit))
+			.arg(tr("%L1").arg(snapshot.queryHistogram.at(i)));
+	}
+
+	/* Contig cache and memory */
+	contigList = mapArea->getContigList();
+	numHits = contigList->getNumCacheHits() + contigList->getNumPrefetchHits();
+	numRequests = numHits + contigList->getNumCacheMisses();
+	contigList->getCacheMemoryUsage(fragBytes, seqBytes, annotBytes, totalBytes);
+	str += "<tr><td colspan=\"2\"><b>Contig cache</b></td></tr>";
+	str += row.arg(tr("Hit rate")).arg((numRequests > 0)?
+			tr("%1% of %L2").arg(100.0 * numHits / numRequests, 0, 'f', 1)
+				.arg(numRequests): QString("-"));
+	str += row.arg(tr("Served by prefetcher"))
+		.arg(tr("%L1").arg(contigList->getNumPrefetchHits()));
+	str += row.arg(tr("Evictions")).arg(tr("%L1").arg(contigList->getNumEvictions()));
+	str += row.arg(tr("Reads")).arg(tr("%1 MB").arg(fragBytes / BYTE_TO_MBYTE, 0, 'f', 1));
+	str += row.arg(tr("Sequences")).arg(tr("%1 MB").arg(seqBytes / BYTE_TO_MBYTE, 0, 'f', 1));
+	str += row.arg(tr("Annotations")).arg(tr("%1 MB").arg(annotBytes / BYTE_TO_MBYTE, 0, 'f', 1));
+	str += row.arg(tr("Total / budget")).arg(tr("%1 / %2 MB")
+			.arg(totalBytes / BYTE_TO_MBYTE, 0, 'f', 1)
+			.arg(contigList->getMemoryBudget()));
+
+	/* Import throughput */
+	str += "<tr><td colspan=\"2\"><b>Import</b></td></tr>";
+	str += row.arg(tr("Parsed")).arg(tr("%1 MB/s").arg(
+			(snapshot.counters.at(PerfMetrics::BytesParsed)
+				- lastSnapshot.counters.at(PerfMetrics::BytesParsed))
+			/ BYTE_TO_MBYTE / seconds, 0, 'f', 1));
+	str += row.arg(tr("Contigs saved")).arg(tr("%1/s").arg(
+			(snapshot.counters.at(PerfMetrics::ContigsSaved)
+				- lastSnapshot.counters.at(PerfMetrics::ContigsSaved))
+			/ seconds, 0, 'f', 1));
+	str += row.arg(tr("Reads saved")).arg(tr("%1/s").arg(
+			(snapshot.counters.at(PerfMetrics::ReadsSaved)
+				- lastSnapshot.counters.at(PerfMetrics::ReadsSaved))
+			/ seconds, 0, 'f', 0));
+	str += row.arg(tr("Total parsed")).arg(tr("%1 MB").arg(
+			snapshot.counters.at(PerfMetrics::BytesParsed) / BYTE_TO_MBYTE, 0, 'f', 1));
+	str += "</table>";
+
+	label->setText(str);
+	lastSnapshot = snapshot;
+}
@@ -0,0 +1,35 @@
+#ifndef PERFMONITOR_H_
+#define PERFMONITOR_H_
+
+#include <QtGui>
+#include <QWidget>
+#include <QElapsedTimer>
+#include "perfMetrics.h"
+
+class MapArea;
+
+class PerfMonitor : public QWidget
+{
+	Q_OBJECT
+
+public:
+	PerfMonitor(MapArea *, QWidget *parent = 0);
+	~PerfMonitor();
+
+protected:
+	void showEvent(QShowEvent *);
+	void hideEvent(QHideEvent *);
+
+private:
+	MapArea *mapArea;
+	QLabel *label;
+	QVBoxLayout *layout;
+	QTimer timer;						/* Refreshes the panel while it is shown */
+	QElapsedTimer intervalTimer;		/* Time since the last refresh */
+	PerfMetrics::Snapshot lastSnapshot;	/* Counters at the last refresh */
+
+	private slots:
+	void refresh();
+};
+
+#endif /* PERFMONITOR_H_ */
@@ -100,9 +100,10 @@ void ReadsNavWidget::goToFirstRead()
 	str = "select startPos, yPos "
 			" from fragment "
 			" where contig_id = " + QString::number(contig->id) +
+			" and yPos >= 0 "
 			" order by startPos asc "
 			" limit 1 ";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this->parentWidget(),
@@ -138,10 +139,11 @@ void ReadsNavWidget::goToPrevRead()
 	str = "select startPos, yPos "
 			" from fragment "
 			" where contig_id = " + QString::number(contig->id) + ""
+			" and yPos >= 0 "
 			" and startPos < " + QString::number(Contig::startPos) + ""
 			" order by startPos desc "
 			" limit 1 ";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this->parentWidget(),
@@ -179,10 +181,11 @@ void ReadsNavWidget::goToNextRead()
 	str = "select startPos, yPos "
 			" from fragment "
 			" where contig_id = " + QString::number(contig->id) +
+			" and yPos >= 0 "
 			" and startPos > " + QString::number(Contig::startPos+1) +
 			" order by startPos asc "
 			" limit 1 ";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this->parentWidget(),
@@ -220,9 +223,10 @@ void ReadsNavWidget::goToLastRead()
 	str = "select startPos, yPos "
 			" from fragment "
 			" where contig_id = " + QString::number(contig->id) +
+			" and yPos >= 0 "
 			" order by startPos desc "
 			" limit 1";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this,
@@ -0,0 +1,350 @@
+
+#include "regionExporterThread.h"
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QFileInfo>
+#include <QtDebug>
+#include "database.h"
+#include "trace.h"
+
+#define	WRITE_BUFFER_SIZE		4194304		/* Bytes buffered before they are written */
+#define	SEQ_LINE_LENGTH			50			/* Bases per sequence line */
+#define	QUAL_LINE_LENGTH		50			/* Values per base quality line */
+#define	BASE_QUALITY			"20"		/* The DB does not keep base qualities */
+#define	PROGRESS_INTERVAL		100000		/* Reads between progress messages */
+
+
+/**
+ * Constructor
+ */
+RegionExporterThread::RegionExporterThread()
+	: contigConnectionName(QString(this->metaObject()->className()) + "Contig"),
+	  fragConnectionName(QString(this->metaObject()->className()) + "Frag")
+{
+	contigId = 0;
+	startPos = 0;
+	endPos = 0;
+	hasWriteError = false;
+	isCanceled = false;
+}
+
+
+/**
+ * Destructor
+ */
+RegionExporterThread::~RegionExporterThread()
+{
+	cancel();
+	wait();
+}
+
+
+/**
+ * Sets the region to be exported by the next run
+ *
+ * @param id : ID of the contig
+ * @param start : First padded position of the window, 1-based
+ * @param end : Last padded position of the window, 1-based
+ * @param name : Name of the output ACE file
+ */
+void RegionExporterThread::setRegion(
+		const int id,
+		const int start,
+		const int end,
+		const QString &name)
+{
+	contigId = id;
+	startPos = start;
+	endPos = end;
+	fileName = name;
+}
+
+
+/**
+ * Asks a running export to stop. The partially written file is removed.
+ */
+void RegionExporterThread::cancel()
+{
+	isCanceled = true;
+}
+
+
+/**
+ * Implements the run method
+ */
+void RegionExporterThread::run()
+{
+	bool ok, wasOpened;
+
+	isCanceled = false;
+	hasWriteError = false;
+	buffer.clear();
+	file.setFileName(fileName);
+	{
+		TRACE_SPAN("export region");
+		QSqlDatabase contigDb =
+			Database::createConnection(
+				contigConnectionName,
+				Database::getContigDBName());
+		QSqlDatabase fragDb =
+			Database::createConnection(
+				fragConnectionName,
+				Database::getFragDBName());
+
+		ok = exportRegion(contigDb, fragDb);
+
+		contigDb.close();
+		fragDb.close();
+	}
+	QSqlDatabase::removeDatabase(contigConnectionName);
+	QSqlDatabase::removeDatabase(fragConnectionName);
+
+	wasOpened = file.isOpen();
+	if (wasOpened)
+		file.close();
+	buffer.clear();
+	if (ok)
+		emit messageChanged(tr("Region exported to %1").arg(fileName));
+	else if (wasOpened)
+		file.remove();
+}
+
+
+/*
+ * Writes the contig window and its reads to the output file
+ *
+ * @return Returns true on success and false on failure or cancellation
+ */
+bool RegionExporterThread::exportRegion(QSqlDatabase &contigDb, QSqlDatabase &fragDb)
+{
+	QSqlQuery query(contigDb);
+	QSqlQuery fragQuery(fragDb);
+	QString str, rangeStr, orderStr;
+	QByteArray contigName, seq, line;
+	int contigSize, maxReadSize, numReads, numBases, i, n;
+
+	/* Contig name, size and longest read */
+	str = "select name, size, maxReadSize "
+			" from contig "
+			" where id = " + QString::number(contigId);
+	if (!DB_EXEC(query, str) || !query.next())
+	{
+		qCritical() << "Error fetching contig" << contigId << "for export:"
+			<< query.lastError().text();
+		emit messageChanged(tr("Error exporting region"));
+		return false;
+	}
+	contigName = query.value(0).toByteArray();
+	contigSize = query.value(1).toInt();
+	maxReadSize = query.value(2).toInt();
+	query.finish();
+
+	if (startPos < 1)
+		startPos = 1;
+	if (endPos > contigSize)
+		endPos = contigSize;
+	if (startPos > endPos)
+	{
+		emit messageChanged(tr("Nothing to export"));
+		return false;
+	}
+
+	/* Contig window; substr() keeps the rest of the sequence in the DB */
+	str = "select substr(seq, " + QString::number(startPos)
+			+ ", " + QString::number(endPos - startPos + 1) + ") "
+			" from contigSeq "
+			" where contigId = " + QString::number(contigId);
+	if (!DB_EXEC(query, str) || !query.next())
+	{
+		qCritical() << "Error fetching sequence of contig" << contigId
+			<< "for export:" << query.lastError().text();
+		emit messageChanged(tr("Error exporting region"));
+		return false;
+	}
+	seq = query.value(0).toByteArray();
+	query.finish();
+
+	/* Projects imported before reads were indexed by position get the
+	 * index now; this takes a while once and is a no-op afterwards */
+	emit messageChanged(tr("Indexing reads..."));
+	if (!fragQuery.exec(Database::getFragIndexSql()))
+	{
+		qCritical() << "Error creating fragment index:"
+			<< fragQuery.lastError().text();
+		emit messageChanged(tr("Error exporting region"));
+		return false;
+	}
+
+	/* Projects imported before the longest read was recorded */
+	if (maxReadSize <= 0)
+	{
+		str = "select max(size) from fragment "
+				" where contig_id = " + QString::number(contigId);
+		if (DB_EXEC(fragQuery, str) && fragQuery.next())
+			maxReadSize = fragQuery.value(0).toInt();
+		fragQuery.finish();
+	}
+
+	/* A read overlaps the window if it starts no more than the longest
+	 * read size before it, so the index range stays narrow */
+	rangeStr = " from fragment "
+			" where contig_id = " + QString::number(contigId)
+			+ " and startPos between " + QString::number(startPos - maxReadSize + 1)
+			+ " and " + QString::number(endPos)
+			+ " and endPos >= " + QString::number(startPos);
+	orderStr = " order by startPos, id";
+
+	str = "select count(*)" + rangeStr;
+	if (!DB_EXEC(fragQuery, str) || !fragQuery.next())
+	{
+		qCritical() << "Error counting reads for export:"
+			<< fragQuery.lastError().text();
+		emit messageChanged(tr("Error exporting region"));
+		return false;
+	}
+	numReads = fragQuery.value(0).toInt();
+	fragQuery.finish();
+
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qCritical() << "Cannot write file" << fileName << ":" << file.errorString();
+		emit messageChanged(tr("Cannot write file %1").arg(fileName));
+		return false;
+	}
+
+	/* Header and contig */
+	write("AS 1 " + QByteArray::number(numReads) + "\n\n");
+	write("CO " + contigName + "_" + QByteArray::number(startPos)
+			+ "_" + QByteArray::number(endPos)
+			+ " " + QByteArray::number(seq.size())
+			+ " " + QByteArray::number(numReads) + " 0 U\n");
+	writeSeq(seq);
+	write("\n");
+
+	/* The contig has one quality value per unpadded base */
+	numBases = seq.size() - seq.count('*');
+	line.clear();
+	write("BQ\n");
+	for (i = 0; i < numBases; ++i)
+	{
+		line += " " BASE_QUALITY;
+		if ((i + 1) % QUAL_LINE_LENGTH == 0 || i == numBases - 1)
+		{
+			write(line + "\n");
+			line.clear();
+		}
+	}
+	write("\n");
+	seq.clear();
+
+	/* Read placements; positions are shifted to the start of the window */
+	str = "select name, complement, startPos" + rangeStr + orderStr;
+	fragQuery.setForwardOnly(true);
+	if (!DB_EXEC(fragQuery, str))
+	{
+		qCritical() << "Error fetching reads for export:"
+			<< fragQuery.lastError().text();
+		emit messageChanged(tr("Error exporting region"));
+		return false;
+	}
+	while (fragQuery.next() && !isCanceled && !hasWriteError)
+	{
+		write("AF " + fragQuery.value(0).toByteArray()
+				+ " " + fragQuery.value(1).toByteArray()
+				+ " " + QByteArray::number(fragQuery.value(2).toInt() - startPos + 1)
+				+ "\n");
+	}
+	fragQuery.finish();
+	write("\n");
+
+	/* Reads, in the same order as the placements */
+	str = "select name, size, seq, qualStart, qualEnd, alignStart, alignEnd"
+			+ rangeStr + orderStr;
+	if (!DB_EXEC(fragQuery, str))
+	{
+		qCritical() << "Error fetching reads for export:"
+			<< fragQuery.lastError().text();
+		emit messageChanged(tr("Error exporting region"));
+		return false;
+	}
+	n = 0;
+	while (fragQuery.next() && !isCanceled && !hasWriteError)
+	{
+		write("RD " + fragQuery.value(0).toByteArray()
+				+ " " + fragQuery.value(1).toByteArray()
+				+ " 0 0\n");
+		writeSeq(fragQuery.value(2).toByteArray());
+		write("\nQA " + fragQuery.value(3).toByteArray()
+				+ " " + fragQuery.value(4).toByteArray()
+				+ " " + fragQuery.value(5).toByteArray()
+				+ " " + fragQuery.value(6).toByteArray()
+				+ "\n\n");
+		if (++n % PROGRESS_INTERVAL == 0)
+		{
+			emit messageChanged(tr("Exporting reads: %L1 of %L2")
+					.arg(n).arg(numReads));
+		}
+	}
+	fragQuery.finish();
+
+	if (isCanceled)
+	{
+		emit messageChanged(tr("Export canceled"));
+		return false;
+	}
+	if (!flush())
+	{
+		emit messageChanged(tr("Error writing file %1").arg(fileName));
+		return false;
+	}
+	return true;
+}
+
+
+/*
+ * Appends the given bytes to the output buffer, writing the buffer to
+ * the file when it is full
+ */
+void RegionExporterThread::write(const QByteArray &bytes)
+{
+	buffer += bytes;
+	if (buffer.size() >= WRITE_BUFFER_SIZE)
+		flush();
+}
+
+
+/*
+ * Appends the given sequence, SEQ_LINE_LENGTH bases per line
+ */
+void RegionExporterThread::writeSeq(const QByteArray &seq)
+{
+	int i;
+
+	for (i = 0; i < seq.size(); i += SEQ_LINE_LENGTH)
+	{
+		buffer.append(seq.constData() + i, qMin(SEQ_LINE_LENGTH, seq.size() - i));
+		buffer.append('\n');
+	}
+	if (buffer.size() >= WRITE_BUFFER_SIZE)
+		flush();
+}
+
+
+/*
+ * Writes the output buffer to the file
+ *
+ * @return Returns true on success and false on failure
+ */
+bool RegionExporterThread::flush()
+{
+	if (hasWriteError)
+		return false;
+	if (!buffer.isEmpty() && file.write(buffer) != buffer.size())
+	{
+		qCritical() << "Error writing file" << fileName << ":" << file.errorString();
+		hasWriteError = true;
+		return false;
+	}
+	buffer.clear();
+	return true;
+}
@@ -0,0 +1,50 @@
+#ifndef REGIONEXPORTERTHREAD_H_
+#define REGIONEXPORTERTHREAD_H_
+
+#include <QThread>
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QSqlDatabase>
+
+/*
+ * Writes a window of a contig and the reads overlapping it to an ACE
+ * file. Reads are streamed from the DB by an indexed range query and
+ * written through a large buffer, so the whole contig is never held in
+ * memory.
+ */
+class RegionExporterThread : public QThread
+{
+	Q_OBJECT
+
+public:
+	RegionExporterThread();
+	~RegionExporterThread();
+	void setRegion(const int, const int, const int, const QString &);
+	void cancel();
+
+    signals:
+    void messageChanged(const QString &);
+
+protected:
+	void run();
+
+private:
+	QString contigConnectionName;
+	QString fragConnectionName;
+	int contigId;				/* ID of the contig being exported */
+	int startPos;				/* First padded position of the window, 1-based */
+	int endPos;					/* Last padded position of the window, 1-based */
+	QString fileName;			/* Output ACE file */
+	QFile file;
+	QByteArray buffer;			/* Output waiting to be written to the file */
+	bool hasWriteError;
+	volatile bool isCanceled;
+
+	bool exportRegion(QSqlDatabase &, QSqlDatabase &);
+	void write(const QByteArray &);
+	void writeSeq(const QByteArray &);
+	bool flush();
+};
+
+#endif /* REGIONEXPORTERTHREAD_H_ */
@@ -0,0 +1,440 @@
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QImage>
+#include <QStringList>
+#include <QTextStream>
+#include <QSqlDatabase>
+#include <QSqlQuery>
+#include <QSqlError>
+#include <QtAlgorithms>
+#include <QtDebug>
+#include <math.h>
+#include <limits.h>
+#include "database.h"
+#include "parser.h"
+#include "contig.h"
+#include "maparea.h"
+#include "intermediateViewPainterThread.h"
+#include "globalViewPainterThread.h"
+
+#define	IMAGE_WIDTH			1000
+#define	IMAGE_HEIGHT		700
+#define	NUM_FRAMES			20
+#define	TOLERANCE_PERCENT	20		/* Allowed slowdown against the baseline */
+#define	MIN_REGRESSION_MS	0.5		/* Slowdowns below this are treated as noise */
+#define	NSEC_TO_MSEC		1000000.0
+
+/*
+ * Offscreen rendering benchmark. Opens a project built by
+ * 'basejumper-import' and paints Base View (MapArea), Intermediate View
+ * and Global View into a QImage for a scripted set of viewports: every
+ * zoom level of the deepest contigs, the deepest and the shallowest
+ * region at each level, and with and without annotation tracks. Prints
+ * one tab-separated line per viewport with frame time percentiles and,
+ * for Base View, the mean time per frame spent in drawContig,
+ * drawFragments, drawGenes and drawSnps.
+ *
+ * Given a baseline file written by an earlier run, it exits with 1 if
+ * the median frame time of any viewport got slower than the tolerance.
+ *
+ * QWidget needs a display even when painting into an image, so on X11
+ * run it under a virtual server, e.g. 'xvfb-run basejumper-renderbench'.
+ */
+
+
+/*
+ * Gives access to the paint routine of the Intermediate View thread, so
+ * that it can be run in the calling thread
+ */
+class IntermediateViewBench : public IntermediateViewPainterThread
+{
+public:
+	inline void paint() { run(); };
+};
+
+
+/*
+ * Gives access to the paint routine of the Global View thread, so that
+ * it can be run in the calling thread
+ */
+class GlobalViewBench : public GlobalViewPainterThread
+{
+public:
+	inline void paint() { run(); };
+};
+
+
+static QHash<QString, qreal> baselineHash;	/* Median frame time of each viewport in the baseline */
+static qreal tolerance = TOLERANCE_PERCENT;
+static int numRegressions = 0;
+
+
+/*
+ * Prints the usage message
+ */
+static void printUsage()
+{
+	QTextStream err(stderr);
+
+	err << "Usage: basejumper-renderbench --project <dir> [options]\n"
+		<< "Options:\n"
+		<< "  --project <dir>      Project directory built by basejumper-import\n"
+		<< "  --width <n>          Image width\n"
+		<< "  --height <n>         Image height\n"
+		<< "  --frames <n>         Frames painted per viewport\n"
+		<< "  --contigs <n>        Number of contigs, those with the most reads first\n"
+		<< "  --baseline <file>    Output of an earlier run to compare against\n"
+		<< "  --tolerance <pct>    Allowed slowdown of the median frame time\n";
+}
+
+
+/*
+ * Returns the given percentile of the sorted frame times in milliseconds
+ */
+static qreal getPercentile(const QVector<qint64> &sortedTimes, const int percentile)
+{
+	int i;
+
+	if (sortedTimes.isEmpty())
+		return 0.0;
+	i = (int) ceil(percentile / 100.0 * sortedTimes.size()) - 1;
+	return sortedTimes.at(qBound(0, i, sortedTimes.size() - 1)) / NSEC_TO_MSEC;
+}
+
+
+/*
+ * Formats milliseconds for the results table
+ */
+static QString formatMsecs(const qreal msecs)
+{
+	return QString::number(msecs, 'f', 3);
+}
+
+
+/*
+ * Loads the median frame time of each viewport from an earlier run
+ */
+static bool loadBaseline(const QString &fileName)
+{
+	QFile file(fileName);
+	QStringList fields;
+
+	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qCritical() << "Cannot open baseline file " << fileName;
+		return false;
+	}
+	QTextStream in(&file);
+	in.readLine();
+	while (!in.atEnd())
+	{
+		fields = in.readLine().split("\t");
+		if (fields.size() >= 7)
+			baselineHash.insert(QStringList(fields.mid(0, 5)).join("\t"), fields.at(6).toDouble());
+	}
+	return true;
+}
+
+
+/*
+ * Prints the results of one viewport and checks them against the
+ * baseline. 'stageTimes' holds the total nanoseconds spent in each
+ * MapArea::DrawStage, or is empty for the other views.
+ */
+static void printResult(
+		const QString &view,
+		const QString &contig,
+		const QString &zoom,
+		const QString &region,
+		const QString &tracks,
+		QVector<qint64> &frameTimes,
+		const QVector<qint64> &stageTimes)
+{
+	QTextStream out(stdout);
+	QString key;
+	qreal median;
+	int i;
+
+	qSort(frameTimes);
+	median = getPercentile(frameTimes, 50);
+	key = QStringList(QStringList() << view << contig << zoom << region << tracks).join("\t");
+	out << key << "\t" << frameTimes.size()
+		<< "\t" << formatMsecs(median)
+		<< "\t" << formatMsecs(getPercentile(frameTimes, 90))
+		<< "\t" << formatMsecs(getPercentile(frameTimes, 99))
+		<< "\t" << formatMsecs(getPercentile(frameTimes, 100));
+	for (i = 0; i < MapArea::NumDrawStages; ++i)
+	{
+		if (stageTimes.isEmpty() || frameTimes.isEmpty())
+			out << "\t-";
+		else
+			out << "\t" << formatMsecs(stageTimes.at(i) / NSEC_TO_MSEC / frameTimes.size());
+	}
+	out << "\n";
+	out.flush();
+
+	if (baselineHash.contains(key)
+			&& median > baselineHash.value(key) * (1.0 + tolerance / 100.0)
+			&& median - baselineHash.value(key) > MIN_REGRESSION_MS)
+	{
+		QTextStream(stderr) << "Regression: " << key << ": median "
+			<< formatMsecs(median) << " ms, baseline "
+			<< formatMsecs(baselineHash.value(key)) << " ms\n";
+		++numRegressions;
+	}
+}
+
+
+/*
+ * Finds the regions of the given window size with the highest and the
+ * lowest mean read depth
+ */
+static void findRegions(
+		const Contig *contig,
+		const int window,
+		int &deepStart,
+		int &shallowStart)
+{
+	int start, step;
+	qreal depth, maxDepth, minDepth;
+
+	deepStart = 0;
+	shallowStart = 0;
+	maxDepth = -1.0;
+	minDepth = -1.0;
+	step = qMax(1, window / 2);
+	for (start = 0; start < contig->size; start += step)
+	{
+		depth = contig->coverageProfile.getMeanDepth(
+				start, qMin(start + window, contig->size) - 1);
+		if (depth > maxDepth)
+		{
+			maxDepth = depth;
+			deepStart = start;
+		}
+		if (minDepth < 0 || depth < minDepth)
+		{
+			minDepth = depth;
+			shallowStart = start;
+		}
+		if (start + window >= contig->size)
+			break;
+	}
+}
+
+
+/*
+ * Paints Base View at its current viewport and prints the results
+ */
+static void benchMapArea(
+		MapArea *mapArea,
+		QImage &image,
+		const int numFrames,
+		const QString &zoom,
+		const QString &region,
+		const bool showTracks)
+{
+	Contig *contig = mapArea->getContig();
+	QList<AnnotationList *> annotationLists;
+	QVector<qint64> frameTimes, stageTimes;
+	QElapsedTimer timer;
+	int i, j;
+
+	/* Hide the tracks by detaching them from the contig for the run */
+	annotationLists = contig->annotationLists;
+	if (!showTracks)
+		contig->annotationLists.clear();
+
+	/* The first frame only warms up the caches */
+	mapArea->render(&image);
+	stageTimes.fill(0, MapArea::NumDrawStages);
+	for (i = 0; i < numFrames; ++i)
+	{
+		timer.start();
+		mapArea->render(&image);
+		frameTimes.append(timer.nsecsElapsed());
+		for (j = 0; j < MapArea::NumDrawStages; ++j)
+			stageTimes[j] += mapArea->getDrawTimes().at(j);
+	}
+	contig->annotationLists = annotationLists;
+
+	printResult("base", QString::number(contig->id), zoom, region,
+			showTracks? "on": "off", frameTimes, stageTimes);
+}
+
+
+/*
+ * Returns the IDs of the contigs with the most reads
+ */
+static QList<int> getContigIds(const int numContigs)
+{
+	QString connectionName = "renderBench";
+	QList<int> idList;
+
+	{
+		QSqlDatabase db =
+			Database::createConnection(
+				connectionName,
+				Database::getContigDBName());
+		QSqlQuery query(db);
+
+		if (!query.exec("select id from contig "
+				" where id <= " + QString::number(Contig::getNumAvailableContigs()) +
+				" order by numberReads desc, id asc "
+				" limit " + QString::number(numContigs)))
+			qCritical() << "Error fetching contig IDs. Reason: "
+				<< query.lastError().text();
+		while (query.next())
+			idList.append(query.value(0).toInt());
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(connectionName);
+	return idList;
+}
+
+
+int main(int argc, char *argv[])
+{
+	QApplication app(argc, argv);
+	QStringList args;
+	QString projectDir, baselineFile, arg, value;
+	QList<int> idList;
+	QVector<qint64> frameTimes;
+	QElapsedTimer timer;
+	QImage image;
+	Parser *parser;
+	MapArea *mapArea;
+	IntermediateViewBench *intermediateView;
+	GlobalViewBench *globalView;
+	Contig *contig;
+	bool ok, showTracks;
+	int i, id, level, deepStart, shallowStart, width, height, numFrames, numContigs;
+
+	width = IMAGE_WIDTH;
+	height = IMAGE_HEIGHT;
+	numFrames = NUM_FRAMES;
+	numContigs = 1;
+
+	args = app.arguments();
+	for (i = 1; i < args.size(); ++i)
+	{
+		arg = args.at(i);
+		if (!arg.startsWith("--") || i + 1 >= args.size())
+		{
+			printUsage();
+			return 2;
+		}
+		value = args.at(++i);
+		ok = true;
+		if (arg == "--project")
+			projectDir = value;
+		else if (arg == "--width")
+			width = value.toInt(&ok);
+		else if (arg == "--height")
+			height = value.toInt(&ok);
+		else if (arg == "--frames")
+			numFrames = value.toInt(&ok);
+		else if (arg == "--contigs")
+			numContigs = value.toInt(&ok);
+		else if (arg == "--baseline")
+			baselineFile = value;
+		else if (arg == "--tolerance")
+			tolerance = value.toDouble(&ok);
+		else
+			ok = false;
+		if (!ok)
+		{
+			printUsage();
+			return 2;
+		}
+	}
+	if (projectDir.isEmpty() || width <= 0 || width > USHRT_MAX
+			|| height <= 0 || height > USHRT_MAX
+			|| numFrames <= 0 || numContigs <= 0)
+	{
+		printUsage();
+		return 2;
+	}
+	if (!baselineFile.isEmpty() && !loadBaseline(baselineFile))
+		return 1;
+
+	Database::setDirectory(projectDir);
+	parser = new Parser;
+	if (!parser->openProject())
+	{
+		qCritical() << "No contigs found in " << projectDir;
+		return 1;
+	}
+	idList = getContigIds(numContigs);
+
+	QTextStream(stdout) << "view\tcontig\tzoom\tregion\ttracks\tframes"
+		<< "\tp50_ms\tp90_ms\tp99_ms\tmax_ms"
+		<< "\tcontig_ms\tfragments_ms\tgenes_ms\tsnps_ms\n";
+
+	/* Base View */
+	image = QImage(width, height, QImage::Format_ARGB32);
+	mapArea = new MapArea(NULL);
+	mapArea->resize(width, height);
+	mapArea->initialize();
+	mapArea->getContigOrderIdHash();
+	mapArea->zoomSliderMoved(1);
+	foreach (id, idList)
+	{
+		mapArea->goToPos(id, 0);
+		contig = mapArea->getContig();
+		for (level = 1; level <= contig->zoomLevels; ++level)
+		{
+			mapArea->zoomSliderMoved(level);
+			findRegions(contig, mapArea->getNumBases(), deepStart, shallowStart);
+			for (i = 0; i < 4; ++i)
+			{
+				showTracks = (i % 2 == 0);
+				mapArea->goToPos(id, (i < 2)? deepStart: shallowStart);
+				benchMapArea(mapArea, image, numFrames, QString::number(level),
+						(i < 2)? "deep": "shallow", showTracks);
+			}
+		}
+	}
+
+	/* Intermediate View, one whole contig per frame */
+	intermediateView = new IntermediateViewBench;
+	intermediateView->setWidth(width);
+	intermediateView->setHeight(height);
+	foreach (id, idList)
+	{
+		mapArea->goToPos(id, 0);
+		intermediateView->setContig(mapArea->getContig());
+		intermediateView->paint();
+		frameTimes.clear();
+		for (i = 0; i < numFrames; ++i)
+		{
+			timer.start();
+			intermediateView->paint();
+			frameTimes.append(timer.nsecsElapsed());
+		}
+		printResult("intermediate", QString::number(id), "-", "-", "-",
+				frameTimes, QVector<qint64>());
+	}
+
+	/* Global View, all contigs per frame */
+	globalView = new GlobalViewBench;
+	globalView->setWidth(width);
+	globalView->setHeight(height);
+	globalView->paint();
+	frameTimes.clear();
+	for (i = 0; i < numFrames; ++i)
+	{
+		timer.start();
+		globalView->paint();
+		frameTimes.append(timer.nsecsElapsed());
+	}
+	printResult("global", "-", "-", "-", "-", frameTimes, QVector<qint64>());
+
+	delete globalView;
+	delete intermediateView;
+	delete mapArea;
+	delete parser;
+	return (numRegressions > 0)? 1: 0;
+}
@@ -0,0 +1,370 @@
+
+#include "samReader.h"
+#include <QList>
+#include <QtEndian>
+#include <QtDebug>
+#include <string.h>
+
+#define	BAM_FIXED_SIZE	32		/* Bytes of a BAM record before the read name */
+
+static const char *cigarOps = "MIDNSHP=X";
+static const char *bamBases = "=ACMGRSVTWYHKDBN";
+
+
+/**
+ * Constructor
+ */
+SamReader::SamReader()
+{
+	isBgzf = false;
+	isBam = false;
+	error = false;
+	hasLine = false;
+}
+
+
+/**
+ * Destructor
+ */
+SamReader::~SamReader()
+{
+	close();
+}
+
+
+/**
+ * Opens the given SAM or BAM file and reads its header. The format is
+ * recognized from the contents of the file.
+ *
+ * @param path : Path of the file
+ * @return Returns true on success and false on failure
+ */
+bool SamReader::open(const QString &path)
+{
+	QByteArray magic;
+	char bamMagic[4];
+
+	close();
+	file.setFileName(path);
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qCritical() << "Cannot read file " << path << ". Reason: "
+			<< file.errorString();
+		return false;
+	}
+	magic = file.peek(2);
+	isBgzf = (magic.size() == 2 && (uchar) magic.at(0) == 31
+			&& (uchar) magic.at(1) == 139);
+
+	if (isBgzf)
+	{
+		file.close();
+		if (!bgzf.open(path))
+			return false;
+		bgzf.setParallel(true);
+		if (bgzf.read(bamMagic, 4) == 4 && memcmp(bamMagic, "BAM\1", 4) == 0)
+			isBam = true;
+		else if (!bgzf.seek(0))
+			return false;
+	}
+
+	if (isBam && !readBamHeader())
+	{
+		qCritical() << "Invalid BAM header in " << path;
+		return false;
+	}
+	return (isBam || readSamHeader());
+}
+
+
+/**
+ * Closes the file
+ */
+void SamReader::close()
+{
+	if (file.isOpen())
+		file.close();
+	bgzf.close();
+	isBgzf = false;
+	isBam = false;
+	error = false;
+	hasLine = false;
+	refNames.clear();
+	refLengths.clear();
+	refIdHash.clear();
+}
+
+
+/**
+ * Reads the next alignment
+ *
+ * @param record : Set to the alignment that was read
+ * @return Returns false at the end of the file or on a malformed record;
+ * use hasError() to tell them apart
+ */
+bool SamReader::next(Record &record)
+{
+	error = false;
+	if (isBam)
+		return readBamRecord(record);
+
+	forever
+	{
+		if (!hasLine && !readSamLine(line))
+			return false;
+		hasLine = false;
+		if (!line.isEmpty())
+			break;
+	}
+	if (!parseSamRecord(line, record))
+	{
+		error = true;
+		return false;
+	}
+	return true;
+}
+
+
+/**
+ * Returns the number of bytes of the file that have been read. For
+ * compressed files this counts compressed bytes.
+ */
+qint64 SamReader::getCompressedPos() const
+{
+	if (isBgzf)
+		return bgzf.getBlockAddress();
+	return file.pos();
+}
+
+
+/*
+ * Reads the next line of a SAM file, without the line terminator
+ */
+bool SamReader::readSamLine(QByteArray &l)
+{
+	if (isBgzf)
+		return bgzf.readLine(l);
+	if (file.atEnd())
+		return false;
+	l = file.readLine();
+	while (l.endsWith('\n') || l.endsWith('\r'))
+		l.chop(1);
+	return true;
+}
+
+
+/*
+ * Reads the header lines of a SAM file, keeping the references listed
+ * in its @SQ lines. The first alignment line is kept in 'line'.
+ */
+bool SamReader::readSamHeader()
+{
+	QList<QByteArray> fields;
+	QByteArray name;
+	int length;
+	bool ok;
+
+	while (readSamLine(line))
+	{
+		if (!line.startsWith('@'))
+		{
+			hasLine = true;
+			break;
+		}
+		if (!line.startsWith("@SQ\t"))
+			continue;
+
+		name.clear();
+		length = -1;
+		fields = line.split('\t');
+		foreach (QByteArray field, fields)
+		{
+			if (field.startsWith("SN:"))
+				name = field.mid(3);
+			else if (field.startsWith("LN:"))
+				length = field.mid(3).toInt(&ok);
+		}
+		if (name.isEmpty() || length < 0)
+		{
+			qCritical() << "Invalid @SQ line in " << file.fileName() << ": " << line;
+			return false;
+		}
+		addReference(name, length);
+	}
+	return true;
+}
+
+
+/*
+ * Reads the header of a BAM file following its magic string
+ */
+bool SamReader::readBamHeader()
+{
+	qint32 textLength, numRefs, nameLength, length;
+	int i;
+
+	if (!readInt32(textLength) || textLength < 0)
+		return false;
+	buffer.resize(textLength);
+	if (bgzf.read(buffer.data(), textLength) != textLength)
+		return false;
+	if (!readInt32(numRefs) || numRefs < 0)
+		return false;
+	for (i = 0; i < numRefs; ++i)
+	{
+		if (!readInt32(nameLength) || nameLength < 1)
+			return false;
+		buffer.resize(nameLength);
+		if (bgzf.read(buffer.data(), nameLength) != nameLength)
+			return false;
+		if (!readInt32(length))
+			return false;
+		addReference(QByteArray(buffer.constData(), nameLength - 1), length);
+	}
+	return true;
+}
+
+
+/*
+ * Parses the given SAM alignment line. Returns false if it is malformed.
+ */
+bool SamReader::parseSamRecord(const QByteArray &l, Record &record)
+{
+	QList<QByteArray> fields;
+	const char *cigar, *op;
+	quint32 length;
+	bool ok;
+
+	fields = l.split('\t');
+	if (fields.size() < 11)
+		return false;
+
+	record.name = fields.at(0);
+	record.flag = fields.at(1).toInt(&ok);
+	if (!ok)
+		return false;
+	if (fields.at(2) == "*")
+		record.refId = -1;
+	else
+	{
+		record.refId = refIdHash.value(fields.at(2), -1);
+		if (record.refId == -1)
+			return false;
+	}
+	record.pos = fields.at(3).toInt(&ok) - 1;
+	if (!ok)
+		return false;
+	record.mapq = fields.at(4).toInt(&ok);
+	if (!ok)
+		return false;
+
+	/* CIGAR, e.g. '5S40M2I10M' */
+	record.cigar.clear();
+	if (fields.at(5) != "*")
+	{
+		cigar = fields.at(5).constData();
+		while (*cigar != '\0')
+		{
+			length = 0;
+			while (*cigar >= '0' && *cigar <= '9')
+				length = length * 10 + (*cigar++ - '0');
+			if (*cigar == '\0' || (op = strchr(cigarOps, *cigar)) == NULL)
+				return false;
+			record.cigar.append((length << 4) | (quint32) (op - cigarOps));
+			++cigar;
+		}
+	}
+
+	if (fields.at(9) == "*")
+		record.seq.clear();
+	else
+		record.seq = fields.at(9);
+	return true;
+}
+
+
+/*
+ * Reads the next BAM alignment record
+ */
+bool SamReader::readBamRecord(Record &record)
+{
+	qint32 blockSize;
+	const uchar *data;
+	int nameLength, numCigarOps, seqLength, i;
+
+	if (!readInt32(blockSize))
+		return false;
+	if (blockSize < BAM_FIXED_SIZE)
+	{
+		error = true;
+		return false;
+	}
+	buffer.resize(blockSize);
+	if (bgzf.read(buffer.data(), blockSize) != blockSize)
+	{
+		error = true;
+		return false;
+	}
+
+	data = (const uchar *) buffer.constData();
+	record.refId = qFromLittleEndian<qint32>(data);
+	record.pos = qFromLittleEndian<qint32>(data + 4);
+	nameLength = data[8];
+	record.mapq = data[9];
+	numCigarOps = qFromLittleEndian<quint16>(data + 12);
+	record.flag = qFromLittleEndian<quint16>(data + 14);
+	seqLength = qFromLittleEndian<qint32>(data + 16);
+	if (nameLength < 1 || seqLength < 0 || seqLength > blockSize
+			|| BAM_FIXED_SIZE + nameLength + 4 * numCigarOps
+				+ (seqLength + 1) / 2 + seqLength > blockSize
+			|| record.refId >= refNames.size())
+	{
+		error = true;
+		return false;
+	}
+
+	data += BAM_FIXED_SIZE;
+	record.name = QByteArray((const char *) data, nameLength - 1);
+	data += nameLength;
+	record.cigar.resize(numCigarOps);
+	for (i = 0; i < numCigarOps; ++i, data += 4)
+		record.cigar[i] = qFromLittleEndian<quint32>(data);
+
+	/* Bases are packed two per byte */
+	record.seq.resize(seqLength);
+	for (i = 0; i < seqLength; ++i)
+		record.seq[i] = bamBases[(data[i / 2] >> ((i % 2)? 0: 4)) & 0xF];
+	return true;
+}
+
+
+/*
+ * Reads a little-endian 32-bit integer from the BGZF file. A partial
+ * integer is an error; no data at all is the end of the file.
+ */
+bool SamReader::readInt32(qint32 &n)
+{
+	uchar bytes[4];
+	qint64 numRead;
+
+	numRead = bgzf.read((char *) bytes, 4);
+	if (numRead != 4)
+	{
+		if (numRead != 0)
+			error = true;
+		return false;
+	}
+	n = qFromLittleEndian<qint32>(bytes);
+	return true;
+}
+
+
+/*
+ * Adds a reference from the header
+ */
+void SamReader::addReference(const QByteArray &name, const int length)
+{
+	refIdHash.insert(name, refNames.size());
+	refNames.append(name);
+	refLengths.append(length);
+}
@@ -0,0 +1,74 @@
+#ifndef SAMREADER_H_
+#define SAMREADER_H_
+
+#include <QFile>
+#include <QByteArray>
+#include <QVector>
+#include <QHash>
+#include "bgzfReader.h"
+
+/*
+ * Reads alignments from a SAM file, plain or bgzipped, or from a BAM
+ * file. BGZF blocks are uncompressed in parallel ahead of the reader.
+ */
+class SamReader
+{
+public:
+	/** One alignment. CIGAR operations are encoded as in BAM: the length
+	 * shifted left by 4 bits, ORed with the index of the operation in
+	 * "MIDNSHP=X". */
+	struct Record
+	{
+		QByteArray name;		/* Read name */
+		int flag;				/* Bitwise flags */
+		int refId;				/* Index of the reference, -1 if none */
+		int pos;				/* 0-based leftmost position, -1 if none */
+		int mapq;				/* Mapping quality */
+		QVector<quint32> cigar;	/* CIGAR operations */
+		QByteArray seq;			/* Bases, empty if not stored */
+	};
+
+	SamReader();
+	~SamReader();
+	bool open(const QString &);
+	void close();
+	bool next(Record &);
+	qint64 getCompressedPos() const;
+
+	/** Returns the number of references in the header */
+	inline int getNumReferences() const { return refNames.size(); };
+
+	/** Returns the name of the given reference */
+	inline QByteArray getReferenceName(const int i) const { return refNames.at(i); };
+
+	/** Returns the length of the given reference */
+	inline int getReferenceLength(const int i) const { return refLengths.at(i); };
+
+	/** Returns whether the last call to next() failed on a malformed
+	 * record or a truncated or corrupt compressed file rather than at
+	 * the end of the file */
+	inline bool hasError() const { return error || bgzf.hasError(); };
+
+private:
+	QFile file;					/* Plain SAM file */
+	BgzfReader bgzf;			/* Bgzipped SAM or BAM file */
+	bool isBgzf;
+	bool isBam;
+	bool error;
+	QVector<QByteArray> refNames;
+	QVector<int> refLengths;
+	QHash<QByteArray, int> refIdHash;	/* Maps reference name => index */
+	QByteArray line;			/* SAM line to be parsed next */
+	bool hasLine;				/* Whether 'line' holds an unparsed line */
+	QByteArray buffer;			/* Data of the current BAM record */
+
+	bool readSamLine(QByteArray &);
+	bool readSamHeader();
+	bool readBamHeader();
+	bool parseSamRecord(const QByteArray &, Record &);
+	bool readBamRecord(Record &);
+	bool readInt32(qint32 &);
+	void addReference(const QByteArray &, const int);
+};
+
+#endif /* SAMREADER_H_ */
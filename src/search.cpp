@@ -7,6 +7,9 @@
 #include <iostream>
 #include <QSqlQuery>
 #include <QSqlError>
+#include "contigPlacementIndex.h"
+#include "contigList.h"
+#include "database.h"
 
 #define MINIMUM_SEARCH_SUGGESTION_LENGTH 4
 #define MAXIMUM_VISIBLE_SEARCH_SUGGESTIONS 4
@@ -370,7 +373,7 @@ void Search::searchSeq(const QString &str)
 	map = NULL;
 	queryStr = "select id "
 			" from contig ";
-	if (!query.exec(queryStr))
+	if (!DB_EXEC(query, queryStr))
 	{
 		qDebug() << "Error fetching contig from DB.\nReason: " << query.lastError().text() << endl;
 		return;
@@ -421,10 +424,14 @@ void Search::searchSeq(const QString &str)
 void Search::searchPos(const QString &str)
 {
 	QStringList strList1, strList2;
-	QString chromName, queryStr;
+	QString chromName;
 	int start, end, contigId, start2, end2;
-	QSqlQuery query;
 	QMap<int, int> *map;
+	QSqlQuery query;
+	PadIndex padIndex;
+	const ContigPlacementIndex *placementIndex;
+	QVector<ContigPlacementIndex::Placement> placements;
+	ContigPlacementIndex::Placement placement;
 
 	map = NULL;
 	strList1 = str.split(":");
@@ -434,29 +441,33 @@ void Search::searchPos(const QString &str)
 	start = strList2[0].remove(QChar(','), Qt::CaseInsensitive).toInt();
 	end = strList2[1].remove(QChar(','), Qt::CaseInsensitive).toInt();
 
-	queryStr = "select contigId, chromStart "
-			" from chrom_contig, chromosome "
-			" where chrom_contig.chromId = chromosome.id "
-			" and chromosome.name = '" + chromName + "' "
-			" and chromStart <= " + QString::number(start) +
-			" and chromEnd >= " + QString::number(start) +
-			" and chromStart <= " + QString::number(end) +
-			" and chromEnd >= " + QString::number(end) +
-			" order by contigId asc, chromStart asc, chromEnd asc ";
-	if (!query.exec(queryStr))
+	placementIndex = ContigPlacementIndex::getShared();
+	if (placementIndex == NULL)
 	{
 		QMessageBox::critical(
 				this,
 				tr("Basejumper"),
-				tr("Error fetching chromosome and contig from DB.\nReason: "
-						+ query.lastError().text().toAscii()));
+				tr("Error fetching chromosome and contig from DB."));
 		return;
 	}
-	while (query.next())
+	placementIndex->findContaining(chromName.toAscii(), start, end, placements);
+	foreach (placement, placements)
 	{
-		contigId = query.value(0).toInt();
-		start2 = start - query.value(1).toInt() + 1;
-		end2 = start2 + (end - start);
+		contigId = placement.contigId;
+		ContigPlacementIndex::toContigRange(placement, start, end, start2, end2);
+
+		/* Highlight the padded contig positions of the bases */
+		if (!ContigList::fetchPadIndex(query, contigId, padIndex))
+		{
+			QMessageBox::critical(
+					this,
+					tr("Basejumper"),
+					tr("Error fetching contig pads from DB.\nReason: "
+							+ query.lastError().text().toAscii()));
+			return;
+		}
+		start2 = padIndex.toPadded(start2) + 1;
+		end2 = padIndex.toPadded(end2) + 1;
 		if (resultsMap.contains(contigId))
 			resultsMap.value(contigId)->insert(start2, end2);
 		else
@@ -494,7 +505,7 @@ void Search::searchGene(const QString &name)
 			" from annotation "
 			" where name = '" + name + "'"
 			" order by contigId asc, startPos asc ";
-	if (!query.exec(str))
+	if (!DB_EXEC(query, str))
 	{
 		QMessageBox::critical(
 				this,
@@ -839,19 +850,19 @@ void Search::saveSearchQuery(const QString str)
 	QSqlQuery selectQuery;
 	QSqlQuery modifyQuery;
 
-	if ( selectQuery.exec("Select query, count, id From searchQueries Where query = '"+str+"' Limit 1") )
+	if ( DB_EXEC(selectQuery, "Select query, count, id From searchQueries Where query = '"+str+"' Limit 1") )
 	{
 		if ( selectQuery.next() )
 		{
 			// should only be one result
 			// query already existed so update count and lastDatetime
 			int count = selectQuery.value(1).toInt() + 1;
-			modifyQuery.exec("Update searchQueries set count = "+QString::number(count)+", "
+			DB_EXEC(modifyQuery, "Update searchQueries set count = "+QString::number(count)+", "
 					"lastDatetime = datetime('now') "
 					"Where id = "+QString::number(selectQuery.value(2).toInt()));
 		} else {
 			// insert the new query
-			modifyQuery.exec("Insert into searchQueries (query, count, lastDatetime) "
+			DB_EXEC(modifyQuery, "Insert into searchQueries (query, count, lastDatetime) "
 							"Values ('" + str + "', 1, datetime('now'))");
 		}
 	}
@@ -870,7 +881,7 @@ QStringList Search::findSuggestions(const QString str)
 	QSqlQuery query;
 
 	// ordering search queries by week (most recent) and count (most often)
-	if ( query.exec("Select query From searchQueries "
+	if ( DB_EXEC(query, "Select query From searchQueries "
 			"Where query Like '"+str+"%' Order By strftime('%Y %W', lastDatetime) "
 			"Desc, count Desc") )
 	{
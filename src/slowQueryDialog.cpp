@@ -0,0 +1,183 @@
+
+#include "slowQueryDialog.h"
+
+#define	NSEC_TO_MSEC	1000000.0
+#define	MAX_THRESHOLD	600000		/* In milliseconds */
+
+/* Columns of the tree */
+enum {CallSiteColumn, CountColumn, TotalColumn, MaxColumn, RowsColumn, SqlColumn, NumColumns};
+
+
+/**
+ * Constructor
+ */
+SlowQueryDialog::SlowQueryDialog(
+		QWidget *parent,
+		Qt::WindowFlags f)
+	: QDialog(parent, f)
+{
+	QStringList headers;
+
+	/* Create threshold spin box */
+	thresholdLabel = new QLabel(tr("Log statements slower than:"), this, Qt::Widget);
+	thresholdSpinBox = new QSpinBox(this);
+	thresholdSpinBox->setRange(0, MAX_THRESHOLD);
+	thresholdSpinBox->setSuffix(tr(" ms"));
+	thresholdSpinBox->setSpecialValueText(tr("Off"));
+	thresholdSpinBox->setValue(SlowQueryLog::getThreshold());
+	connect(thresholdSpinBox, SIGNAL(valueChanged(int)),
+			this, SLOT(thresholdChanged(int)));
+
+	fileLabel = new QLabel(this, Qt::Widget);
+	fileLabel->setTextInteractionFlags(Qt::TextSelectableByMouse);
+
+	/* Create the list of call sites, the slowest first */
+	headers << tr("Call site") << tr("Count") << tr("Total (ms)")
+		<< tr("Max (ms)") << tr("Rows") << tr("Statement");
+	tree = new QTreeWidget(this);
+	tree->setColumnCount(NumColumns);
+	tree->setHeaderLabels(headers);
+	tree->setRootIsDecorated(false);
+	tree->setAlternatingRowColors(true);
+	tree->setSelectionMode(QAbstractItemView::SingleSelection);
+	connect(tree, SIGNAL(itemSelectionChanged()), this, SLOT(entrySelected()));
+
+	planTextEdit = new QPlainTextEdit(this);
+	planTextEdit->setReadOnly(true);
+	planTextEdit->setLineWrapMode(QPlainTextEdit::NoWrap);
+	planTextEdit->setMaximumHeight(150);
+
+	/* Create push buttons */
+	refreshButton = new QPushButton(tr("Refresh"), this);
+	connect(refreshButton, SIGNAL(clicked()), this, SLOT(refresh()));
+	clearButton = new QPushButton(tr("Clear"), this);
+	connect(clearButton, SIGNAL(clicked()), this, SLOT(clearTriggered()));
+	closeButton = new QPushButton(tr("Close"), this);
+	closeButton->setAutoDefault(true);
+	closeButton->setDefault(true);
+	connect(closeButton, SIGNAL(clicked()), this, SLOT(close()));
+
+	/* Create layouts */
+	thresholdLayout = new QHBoxLayout;
+	thresholdLayout->addWidget(thresholdLabel);
+	thresholdLayout->addWidget(thresholdSpinBox);
+	thresholdLayout->addStretch(1);
+
+	buttonsLayout = new QHBoxLayout;
+	buttonsLayout->addStretch(1);
+	buttonsLayout->addWidget(refreshButton, 0, Qt::AlignRight);
+	buttonsLayout->addWidget(clearButton, 0, Qt::AlignRight);
+	buttonsLayout->addWidget(closeButton, 0, Qt::AlignRight);
+
+	parentLayout = new QVBoxLayout;
+	parentLayout->addLayout(thresholdLayout, 0);
+	parentLayout->addWidget(fileLabel, 0);
+	parentLayout->addWidget(tree, 1);
+	parentLayout->addWidget(planTextEdit, 0);
+	parentLayout->addLayout(buttonsLayout, 0);
+
+	this->setWindowTitle(tr("Slow Queries"));
+	this->setLayout(parentLayout);
+	this->resize(800, 500);
+}
+
+
+/**
+ * Destructor
+ */
+SlowQueryDialog::~SlowQueryDialog()
+{
+	delete thresholdLabel;
+	delete thresholdSpinBox;
+	delete fileLabel;
+	delete tree;
+	delete planTextEdit;
+	delete refreshButton;
+	delete clearButton;
+	delete closeButton;
+	delete thresholdLayout;
+	delete buttonsLayout;
+	delete parentLayout;
+}
+
+
+/**
+ * Refreshes the list each time the dialog is shown
+ */
+void SlowQueryDialog::showEvent(QShowEvent *event)
+{
+	thresholdSpinBox->setValue(SlowQueryLog::getThreshold());
+	refresh();
+	QDialog::showEvent(event);
+}
+
+
+/*
+ * Fills the tree with the statistics of each call site
+ */
+void SlowQueryDialog::refresh()
+{
+	QTreeWidgetItem *item;
+	int i;
+
+	fileLabel->setText(tr("Log file: %1").arg(SlowQueryLog::getFileName()));
+	tree->clear();
+	planTextEdit->clear();
+	entries = SlowQueryLog::getEntries();
+	for (i = 0; i < entries.size(); ++i)
+	{
+		const SlowQueryLog::Entry &entry = entries.at(i);
+		item = new QTreeWidgetItem(tree);
+		item->setText(CallSiteColumn, entry.callSite);
+		item->setText(CountColumn, QString::number(entry.count));
+		item->setText(TotalColumn, QString::number(entry.totalTime / NSEC_TO_MSEC, 'f', 1));
+		item->setText(MaxColumn, QString::number(entry.maxTime / NSEC_TO_MSEC, 'f', 1));
+		item->setText(RowsColumn, (entry.numRows < 0)? QString("-"): QString::number(entry.numRows));
+		item->setText(SqlColumn, entry.sql);
+		item->setToolTip(SqlColumn, entry.sql);
+		item->setData(CallSiteColumn, Qt::UserRole, i);
+		item->setTextAlignment(CountColumn, Qt::AlignRight);
+		item->setTextAlignment(TotalColumn, Qt::AlignRight);
+		item->setTextAlignment(MaxColumn, Qt::AlignRight);
+		item->setTextAlignment(RowsColumn, Qt::AlignRight);
+	}
+	for (i = 0; i < SqlColumn; ++i)
+		tree->resizeColumnToContents(i);
+}
+
+
+/*
+ * Clears the statistics
+ */
+void SlowQueryDialog::clearTriggered()
+{
+	SlowQueryLog::clear();
+	refresh();
+}
+
+
+/*
+ * Sets the slow query threshold
+ */
+void SlowQueryDialog::thresholdChanged(int msecs)
+{
+	SlowQueryLog::setThreshold(msecs);
+}
+
+
+/*
+ * Shows the statement and query plan of the selected call site
+ */
+void SlowQueryDialog::entrySelected()
+{
+	QList<QTreeWidgetItem *> items = tree->selectedItems();
+	int i;
+
+	planTextEdit->clear();
+	if (items.isEmpty())
+		return;
+	i = items.first()->data(CallSiteColumn, Qt::UserRole).toInt();
+	if (i < 0 || i >= entries.size())
+		return;
+	planTextEdit->setPlainText(entries.at(i).sql + "\n\n" + entries.at(i).plan);
+}
@@ -0,0 +1,46 @@
+
+#ifndef SLOWQUERYDIALOG_H_
+#define SLOWQUERYDIALOG_H_
+#include <QDialog>
+#include <QLabel>
+#include <QSpinBox>
+#include <QTreeWidget>
+#include <QPlainTextEdit>
+#include <QPushButton>
+#include <QBoxLayout>
+#include <QList>
+#include "slowQueryLog.h"
+
+class SlowQueryDialog : public QDialog
+{
+	Q_OBJECT
+
+public:
+	SlowQueryDialog(QWidget *parent=0, Qt::WindowFlags f=0);
+	~SlowQueryDialog();
+
+protected:
+	void showEvent(QShowEvent *);
+
+private:
+	QLabel *thresholdLabel;
+	QSpinBox *thresholdSpinBox;
+	QLabel *fileLabel;
+	QTreeWidget *tree;
+	QPlainTextEdit *planTextEdit;
+	QPushButton *refreshButton;
+	QPushButton *clearButton;
+	QPushButton *closeButton;
+	QHBoxLayout *thresholdLayout;
+	QHBoxLayout *buttonsLayout;
+	QVBoxLayout *parentLayout;
+	QList<SlowQueryLog::Entry> entries;	/* Entries shown in the tree */
+
+	private slots:
+	void refresh();
+	void clearTriggered();
+	void thresholdChanged(int);
+	void entrySelected();
+};
+
+#endif /* SLOWQUERYDIALOG_H_ */
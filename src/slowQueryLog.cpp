@@ -0,0 +1,234 @@
+
+#include "slowQueryLog.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSqlDriver>
+#include <QSqlError>
+#include <QSqlRecord>
+#include <QSqlResult>
+#include <QStringList>
+#include <QTextStream>
+#include <QtAlgorithms>
+#include <QtDebug>
+#include "database.h"
+
+#define	SLOW_QUERY_THRESHOLD	100			/* In milliseconds */
+#define	LOG_FILE_NAME			"slowQueries.log"
+#define	MAX_LOG_SIZE			1048576		/* Bytes before the log is rotated */
+#define	NUM_OLD_LOGS			3			/* Rotated logs that are kept */
+#define	NSEC_TO_MSEC			1000000.0
+
+
+/*
+ * Static member definitions
+ */
+QMutex SlowQueryLog::mutex;
+QHash<QString, SlowQueryLog::Entry> SlowQueryLog::entryHash;
+int SlowQueryLog::threshold = SLOW_QUERY_THRESHOLD;
+
+
+/**
+ * Records a statement that took longer than the threshold: its query
+ * plan and row count are looked up and it is added to the statistics of
+ * its call site and to the log file. The rows of a SELECT are counted by
+ * fetching them into the result's cache, which the caller then reads
+ * them from, so the statement is not run again. Forward-only results do
+ * not keep fetched rows, so their row count is unknown.
+ *
+ * @param query : Query that executed the statement; it stays positioned
+ * before its first row
+ * @param callSite : File and line that issued the statement
+ * @param nsecs : Execution time in nanoseconds
+ */
+void SlowQueryLog::record(QSqlQuery &query, const QString &callSite, const qint64 nsecs)
+{
+	Entry entry;
+
+	/* The plan and the row count are looked up outside the lock because
+	 * they use the database */
+	entry.callSite = callSite;
+	entry.sql = query.lastQuery().simplified();
+	entry.plan = getPlan(query);
+	entry.numRows = countRows(query);
+
+	QMutexLocker locker(&mutex);
+	if (entryHash.contains(callSite))
+	{
+		entry.count = entryHash.value(callSite).count + 1;
+		entry.totalTime = entryHash.value(callSite).totalTime + nsecs;
+		entry.maxTime = qMax(entryHash.value(callSite).maxTime, nsecs);
+	}
+	else
+	{
+		entry.count = 1;
+		entry.totalTime = nsecs;
+		entry.maxTime = nsecs;
+	}
+	entryHash.insert(callSite, entry);
+	writeToFile(entry, nsecs);
+}
+
+
+/*
+ * Orders entries by total time, slowest first
+ */
+static bool totalTimeGreaterThan(
+		const SlowQueryLog::Entry &e1,
+		const SlowQueryLog::Entry &e2)
+{
+	return e1.totalTime > e2.totalTime;
+}
+
+
+/**
+ * Returns the statistics of each call site, the one with the largest
+ * total time first
+ */
+QList<SlowQueryLog::Entry> SlowQueryLog::getEntries()
+{
+	QList<Entry> list;
+
+	{
+		QMutexLocker locker(&mutex);
+		list = entryHash.values();
+	}
+	qSort(list.begin(), list.end(), totalTimeGreaterThan);
+	return list;
+}
+
+
+/**
+ * Clears the statistics. The log file is kept.
+ */
+void SlowQueryLog::clear()
+{
+	QMutexLocker locker(&mutex);
+
+	entryHash.clear();
+}
+
+
+/**
+ * Sets the time in milliseconds above which statements are logged
+ *
+ * @param msecs : Threshold; 0 turns the log off
+ */
+void SlowQueryLog::setThreshold(const int msecs)
+{
+	threshold = (msecs < 0)? 0: msecs;
+}
+
+
+/**
+ * Returns the name of the log file, which is kept next to the DBs
+ */
+QString SlowQueryLog::getFileName()
+{
+	return QFileInfo(Database::getContigDBName()).absoluteDir().filePath(LOG_FILE_NAME);
+}
+
+
+/*
+ * Returns the query plan of the statement last executed by the given
+ * query, one line per step
+ */
+QString SlowQueryLog::getPlan(QSqlQuery &query)
+{
+	QSqlQuery plan(query.driver()->createResult());
+	QMap<QString, QVariant> boundValues;
+	QMap<QString, QVariant>::const_iterator i;
+	QStringList lines;
+	QStringList fields;
+	int j;
+
+	if (!plan.prepare("EXPLAIN QUERY PLAN " + query.lastQuery()))
+		return "(no plan: " + plan.lastError().text() + ")";
+	boundValues = query.boundValues();
+	for (i = boundValues.constBegin(); i != boundValues.constEnd(); ++i)
+	{
+		if (i.key().startsWith(":"))
+			plan.bindValue(i.key(), i.value());
+	}
+	if (!plan.exec())
+		return "(no plan: " + plan.lastError().text() + ")";
+	while (plan.next())
+	{
+		fields.clear();
+		for (j = 0; j < plan.record().count(); ++j)
+			fields.append(plan.value(j).toString());
+		lines.append(fields.join(" | "));
+	}
+	return lines.join("\n");
+}
+
+
+/*
+ * Returns the number of rows returned or changed by the statement last
+ * executed by the given query, or -1 if it cannot be counted without
+ * running the statement again. The query is left before its first row.
+ */
+qint64 SlowQueryLog::countRows(QSqlQuery &query)
+{
+	qint64 n;
+
+	if (!query.isSelect())
+		return query.numRowsAffected();
+	if (query.isForwardOnly())
+		return -1;
+	if (!query.last())
+		return 0;
+	n = query.at() + 1;
+
+	/* Stepping back from the first row leaves the query before it */
+	query.first();
+	query.previous();
+	return n;
+}
+
+
+/*
+ * Appends the given statement to the log file. Must be called with the
+ * mutex locked.
+ */
+void SlowQueryLog::writeToFile(const Entry &entry, const qint64 nsecs)
+{
+	QFile file(getFileName());
+
+	if (file.exists() && file.size() >= MAX_LOG_SIZE)
+		rotate();
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text))
+	{
+		qWarning() << "Cannot write slow query log " << file.fileName();
+		return;
+	}
+	QTextStream out(&file);
+	out << QDateTime::currentDateTime().toString(Qt::ISODate)
+		<< "  " << QString::number(nsecs / NSEC_TO_MSEC, 'f', 1) << " ms"
+		<< "  rows: ";
+	if (entry.numRows < 0)
+		out << "unknown";
+	else
+		out << entry.numRows;
+	out << "  at " << entry.callSite << "\n"
+		<< "  " << entry.sql << "\n";
+	foreach (QString line, entry.plan.split("\n"))
+		out << "    " << line << "\n";
+	out << "\n";
+}
+
+
+/*
+ * Renames the log to '.1', '.1' to '.2' and so on, dropping the oldest
+ */
+void SlowQueryLog::rotate()
+{
+	QString name = getFileName();
+	int i;
+
+	QFile::remove(name + "." + QString::number(NUM_OLD_LOGS));
+	for (i = NUM_OLD_LOGS - 1; i >= 1; --i)
+		QFile::rename(name + "." + QString::number(i), name + "." + QString::number(i + 1));
+	QFile::rename(name, name + ".1");
+}
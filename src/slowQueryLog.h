@@ -0,0 +1,51 @@
+#ifndef SLOWQUERYLOG_H_
+#define SLOWQUERYLOG_H_
+
+#include <QString>
+#include <QList>
+#include <QHash>
+#include <QMutex>
+#include <QSqlQuery>
+
+/*
+ * Keeps the statements that took longer than a threshold, grouped by
+ * call site, and appends each of them with its query plan to a log file
+ * that is rotated when it grows too large. Thread safe.
+ */
+class SlowQueryLog
+{
+public:
+	/** Statistics of the slow statements issued from one call site */
+	struct Entry
+	{
+		QString callSite;		/* File and line that issued the statement */
+		QString sql;			/* Last slow statement */
+		QString plan;			/* Query plan of the last slow statement */
+		qint64 numRows;			/* Rows of the last slow statement, -1 if unknown */
+		int count;				/* Number of slow executions */
+		qint64 totalTime;		/* Nanoseconds spent in all the slow executions */
+		qint64 maxTime;			/* Nanoseconds spent in the slowest execution */
+	};
+
+	static void record(QSqlQuery &, const QString &, const qint64);
+	static QList<Entry> getEntries();
+	static void clear();
+	static void setThreshold(const int);
+	static QString getFileName();
+
+	/** Returns the time in milliseconds above which statements are
+	 * logged; 0 means that nothing is logged */
+	inline static int getThreshold() { return threshold; };
+
+private:
+	static QMutex mutex;
+	static QHash<QString, Entry> entryHash;	/* Maps call site to statistics */
+	static int threshold;
+
+	static QString getPlan(QSqlQuery &);
+	static qint64 countRows(QSqlQuery &);
+	static void writeToFile(const Entry &, const qint64);
+	static void rotate();
+};
+
+#endif /* SLOWQUERYLOG_H_ */
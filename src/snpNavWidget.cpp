@@ -1,8 +1,5 @@
 
-#include <QSqlQuery>
-#include <QSqlError>
 #include "snpNavWidget.h"
-#include "database.h"
 
 
 /**
@@ -94,37 +91,17 @@ SnpNavWidget::~SnpNavWidget()
  */
 void SnpNavWidget::goToFirstSnp()
 {
-	QSqlDatabase db =
-		Database::createConnection(
-			QString(this->metaObject()->className()),
-			Database::getSnpDBName());
-	QSqlQuery query(db);
-	QString str;
-
-	str = "select pos "
-			" from snp_pos "
-			" where contig_id = " + QString::number(contig->id) +
-			" and variationPercent >= " + QString::number(threshold) +
-			" order by pos asc "
-			" limit 1 ";
-	if (!query.exec(str))
-	{
-		QMessageBox::critical(
-				this->parentWidget(),
-				tr("Basejumper"),
-				tr("Error fetching 'first SNP' from DB.\nReason: "
-						+ query.lastError().text().toAscii()));
-		db.close();
+	int pos;
+
+	if (contig == NULL)
 		return;
-	}
 
-	if (query.next())
+	pos = contig->getFirstSnp(threshold);
+	if (pos != -1)
 	{
-		emit goToHPos(contig->id, query.value(0).toInt());
+		emit goToHPos(contig->id, pos);
 		emit goToVPos(0);
 	}
-
-	db.close();
 }
 
 
@@ -136,40 +113,19 @@ void SnpNavWidget::goToFirstSnp()
  */
 void SnpNavWidget::goToPrevSnp()
 {
-	QSqlDatabase db =
-		Database::createConnection(
-			QString(this->metaObject()->className()),
-			Database::getSnpDBName());
-	QSqlQuery query(db);
-	QString str;
-
-	str = "select pos "
-			" from snp_pos "
-			" where contig_id = " + QString::number(contig->id) +
-			" and pos < " + QString::number(Contig::startPos) +
-			" and variationPercent >= " + QString::number(threshold) +
-			" order by pos desc "
-			" limit 1 ";
-	if (!query.exec(str))
-	{
-		QMessageBox::critical(
-				this->parentWidget(),
-				tr("Basejumper"),
-				tr("Error fetching 'previous SNP' from DB.\nReason: "
-						+ query.lastError().text().toAscii()));
-		db.close();
+	int pos;
+
+	if (contig == NULL)
 		return;
-	}
 
-	if (query.next())
+	pos = contig->getPrevSnp(Contig::startPos, threshold);
+	if (pos != -1)
 	{
-		emit goToHPos(contig->id, query.value(0).toInt());
+		emit goToHPos(contig->id, pos);
 		emit goToVPos(0);
 	}
 	else
 		emit messageChanged(tr("No more SNPs"));
-
-	db.close();
 }
 
 
@@ -181,40 +137,19 @@ void SnpNavWidget::goToPrevSnp()
  */
 void SnpNavWidget::goToNextSnp()
 {
-	QSqlDatabase db =
-		Database::createConnection(
-			QString(this->metaObject()->className()),
-			Database::getSnpDBName());
-	QSqlQuery query(db);
-	QString str;
-
-	str = "select pos "
-			" from snp_pos "
-			" where contig_id = " + QString::number(contig->id) +
-			" and pos > " + QString::number(Contig::startPos) +
-			" and variationPercent >= " + QString::number(threshold) +
-			" order by pos asc "
-			" limit 1 ";
-	if (!query.exec(str))
-	{
-		QMessageBox::critical(
-				this->parentWidget(),
-				tr("Basejumper"),
-				tr("Error fetching 'next SNP' from DB.\nReason: "
-						+ query.lastError().text().toAscii()));
-		db.close();
+	int pos;
+
+	if (contig == NULL)
 		return;
-	}
 
-	if (query.next())
+	pos = contig->getNextSnp(Contig::startPos, threshold);
+	if (pos != -1)
 	{
-		emit goToHPos(contig->id, query.value(0).toInt());
+		emit goToHPos(contig->id, pos);
 		emit goToVPos(0);
 	}
 	else
 		emit messageChanged(tr("No more SNPs"));
-
-	db.close();
 }
 
 
@@ -225,37 +160,17 @@ void SnpNavWidget::goToNextSnp()
  */
 void SnpNavWidget::goToLastSnp()
 {
-	QSqlDatabase db =
-		Database::createConnection(
-			QString(this->metaObject()->className()),
-			Database::getSnpDBName());
-	QSqlQuery query(db);
-	QString str;
-
-	str = "select pos "
-			" from snp_pos "
-			" where contig_id = " + QString::number(contig->id) +
-			" and variationPercent >= " + QString::number(threshold) +
-			" order by pos desc "
-			" limit 1 ";
-	if (!query.exec(str))
-	{
-		QMessageBox::critical(
-				this->parentWidget(),
-				tr("Basejumper"),
-				tr("Error fetching 'last SNP' from DB.\nReason: "
-						+ query.lastError().text().toAscii()));
-		db.close();
+	int pos;
+
+	if (contig == NULL)
 		return;
-	}
 
-	if (query.next())
+	pos = contig->getLastSnp(threshold);
+	if (pos != -1)
 	{
-		emit goToHPos(contig->id, query.value(0).toInt());
+		emit goToHPos(contig->id, pos);
 		emit goToVPos(0);
 	}
-
-	db.close();
 }
 
 
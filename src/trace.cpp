@@ -0,0 +1,178 @@
+
+#include "trace.h"
+#include <QThread>
+#include <QCoreApplication>
+#include <QMutexLocker>
+#include <QtDebug>
+
+#define	FLUSH_SIZE		1048576		/* Buffered bytes that are written at once */
+#define	PROCESS_ID		1
+
+
+/*
+ * Static member definitions
+ */
+QAtomicInt Trace::enabled(0);
+QMutex Trace::mutex;
+QFile Trace::file;
+QElapsedTimer Trace::timer;
+QByteArray Trace::buffer;
+QHash<Qt::HANDLE, int> Trace::threadIdHash;
+bool Trace::isFirstEvent = true;
+
+
+/**
+ * Starts recording a trace into the given file, replacing any trace
+ * that is being recorded
+ *
+ * @param fileName : Name of the trace file
+ * @return Returns true on success and false if the file cannot be written
+ */
+bool Trace::start(const QString &fileName)
+{
+	stop();
+
+	QMutexLocker locker(&mutex);
+	file.setFileName(fileName);
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+	{
+		qCritical() << "Cannot write trace file " << fileName;
+		return false;
+	}
+	buffer = "{\"traceEvents\":[\n";
+	threadIdHash.clear();
+	isFirstEvent = true;
+	timer.start();
+	enabled = 1;
+	return true;
+}
+
+
+/**
+ * Stops recording and closes the trace file
+ */
+void Trace::stop()
+{
+	QMutexLocker locker(&mutex);
+
+	if ((int) enabled == 0)
+		return;
+	enabled = 0;
+	buffer += "\n]}\n";
+	flush();
+	file.close();
+}
+
+
+/**
+ * Records the beginning of a span in the calling thread
+ *
+ * @param name : Name of the span
+ */
+void Trace::begin(const char *name)
+{
+	addEvent('B', name, QByteArray());
+}
+
+
+/**
+ * Records the end of a span in the calling thread
+ *
+ * @param name : Name of the span
+ */
+void Trace::end(const char *name)
+{
+	addEvent('E', name, QByteArray());
+}
+
+
+/**
+ * Records the value of a counter
+ *
+ * @param name : Name of the counter
+ * @param value : Value of the counter
+ */
+void Trace::counter(const char *name, const qint64 value)
+{
+	addEvent('C', name, "{\"value\":" + QByteArray::number(value) + "}");
+}
+
+
+/*
+ * Appends an event of the given phase to the trace
+ */
+void Trace::addEvent(const char phase, const char *name, const QByteArray &args)
+{
+	QMutexLocker locker(&mutex);
+	int tid;
+
+	/* Recording may have stopped after the caller tested the flag */
+	if ((int) enabled == 0)
+		return;
+
+	tid = getThreadId();
+	if (!isFirstEvent)
+		buffer += ",\n";
+	isFirstEvent = false;
+	buffer += "{\"name\":\"";
+	buffer += name;
+	buffer += "\",\"ph\":\"";
+	buffer += phase;
+	buffer += "\",\"ts\":";
+	buffer += QByteArray::number(timer.nsecsElapsed() / 1000.0, 'f', 3);
+	buffer += ",\"pid\":" + QByteArray::number(PROCESS_ID);
+	buffer += ",\"tid\":" + QByteArray::number(tid);
+	if (!args.isEmpty())
+		buffer += ",\"args\":" + args;
+	buffer += "}";
+	if (buffer.size() >= FLUSH_SIZE)
+		flush();
+}
+
+
+/*
+ * Returns the trace ID of the calling thread. The first event of each
+ * thread is preceded by the thread's name, e.g. its class name.
+ */
+int Trace::getThreadId()
+{
+	Qt::HANDLE handle = QThread::currentThreadId();
+	QThread *thread;
+	QByteArray threadName;
+	int tid;
+
+	if (threadIdHash.contains(handle))
+		return threadIdHash.value(handle);
+
+	tid = threadIdHash.size() + 1;
+	threadIdHash.insert(handle, tid);
+
+	thread = QThread::currentThread();
+	if (QCoreApplication::instance() != NULL
+			&& thread == QCoreApplication::instance()->thread())
+		threadName = "Main";
+	else if (!thread->objectName().isEmpty())
+		threadName = thread->objectName().toAscii();
+	else
+		threadName = thread->metaObject()->className();
+
+	if (!isFirstEvent)
+		buffer += ",\n";
+	isFirstEvent = false;
+	buffer += "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":"
+		+ QByteArray::number(PROCESS_ID)
+		+ ",\"tid\":" + QByteArray::number(tid)
+		+ ",\"args\":{\"name\":\"" + threadName + "\"}}";
+	return tid;
+}
+
+
+/*
+ * Writes the buffered events to the file
+ */
+void Trace::flush()
+{
+	if (file.write(buffer) != buffer.size())
+		qCritical() << "Error writing trace file " << file.fileName();
+	buffer.clear();
+}
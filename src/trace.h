@@ -0,0 +1,88 @@
+#ifndef TRACE_H_
+#define TRACE_H_
+
+#include <QString>
+#include <QByteArray>
+#include <QFile>
+#include <QMutex>
+#include <QHash>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+
+/*
+ * Trace points. They cost one flag test while no trace is being
+ * recorded, and nothing when BASEJUMPER_NO_TRACE is defined at compile
+ * time. Names must be string literals.
+ *
+ * TRACE_SPAN(name) records a span from the trace point to the end of
+ * the enclosing block; TRACE_COUNTER(name, value) records the value of a
+ * counter, such as a queue depth, at this moment.
+ */
+#ifdef BASEJUMPER_NO_TRACE
+#define	TRACE_SPAN(name)
+#define	TRACE_COUNTER(name, value)
+#else
+#define	TRACE_CONCAT2(a, b)			a##b
+#define	TRACE_CONCAT(a, b)			TRACE_CONCAT2(a, b)
+#define	TRACE_SPAN(name)			TraceSpan TRACE_CONCAT(traceSpan, __LINE__)(name)
+#define	TRACE_COUNTER(name, value)	\
+	do { if (Trace::isEnabled()) Trace::counter(name, value); } while (0)
+#endif
+
+/*
+ * Records trace points of all threads into a file in the Chrome trace
+ * event format, which can be opened in chrome://tracing or Perfetto
+ */
+class Trace
+{
+public:
+	static bool start(const QString &);
+	static void stop();
+	static void begin(const char *);
+	static void end(const char *);
+	static void counter(const char *, const qint64);
+
+	/** Returns whether a trace is being recorded */
+	inline static bool isEnabled() { return (int) enabled != 0; };
+
+	/** Returns the name of the file the trace is written to */
+	inline static QString getFileName() { return file.fileName(); };
+
+private:
+	static QAtomicInt enabled;
+	static QMutex mutex;
+	static QFile file;
+	static QElapsedTimer timer;
+	static QByteArray buffer;
+	static QHash<Qt::HANDLE, int> threadIdHash;
+	static bool isFirstEvent;
+
+	static void addEvent(const char, const char *, const QByteArray &);
+	static int getThreadId();
+	static void flush();
+};
+
+
+/*
+ * Records a span for as long as it exists
+ */
+class TraceSpan
+{
+public:
+	inline TraceSpan(const char *name)
+	{
+		this->name = Trace::isEnabled()? name: NULL;
+		if (this->name != NULL)
+			Trace::begin(name);
+	};
+	inline ~TraceSpan()
+	{
+		if (name != NULL)
+			Trace::end(name);
+	};
+
+private:
+	const char *name;	/* NULL if no trace was being recorded at the start */
+};
+
+#endif /* TRACE_H_ */